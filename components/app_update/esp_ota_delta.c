@@ -0,0 +1,326 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_log.h"
+#include "esp32/rom/crc.h"
+#include "sys/param.h"
+
+/*
+ * Delta patch format, as generated by otadelta.py. All integers are little endian.
+ *
+ * Header:
+ *   uint32 magic ("ESPD"), uint8 version, uint8 reserved[3],
+ *   uint32 base_size, uint32 base_crc, uint32 new_size, uint32 new_crc
+ *
+ * The header is followed by a sequence of operations that produce the new image in order.
+ * Each operation starts with a byte holding the opcode in the top two bits and the argument
+ * in the low six bits. An argument of 63 means the argument is 63 plus a LEB128 varint that follows.
+ *
+ *   COPY n   - copy n bytes of the base image from the current base position
+ *   PATCH n  - n literal bytes follow, replacing n bytes of the base image
+ *   INSERT n - n literal bytes follow, the base position does not move
+ *   SEEK d   - move the base position by d, zigzag encoded
+ */
+
+#define DELTA_MAGIC             0x44505345  /* "ESPD" */
+#define DELTA_VERSION           1
+#define DELTA_HEADER_SIZE       24
+
+#define DELTA_OP_COPY           0
+#define DELTA_OP_PATCH          1
+#define DELTA_OP_INSERT         2
+#define DELTA_OP_SEEK           3
+
+#define DELTA_ARG_EXTENDED      0x3F
+#define DELTA_BUF_SIZE          512
+
+static const char *TAG = "esp_ota_delta";
+
+typedef enum {
+    DELTA_STATE_HEADER,
+    DELTA_STATE_OP,
+    DELTA_STATE_VARINT,
+    DELTA_STATE_LITERAL,
+    DELTA_STATE_FAILED,
+} delta_state_t;
+
+struct esp_ota_delta {
+    const esp_partition_t *base;
+    const esp_partition_t *part;
+    esp_ota_handle_t ota_handle;
+    bool ota_started;
+    delta_state_t state;
+    uint8_t op;
+    uint8_t varint_shift;
+    uint32_t arg;               /* argument of the current operation, or bytes left in a literal */
+    uint32_t header_len;
+    uint32_t base_size;
+    uint32_t base_pos;
+    uint32_t new_size;
+    uint32_t new_crc;
+    uint32_t written;
+    uint32_t crc;               /* running CRC of the image written so far */
+    uint8_t buf[DELTA_BUF_SIZE];  /* header while it's being received, then base image data for COPY */
+};
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static esp_err_t delta_output(esp_ota_delta_handle_t h, const uint8_t *data, size_t size)
+{
+    if (size > h->new_size - h->written) {
+        ESP_LOGE(TAG, "patch produces more than %d bytes", h->new_size);
+        return ESP_ERR_OTA_DELTA_INVALID;
+    }
+    esp_err_t err = esp_ota_write(h->ota_handle, data, size);
+    if (err != ESP_OK) {
+        return err;
+    }
+    h->crc = crc32_le(h->crc, data, size);
+    h->written += size;
+    return ESP_OK;
+}
+
+static esp_err_t delta_check_base(esp_ota_delta_handle_t h, uint32_t base_crc)
+{
+    if (h->base_size > h->base->size) {
+        ESP_LOGE(TAG, "base image of the patch (%d bytes) doesn't fit in partition %s", h->base_size, h->base->label);
+        return ESP_ERR_OTA_DELTA_INVALID;
+    }
+    uint32_t crc = 0;
+    for (uint32_t offset = 0; offset < h->base_size; offset += DELTA_BUF_SIZE) {
+        size_t len = MIN(DELTA_BUF_SIZE, h->base_size - offset);
+        esp_err_t err = esp_partition_read(h->base, offset, h->buf, len);
+        if (err != ESP_OK) {
+            return err;
+        }
+        crc = crc32_le(crc, h->buf, len);
+    }
+    if (crc != base_crc) {
+        ESP_LOGE(TAG, "patch was generated for a different base image (crc 0x%08x, partition %s has 0x%08x)",
+                 base_crc, h->base->label, crc);
+        return ESP_ERR_OTA_DELTA_INVALID;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t delta_parse_header(esp_ota_delta_handle_t h)
+{
+    if (get_u32(h->buf) != DELTA_MAGIC || h->buf[4] != DELTA_VERSION) {
+        ESP_LOGE(TAG, "not a delta patch or unsupported version");
+        return ESP_ERR_OTA_DELTA_INVALID;
+    }
+    h->base_size = get_u32(h->buf + 8);
+    uint32_t base_crc = get_u32(h->buf + 12);
+    h->new_size = get_u32(h->buf + 16);
+    h->new_crc = get_u32(h->buf + 20);
+    if (h->new_size > h->part->size) {
+        ESP_LOGE(TAG, "new image (%d bytes) doesn't fit in partition %s", h->new_size, h->part->label);
+        return ESP_ERR_OTA_DELTA_INVALID;
+    }
+
+    esp_err_t err = delta_check_base(h, base_crc);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = esp_ota_begin(h->part, h->new_size, &h->ota_handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    h->ota_started = true;
+    ESP_LOGD(TAG, "applying patch to %d byte image, new image is %d bytes", h->base_size, h->new_size);
+    return ESP_OK;
+}
+
+static esp_err_t delta_copy(esp_ota_delta_handle_t h, uint32_t len)
+{
+    if (len > h->base_size - h->base_pos) {
+        ESP_LOGE(TAG, "copy past the end of the base image");
+        return ESP_ERR_OTA_DELTA_INVALID;
+    }
+    while (len > 0) {
+        size_t chunk = MIN(DELTA_BUF_SIZE, len);
+        esp_err_t err = esp_partition_read(h->base, h->base_pos, h->buf, chunk);
+        if (err != ESP_OK) {
+            return err;
+        }
+        err = delta_output(h, h->buf, chunk);
+        if (err != ESP_OK) {
+            return err;
+        }
+        h->base_pos += chunk;
+        len -= chunk;
+    }
+    return ESP_OK;
+}
+
+/* Called once the argument of the current operation is known */
+static esp_err_t delta_run_op(esp_ota_delta_handle_t h)
+{
+    esp_err_t err = ESP_OK;
+    h->state = DELTA_STATE_OP;
+    switch (h->op) {
+    case DELTA_OP_COPY:
+        err = delta_copy(h, h->arg);
+        break;
+    case DELTA_OP_PATCH:
+        if (h->arg > h->base_size - h->base_pos) {
+            ESP_LOGE(TAG, "patch past the end of the base image");
+            return ESP_ERR_OTA_DELTA_INVALID;
+        }
+        /* fall through */
+    case DELTA_OP_INSERT:
+        if (h->arg > 0) {
+            h->state = DELTA_STATE_LITERAL;
+        }
+        break;
+    case DELTA_OP_SEEK: {
+        int32_t delta = (int32_t)(h->arg >> 1) ^ -(int32_t)(h->arg & 1);
+        int64_t pos = (int64_t)h->base_pos + delta;
+        if (pos < 0 || pos > h->base_size) {
+            ESP_LOGE(TAG, "seek outside of the base image");
+            return ESP_ERR_OTA_DELTA_INVALID;
+        }
+        h->base_pos = pos;
+        break;
+    }
+    }
+    return err;
+}
+
+esp_err_t esp_ota_delta_begin(const esp_partition_t *base, const esp_partition_t *partition, esp_ota_delta_handle_t *out_handle)
+{
+    if (base == NULL) {
+        base = esp_ota_get_running_partition();
+    }
+    if (partition == NULL || out_handle == NULL || base == NULL || partition == base) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_ota_delta_handle_t h = calloc(1, sizeof(struct esp_ota_delta));
+    if (h == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    h->base = base;
+    h->part = partition;
+    h->state = DELTA_STATE_HEADER;
+    *out_handle = h;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_delta_write(esp_ota_delta_handle_t h, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    const uint8_t *end = p + size;
+    esp_err_t err = ESP_OK;
+
+    if (h == NULL || (data == NULL && size > 0) || h->state == DELTA_STATE_FAILED) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    while (p < end && err == ESP_OK) {
+        switch (h->state) {
+        case DELTA_STATE_HEADER: {
+            size_t len = MIN(DELTA_HEADER_SIZE - h->header_len, end - p);
+            memcpy(h->buf + h->header_len, p, len);
+            h->header_len += len;
+            p += len;
+            if (h->header_len == DELTA_HEADER_SIZE) {
+                h->state = DELTA_STATE_OP;
+                err = delta_parse_header(h);
+            }
+            break;
+        }
+        case DELTA_STATE_OP:
+            h->op = *p >> 6;
+            h->arg = *p & DELTA_ARG_EXTENDED;
+            p++;
+            if (h->arg == DELTA_ARG_EXTENDED) {
+                h->varint_shift = 0;
+                h->state = DELTA_STATE_VARINT;
+            } else {
+                err = delta_run_op(h);
+            }
+            break;
+        case DELTA_STATE_VARINT:
+            if (h->varint_shift > 28) {
+                ESP_LOGE(TAG, "operation argument too large");
+                err = ESP_ERR_OTA_DELTA_INVALID;
+                break;
+            }
+            h->arg += (uint32_t)(*p & 0x7F) << h->varint_shift;
+            h->varint_shift += 7;
+            if ((*p++ & 0x80) == 0) {
+                err = delta_run_op(h);
+            }
+            break;
+        case DELTA_STATE_LITERAL: {
+            size_t len = MIN(h->arg, end - p);
+            err = delta_output(h, p, len);
+            p += len;
+            h->arg -= len;
+            if (h->op == DELTA_OP_PATCH) {
+                h->base_pos += len;
+            }
+            if (h->arg == 0) {
+                h->state = DELTA_STATE_OP;
+            }
+            break;
+        }
+        case DELTA_STATE_FAILED:
+            break;
+        }
+    }
+
+    if (err != ESP_OK) {
+        h->state = DELTA_STATE_FAILED;
+    }
+    return err;
+}
+
+esp_err_t esp_ota_delta_end(esp_ota_delta_handle_t h)
+{
+    esp_err_t err = ESP_OK;
+
+    if (h == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (h->state == DELTA_STATE_FAILED) {
+        err = ESP_ERR_OTA_DELTA_INVALID;
+    } else {
+        if (h->state != DELTA_STATE_OP || h->written != h->new_size) {
+            ESP_LOGE(TAG, "patch is incomplete (%d of %d bytes written)", h->written, h->new_size);
+            err = ESP_ERR_OTA_DELTA_INVALID;
+        } else if (h->crc != h->new_crc) {
+            ESP_LOGE(TAG, "new image crc mismatch (expected 0x%08x, got 0x%08x)", h->new_crc, h->crc);
+            err = ESP_ERR_OTA_DELTA_INVALID;
+        }
+    }
+    if (h->ota_started) {
+        /* Releases the OTA handle even if the image is known to be bad */
+        esp_err_t end_err = esp_ota_end(h->ota_handle);
+        if (err == ESP_OK) {
+            err = end_err;
+        }
+    }
+    free(h);
+    return err;
+}
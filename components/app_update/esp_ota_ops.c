@@ -51,6 +51,7 @@ typedef struct ota_ops_entry_ {
     uint32_t wrote_size;
     uint8_t partial_bytes;
     uint8_t partial_data[16];
+    esp_image_stream_verify_handle_t verify;
     LIST_ENTRY(ota_ops_entry_) entries;
 } ota_ops_entry_t;
 
@@ -178,6 +179,17 @@ esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp
         new_entry->erased_size = image_size;
     }
 
+#ifdef CONFIG_APP_UPDATE_VERIFY_WHILE_WRITING
+    const esp_partition_pos_t part_pos = {
+        .offset = partition->address,
+        .size = partition->size,
+    };
+    if (esp_image_stream_verify_begin(&part_pos, &new_entry->verify) != ESP_OK) {
+        ESP_LOGW(TAG, "image will be verified by reading it back in esp_ota_end()");
+        new_entry->verify = NULL;
+    }
+#endif
+
     new_entry->part = partition;
     new_entry->handle = ++s_ota_ops_last_handle;
     *out_handle = new_entry->handle;
@@ -205,6 +217,10 @@ esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
                 return ESP_ERR_OTA_VALIDATE_FAILED;
             }
 
+            if (it->verify != NULL && esp_image_stream_verify_data(it->verify, data_bytes, size) != ESP_OK) {
+                return ESP_ERR_OTA_VALIDATE_FAILED;
+            }
+
             if (esp_flash_encryption_enabled()) {
                 /* Can only write 16 byte blocks to flash, so need to cache anything else */
                 size_t copy_len;
@@ -285,17 +301,30 @@ esp_err_t esp_ota_end(esp_ota_handle_t handle)
     }
 
     esp_image_metadata_t data;
-    const esp_partition_pos_t part_pos = {
-      .offset = it->part->address,
-      .size = it->part->size,
-    };
+    if (it->verify != NULL) {
+        // image was checksummed and hashed by esp_ota_write(), no need to read it back
+        esp_err_t err = esp_image_stream_verify_end(it->verify, &data);
+        it->verify = NULL;
+        if (err != ESP_OK) {
+            ret = ESP_ERR_OTA_VALIDATE_FAILED;
+            goto cleanup;
+        }
+    } else {
+        const esp_partition_pos_t part_pos = {
+          .offset = it->part->address,
+          .size = it->part->size,
+        };
 
-    if (esp_image_verify(ESP_IMAGE_VERIFY, &part_pos, &data) != ESP_OK) {
-        ret = ESP_ERR_OTA_VALIDATE_FAILED;
-        goto cleanup;
+        if (esp_image_verify(ESP_IMAGE_VERIFY, &part_pos, &data) != ESP_OK) {
+            ret = ESP_ERR_OTA_VALIDATE_FAILED;
+            goto cleanup;
+        }
     }
 
  cleanup:
+    if (it->verify != NULL) {
+        esp_image_stream_verify_end(it->verify, NULL);
+    }
     LIST_REMOVE(it, entries);
     free(it);
     return ret;
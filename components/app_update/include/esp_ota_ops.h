@@ -37,6 +37,7 @@ extern "C"
 #define ESP_ERR_OTA_SMALL_SEC_VER                (ESP_ERR_OTA_BASE + 0x04)  /*!< Error if the firmware has a secure version less than the running firmware. */
 #define ESP_ERR_OTA_ROLLBACK_FAILED              (ESP_ERR_OTA_BASE + 0x05)  /*!< Error if flash does not have valid firmware in passive partition and hence rollback is not possible */
 #define ESP_ERR_OTA_ROLLBACK_INVALID_STATE       (ESP_ERR_OTA_BASE + 0x06)  /*!< Error if current active firmware is still marked in pending validation state (ESP_OTA_IMG_PENDING_VERIFY), essentially first boot of firmware image post upgrade and hence firmware upgrade is not possible */
+#define ESP_ERR_OTA_DELTA_INVALID                (ESP_ERR_OTA_BASE + 0x07)  /*!< Error if a delta patch is malformed or was made for a different base image */
 
 
 /**
@@ -47,6 +48,14 @@ extern "C"
  */
 typedef uint32_t esp_ota_handle_t;
 
+/**
+ * @brief Opaque handle for an OTA update applied from a delta patch
+ *
+ * esp_ota_delta_begin() returns a handle which is then used for subsequent
+ * calls to esp_ota_delta_write() and esp_ota_delta_end().
+ */
+typedef struct esp_ota_delta *esp_ota_delta_handle_t;
+
 /**
  * @brief   Return esp_app_desc structure. This structure includes app version.
  * 
@@ -111,7 +120,8 @@ esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp
  * @return
  *    - ESP_OK: Data was written to flash successfully.
  *    - ESP_ERR_INVALID_ARG: handle is invalid.
- *    - ESP_ERR_OTA_VALIDATE_FAILED: First byte of image contains invalid app image magic byte.
+ *    - ESP_ERR_OTA_VALIDATE_FAILED: First byte of image contains invalid app image magic byte, or (if CONFIG_APP_UPDATE_VERIFY_WHILE_WRITING
+ *      is enabled) the image or a segment header is invalid.
  *    - ESP_ERR_FLASH_OP_TIMEOUT or ESP_ERR_FLASH_OP_FAIL: Flash write failed.
  *    - ESP_ERR_OTA_SELECT_INFO_INVALID: OTA data partition has invalid contents
  */
@@ -133,6 +143,61 @@ esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size);
  */
 esp_err_t esp_ota_end(esp_ota_handle_t handle);
 
+/**
+ * @brief   Commence an OTA update from a delta patch.
+ *
+ * A delta patch is generated on the host with otadelta.py from the image
+ * currently installed in the base partition and the new image. The new image is rebuilt from
+ * the base partition and the patch stream, and written through esp_ota_begin(), esp_ota_write()
+ * and esp_ota_end(), so it is validated the same way as a full image.
+ *
+ * Patch data is processed as it arrives and the memory used does not depend on the image size.
+ *
+ * @param base       Partition holding the image the patch was generated against. If NULL, the running partition is used.
+ * @param partition  Partition which will receive the new image. Must not be the base partition.
+ * @param out_handle On success, returns a handle which should be used for subsequent esp_ota_delta_write() and esp_ota_delta_end() calls.
+ *
+ * @return
+ *    - ESP_OK: Delta OTA operation commenced successfully.
+ *    - ESP_ERR_INVALID_ARG: partition or out_handle arguments were NULL, or partition is the base partition.
+ *    - ESP_ERR_NO_MEM: Cannot allocate memory for the delta OTA operation.
+ */
+esp_err_t esp_ota_delta_begin(const esp_partition_t* base, const esp_partition_t* partition, esp_ota_delta_handle_t* out_handle);
+
+/**
+ * @brief   Apply the next part of a delta patch
+ *
+ * This function can be called multiple times as patch data is received, in chunks of any size.
+ * The OTA update is started with esp_ota_begin() once the patch header has been received and the
+ * base partition has been checked against it.
+ *
+ * @param handle  Handle obtained from esp_ota_delta_begin
+ * @param data    Patch data buffer
+ * @param size    Size of patch data buffer in bytes.
+ *
+ * @return
+ *    - ESP_OK: Patch data was applied successfully.
+ *    - ESP_ERR_INVALID_ARG: handle is invalid.
+ *    - ESP_ERR_OTA_DELTA_INVALID: Patch is malformed, or the base partition doesn't hold the image the patch was generated against.
+ *    - Any error returned by esp_ota_begin() or esp_ota_write(), or by esp_partition_read() for the base partition.
+ */
+esp_err_t esp_ota_delta_write(esp_ota_delta_handle_t handle, const void* data, size_t size);
+
+/**
+ * @brief Finish a delta OTA update and validate newly written app image.
+ *
+ * @param handle  Handle obtained from esp_ota_delta_begin().
+ *
+ * @note After calling esp_ota_delta_end(), the handle is no longer valid and any memory associated with it is freed (regardless of result).
+ *
+ * @return
+ *    - ESP_OK: Newly written OTA app image is valid.
+ *    - ESP_ERR_INVALID_ARG: handle is invalid.
+ *    - ESP_ERR_OTA_DELTA_INVALID: Patch was incomplete, or the rebuilt image doesn't match the checksum recorded in the patch.
+ *    - Any error returned by esp_ota_end().
+ */
+esp_err_t esp_ota_delta_end(esp_ota_delta_handle_t handle);
+
 /**
  * @brief Configure OTA data for a new boot partition
  *
@@ -0,0 +1,274 @@
+#!/usr/bin/env python
+#
+# otadelta generates delta patches for OTA updates - the device rebuilds the new
+# application image from the image it is currently running and the patch, see
+# esp_ota_delta_begin()
+#
+# Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+from __future__ import print_function, division
+import argparse
+import struct
+import sys
+import zlib
+
+__version__ = '1.0'
+
+DELTA_MAGIC = b"ESPD"
+DELTA_VERSION = 1
+DELTA_HEADER_FMT = "<4sB3xIIII"
+
+OP_COPY = 0
+OP_PATCH = 1
+OP_INSERT = 2
+OP_SEEK = 3
+
+ARG_EXTENDED = 0x3F
+
+# Length of the base image substrings used to find matches
+MATCH_KEY_LEN = 16
+# Only every n-th position of the base image is indexed, any match at least
+# MATCH_KEY_LEN + n - 1 bytes long is still found
+INDEX_STEP = 4
+# Matches shorter than this cost more to encode than the literal bytes
+MIN_MATCH_LEN = 12
+# Differences of up to this many bytes inside a match (e.g. a relocated address)
+# are encoded as PATCH without losing the match
+MAX_PATCH_GAP = 16
+
+quiet = False
+
+
+def status(msg):
+    if not quiet:
+        print(msg)
+
+
+def crc32(data):
+    return zlib.crc32(data) & 0xffffffff
+
+
+def _encode_op(op, arg):
+    if arg < ARG_EXTENDED:
+        return bytearray([(op << 6) | arg])
+    out = bytearray([(op << 6) | ARG_EXTENDED])
+    arg -= ARG_EXTENDED
+    while True:
+        if arg < 0x80:
+            out.append(arg)
+            return out
+        out.append((arg & 0x7F) | 0x80)
+        arg >>= 7
+
+
+def _match_len(a, a_pos, b, b_pos):
+    """ Length of the common prefix of a[a_pos:] and b[b_pos:] """
+    n = min(len(a) - a_pos, len(b) - b_pos)
+    length = 0
+    step = 256
+    while length < n:
+        step = min(step, n - length)
+        if a[a_pos + length:a_pos + length + step] == b[b_pos + length:b_pos + length + step]:
+            length += step
+        elif step > 1:
+            step //= 8 if step > 8 else step
+        else:
+            break
+    return length
+
+
+class DeltaEncoder(object):
+
+    def __init__(self, base):
+        self.base = base
+        self.out = bytearray()
+        self.base_pos = 0
+        self.copied = 0
+
+    def copy(self, length):
+        self.out += _encode_op(OP_COPY, length)
+        self.base_pos += length
+        self.copied += length
+
+    def literal(self, data, op):
+        if data:
+            self.out += _encode_op(op, len(data))
+            self.out += data
+            if op == OP_PATCH:
+                self.base_pos += len(data)
+
+    def seek(self, pos):
+        delta = pos - self.base_pos
+        if delta:
+            self.out += _encode_op(OP_SEEK, (delta << 1) ^ (delta >> 63))
+            self.base_pos = pos
+
+
+def generate_patch(base, new):
+    """ Return a delta patch that turns the base image into the new image """
+    base = bytes(base)
+    new = bytes(new)
+
+    index = {}
+    for pos in range(0, len(base) - MATCH_KEY_LEN + 1, INDEX_STEP):
+        index.setdefault(base[pos:pos + MATCH_KEY_LEN], pos)
+
+    enc = DeltaEncoder(base)
+    literal_start = 0
+    i = 0
+    while i < len(new):
+        # Prefer continuing in the alignment of the previous match, literal bytes
+        # in between are then a PATCH of the base image
+        match_pos = enc.base_pos + (i - literal_start)
+        match = _match_len(new, i, base, match_pos) if match_pos < len(base) else 0
+        if match < MIN_MATCH_LEN:
+            match_pos = index.get(new[i:i + MATCH_KEY_LEN])
+            match = _match_len(new, i, base, match_pos) if match_pos is not None else 0
+        if match < MIN_MATCH_LEN:
+            i += 1
+            continue
+
+        # The match may start before the indexed position
+        while i > literal_start and match_pos > 0 and new[i - 1:i] == base[match_pos - 1:match_pos]:
+            i -= 1
+            match_pos -= 1
+            match += 1
+
+        if match_pos == enc.base_pos + (i - literal_start) and match_pos <= len(base):
+            enc.literal(new[literal_start:i], OP_PATCH)
+        else:
+            enc.literal(new[literal_start:i], OP_INSERT)
+            enc.seek(match_pos)
+
+        while True:
+            enc.copy(match)
+            i += match
+            # Bridge small differences to keep the alignment
+            gap_end = min(MAX_PATCH_GAP, len(new) - i, len(base) - enc.base_pos)
+            for gap in range(1, gap_end + 1):
+                match = _match_len(new, i + gap, base, enc.base_pos + gap)
+                if match >= MIN_MATCH_LEN or (match > 0 and i + gap + match == len(new)):
+                    enc.literal(new[i:i + gap], OP_PATCH)
+                    i += gap
+                    break
+            else:
+                break
+        literal_start = i
+
+    enc.literal(new[literal_start:], OP_INSERT)
+
+    header = struct.pack(DELTA_HEADER_FMT, DELTA_MAGIC, DELTA_VERSION,
+                         len(base), crc32(base), len(new), crc32(new))
+    status("Patch is %d bytes (%d%% of the new image), %d bytes copied from the base image" %
+           (len(header) + len(enc.out), 100 * (len(header) + len(enc.out)) // max(len(new), 1), enc.copied))
+    return header + bytes(enc.out)
+
+
+def _read_op(patch, pos):
+    op = ord(patch[pos:pos + 1]) >> 6
+    arg = ord(patch[pos:pos + 1]) & ARG_EXTENDED
+    pos += 1
+    if arg == ARG_EXTENDED:
+        shift = 0
+        while True:
+            b = ord(patch[pos:pos + 1])
+            pos += 1
+            arg += (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                break
+    return op, arg, pos
+
+
+def apply_patch(base, patch):
+    """ Rebuild the new image from the base image and a delta patch, as the device does """
+    header_len = struct.calcsize(DELTA_HEADER_FMT)
+    magic, version, base_size, base_crc, new_size, new_crc = struct.unpack(DELTA_HEADER_FMT, patch[:header_len])
+    if magic != DELTA_MAGIC or version != DELTA_VERSION:
+        raise RuntimeError("Not a delta patch or unsupported version")
+    base = base[:base_size]
+    if len(base) != base_size or crc32(base) != base_crc:
+        raise RuntimeError("Patch was generated for a different base image")
+
+    new = bytearray()
+    base_pos = 0
+    pos = header_len
+    while pos < len(patch):
+        op, arg, pos = _read_op(patch, pos)
+        if op == OP_COPY:
+            new += base[base_pos:base_pos + arg]
+            base_pos += arg
+        elif op == OP_SEEK:
+            base_pos += (arg >> 1) ^ -(arg & 1)
+        else:
+            new += patch[pos:pos + arg]
+            pos += arg
+            if op == OP_PATCH:
+                base_pos += arg
+
+    if len(new) != new_size or crc32(bytes(new)) != new_crc:
+        raise RuntimeError("Rebuilt image doesn't match the patch")
+    return bytes(new)
+
+
+def _read_file(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def _write_file(path, data):
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def main():
+    global quiet
+
+    parser = argparse.ArgumentParser("ESP-IDF OTA Delta Patch Tool")
+
+    parser.add_argument("--quiet", "-q", help="suppress stderr messages", action="store_true")
+
+    subparsers = parser.add_subparsers(dest="operation", help="run otadelta -h for additional help")
+
+    create_parser = subparsers.add_parser("create", help="generate a patch from the running and the new app image")
+    create_parser.add_argument("base", help="app image the device is running")
+    create_parser.add_argument("new", help="new app image")
+    create_parser.add_argument("--output", "-o", help="file to write the patch to", required=True)
+
+    apply_parser = subparsers.add_parser("apply", help="rebuild the new app image from a base image and a patch")
+    apply_parser.add_argument("base", help="app image the patch was generated against")
+    apply_parser.add_argument("patch", help="patch generated by the create operation")
+    apply_parser.add_argument("--output", "-o", help="file to write the new app image to", required=True)
+
+    args = parser.parse_args()
+
+    quiet = args.quiet
+
+    if args.operation is None:
+        parser.print_help()
+        sys.exit(1)
+
+    if args.operation == "create":
+        _write_file(args.output, generate_patch(_read_file(args.base), _read_file(args.new)))
+    else:
+        _write_file(args.output, apply_patch(_read_file(args.base), _read_file(args.patch)))
+    status("Wrote %s" % args.output)
+
+
+if __name__ == '__main__':
+    try:
+        main()
+    except RuntimeError as e:
+        print("A fatal error occurred: %s" % e, file=sys.stderr)
+        sys.exit(2)
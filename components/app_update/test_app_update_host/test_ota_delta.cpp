@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+
+#include "catch.hpp"
+
+extern "C" void _spi_flash_init(const char* chip_size, size_t block_size, size_t sector_size, size_t page_size, const char* partition_bin);
+
+typedef std::vector<uint8_t> image_t;
+
+static const size_t image_size = 512 * 1024;
+
+static image_t make_base_image(unsigned seed)
+{
+    srand(seed);
+    image_t image(image_size);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = rand();
+    }
+    image[0] = ESP_IMAGE_HEADER_MAGIC;
+    return image;
+}
+
+/* What a small code change does to an app image: some code is added and removed,
+ * which moves everything behind it and changes the addresses that refer to it */
+static image_t make_new_image(const image_t& base)
+{
+    image_t image(base);
+    image.insert(image.begin() + 100000, 3000, 0);
+    for (size_t i = 100000; i < 103000; ++i) {
+        image[i] = rand();
+    }
+    image.erase(image.begin() + 300000, image.begin() + 301000);
+    for (int i = 0; i < 1000; ++i) {
+        size_t pos = 4 * (rand() % (image.size() / 4));
+        image[pos] += 1;
+        image[pos + 1] += 0x30;
+    }
+    return image;
+}
+
+static void write_file(const char* path, const image_t& data)
+{
+    FILE* f = fopen(path, "wb");
+    REQUIRE(f != NULL);
+    REQUIRE(fwrite(data.data(), 1, data.size(), f) == data.size());
+    fclose(f);
+}
+
+static image_t read_file(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    REQUIRE(f != NULL);
+    image_t data;
+    uint8_t buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + len);
+    }
+    fclose(f);
+    return data;
+}
+
+static image_t create_patch(const image_t& base, const image_t& new_image)
+{
+    write_file("build/base.bin", base);
+    write_file("build/new.bin", new_image);
+    REQUIRE(system("python ../otadelta.py -q create build/base.bin build/new.bin -o build/patch.bin") == 0);
+    return read_file("build/patch.bin");
+}
+
+static const esp_partition_t* install_base_image(const image_t& base)
+{
+    _spi_flash_init(CONFIG_ESPTOOLPY_FLASHSIZE, 0x10000, SPI_FLASH_SEC_SIZE, 256, "partition_table.bin");
+
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    REQUIRE(running != NULL);
+    REQUIRE(esp_partition_erase_range(running, 0, running->size) == ESP_OK);
+    REQUIRE(esp_partition_write(running, 0, base.data(), base.size()) == ESP_OK);
+    return running;
+}
+
+/* Feeds the patch in chunks of varying size, like a download would deliver it */
+static esp_err_t apply_patch(const esp_partition_t* base, const esp_partition_t* update, const image_t& patch)
+{
+    esp_ota_delta_handle_t handle;
+    REQUIRE(esp_ota_delta_begin(base, update, &handle) == ESP_OK);
+
+    esp_err_t err = ESP_OK;
+    size_t chunk = 1;
+    for (size_t pos = 0; pos < patch.size() && err == ESP_OK; pos += chunk) {
+        chunk = std::min(patch.size() - pos, (size_t) 1 + rand() % 1500);
+        err = esp_ota_delta_write(handle, patch.data() + pos, chunk);
+    }
+    esp_err_t end_err = esp_ota_delta_end(handle);
+    return err != ESP_OK ? err : end_err;
+}
+
+TEST_CASE("new image is rebuilt from the running partition and a delta patch", "[ota_delta]")
+{
+    image_t base = make_base_image(1);
+    image_t new_image = make_new_image(base);
+    image_t patch = create_patch(base, new_image);
+    CHECK(patch.size() < new_image.size() / 20);
+
+    const esp_partition_t* running = install_base_image(base);
+    const esp_partition_t* update = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, NULL);
+    REQUIRE(update != NULL);
+    REQUIRE(update != running);
+
+    REQUIRE(apply_patch(NULL, update, patch) == ESP_OK);
+
+    image_t written(new_image.size());
+    REQUIRE(esp_partition_read(update, 0, written.data(), written.size()) == ESP_OK);
+    CHECK(written == new_image);
+}
+
+TEST_CASE("delta patch for a different base image is rejected", "[ota_delta]")
+{
+    image_t base = make_base_image(1);
+    image_t patch = create_patch(base, make_new_image(base));
+
+    image_t other_base = make_base_image(2);
+    const esp_partition_t* running = install_base_image(other_base);
+    const esp_partition_t* update = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, NULL);
+
+    esp_ota_delta_handle_t handle;
+    REQUIRE(esp_ota_delta_begin(running, update, &handle) == ESP_OK);
+    CHECK(esp_ota_delta_write(handle, patch.data(), patch.size()) == ESP_ERR_OTA_DELTA_INVALID);
+    CHECK(esp_ota_delta_end(handle) == ESP_ERR_OTA_DELTA_INVALID);
+}
+
+TEST_CASE("truncated or corrupted delta patch is rejected", "[ota_delta]")
+{
+    image_t base = make_base_image(1);
+    image_t patch = create_patch(base, make_new_image(base));
+    const esp_partition_t* running = install_base_image(base);
+    const esp_partition_t* update = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, NULL);
+
+    image_t truncated(patch.begin(), patch.end() - 100);
+    CHECK(apply_patch(running, update, truncated) == ESP_ERR_OTA_DELTA_INVALID);
+
+    image_t corrupted(patch);
+    corrupted[corrupted.size() - 1] ^= 0xff;
+    CHECK(apply_patch(running, update, corrupted) == ESP_ERR_OTA_DELTA_INVALID);
+
+    esp_ota_delta_handle_t handle;
+    CHECK(esp_ota_delta_begin(running, running, &handle) == ESP_ERR_INVALID_ARG);
+}
@@ -169,6 +169,56 @@ esp_err_t esp_image_verify_bootloader(uint32_t *length);
  */
 esp_err_t esp_image_verify_bootloader_data(esp_image_metadata_t *data);
 
+/* Handle of an image verification running over the data while it is written to a partition */
+typedef struct esp_image_stream_verify *esp_image_stream_verify_handle_t;
+
+/**
+ * @brief Start verifying an app image while it is being written (not available in the bootloader).
+ *
+ * The data passed to esp_image_stream_verify_data() is parsed, checksummed and hashed as it passes,
+ * so verifying the image after it has been written does not need to read the partition back.
+ *
+ * @param part Partition the image is written to.
+ * @param[out] out_handle On success, the verification handle.
+ *
+ * @return
+ * - ESP_OK on success
+ * - ESP_ERR_INVALID_ARG if the partition or handle pointers are invalid, or the partition is larger than 16MB.
+ * - ESP_ERR_NO_MEM if the handle could not be allocated.
+ */
+esp_err_t esp_image_stream_verify_begin(const esp_partition_pos_t *part, esp_image_stream_verify_handle_t *out_handle);
+
+/**
+ * @brief Pass the next part of the image to the verification.
+ *
+ * Data must be passed in the order it is written, in chunks of any size. Data following
+ * the image (signature block, padding) is accepted and ignored.
+ *
+ * @param handle Verification handle.
+ * @param data Image data.
+ * @param len Length of the data.
+ *
+ * @return
+ * - ESP_OK if the data seen so far looks like a valid image
+ * - ESP_ERR_IMAGE_INVALID if the image header, a segment header or the checksum are invalid.
+ */
+esp_err_t esp_image_stream_verify_data(esp_image_stream_verify_handle_t handle, const void *data, size_t len);
+
+/**
+ * @brief Finish the verification and free the handle.
+ *
+ * Checks the same as esp_image_verify(), using the checksum and SHA-256 calculated while the data
+ * was passed in. Only the signature block (if signature verification is enabled) is read from flash.
+ *
+ * @param handle Verification handle.
+ * @param[out] data If not NULL, set to the image metadata on success.
+ *
+ * @return
+ * - ESP_OK if the image is valid
+ * - ESP_ERR_IMAGE_INVALID if the image is incomplete or invalid.
+ */
+esp_err_t esp_image_stream_verify_end(esp_image_stream_verify_handle_t handle, esp_image_metadata_t *data);
+
 
 typedef struct {
     uint32_t drom_addr;
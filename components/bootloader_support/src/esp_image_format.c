@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include <string.h>
+#include <stdlib.h>
 #include <sys/param.h>
 #include <soc/cpu.h>
 #include <bootloader_utility.h>
@@ -97,6 +98,11 @@ static esp_err_t verify_checksum(bootloader_sha256_handle_t sha_handle, uint32_t
 static esp_err_t __attribute__((unused)) verify_secure_boot_signature(bootloader_sha256_handle_t sha_handle, esp_image_metadata_t *data, uint8_t *image_digest, uint8_t *verified_digest);
 static esp_err_t __attribute__((unused)) verify_simple_hash(bootloader_sha256_handle_t sha_handle, esp_image_metadata_t *data);
 
+#ifdef SECURE_BOOT_CHECK_SIGNATURE
+/* Verify the signature block at sig_addr against a digest already calculated over the signed data */
+static esp_err_t verify_signature_block(uint32_t sig_addr, const uint8_t *image_digest, uint8_t *verified_digest);
+#endif
+
 static esp_err_t image_load(esp_image_load_mode_t mode, const esp_partition_pos_t *part, esp_image_metadata_t *data)
 {
 #ifdef BOOTLOADER_BUILD
@@ -747,6 +753,26 @@ static esp_err_t verify_checksum(bootloader_sha256_handle_t sha_handle, uint32_t
     return ESP_OK;
 }
 
+#ifdef SECURE_BOOT_CHECK_SIGNATURE
+static esp_err_t verify_signature_block(uint32_t sig_addr, const uint8_t *image_digest, uint8_t *verified_digest)
+{
+    esp_err_t err = ESP_ERR_IMAGE_INVALID;
+    const void *sig_block;
+#ifdef CONFIG_SECURE_SIGNED_APPS_ECDSA_SCHEME
+    ESP_FAULT_ASSERT(memcmp(image_digest, verified_digest, HASH_LEN) != 0); /* sanity check that these values start differently */
+    sig_block = bootloader_mmap(sig_addr, sizeof(esp_secure_boot_sig_block_t));
+    err = esp_secure_boot_verify_ecdsa_signature_block(sig_block, image_digest, verified_digest);
+#elif CONFIG_SECURE_SIGNED_APPS_RSA_SCHEME
+    ESP_FAULT_ASSERT(memcmp(image_digest, verified_digest, HASH_LEN) != 0);  /* sanity check that these values start differently */
+    sig_block = bootloader_mmap(sig_addr, sizeof(ets_secure_boot_signature_t));
+    err = esp_secure_boot_verify_rsa_signature_block(sig_block, image_digest, verified_digest);
+#endif
+
+    bootloader_munmap(sig_block);
+    return err;
+}
+#endif // SECURE_BOOT_CHECK_SIGNATURE
+
 static esp_err_t verify_secure_boot_signature(bootloader_sha256_handle_t sha_handle, esp_image_metadata_t *data, uint8_t *image_digest, uint8_t *verified_digest)
 {
 #ifdef SECURE_BOOT_CHECK_SIGNATURE
@@ -780,19 +806,11 @@ static esp_err_t verify_secure_boot_signature(bootloader_sha256_handle_t sha_han
     bootloader_debug_buffer(image_digest, HASH_LEN, "Calculated secure boot hash");
 
     // Use hash to verify signature block
-    esp_err_t err = ESP_ERR_IMAGE_INVALID;
-    const void *sig_block;
 #ifdef CONFIG_SECURE_SIGNED_APPS_ECDSA_SCHEME
-    ESP_FAULT_ASSERT(memcmp(image_digest, verified_digest, HASH_LEN) != 0); /* sanity check that these values start differently */
-    sig_block = bootloader_mmap(data->start_addr + data->image_len, sizeof(esp_secure_boot_sig_block_t));
-    err = esp_secure_boot_verify_ecdsa_signature_block(sig_block, image_digest, verified_digest);
+    esp_err_t err = verify_signature_block(data->start_addr + data->image_len, image_digest, verified_digest);
 #elif CONFIG_SECURE_SIGNED_APPS_RSA_SCHEME
-    ESP_FAULT_ASSERT(memcmp(image_digest, verified_digest, HASH_LEN) != 0);  /* sanity check that these values start differently */
-    sig_block = bootloader_mmap(end, sizeof(ets_secure_boot_signature_t));
-    err = esp_secure_boot_verify_rsa_signature_block(sig_block, image_digest, verified_digest);
+    esp_err_t err = verify_signature_block(end, image_digest, verified_digest);
 #endif
-
-    bootloader_munmap(sig_block);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Secure boot signature verification failed");
 
@@ -841,3 +859,282 @@ static esp_err_t verify_simple_hash(bootloader_sha256_handle_t sha_handle, esp_i
     bootloader_munmap(hash);
     return ESP_OK;
 }
+
+#ifndef BOOTLOADER_BUILD
+
+typedef enum {
+    STREAM_IMAGE_HEADER,
+    STREAM_SEGMENT_HEADER,
+    STREAM_SEGMENT_DATA,
+    STREAM_CHECKSUM,        /* padding to 16 bytes, the checksum is the last byte */
+    STREAM_HASH,            /* appended SHA-256 */
+    STREAM_SIGNATURE_PAD,   /* padding to a flash sector, included in the signed digest */
+    STREAM_DONE,
+    STREAM_FAILED,
+} stream_state_t;
+
+struct esp_image_stream_verify {
+    esp_partition_pos_t part;
+    stream_state_t state;
+    uint32_t offset;        /* bytes of the image processed so far */
+    uint32_t state_end;     /* offset at which the current state is complete */
+    int segment;
+    uint32_t checksum_word;
+    bootloader_sha256_handle_t sha_handle;
+    uint8_t digest[HASH_LEN];
+    uint8_t buf[HASH_LEN];  /* header, checksum or hash being collected */
+    size_t buf_len;
+    esp_image_metadata_t data;
+};
+
+_Static_assert(sizeof(esp_image_header_t) <= HASH_LEN, "image header must fit in the stream buffer");
+
+static void stream_set_state(esp_image_stream_verify_handle_t s, stream_state_t state, uint32_t len)
+{
+    s->state = state;
+    s->state_end = s->offset + len;
+    s->buf_len = 0;
+}
+
+/* The 8 bit checksum is the XOR of all segment data bytes, the byte lanes of the word are only folded at the end */
+static void stream_checksum(uint32_t *checksum, const uint8_t *p, size_t len)
+{
+    while (len > 0 && ((intptr_t)p & 3) != 0) {
+        *checksum ^= *p++;
+        len--;
+    }
+    for (; len >= 4; p += 4, len -= 4) {
+        *checksum ^= *(const uint32_t *)p;
+    }
+    while (len > 0) {
+        *checksum ^= *p++;
+        len--;
+    }
+}
+
+static void stream_finish_hash(esp_image_stream_verify_handle_t s)
+{
+    if (s->sha_handle != NULL) {
+        bootloader_sha256_finish(s->sha_handle, s->digest);
+        s->sha_handle = NULL;
+    }
+}
+
+static void stream_after_hash(esp_image_stream_verify_handle_t s)
+{
+#if defined(SECURE_BOOT_CHECK_SIGNATURE) && CONFIG_SECURE_SIGNED_APPS_RSA_SCHEME
+    uint32_t padded_end = (s->offset + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1);
+    stream_set_state(s, STREAM_SIGNATURE_PAD, padded_end - s->offset);
+#else
+    stream_set_state(s, STREAM_DONE, 0);
+#endif
+}
+
+static void stream_next_segment(esp_image_stream_verify_handle_t s)
+{
+    if (s->segment < s->data.image.segment_count) {
+        stream_set_state(s, STREAM_SEGMENT_HEADER, sizeof(esp_image_segment_header_t));
+    } else {
+        s->data.image_len = s->offset;
+        stream_set_state(s, STREAM_CHECKSUM, ((s->offset + 1 + 15) & ~15) - s->offset);
+    }
+}
+
+/* Called when the current state has all its data, moves on to the next part of the image */
+static esp_err_t stream_next_state(esp_image_stream_verify_handle_t s)
+{
+    esp_image_metadata_t *data = &s->data;
+    esp_image_segment_header_t *header;
+
+    switch (s->state) {
+    case STREAM_IMAGE_HEADER:
+        memcpy(&data->image, s->buf, sizeof(esp_image_header_t));
+        if (verify_image_header(data->start_addr, &data->image, false) != ESP_OK) {
+            return ESP_ERR_IMAGE_INVALID;
+        }
+        if (data->image.segment_count > ESP_IMAGE_MAX_SEGMENTS) {
+            ESP_LOGE(TAG, "image at 0x%x segment count %d exceeds max %d",
+                     data->start_addr, data->image.segment_count, ESP_IMAGE_MAX_SEGMENTS);
+            return ESP_ERR_IMAGE_INVALID;
+        }
+#ifndef SECURE_BOOT_CHECK_SIGNATURE
+        if (data->image.hash_appended)
+#endif
+        {
+            s->sha_handle = bootloader_sha256_start();
+            if (s->sha_handle == NULL) {
+                return ESP_ERR_NO_MEM;
+            }
+            bootloader_sha256_data(s->sha_handle, &data->image, sizeof(esp_image_header_t));
+        }
+        stream_next_segment(s);
+        break;
+
+    case STREAM_SEGMENT_HEADER:
+        header = &data->segments[s->segment];
+        memcpy(header, s->buf, sizeof(esp_image_segment_header_t));
+        data->segment_data[s->segment] = data->start_addr + s->offset;
+        if (verify_segment_header(s->segment, header, data->segment_data[s->segment], false) != ESP_OK) {
+            return ESP_ERR_IMAGE_INVALID;
+        }
+        ESP_LOGD(TAG, "segment %d: paddr=0x%08x vaddr=0x%08x size=0x%05x (%6d)",
+                 s->segment, data->segment_data[s->segment], header->load_addr, header->data_len, header->data_len);
+        stream_set_state(s, STREAM_SEGMENT_DATA, header->data_len);
+        break;
+
+    case STREAM_SEGMENT_DATA:
+        s->segment++;
+        stream_next_segment(s);
+        break;
+
+    case STREAM_CHECKSUM: {
+        uint8_t calc = s->buf[s->buf_len - 1];
+        uint8_t checksum = (s->checksum_word >> 24)
+                           ^ (s->checksum_word >> 16)
+                           ^ (s->checksum_word >> 8)
+                           ^ (s->checksum_word >> 0);
+        if (checksum != calc && !esp_cpu_in_ocd_debug_mode()) {
+            ESP_LOGE(TAG, "Checksum failed. Calculated 0x%x read 0x%x", checksum, calc);
+            return ESP_ERR_IMAGE_INVALID;
+        }
+        data->image_len = s->offset;
+#ifndef SECURE_BOOT_CHECK_SIGNATURE
+        // The simple hash covers the image up to here, the signature also covers the simple hash
+        stream_finish_hash(s);
+#endif
+        if (data->image.hash_appended) {
+            data->image_len += HASH_LEN;
+            stream_set_state(s, STREAM_HASH, HASH_LEN);
+        } else {
+            stream_after_hash(s);
+        }
+        break;
+    }
+
+    case STREAM_HASH:
+        memcpy(data->image_digest, s->buf, HASH_LEN);
+        stream_after_hash(s);
+        break;
+
+    case STREAM_SIGNATURE_PAD:
+        stream_set_state(s, STREAM_DONE, 0);
+        break;
+
+    default:
+        break;
+    }
+
+    if (s->state_end > s->part.size) {
+        ESP_LOGE(TAG, "Image length %d doesn't fit in partition length %d", s->state_end, s->part.size);
+        return ESP_ERR_IMAGE_INVALID;
+    }
+    if (s->state == STREAM_DONE) {
+        stream_finish_hash(s);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_image_stream_verify_begin(const esp_partition_pos_t *part, esp_image_stream_verify_handle_t *out_handle)
+{
+    if (part == NULL || out_handle == NULL || part->size > SIXTEEN_MB) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_image_stream_verify_handle_t s = calloc(1, sizeof(struct esp_image_stream_verify));
+    if (s == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    s->part = *part;
+    s->data.start_addr = part->offset;
+    s->checksum_word = ESP_ROM_CHECKSUM_INITIAL;
+    stream_set_state(s, STREAM_IMAGE_HEADER, sizeof(esp_image_header_t));
+    *out_handle = s;
+    return ESP_OK;
+}
+
+esp_err_t esp_image_stream_verify_data(esp_image_stream_verify_handle_t s, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (len > 0 && s->state != STREAM_DONE && s->state != STREAM_FAILED) {
+        size_t n = MIN(len, s->state_end - s->offset);
+
+        if (s->state == STREAM_SEGMENT_DATA) {
+            stream_checksum(&s->checksum_word, p, n);
+        } else if (s->state != STREAM_SIGNATURE_PAD) {
+            memcpy(s->buf + s->buf_len, p, n);
+            s->buf_len += n;
+        }
+        if (s->sha_handle != NULL) {
+            bootloader_sha256_data(s->sha_handle, p, n);
+        }
+        s->offset += n;
+        p += n;
+        len -= n;
+
+        // zero length segments complete without further data
+        while (s->offset == s->state_end && s->state != STREAM_DONE) {
+            if (stream_next_state(s) != ESP_OK) {
+                s->state = STREAM_FAILED;
+                break;
+            }
+        }
+    }
+
+    return (s->state == STREAM_FAILED) ? ESP_ERR_IMAGE_INVALID : ESP_OK;
+}
+
+esp_err_t esp_image_stream_verify_end(esp_image_stream_verify_handle_t s, esp_image_metadata_t *data)
+{
+    esp_err_t err = ESP_ERR_IMAGE_INVALID;
+
+    if (s->state == STREAM_FAILED) {
+        goto err;
+    }
+    if (s->state != STREAM_DONE) {
+        ESP_LOGE(TAG, "Image incomplete, %d bytes written", s->offset);
+        goto err;
+    }
+
+#ifdef SECURE_BOOT_CHECK_SIGNATURE
+    uint8_t verified_digest[HASH_LEN] = { [ 0 ... 31 ] = 0x01 };
+    ESP_LOGI(TAG, "Verifying image signature...");
+    bootloader_debug_buffer(s->digest, HASH_LEN, "Calculated secure boot hash");
+#if CONFIG_SECURE_SIGNED_APPS_RSA_SCHEME
+    // The signature follows the padding to the next flash sector
+    err = verify_signature_block(s->data.start_addr + s->offset, s->digest, verified_digest);
+    s->data.image_len = s->offset + sizeof(ets_secure_boot_signature_t);
+#else
+    err = verify_signature_block(s->data.start_addr + s->data.image_len, s->digest, verified_digest);
+#endif
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Secure boot signature verification failed");
+        err = ESP_ERR_IMAGE_INVALID;
+        goto err;
+    }
+#else
+    if (s->data.image.hash_appended && !esp_cpu_in_ocd_debug_mode()) {
+        bootloader_debug_buffer(s->digest, HASH_LEN, "Calculated hash");
+        if (memcmp(s->digest, s->data.image_digest, HASH_LEN) != 0) {
+            ESP_LOGE(TAG, "Image hash failed - image is corrupt");
+            bootloader_debug_buffer(s->data.image_digest, HASH_LEN, "Expected hash");
+            goto err;
+        }
+    }
+    err = ESP_OK;
+#endif
+
+    if (data != NULL) {
+        memcpy(data, &s->data, sizeof(esp_image_metadata_t));
+    }
+
+err:
+    if (s->sha_handle != NULL) {
+        // Need to finish the hash process to free the handle
+        bootloader_sha256_finish(s->sha_handle, NULL);
+    }
+    free(s);
+    return err;
+}
+
+#endif // BOOTLOADER_BUILD
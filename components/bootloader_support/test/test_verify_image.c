@@ -4,6 +4,9 @@
 
 #include <esp_types.h>
 #include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/param.h>
 #include "string.h"
 
 #include "freertos/FreeRTOS.h"
@@ -48,6 +51,128 @@ TEST_CASE("Verify unit test app image", "[bootloader_support]")
     TEST_ASSERT_NOT_EQUAL(0, data.image_len);
     TEST_ASSERT_TRUE(data.image_len <= running->size);
 }
+
+/* Byte of the image to flip while it is passed to the streaming verifier */
+typedef struct {
+    uint32_t offset;
+    uint8_t xor;
+} image_corruption_t;
+
+/* Metadata of the running app as found by esp_image_verify() */
+static esp_image_metadata_t running_app_metadata(void)
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    TEST_ASSERT_NOT_EQUAL(NULL, running);
+    const esp_partition_pos_t running_pos  = {
+        .offset = running->address,
+        .size = running->size,
+    };
+    esp_image_metadata_t data = { 0 };
+    TEST_ASSERT_EQUAL_HEX(ESP_OK, esp_image_verify(ESP_IMAGE_VERIFY, &running_pos, &data));
+    return data;
+}
+
+/* Pass the running app to the streaming verifier in odd sized chunks, as esp_ota_write() would,
+ * with up to two bytes corrupted on the way. Returns the first error. */
+static esp_err_t stream_verify_running_app(const image_corruption_t *corrupt, size_t corrupt_count, esp_image_metadata_t *out_data)
+{
+    const size_t chunk = 1000;
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    const esp_partition_pos_t running_pos  = {
+        .offset = running->address,
+        .size = running->size,
+    };
+    esp_image_metadata_t data = running_app_metadata();
+
+    uint8_t *buf = malloc(chunk);
+    TEST_ASSERT_NOT_NULL(buf);
+    esp_image_stream_verify_handle_t handle;
+    TEST_ASSERT_EQUAL_HEX(ESP_OK, esp_image_stream_verify_begin(&running_pos, &handle));
+
+    esp_err_t err = ESP_OK;
+    for (uint32_t offset = 0; offset < data.image_len && err == ESP_OK; offset += chunk) {
+        size_t len = MIN(chunk, data.image_len - offset);
+        TEST_ASSERT_EQUAL_HEX(ESP_OK, esp_partition_read(running, offset, buf, len));
+        for (size_t i = 0; i < corrupt_count; i++) {
+            if (corrupt[i].offset >= offset && corrupt[i].offset < offset + len) {
+                buf[corrupt[i].offset - offset] ^= corrupt[i].xor;
+            }
+        }
+        err = esp_image_stream_verify_data(handle, buf, len);
+    }
+    esp_err_t end_err = esp_image_stream_verify_end(handle, out_data);
+    free(buf);
+    return (err != ESP_OK) ? err : end_err;
+}
+
+TEST_CASE("Streaming verification of unit test app image agrees with esp_image_verify", "[bootloader_support]")
+{
+    esp_image_metadata_t expected = running_app_metadata();
+    esp_image_metadata_t data = { 0 };
+
+    TEST_ASSERT_EQUAL_HEX(ESP_OK, stream_verify_running_app(NULL, 0, &data));
+    TEST_ASSERT_EQUAL_HEX(expected.start_addr, data.start_addr);
+    TEST_ASSERT_EQUAL(expected.image_len, data.image_len);
+    TEST_ASSERT_EQUAL_MEMORY(&expected.image, &data.image, sizeof(esp_image_header_t));
+    TEST_ASSERT_EQUAL_MEMORY(expected.segments, data.segments, sizeof(expected.segments));
+    TEST_ASSERT_EQUAL_MEMORY(expected.segment_data, data.segment_data, sizeof(expected.segment_data));
+    if (expected.image.hash_appended) {
+        TEST_ASSERT_EQUAL_MEMORY(expected.image_digest, data.image_digest, sizeof(expected.image_digest));
+    }
+}
+
+TEST_CASE("Streaming verification detects a corrupted segment", "[bootloader_support]")
+{
+    esp_image_metadata_t expected = running_app_metadata();
+    const int last = expected.image.segment_count - 1;
+
+    /* Segment data, caught by the checksum */
+    image_corruption_t data_byte = {
+        .offset = expected.segment_data[last] - expected.start_addr + expected.segments[last].data_len / 2,
+        .xor = 0x10,
+    };
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_IMAGE_INVALID, stream_verify_running_app(&data_byte, 1, NULL));
+
+    /* Segment header, its length makes the image overrun the partition */
+    image_corruption_t header_byte = {
+        .offset = expected.segment_data[last] - expected.start_addr
+                  - sizeof(esp_image_segment_header_t) + offsetof(esp_image_segment_header_t, data_len) + 3,
+        .xor = 0x80,
+    };
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_IMAGE_INVALID, stream_verify_running_app(&header_byte, 1, NULL));
+}
+
+TEST_CASE("Streaming verification detects a bad checksum", "[bootloader_support]")
+{
+    esp_image_metadata_t expected = running_app_metadata();
+    const int last = expected.image.segment_count - 1;
+    uint32_t end = expected.segment_data[last] - expected.start_addr + expected.segments[last].data_len;
+
+    image_corruption_t checksum = {
+        .offset = ((end + 1 + 15) & ~15) - 1,
+        .xor = 0x01,
+    };
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_IMAGE_INVALID, stream_verify_running_app(&checksum, 1, NULL));
+}
+
+TEST_CASE("Streaming verification detects a hash or signature mismatch", "[bootloader_support]")
+{
+    esp_image_metadata_t expected = running_app_metadata();
+#ifndef CONFIG_SECURE_SIGNED_ON_UPDATE
+    if (!expected.image.hash_appended) {
+        TEST_IGNORE_MESSAGE("app has no SHA-256 appended");
+    }
+#endif
+    const int last = expected.image.segment_count - 1;
+    uint32_t offset = expected.segment_data[last] - expected.start_addr;
+
+    /* Flipping the same bit in two bytes of a segment keeps the checksum, so only the digest differs */
+    image_corruption_t same_checksum[2] = {
+        { .offset = offset, .xor = 0x04 },
+        { .offset = offset + 1, .xor = 0x04 },
+    };
+    TEST_ASSERT_EQUAL_HEX(ESP_ERR_IMAGE_INVALID, stream_verify_running_app(same_checksum, 2, NULL));
+}
 #endif
 
 void check_label_search (int num_test, const char *list, const char *t_label, bool result)
@@ -37,6 +37,45 @@
 #define UC_BT_STACK_NO_LOG               FALSE
 #endif
 
+//OSI HASH MAP
+#ifdef CONFIG_BT_OSI_HASH_MAP_OPEN_ADDRESSING
+#define UC_BT_OSI_HASH_MAP_OPEN_ADDRESSING      CONFIG_BT_OSI_HASH_MAP_OPEN_ADDRESSING
+#else
+#define UC_BT_OSI_HASH_MAP_OPEN_ADDRESSING      FALSE
+#endif
+
+//OSI FIXED QUEUE
+#ifdef CONFIG_BT_OSI_FIXED_QUEUE_RING
+#define UC_BT_OSI_FIXED_QUEUE_RING              CONFIG_BT_OSI_FIXED_QUEUE_RING
+#else
+#define UC_BT_OSI_FIXED_QUEUE_RING              FALSE
+#endif
+
+//OSI BUFFER POOLS
+#ifdef CONFIG_BT_OSI_BUF_POOL
+#define UC_BT_OSI_BUF_POOL                      CONFIG_BT_OSI_BUF_POOL
+#else
+#define UC_BT_OSI_BUF_POOL                      FALSE
+#endif
+
+#ifdef CONFIG_BT_OSI_BUF_POOL_SMALL_NUM
+#define UC_BT_OSI_BUF_POOL_SMALL_NUM            CONFIG_BT_OSI_BUF_POOL_SMALL_NUM
+#else
+#define UC_BT_OSI_BUF_POOL_SMALL_NUM            16
+#endif
+
+#ifdef CONFIG_BT_OSI_BUF_POOL_MEDIUM_NUM
+#define UC_BT_OSI_BUF_POOL_MEDIUM_NUM           CONFIG_BT_OSI_BUF_POOL_MEDIUM_NUM
+#else
+#define UC_BT_OSI_BUF_POOL_MEDIUM_NUM           16
+#endif
+
+#ifdef CONFIG_BT_OSI_BUF_POOL_LARGE_NUM
+#define UC_BT_OSI_BUF_POOL_LARGE_NUM            CONFIG_BT_OSI_BUF_POOL_LARGE_NUM
+#else
+#define UC_BT_OSI_BUF_POOL_LARGE_NUM            4
+#endif
+
 /**********************************************************
  * Thread/Task reference
  **********************************************************/
@@ -142,6 +142,17 @@ void osi_mem_dbg_show(void)
     }
     OSI_TRACE_ERROR("--> count %d\n", mem_dbg_count);
     OSI_TRACE_ERROR("--> size %dB\n--> max size %dB\n", mem_dbg_current_size, mem_dbg_max_size);
+
+#if UC_BT_OSI_BUF_POOL
+    for (i = 0; i < OSI_POOL_NUM_CLASSES; i++) {
+        osi_pool_stats_t stats;
+
+        osi_pool_get_stats(i, &stats);
+        OSI_TRACE_ERROR("--> pool %dB: used %d/%d, max used %d, allocs %d, misses %d\n",
+                        stats.block_size, stats.used, stats.block_num, stats.max_used,
+                        stats.alloc_count, stats.miss_count);
+    }
+#endif
 }
 
 uint32_t osi_mem_dbg_get_max_size(void)
@@ -253,6 +264,11 @@ void *osi_calloc_func(size_t size)
 
 void osi_free_func(void *ptr)
 {
+#if UC_BT_OSI_BUF_POOL
+    if (osi_pool_free(ptr)) {
+        return;
+    }
+#endif
 #if HEAP_MEMORY_DEBUG
     osi_mem_dbg_clean(ptr, __func__, __LINE__);
 #endif
@@ -19,6 +19,7 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,7 +31,17 @@
 
 #define CONFIG_FILE_MAX_SIZE             (1536)//1.5k
 #define CONFIG_FILE_DEFAULE_LENGTH       (2048)
-#define CONFIG_KEY                       "bt_cfg_key"
+#define CONFIG_KEY                       "bt_cfg_key"   // text format of previous versions, only read for migration
+
+// Each section is stored as a binary blob "bt_cfg_s<slot>" holding its entries as
+// (key length:1, value length:2, key, value) records. The index blob lists the
+// sections in order as (slot:1, name length:1, name) records.
+#define CONFIG_INDEX_KEY                 "bt_cfg_idx"
+#define CONFIG_SECTION_KEY               "bt_cfg_s"
+#define CONFIG_SECTION_KEY_SIZE          (sizeof(CONFIG_SECTION_KEY) + 3)
+#define CONFIG_SLOT_MAX                  (256)
+#define CONFIG_SLOT_NONE                 (-1)
+
 typedef struct {
     char *key;
     char *value;
@@ -39,20 +50,31 @@ typedef struct {
 typedef struct {
     char *name;
     list_t *entries;
+    int slot;           // blob slot of the section, CONFIG_SLOT_NONE if not stored yet
+    bool loaded;        // entries have been read from NVS
+    bool dirty;         // entries changed since the section was stored
 } section_t;
 
 struct config_t {
     list_t *sections;
+    char *filename;     // NVS namespace the sections are stored in, NULL if not stored
+    bool index_dirty;   // sections added or removed since the index was stored
+    uint8_t erase_slots[CONFIG_SLOT_MAX / 8];   // slots of removed sections
 };
 
 // Empty definition; this type is aliased to list_node_t.
 struct config_section_iter_t {};
 
+static int get_config_size_from_flash(nvs_handle_t fp);
 static void config_parse(nvs_handle_t fp, config_t *config);
+static bool config_load_index(nvs_handle_t fp, config_t *config);
+static bool config_store(config_t *config, nvs_handle_t fp);
+static void config_erase_text(nvs_handle_t fp);
 
 static section_t *section_new(const char *name);
 static void section_free(void *ptr);
 static section_t *section_find(const config_t *config, const char *section);
+static bool section_load(const config_t *config, section_t *sec);
 
 static entry_t *entry_new(const char *key, const char *value);
 static void entry_free(void *ptr);
@@ -102,7 +124,26 @@ config_t *config_new(const char *filename)
         return NULL;
     }
 
-    config_parse(fp, config);
+    config->filename = osi_strdup(filename);
+    if (!config->filename) {
+        nvs_close(fp);
+        config_free(config);
+        return NULL;
+    }
+
+    if (config_load_index(fp, config)) {
+        // A migration may have been interrupted before the text was erased
+        config_erase_text(fp);
+    } else if (get_config_size_from_flash(fp) > 0) {
+        // Migrate the text format of previous versions, the text is only erased
+        // once the sections and the index have been stored.
+        OSI_TRACE_WARNING("%s migrating config to binary sections\n", __func__);
+        config_parse(fp, config);
+        if (config_store(config, fp)) {
+            config_erase_text(fp);
+        }
+    }
+
     nvs_close(fp);
     return config;
 }
@@ -114,6 +155,7 @@ void config_free(config_t *config)
     }
 
     list_free(config->sections);
+    osi_free(config->filename);
     osi_free(config);
 }
 
@@ -138,7 +180,10 @@ bool config_has_key_in_section(config_t *config, const char *key, char *key_valu
 {
     OSI_TRACE_DEBUG("key = %s, value = %s", key, key_value);
     for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
-        const section_t *section = (const section_t *)list_node(node);
+        section_t *section = (section_t *)list_node(node);
+        if (!section_load(config, section)) {
+            continue;
+        }
 
         for (const list_node_t *node = list_begin(section->entries); node != list_end(section->entries); node = list_next(node)) {
             entry_t *entry = list_node(node);
@@ -234,19 +279,28 @@ void config_set_string(config_t *config, const char *section, const char *key, c
         } else {
             list_prepend(config->sections, sec);
         }
+        config->index_dirty = true;
+    } else if (!section_load(config, sec)) {
+        // Changing a section which could not be read would lose its other entries
+        OSI_TRACE_ERROR("%s unable to set %s in section %s\n", __func__, key, section);
+        return;
     }
 
     for (const list_node_t *node = list_begin(sec->entries); node != list_end(sec->entries); node = list_next(node)) {
         entry_t *entry = list_node(node);
         if (!strcmp(entry->key, key)) {
-            osi_free(entry->value);
-            entry->value = osi_strdup(value);
+            if (strcmp(entry->value, value)) {
+                osi_free(entry->value);
+                entry->value = osi_strdup(value);
+                sec->dirty = true;
+            }
             return;
         }
     }
 
     entry_t *entry = entry_new(key, value);
     list_append(sec->entries, entry);
+    sec->dirty = true;
 }
 
 bool config_remove_section(config_t *config, const char *section)
@@ -259,6 +313,11 @@ bool config_remove_section(config_t *config, const char *section)
         return false;
     }
 
+    if (sec->slot != CONFIG_SLOT_NONE) {
+        config->erase_slots[sec->slot / 8] |= 1 << (sec->slot % 8);
+    }
+    config->index_dirty = true;
+
     return list_remove(config->sections, sec);
 }
 
@@ -274,6 +333,7 @@ bool config_remove_key(config_t *config, const char *section, const char *key)
         return false;
     }
 
+    sec->dirty = true;
     return list_remove(sec->entries, entry);
 }
 
@@ -303,34 +363,6 @@ const char *config_section_name(const config_section_node_t *node)
     return section->name;
 }
 
-static int get_config_size(const config_t *config)
-{
-    assert(config != NULL);
-
-    int w_len = 0, total_size = 0;
-
-    for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
-        const section_t *section = (const section_t *)list_node(node);
-        w_len = strlen(section->name) + strlen("[]\n");// format "[section->name]\n"
-        total_size += w_len;
-
-        for (const list_node_t *enode = list_begin(section->entries); enode != list_end(section->entries); enode = list_next(enode)) {
-            const entry_t *entry = (const entry_t *)list_node(enode);
-            w_len = strlen(entry->key) + strlen(entry->value) + strlen(" = \n");// format "entry->key = entry->value\n"
-            total_size += w_len;
-        }
-
-        // Only add a separating newline if there are more sections.
-        if (list_next(node) != list_end(config->sections)) {
-                total_size ++;  //'\n'
-        } else {
-            break;
-        }
-    }
-    total_size ++; //'\0'
-    return total_size;
-}
-
 static int get_config_size_from_flash(nvs_handle_t fp)
 {
     assert(fp != 0);
@@ -376,137 +408,352 @@ static int get_config_size_from_flash(nvs_handle_t fp)
     return total_length;
 }
 
-bool config_save(const config_t *config, const char *filename)
+static void section_key(char *keyname, int slot)
 {
-    assert(config != NULL);
-    assert(filename != NULL);
-    assert(*filename != '\0');
+    snprintf(keyname, CONFIG_SECTION_KEY_SIZE, "%s%d", CONFIG_SECTION_KEY, slot);
+}
+
+// Reads the index of the binary format. The sections are created without their
+// entries, which are read on first use. Returns false if there is no index.
+static bool config_load_index(nvs_handle_t fp, config_t *config)
+{
+    size_t length = 0;
+    esp_err_t err = nvs_get_blob(fp, CONFIG_INDEX_KEY, NULL, &length);
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_NVS_NOT_FOUND) {
+            OSI_TRACE_ERROR("%s, error %d\n", __func__, err);
+        }
+        return false;
+    }
+
+    uint8_t *buf = osi_malloc(length);
+    char *name = osi_malloc(UINT8_MAX + 1);
+    if (!buf || !name || nvs_get_blob(fp, CONFIG_INDEX_KEY, buf, &length) != ESP_OK) {
+        OSI_TRACE_ERROR("%s unable to read the config index\n", __func__);
+        osi_free(buf);
+        osi_free(name);
+        return false;
+    }
+
+    for (size_t pos = 0; pos + 2 <= length && pos + 2 + buf[pos + 1] <= length; pos += 2 + buf[pos + 1]) {
+        memcpy(name, &buf[pos + 2], buf[pos + 1]);
+        name[buf[pos + 1]] = '\0';
+
+        section_t *sec = section_new(name);
+        if (!sec) {
+            break;
+        }
+        sec->slot = buf[pos];
+        sec->loaded = false;
+        sec->dirty = false;
+        list_append(config->sections, sec);
+    }
+
+    osi_free(buf);
+    osi_free(name);
+    return true;
+}
+
+// Reads the entries of a section stored in the binary format. Returns false if
+// they could not be read, the section is then left unloaded and read again on
+// next use.
+static bool section_load(const config_t *config, section_t *sec)
+{
+    if (sec->loaded) {
+        return true;
+    }
 
-    esp_err_t err;
-    int err_code = 0;
     nvs_handle_t fp;
-    char *line = osi_calloc(1024);
-    const size_t keyname_bufsz = sizeof(CONFIG_KEY) + 5 + 1; // including log10(sizeof(i))
-    char *keyname = osi_calloc(keyname_bufsz);
-    int config_size = get_config_size(config);
-    char *buf = osi_calloc(config_size);
-    if (!line || !buf || !keyname) {
-        err_code |= 0x01;
-        goto error;
+    char keyname[CONFIG_SECTION_KEY_SIZE];
+    size_t length = 0;
+    uint8_t *buf = NULL;
+    esp_err_t err;
+
+    if (nvs_open(config->filename, NVS_READONLY, &fp) != ESP_OK) {
+        OSI_TRACE_ERROR("%s unable to open NVS namespace '%s'\n", __func__, config->filename);
+        return false;
     }
 
-    err = nvs_open(filename, NVS_READWRITE, &fp);
-    if (err != ESP_OK) {
-        if (err == ESP_ERR_NVS_NOT_INITIALIZED) {
-            OSI_TRACE_ERROR("%s: NVS not initialized. "
-                      "Call nvs_flash_init before initializing bluetooth.", __func__);
+    section_key(keyname, sec->slot);
+    err = nvs_get_blob(fp, keyname, NULL, &length);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        // Empty sections are not stored
+        sec->loaded = true;
+        goto done;
+    }
+
+    buf = (err == ESP_OK) ? osi_malloc(length) : NULL;
+    if (!buf || nvs_get_blob(fp, keyname, buf, &length) != ESP_OK) {
+        OSI_TRACE_ERROR("%s unable to read section %s\n", __func__, sec->name);
+        goto done;
+    }
+
+    size_t pos = 0;
+    while (pos + 3 <= length) {
+        size_t key_len = buf[pos];
+        size_t value_len = buf[pos + 1] | (buf[pos + 2] << 8);
+        if (pos + 3 + key_len + value_len > length) {
+            OSI_TRACE_WARNING("%s section %s truncated\n", __func__, sec->name);
+            break;
         }
-        err_code |= 0x02;
-        goto error;
+        entry_t *entry = osi_calloc(sizeof(entry_t));
+        if (!entry) {
+            goto done;
+        }
+        entry->key = osi_malloc(key_len + 1);
+        entry->value = osi_malloc(value_len + 1);
+        if (!entry->key || !entry->value) {
+            entry_free(entry);
+            goto done;
+        }
+        memcpy(entry->key, &buf[pos + 3], key_len);
+        entry->key[key_len] = '\0';
+        memcpy(entry->value, &buf[pos + 3 + key_len], value_len);
+        entry->value[value_len] = '\0';
+        list_append(sec->entries, entry);
+        pos += 3 + key_len + value_len;
+    }
+    sec->loaded = true;
+
+done:
+    if (!sec->loaded) {
+        list_clear(sec->entries);
+    }
+    nvs_close(fp);
+    osi_free(buf);
+    return sec->loaded;
+}
+
+static esp_err_t section_store(nvs_handle_t fp, const section_t *sec)
+{
+    char keyname[CONFIG_SECTION_KEY_SIZE];
+    size_t length = 0;
+    esp_err_t err;
+
+    section_key(keyname, sec->slot);
+
+    for (const list_node_t *node = list_begin(sec->entries); node != list_end(sec->entries); node = list_next(node)) {
+        const entry_t *entry = list_node(node);
+        length += 3 + strlen(entry->key) + strlen(entry->value);
+    }
+
+    if (length == 0) {
+        err = nvs_erase_key(fp, keyname);
+        return (err == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : err;
+    }
+
+    uint8_t *buf = osi_malloc(length);
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t pos = 0;
+    for (const list_node_t *node = list_begin(sec->entries); node != list_end(sec->entries); node = list_next(node)) {
+        const entry_t *entry = list_node(node);
+        size_t key_len = strlen(entry->key);
+        size_t value_len = strlen(entry->value);
+        if (key_len > UINT8_MAX || value_len > UINT16_MAX) {
+            OSI_TRACE_ERROR("%s, entry %s of section %s too long\n", __func__, entry->key, sec->name);
+            osi_free(buf);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        buf[pos] = key_len;
+        buf[pos + 1] = value_len & 0xff;
+        buf[pos + 2] = value_len >> 8;
+        memcpy(&buf[pos + 3], entry->key, key_len);
+        memcpy(&buf[pos + 3 + key_len], entry->value, value_len);
+        pos += 3 + key_len + value_len;
     }
 
-    int w_cnt, w_cnt_total = 0;
+    err = nvs_set_blob(fp, keyname, buf, length);
+    osi_free(buf);
+    return err;
+}
+
+static esp_err_t index_store(nvs_handle_t fp, const config_t *config)
+{
+    size_t length = 0;
+    esp_err_t err;
+
     for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
-        const section_t *section = (const section_t *)list_node(node);
-        w_cnt = snprintf(line, 1024, "[%s]\n", section->name);
-        if(w_cnt < 0) {
-            OSI_TRACE_ERROR("snprintf error w_cnt %d.",w_cnt);
-            err_code |= 0x10;
-            goto error;
+        const section_t *sec = list_node(node);
+        length += 2 + strlen(sec->name);
+    }
+
+    if (length == 0) {
+        err = nvs_erase_key(fp, CONFIG_INDEX_KEY);
+        return (err == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : err;
+    }
+
+    uint8_t *buf = osi_malloc(length);
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t pos = 0;
+    for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
+        const section_t *sec = list_node(node);
+        size_t name_len = strlen(sec->name);
+        if (name_len > UINT8_MAX) {
+            osi_free(buf);
+            return ESP_ERR_INVALID_SIZE;
         }
-        if(w_cnt_total + w_cnt > config_size) {
-            OSI_TRACE_ERROR("%s, memcpy size (w_cnt + w_cnt_total = %d) is larger than buffer size (config_size = %d).", __func__, (w_cnt + w_cnt_total), config_size);
-            err_code |= 0x20;
-            goto error;
+        buf[pos] = sec->slot;
+        buf[pos + 1] = name_len;
+        memcpy(&buf[pos + 2], sec->name, name_len);
+        pos += 2 + name_len;
+    }
+
+    err = nvs_set_blob(fp, CONFIG_INDEX_KEY, buf, length);
+    osi_free(buf);
+    return err;
+}
+
+static int slot_alloc(const config_t *config)
+{
+    uint8_t used[CONFIG_SLOT_MAX / 8];
+
+    memcpy(used, config->erase_slots, sizeof(used));
+    for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
+        const section_t *sec = list_node(node);
+        if (sec->slot != CONFIG_SLOT_NONE) {
+            used[sec->slot / 8] |= 1 << (sec->slot % 8);
         }
-        OSI_TRACE_DEBUG("section name: %s, w_cnt + w_cnt_total = %d\n", section->name, w_cnt + w_cnt_total);
-        memcpy(buf + w_cnt_total, line, w_cnt);
-        w_cnt_total += w_cnt;
-
-        for (const list_node_t *enode = list_begin(section->entries); enode != list_end(section->entries); enode = list_next(enode)) {
-            const entry_t *entry = (const entry_t *)list_node(enode);
-            OSI_TRACE_DEBUG("(key, val): (%s, %s)\n", entry->key, entry->value);
-            w_cnt = snprintf(line, 1024, "%s = %s\n", entry->key, entry->value);
-            if(w_cnt < 0) {
-                OSI_TRACE_ERROR("snprintf error w_cnt %d.",w_cnt);
-                err_code |= 0x10;
-                goto error;
-            }
-            if(w_cnt_total + w_cnt > config_size) {
-                OSI_TRACE_ERROR("%s, memcpy size (w_cnt + w_cnt_total = %d) is larger than buffer size.(config_size = %d)", __func__, (w_cnt + w_cnt_total), config_size);
-                err_code |= 0x20;
-                goto error;
-            }
-            OSI_TRACE_DEBUG("%s, w_cnt + w_cnt_total = %d", __func__, w_cnt + w_cnt_total);
-            memcpy(buf + w_cnt_total, line, w_cnt);
-            w_cnt_total += w_cnt;
+    }
+
+    for (int slot = 0; slot < CONFIG_SLOT_MAX; slot++) {
+        if (!(used[slot / 8] & (1 << (slot % 8)))) {
+            return slot;
         }
+    }
 
-        // Only add a separating newline if there are more sections.
-        if (list_next(node) != list_end(config->sections)) {
-            buf[w_cnt_total] = '\n';
-            w_cnt_total += 1;
-        } else {
-            break;
+    return CONFIG_SLOT_NONE;
+}
+
+// Writes the sections changed since the last store. The index is written last,
+// so that a store which is interrupted leaves the previous index valid.
+static bool config_store(config_t *config, nvs_handle_t fp)
+{
+    esp_err_t err;
+    char keyname[CONFIG_SECTION_KEY_SIZE];
+
+    for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
+        section_t *sec = list_node(node);
+        if (sec->slot == CONFIG_SLOT_NONE) {
+            sec->slot = slot_alloc(config);
+            if (sec->slot == CONFIG_SLOT_NONE) {
+                OSI_TRACE_ERROR("%s, no slot left for section %s\n", __func__, sec->name);
+                return false;
+            }
+            sec->dirty = true;
+            config->index_dirty = true;
         }
+        if (!sec->dirty) {
+            continue;
+        }
+        err = section_store(fp, sec);
+        if (err != ESP_OK) {
+            OSI_TRACE_ERROR("%s unable to store section %s, error %d\n", __func__, sec->name, err);
+            return false;
+        }
+        sec->dirty = false;
     }
-    buf[w_cnt_total] = '\0';
-    if (w_cnt_total < CONFIG_FILE_MAX_SIZE) {
-        snprintf(keyname, keyname_bufsz, "%s%d", CONFIG_KEY, 0);
-        err = nvs_set_blob(fp, keyname, buf, w_cnt_total);
+
+    if (config->index_dirty) {
+        err = index_store(fp, config);
         if (err != ESP_OK) {
-            nvs_close(fp);
-            err_code |= 0x04;
-            goto error;
+            OSI_TRACE_ERROR("%s unable to store the config index, error %d\n", __func__, err);
+            return false;
         }
-    }else {
-        int count = (w_cnt_total / CONFIG_FILE_MAX_SIZE);
-        assert(count <= 0xFF);
-        for (uint8_t i = 0; i <= count; i++)
-        {
-            snprintf(keyname, keyname_bufsz, "%s%d", CONFIG_KEY, i);
-            if (i == count) {
-                err = nvs_set_blob(fp, keyname, buf + i*CONFIG_FILE_MAX_SIZE, w_cnt_total - i*CONFIG_FILE_MAX_SIZE);
-                OSI_TRACE_DEBUG("save keyname = %s, i = %d, %d\n", keyname, i, w_cnt_total - i*CONFIG_FILE_MAX_SIZE);
-            }else {
-                err = nvs_set_blob(fp, keyname, buf + i*CONFIG_FILE_MAX_SIZE, CONFIG_FILE_MAX_SIZE);
-                OSI_TRACE_DEBUG("save keyname = %s, i = %d, %d\n", keyname, i, CONFIG_FILE_MAX_SIZE);
-            }
-            if (err != ESP_OK) {
-                nvs_close(fp);
-                err_code |= 0x04;
-                goto error;
+        config->index_dirty = false;
+    }
+
+    // Slots of removed sections are only erased once the index no longer refers to them
+    for (int slot = 0; slot < CONFIG_SLOT_MAX; slot++) {
+        if (config->erase_slots[slot / 8] & (1 << (slot % 8))) {
+            section_key(keyname, slot);
+            err = nvs_erase_key(fp, keyname);
+            if (err != ESP_OK && err != ESP_ERR_NVS_NOT_FOUND) {
+                OSI_TRACE_ERROR("%s unable to erase %s, error %d\n", __func__, keyname, err);
+                return false;
             }
+            config->erase_slots[slot / 8] &= ~(1 << (slot % 8));
         }
     }
 
-    err = nvs_commit(fp);
-    if (err != ESP_OK) {
-        nvs_close(fp);
-        err_code |= 0x08;
-        goto error;
-    }
+    return nvs_commit(fp) == ESP_OK;
+}
 
-    nvs_close(fp);
-    osi_free(line);
-    osi_free(buf);
-    osi_free(keyname);
-    return true;
+static void config_erase_text(nvs_handle_t fp)
+{
+    char keyname[sizeof(CONFIG_KEY) + 5 + 1];
 
-error:
-    if (buf) {
-        osi_free(buf);
+    uint16_t i;
+
+    for (i = 0; ; i++) {
+        snprintf(keyname, sizeof(keyname), "%s%d", CONFIG_KEY, i);
+        if (nvs_erase_key(fp, keyname) != ESP_OK) {
+            break;
+        }
     }
-    if (line) {
-        osi_free(line);
+    if (i > 0) {
+        nvs_commit(fp);
     }
-    if (keyname) {
-        osi_free(keyname);
+}
+
+bool config_save(config_t *config, const char *filename)
+{
+    assert(config != NULL);
+    assert(filename != NULL);
+    assert(*filename != '\0');
+
+    esp_err_t err;
+    nvs_handle_t fp;
+
+    err = nvs_open(filename, NVS_READWRITE, &fp);
+    if (err != ESP_OK) {
+        if (err == ESP_ERR_NVS_NOT_INITIALIZED) {
+            OSI_TRACE_ERROR("%s: NVS not initialized. "
+                      "Call nvs_flash_init before initializing bluetooth.", __func__);
+        }
+        OSI_TRACE_ERROR("%s unable to open NVS namespace '%s'\n", __func__, filename);
+        return false;
     }
-    if (err_code) {
-        OSI_TRACE_ERROR("%s, err_code: 0x%x\n", __func__, err_code);
+
+    if (!config->filename || strcmp(config->filename, filename)) {
+        // The namespace holds another config, replace it entirely
+        char *name = osi_strdup(filename);
+        if (!name) {
+            nvs_close(fp);
+            return false;
+        }
+        for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
+            if (!section_load(config, list_node(node))) {
+                osi_free(name);
+                nvs_close(fp);
+                return false;
+            }
+        }
+        for (const list_node_t *node = list_begin(config->sections); node != list_end(config->sections); node = list_next(node)) {
+            section_t *sec = list_node(node);
+            sec->slot = CONFIG_SLOT_NONE;
+        }
+        memset(config->erase_slots, 0, sizeof(config->erase_slots));
+        config->index_dirty = true;
+        osi_free(config->filename);
+        config->filename = name;
+
+        err = nvs_erase_all(fp);
+        if (err != ESP_OK) {
+            OSI_TRACE_ERROR("%s unable to erase NVS namespace '%s', error %d\n", __func__, filename, err);
+            nvs_close(fp);
+            return false;
+        }
     }
-    return false;
+
+    bool ret = config_store(config, fp);
+    nvs_close(fp);
+    return ret;
 }
 
 static char *trim(char *str)
@@ -645,6 +892,9 @@ static section_t *section_new(const char *name)
 
     section->name = osi_strdup(name);
     section->entries = list_new(entry_free);
+    section->slot = CONFIG_SLOT_NONE;
+    section->loaded = true;
+    section->dirty = true;
     return section;
 }
 
@@ -699,7 +949,7 @@ static void entry_free(void *ptr)
 static entry_t *entry_find(const config_t *config, const char *section, const char *key)
 {
     section_t *sec = section_find(config, section);
-    if (!sec) {
+    if (!sec || !section_load(config, sec)) {
         return NULL;
     }
 
@@ -16,6 +16,7 @@
  *
  ******************************************************************************/
 
+#include "bt_common.h"
 #include "osi/allocator.h"
 #include "osi/fixed_queue.h"
 #include "osi/list.h"
@@ -23,6 +24,23 @@
 #include "osi/mutex.h"
 #include "osi/semaphore.h"
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+#include <stdatomic.h>
+
+// Ring queues are bounded multi-producer multi-consumer rings: each slot has a
+// sequence number telling whether it is free for the enqueue at a position or
+// holds the element for the dequeue at that position. Positions are reserved
+// with a compare-and-swap, so neither side takes a lock. The only notification
+// primitive is the dequeue semaphore, which counts the published elements.
+typedef struct {
+    atomic_uint seq;
+    void *data;
+} fixed_queue_slot_t;
+
+// Times a ring is polled, yielding in between, before sleeping for a tick
+#define RING_POLL_YIELDS    16
+#endif
+
 typedef struct fixed_queue_t {
 
     list_t *list;
@@ -32,8 +50,155 @@ typedef struct fixed_queue_t {
     size_t capacity;
 
     fixed_queue_cb dequeue_ready;
+
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    fixed_queue_slot_t *ring;   // NULL for list backed queues
+    atomic_uint enqueue_pos;
+    atomic_uint dequeue_pos;
+#endif
 } fixed_queue_t;
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+static bool ring_push(fixed_queue_t *queue, void *data)
+{
+    unsigned int pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+
+    while (1) {
+        fixed_queue_slot_t *slot = &queue->ring[pos & (queue->capacity - 1)];
+        int diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                slot->data = data;
+                atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            // The slot still holds the element of the previous round, the ring is full
+            return false;
+        } else {
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+static void *ring_pop(fixed_queue_t *queue)
+{
+    unsigned int pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+
+    while (1) {
+        fixed_queue_slot_t *slot = &queue->ring[pos & (queue->capacity - 1)];
+        int diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) - (pos + 1));
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue_pos, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                void *data = slot->data;
+                atomic_store_explicit(&slot->seq, pos + queue->capacity, memory_order_release);
+                return data;
+            }
+        } else if (diff < 0) {
+            // Empty, or the head slot is not filled yet
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+static size_t ring_length(fixed_queue_t *queue)
+{
+    unsigned int dequeue_pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    unsigned int enqueue_pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+
+    return (size_t)(enqueue_pos - dequeue_pos);
+}
+
+static bool ring_enqueue(fixed_queue_t *queue, void *data, uint32_t timeout)
+{
+    uint32_t waited = 0;
+
+    // Producers are not notified of free space, a full ring is polled
+    for (int polls = 0; !ring_push(queue, data); polls++) {
+        if (timeout != FIXED_QUEUE_MAX_TIMEOUT && waited >= timeout) {
+            return false;
+        }
+        if (polls < RING_POLL_YIELDS) {
+            taskYIELD();
+        } else {
+            vTaskDelay(1);
+            waited += portTICK_PERIOD_MS;
+        }
+    }
+
+    osi_sem_give(&queue->dequeue_sem);
+    return true;
+}
+
+static void *ring_dequeue(fixed_queue_t *queue, uint32_t timeout)
+{
+    void *ret;
+
+    if (osi_sem_take(&queue->dequeue_sem, timeout) != 0) {
+        return NULL;
+    }
+
+    // An element was published, but the head slot may have been reserved by a
+    // producer which was preempted before filling it
+    for (int polls = 0; (ret = ring_pop(queue)) == NULL; polls++) {
+        if (polls < RING_POLL_YIELDS) {
+            taskYIELD();
+        } else {
+            vTaskDelay(1);
+        }
+    }
+
+    return ret;
+}
+
+fixed_queue_t *fixed_queue_new_ring(size_t capacity)
+{
+    fixed_queue_t *ret = osi_calloc(sizeof(fixed_queue_t));
+    if (!ret) {
+        return NULL;
+    }
+
+    ret->capacity = 1;
+    while (ret->capacity < capacity) {
+        ret->capacity <<= 1;
+    }
+
+    ret->ring = osi_malloc(sizeof(fixed_queue_slot_t) * ret->capacity);
+    if (!ret->ring) {
+        osi_free(ret);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < ret->capacity; i++) {
+        atomic_init(&ret->ring[i].seq, i);
+        ret->ring[i].data = NULL;
+    }
+    atomic_init(&ret->enqueue_pos, 0);
+    atomic_init(&ret->dequeue_pos, 0);
+
+    osi_sem_new(&ret->dequeue_sem, ret->capacity, 0);
+    if (!ret->dequeue_sem) {
+        goto error;
+    }
+
+    return ret;
+
+error:;
+    fixed_queue_free(ret, NULL);
+    return NULL;
+}
+#else
+fixed_queue_t *fixed_queue_new_ring(size_t capacity)
+{
+    return fixed_queue_new(capacity);
+}
+#endif /* UC_BT_OSI_FIXED_QUEUE_RING */
+
 
 fixed_queue_t *fixed_queue_new(size_t capacity)
 {
@@ -78,6 +243,24 @@ void fixed_queue_free(fixed_queue_t *queue, fixed_queue_free_cb free_cb)
 
     fixed_queue_unregister_dequeue(queue);
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    if (queue->ring) {
+        void *data;
+
+        while ((data = ring_pop(queue)) != NULL) {
+            if (free_cb) {
+                free_cb(data);
+            }
+        }
+        osi_free(queue->ring);
+        if (queue->dequeue_sem) {
+            osi_sem_free(&queue->dequeue_sem);
+        }
+        osi_free(queue);
+        return;
+    }
+#endif
+
     if (free_cb) {
         for (node = list_begin(queue->list); node != list_end(queue->list); node = list_next(node)) {
             free_cb(list_node(node));
@@ -99,6 +282,12 @@ bool fixed_queue_is_empty(fixed_queue_t *queue)
         return true;
     }
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    if (queue->ring) {
+        return ring_length(queue) == 0;
+    }
+#endif
+
     osi_mutex_lock(&queue->lock, OSI_MUTEX_MAX_TIMEOUT);
     is_empty = list_is_empty(queue->list);
     osi_mutex_unlock(&queue->lock);
@@ -114,6 +303,12 @@ size_t fixed_queue_length(fixed_queue_t *queue)
         return 0;
     }
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    if (queue->ring) {
+        return ring_length(queue);
+    }
+#endif
+
     osi_mutex_lock(&queue->lock, OSI_MUTEX_MAX_TIMEOUT);
     length = list_length(queue->list);
     osi_mutex_unlock(&queue->lock);
@@ -134,6 +329,12 @@ bool fixed_queue_enqueue(fixed_queue_t *queue, void *data, uint32_t timeout)
     assert(queue != NULL);
     assert(data != NULL);
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    if (queue->ring) {
+        return ring_enqueue(queue, data, timeout);
+    }
+#endif
+
     if (osi_sem_take(&queue->enqueue_sem, timeout) != 0) {
         return false;
     }
@@ -154,6 +355,12 @@ void *fixed_queue_dequeue(fixed_queue_t *queue, uint32_t timeout)
 
     assert(queue != NULL);
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    if (queue->ring) {
+        return ring_dequeue(queue, timeout);
+    }
+#endif
+
     if (osi_sem_take(&queue->dequeue_sem, timeout) != 0) {
         return NULL;
     }
@@ -176,6 +383,18 @@ void *fixed_queue_try_peek_first(fixed_queue_t *queue)
         return NULL;
     }
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    if (queue->ring) {
+        unsigned int pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        fixed_queue_slot_t *slot = &queue->ring[pos & (queue->capacity - 1)];
+
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) == pos + 1) {
+            ret = slot->data;
+        }
+        return ret;
+    }
+#endif
+
     osi_mutex_lock(&queue->lock, OSI_MUTEX_MAX_TIMEOUT);
     ret = list_is_empty(queue->list) ? NULL : list_front(queue->list);
     osi_mutex_unlock(&queue->lock);
@@ -191,6 +410,14 @@ void *fixed_queue_try_peek_last(fixed_queue_t *queue)
         return NULL;
     }
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    // Not supported by ring queues
+    assert(queue->ring == NULL);
+    if (queue->ring) {
+        return NULL;
+    }
+#endif
+
     osi_mutex_lock(&queue->lock, OSI_MUTEX_MAX_TIMEOUT);
     ret = list_is_empty(queue->list) ? NULL : list_back(queue->list);
     osi_mutex_unlock(&queue->lock);
@@ -206,6 +433,14 @@ void *fixed_queue_try_remove_from_queue(fixed_queue_t *queue, void *data)
         return NULL;
     }
 
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    // Not supported by ring queues
+    assert(queue->ring == NULL);
+    if (queue->ring) {
+        return NULL;
+    }
+#endif
+
     osi_mutex_lock(&queue->lock, OSI_MUTEX_MAX_TIMEOUT);
     if (list_contains(queue->list, data) &&
             osi_sem_take(&queue->dequeue_sem, 0) == 0) {
@@ -225,6 +460,10 @@ void *fixed_queue_try_remove_from_queue(fixed_queue_t *queue, void *data)
 list_t *fixed_queue_get_list(fixed_queue_t *queue)
 {
     assert(queue != NULL);
+#if UC_BT_OSI_FIXED_QUEUE_RING
+    // Ring queues have no list
+    assert(queue->ring == NULL);
+#endif
 
     // NOTE: This function is not thread safe, and there is no point for
     // calling osi_mutex_lock() / osi_mutex_unlock()
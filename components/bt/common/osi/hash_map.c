@@ -21,6 +21,8 @@
 #include "osi/hash_map.h"
 #include "osi/allocator.h"
 
+#if !UC_BT_OSI_HASH_MAP_OPEN_ADDRESSING
+
 struct hash_map_t;
 
 typedef struct hash_map_bucket_t {
@@ -267,3 +269,5 @@ static bool default_key_equality(const void *x, const void *y)
 {
     return x == y;
 }
+
+#endif /* !UC_BT_OSI_HASH_MAP_OPEN_ADDRESSING */
@@ -0,0 +1,288 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "bt_common.h"
+#include "osi/hash_map.h"
+#include "osi/allocator.h"
+
+#if UC_BT_OSI_HASH_MAP_OPEN_ADDRESSING
+
+// Hash map with open addressing and linear probing. The elements are stored in
+// the slot table itself, a slot is empty if its data is NULL. The table is
+// grown to keep it at most 3/4 full, erased elements are replaced by moving
+// back the following elements of their probe sequence, so there are no
+// tombstones.
+
+#define HASH_MAP_MIN_CAPACITY   8
+
+typedef struct {
+    hash_map_entry_t entry;
+    uint32_t hash;
+} hash_map_slot_t;
+
+typedef struct hash_map_t {
+    hash_map_slot_t *slots;
+    size_t capacity;            // power of 2
+    size_t shift;               // 32 - log2(capacity)
+    size_t hash_size;
+    hash_index_fn hash_fn;
+    key_free_fn key_fn;
+    data_free_fn data_fn;
+    key_equality_fn keys_are_equal;
+} hash_map_t;
+
+static bool default_key_equality(const void *x, const void *y);
+
+// The hash functions of the stack may leave the low bits unused (e.g. aligned
+// pointers), so the index is taken from the high bits of a multiplicative hash.
+static uint32_t hash_of_(const hash_map_t *hash_map, const void *key)
+{
+    uint64_t hash = hash_map->hash_fn(key);
+    return ((uint32_t)hash ^ (uint32_t)(hash >> 32)) * 2654435769U;
+}
+
+static size_t home_of_(const hash_map_t *hash_map, uint32_t hash)
+{
+    return hash >> hash_map->shift;
+}
+
+// Returns the slot holding |key|, or the empty slot where it would be inserted.
+static size_t find_slot_(const hash_map_t *hash_map, const void *key, uint32_t hash)
+{
+    size_t mask = hash_map->capacity - 1;
+    size_t i = home_of_(hash_map, hash);
+
+    while (hash_map->slots[i].entry.data != NULL) {
+        const hash_map_slot_t *slot = &hash_map->slots[i];
+        if (slot->hash == hash && hash_map->keys_are_equal(slot->entry.key, key)) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static bool set_capacity_(hash_map_t *hash_map, size_t capacity)
+{
+    hash_map_slot_t *slots = osi_calloc(sizeof(hash_map_slot_t) * capacity);
+    if (slots == NULL) {
+        return false;
+    }
+
+    hash_map_slot_t *old_slots = hash_map->slots;
+    size_t old_capacity = hash_map->capacity;
+    size_t shift = 32;
+    for (size_t c = capacity; c > 1; c >>= 1) {
+        shift--;
+    }
+
+    hash_map->slots = slots;
+    hash_map->capacity = capacity;
+    hash_map->shift = shift;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].entry.data != NULL) {
+            size_t j = home_of_(hash_map, old_slots[i].hash);
+            while (slots[j].entry.data != NULL) {
+                j = (j + 1) & (capacity - 1);
+            }
+            slots[j] = old_slots[i];
+        }
+    }
+
+    osi_free(old_slots);
+    return true;
+}
+
+hash_map_t *hash_map_new_internal(
+    size_t num_bucket,
+    hash_index_fn hash_fn,
+    key_free_fn key_fn,
+    data_free_fn data_fn,
+    key_equality_fn equality_fn)
+{
+    assert(hash_fn != NULL);
+    assert(num_bucket > 0);
+    hash_map_t *hash_map = osi_calloc(sizeof(hash_map_t));
+    if (hash_map == NULL) {
+        return NULL;
+    }
+
+    hash_map->hash_fn = hash_fn;
+    hash_map->key_fn = key_fn;
+    hash_map->data_fn = data_fn;
+    hash_map->keys_are_equal = equality_fn ? equality_fn : default_key_equality;
+
+    size_t capacity = HASH_MAP_MIN_CAPACITY;
+    while (capacity < num_bucket) {
+        capacity <<= 1;
+    }
+    if (!set_capacity_(hash_map, capacity)) {
+        osi_free(hash_map);
+        return NULL;
+    }
+    return hash_map;
+}
+
+hash_map_t *hash_map_new(
+    size_t num_bucket,
+    hash_index_fn hash_fn,
+    key_free_fn key_fn,
+    data_free_fn data_fn,
+    key_equality_fn equality_fn)
+{
+    return hash_map_new_internal(num_bucket, hash_fn, key_fn, data_fn, equality_fn);
+}
+
+void hash_map_free(hash_map_t *hash_map)
+{
+    if (hash_map == NULL) {
+        return;
+    }
+    hash_map_clear(hash_map);
+    osi_free(hash_map->slots);
+    osi_free(hash_map);
+}
+
+bool hash_map_has_key(const hash_map_t *hash_map, const void *key)
+{
+    assert(hash_map != NULL);
+
+    size_t i = find_slot_(hash_map, key, hash_of_(hash_map, key));
+    return (hash_map->slots[i].entry.data != NULL);
+}
+
+bool hash_map_set(hash_map_t *hash_map, const void *key, void *data)
+{
+    assert(hash_map != NULL);
+    assert(data != NULL);
+
+    uint32_t hash = hash_of_(hash_map, key);
+    size_t i = find_slot_(hash_map, key, hash);
+    hash_map_slot_t *slot = &hash_map->slots[i];
+
+    if (slot->entry.data != NULL) {
+        // Replaces the element, its key and data are released as if it was erased
+        hash_map_entry_t old = slot->entry;
+        slot->entry.key = key;
+        slot->entry.data = data;
+        if (hash_map->key_fn) {
+            hash_map->key_fn((void *)old.key);
+        }
+        if (hash_map->data_fn) {
+            hash_map->data_fn(old.data);
+        }
+        return true;
+    }
+
+    if ((hash_map->hash_size + 1) * 4 > hash_map->capacity * 3) {
+        if (!set_capacity_(hash_map, hash_map->capacity * 2)) {
+            return false;
+        }
+        i = find_slot_(hash_map, key, hash);
+        slot = &hash_map->slots[i];
+    }
+
+    slot->entry.key = key;
+    slot->entry.data = data;
+    slot->entry.hash_map = hash_map;
+    slot->hash = hash;
+    hash_map->hash_size++;
+    return true;
+}
+
+bool hash_map_erase(hash_map_t *hash_map, const void *key)
+{
+    assert(hash_map != NULL);
+
+    size_t mask = hash_map->capacity - 1;
+    size_t i = find_slot_(hash_map, key, hash_of_(hash_map, key));
+    if (hash_map->slots[i].entry.data == NULL) {
+        return false;
+    }
+
+    hash_map_entry_t old = hash_map->slots[i].entry;
+
+    // Moves back the following elements which may not be found past the hole
+    for (size_t j = (i + 1) & mask; hash_map->slots[j].entry.data != NULL; j = (j + 1) & mask) {
+        size_t home = home_of_(hash_map, hash_map->slots[j].hash);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            hash_map->slots[i] = hash_map->slots[j];
+            i = j;
+        }
+    }
+    memset(&hash_map->slots[i], 0, sizeof(hash_map_slot_t));
+    hash_map->hash_size--;
+
+    if (hash_map->key_fn) {
+        hash_map->key_fn((void *)old.key);
+    }
+    if (hash_map->data_fn) {
+        hash_map->data_fn(old.data);
+    }
+    return true;
+}
+
+void *hash_map_get(const hash_map_t *hash_map, const void *key)
+{
+    assert(hash_map != NULL);
+
+    size_t i = find_slot_(hash_map, key, hash_of_(hash_map, key));
+    return hash_map->slots[i].entry.data;
+}
+
+void hash_map_clear(hash_map_t *hash_map)
+{
+    assert(hash_map != NULL);
+
+    for (size_t i = 0; i < hash_map->capacity; i++) {
+        hash_map_slot_t *slot = &hash_map->slots[i];
+        if (slot->entry.data == NULL) {
+            continue;
+        }
+        if (hash_map->key_fn) {
+            hash_map->key_fn((void *)slot->entry.key);
+        }
+        if (hash_map->data_fn) {
+            hash_map->data_fn(slot->entry.data);
+        }
+        memset(slot, 0, sizeof(hash_map_slot_t));
+    }
+    hash_map->hash_size = 0;
+}
+
+void hash_map_foreach(hash_map_t *hash_map, hash_map_iter_cb callback, void *context)
+{
+    assert(hash_map != NULL);
+    assert(callback != NULL);
+
+    for (size_t i = 0; i < hash_map->capacity; i++) {
+        hash_map_slot_t *slot = &hash_map->slots[i];
+        if (slot->entry.data == NULL) {
+            continue;
+        }
+        if (!callback(&slot->entry, context)) {
+            return;
+        }
+    }
+}
+
+static bool default_key_equality(const void *x, const void *y)
+{
+    return x == y;
+}
+
+#endif /* UC_BT_OSI_HASH_MAP_OPEN_ADDRESSING */
@@ -22,6 +22,7 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include "esp_heap_caps.h"
+#include "osi/pool.h"
 
 char *osi_strdup(const char *str);
 
@@ -113,12 +114,23 @@ do {                                                    \
 } while(0)
 #endif
 
+#if UC_BT_OSI_BUF_POOL
+#define osi_free(ptr)                                   \
+do {                                                    \
+    void *tmp_point = (void *)(ptr);                    \
+    if (!osi_pool_free(tmp_point)) {                    \
+        osi_mem_dbg_clean(tmp_point, __func__, __LINE__); \
+        free(tmp_point);                                \
+    }                                                   \
+} while (0)
+#else
 #define osi_free(ptr)                                   \
 do {                                                    \
     void *tmp_point = (void *)(ptr);                    \
     osi_mem_dbg_clean(tmp_point, __func__, __LINE__);   \
     free(tmp_point);                                    \
 } while (0)
+#endif /* UC_BT_OSI_BUF_POOL */
 
 #else
 
@@ -129,7 +141,17 @@ do {                                                    \
 #define osi_malloc(size)                  malloc((size))
 #define osi_calloc(size)                  calloc(1, (size))
 #endif /* #if HEAP_ALLOCATION_FROM_SPIRAM_FIRST */
+#if UC_BT_OSI_BUF_POOL
+#define osi_free(p)                                     \
+do {                                                    \
+    void *tmp_point = (void *)(p);                      \
+    if (!osi_pool_free(tmp_point)) {                    \
+        free(tmp_point);                                \
+    }                                                   \
+} while (0)
+#else
 #define osi_free(p)                       free((p))
+#endif /* UC_BT_OSI_BUF_POOL */
 
 #endif /* HEAP_MEMORY_DEBUG */
 
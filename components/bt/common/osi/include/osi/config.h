@@ -15,10 +15,12 @@
 #ifndef __CONFIG_H__
 #define __CONFIG_H__
 
-// This module implements a configuration parser. Clients can query the
-// contents of a configuration file through the interface provided here.
-// The current implementation is read-only; mutations are only kept in
-// memory. This parser supports the INI file format.
+// This module implements a configuration store. Clients can query the
+// contents of a configuration through the interface provided here, and
+// mutations are kept in memory until |config_save| is called. The config is
+// stored in an NVS namespace with one binary blob per section, which is only
+// written when the section changed and only read when the section is first
+// used. The INI text format of previous versions is migrated when loaded.
 
 // Implementation notes:
 // - Key/value pairs that are not within a section are assumed to be under
@@ -45,11 +47,11 @@ typedef struct config_section_node_t config_section_node_t;
 // |config_free| on the returned handle when it is no longer required.
 config_t *config_new_empty(void);
 
-// Loads the specified file and returns a handle to the config file. If there
-// was a problem loading the file or allocating memory, this function returns
+// Loads the config stored in the NVS namespace |filename| and returns a handle
+// to it. The entries of each section are read on first use. If there was a
+// problem opening the namespace or allocating memory, this function returns
 // NULL. Clients must call |config_free| on the returned handle when it is no
-// longer required. |filename| must not be NULL and must point to a readable
-// file on the filesystem.
+// longer required. |filename| must not be NULL.
 config_t *config_new(const char *filename);
 
 // Frees resources associated with the config file. No further operations may
@@ -137,12 +139,10 @@ const config_section_node_t *config_section_next(const config_section_node_t *it
 // equal the value returned by |config_section_end|.
 const char *config_section_name(const config_section_node_t *iter);
 
-// Saves |config| to a file given by |filename|. Note that this could be a destructive
-// operation: if |filename| already exists, it will be overwritten. The config
-// module does not preserve comments or formatting so if a config file was opened
-// with |config_new| and subsequently overwritten with |config_save|, all comments
-// and special formatting in the original file will be lost. Neither |config| nor
-// |filename| may be NULL.
-bool config_save(const config_t *config, const char *filename);
+// Saves |config| to the NVS namespace given by |filename|. If |config| was loaded
+// from |filename| with |config_new|, only the sections changed since then are
+// written. Otherwise this is a destructive operation: the contents of |filename|
+// are erased and replaced by |config|. Neither |config| nor |filename| may be NULL.
+bool config_save(config_t *config, const char *filename);
 
 #endif /* #ifndef __CONFIG_H__ */
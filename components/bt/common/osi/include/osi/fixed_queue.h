@@ -43,6 +43,15 @@ typedef void (*fixed_queue_cb)(fixed_queue_t *queue);
 // the returned queue with |fixed_queue_free|.
 fixed_queue_t *fixed_queue_new(size_t capacity);
 
+// Creates a new fixed queue backed by a ring of |capacity| elements, rounded up
+// to a power of 2. Enqueue and dequeue take no lock and allocate nothing, which
+// suits the queues between the stack threads. Ring queues do not support
+// |fixed_queue_try_peek_last|, |fixed_queue_try_remove_from_queue| and
+// |fixed_queue_get_list|. A producer finding the ring full polls it every tick
+// until its timeout expires. Without CONFIG_BT_OSI_FIXED_QUEUE_RING, this is the
+// same as |fixed_queue_new|.
+fixed_queue_t *fixed_queue_new_ring(size_t capacity);
+
 // Freeing a queue that is currently in use (i.e. has waiters
 // blocked on it) results in undefined behaviour.
 void fixed_queue_free(fixed_queue_t *queue, fixed_queue_free_cb free_cb);
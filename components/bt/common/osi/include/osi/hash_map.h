@@ -51,6 +51,8 @@ typedef void (*data_free_fn)(void *data);
 // e.g.  memory or file descriptor.  |key_fn| and |data_fn| may be NULL if no cleanup
 // is necessary on element removal. |equality_fn| is used to check for key equality.
 // If |equality_fn| is NULL, default pointer equality is used.
+// With CONFIG_BT_OSI_HASH_MAP_OPEN_ADDRESSING, the elements are stored in a single
+// table and |num_bucket| is its initial size, the table grows when it is 3/4 full.
 hash_map_t *hash_map_new(
     size_t size,
     hash_index_fn hash_fn,
@@ -0,0 +1,78 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "bt_user_config.h"
+
+// Size classed pools of fixed size buffers, for the buffers allocated and
+// released for each HCI packet. The blocks of all the classes are carved out
+// of a single allocation, |osi_free| recognizes them and returns them to their
+// pool, so pool buffers are released like any other buffer.
+
+// Block sizes of the classes, BT_HDR included: short events and LE ACL packets,
+// any event and LE ACL packets with data length extension, BR/EDR ACL packets
+#define OSI_POOL_SMALL_SIZE         80
+#define OSI_POOL_MEDIUM_SIZE        272
+#define OSI_POOL_LARGE_SIZE         1040
+#define OSI_POOL_NUM_CLASSES        3
+
+typedef struct {
+    uint32_t block_size;
+    uint32_t block_num;
+    uint32_t used;              // Blocks currently allocated
+    uint32_t max_used;          // Most blocks allocated at the same time
+    uint32_t alloc_count;       // Allocations served by the pool
+    uint32_t miss_count;        // Allocations of this class served by the heap, the pool being empty
+} osi_pool_stats_t;
+
+#if UC_BT_OSI_BUF_POOL
+
+// Allocates the pools. Returns true on success, or if the pools are already
+// allocated.
+bool osi_pool_init(void);
+
+// Releases the pools. If some blocks are still allocated, the pools are kept
+// and a warning is logged.
+void osi_pool_deinit(void);
+
+// Returns a buffer of at least |size| bytes from the smallest class which fits
+// |size|. If that pool is empty or |size| is larger than the largest class, the
+// buffer is allocated from the heap. Returns NULL if that allocation failed.
+// The contents of the buffer are not initialized.
+void *osi_pool_malloc(size_t size);
+
+// Returns |ptr| to its pool and returns true if it is a pool block, otherwise
+// returns false and does nothing. Called by |osi_free|.
+bool osi_pool_free(void *ptr);
+
+// Returns the size of the pool block |ptr|, or 0 if |ptr| is not a pool block.
+size_t osi_pool_block_size(const void *ptr);
+
+// Copies the usage statistics of the class |class_index| to |stats|. Returns
+// false if |class_index| is not smaller than OSI_POOL_NUM_CLASSES.
+bool osi_pool_get_stats(uint8_t class_index, osi_pool_stats_t *stats);
+
+#else
+
+#define osi_pool_malloc(size)       osi_malloc(size)
+#define osi_pool_block_size(ptr)    ((size_t)0)
+
+#endif /* UC_BT_OSI_BUF_POOL */
+
+#endif /* _POOL_H_ */
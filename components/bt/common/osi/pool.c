@@ -0,0 +1,211 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "bt_common.h"
+#include "osi/allocator.h"
+#include "osi/pool.h"
+#include "freertos/FreeRTOS.h"
+
+#if UC_BT_OSI_BUF_POOL
+
+// The free blocks of a class form a list linked through their first bytes
+typedef struct pool_block_t {
+    struct pool_block_t *next;
+} pool_block_t;
+
+typedef struct {
+    uint8_t *start;
+    uint8_t *end;
+    pool_block_t *free_list;
+    osi_pool_stats_t stats;
+} pool_class_t;
+
+static const uint16_t pool_block_sizes[OSI_POOL_NUM_CLASSES] = {
+    OSI_POOL_SMALL_SIZE,
+    OSI_POOL_MEDIUM_SIZE,
+    OSI_POOL_LARGE_SIZE,
+};
+
+static const uint16_t pool_block_nums[OSI_POOL_NUM_CLASSES] = {
+    UC_BT_OSI_BUF_POOL_SMALL_NUM,
+    UC_BT_OSI_BUF_POOL_MEDIUM_NUM,
+    UC_BT_OSI_BUF_POOL_LARGE_NUM,
+};
+
+static pool_class_t pool_classes[OSI_POOL_NUM_CLASSES];
+static uint8_t *pool_mem;
+static uint8_t *pool_mem_end;
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static pool_class_t *pool_class_of_(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+
+    if (p < pool_mem || p >= pool_mem_end) {
+        return NULL;
+    }
+
+    for (int i = 0; i < OSI_POOL_NUM_CLASSES; i++) {
+        if (p < pool_classes[i].end) {
+            assert((p - pool_classes[i].start) % pool_classes[i].stats.block_size == 0);
+            return &pool_classes[i];
+        }
+    }
+    return NULL;
+}
+
+bool osi_pool_init(void)
+{
+    size_t total = 0;
+    uint8_t *p;
+
+    if (pool_mem) {
+        return true;
+    }
+
+    for (int i = 0; i < OSI_POOL_NUM_CLASSES; i++) {
+        total += pool_block_sizes[i] * pool_block_nums[i];
+    }
+
+    p = osi_malloc(total);
+    if (p == NULL) {
+        OSI_TRACE_ERROR("%s unable to allocate %d bytes\n", __func__, (int)total);
+        return false;
+    }
+
+    portENTER_CRITICAL(&pool_lock);
+    pool_mem = p;
+    for (int i = 0; i < OSI_POOL_NUM_CLASSES; i++) {
+        pool_class_t *pool = &pool_classes[i];
+
+        memset(pool, 0, sizeof(pool_class_t));
+        pool->start = p;
+        pool->end = p + pool_block_sizes[i] * pool_block_nums[i];
+        pool->stats.block_size = pool_block_sizes[i];
+        pool->stats.block_num = pool_block_nums[i];
+
+        // The blocks are handed out in address order
+        for (int j = pool_block_nums[i] - 1; j >= 0; j--) {
+            pool_block_t *block = (pool_block_t *)(p + j * pool_block_sizes[i]);
+            block->next = pool->free_list;
+            pool->free_list = block;
+        }
+        p = pool->end;
+    }
+    pool_mem_end = p;
+    portEXIT_CRITICAL(&pool_lock);
+
+    return true;
+}
+
+void osi_pool_deinit(void)
+{
+    uint8_t *p;
+
+    portENTER_CRITICAL(&pool_lock);
+    for (int i = 0; i < OSI_POOL_NUM_CLASSES; i++) {
+        if (pool_classes[i].stats.used) {
+            portEXIT_CRITICAL(&pool_lock);
+            OSI_TRACE_WARNING("%s %d blocks of %d bytes still in use, pools kept\n", __func__,
+                              (int)pool_classes[i].stats.used, (int)pool_classes[i].stats.block_size);
+            return;
+        }
+    }
+
+    // Forget the pools first, so that osi_free does not take the region for a block
+    p = pool_mem;
+    pool_mem = NULL;
+    pool_mem_end = NULL;
+    memset(pool_classes, 0, sizeof(pool_classes));
+    portEXIT_CRITICAL(&pool_lock);
+
+    osi_free(p);
+}
+
+void *osi_pool_malloc(size_t size)
+{
+    pool_block_t *block = NULL;
+
+    for (int i = 0; i < OSI_POOL_NUM_CLASSES; i++) {
+        pool_class_t *pool = &pool_classes[i];
+
+        if (size > pool_block_sizes[i]) {
+            continue;
+        }
+
+        portENTER_CRITICAL(&pool_lock);
+        block = pool->free_list;
+        if (block) {
+            pool->free_list = block->next;
+            pool->stats.alloc_count++;
+            if (++pool->stats.used > pool->stats.max_used) {
+                pool->stats.max_used = pool->stats.used;
+            }
+        } else {
+            pool->stats.miss_count++;
+        }
+        portEXIT_CRITICAL(&pool_lock);
+        break;
+    }
+
+    if (block) {
+        return block;
+    }
+    return osi_malloc(size);
+}
+
+bool osi_pool_free(void *ptr)
+{
+    pool_class_t *pool;
+
+    portENTER_CRITICAL(&pool_lock);
+    pool = pool_class_of_(ptr);
+    if (pool) {
+        pool_block_t *block = (pool_block_t *)ptr;
+        block->next = pool->free_list;
+        pool->free_list = block;
+        pool->stats.used--;
+    }
+    portEXIT_CRITICAL(&pool_lock);
+
+    return pool != NULL;
+}
+
+size_t osi_pool_block_size(const void *ptr)
+{
+    pool_class_t *pool = pool_class_of_(ptr);
+
+    return pool ? pool->stats.block_size : 0;
+}
+
+bool osi_pool_get_stats(uint8_t class_index, osi_pool_stats_t *stats)
+{
+    if (class_index >= OSI_POOL_NUM_CLASSES || stats == NULL) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&pool_lock);
+    *stats = pool_classes[class_index].stats;
+    portEXIT_CRITICAL(&pool_lock);
+
+    if (stats->block_size == 0) {
+        // Not initialized yet
+        stats->block_size = pool_block_sizes[class_index];
+    }
+    return true;
+}
+
+#endif /* UC_BT_OSI_BUF_POOL */
@@ -0,0 +1,23 @@
+#define CATCH_CONFIG_RUNNER
+#include "catch.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static int s_argc;
+static char **s_argv;
+
+/* The tests run in a task, so that they use the FreeRTOS API the way applications do */
+static void run_tests(void *arg)
+{
+    int result = Catch::Session().run(s_argc, s_argv);
+    exit(result);
+}
+
+int main(int argc, char **argv)
+{
+    s_argc = argc;
+    s_argv = argv;
+    xTaskCreatePinnedToCore(run_tests, "catch", 4096, NULL, 5, NULL, 0);
+    vTaskStartScheduler();
+    return 1;
+}
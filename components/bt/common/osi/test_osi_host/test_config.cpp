@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "nvs.h"
+#include "nvs_test_api.h"
+#include "spi_flash_emulation.h"
+
+extern "C" {
+#include "osi/config.h"
+}
+
+#include "catch.hpp"
+
+#define PARTITION_SECTORS   8
+#define NAMESPACE           "bt_config.conf"
+
+/* Emulated default nvs partition, as used by config_new() and config_save() */
+struct test_nvs {
+    SpiFlashEmulator emu;
+
+    test_nvs() : emu(PARTITION_SECTORS)
+    {
+        init();
+    }
+
+    ~test_nvs()
+    {
+        nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME);
+    }
+
+    void init()
+    {
+        REQUIRE(nvs_flash_init_custom(NVS_DEFAULT_PART_NAME, 0, PARTITION_SECTORS) == ESP_OK);
+    }
+
+    bool has_blob(const char *key)
+    {
+        nvs_handle_t handle;
+        size_t len = 0;
+        if (nvs_open(NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+            return false;
+        }
+        bool found = nvs_get_blob(handle, key, NULL, &len) == ESP_OK;
+        nvs_close(handle);
+        return found;
+    }
+
+    void set_blob(const char *key, const std::string &value)
+    {
+        nvs_handle_t handle;
+        REQUIRE(nvs_open(NAMESPACE, NVS_READWRITE, &handle) == ESP_OK);
+        REQUIRE(nvs_set_blob(handle, key, value.data(), value.size()) == ESP_OK);
+        REQUIRE(nvs_commit(handle) == ESP_OK);
+        nvs_close(handle);
+    }
+};
+
+static std::string get(config_t *config, const char *section, const char *key)
+{
+    return config_get_string(config, section, key, "");
+}
+
+static std::string section_names(config_t *config)
+{
+    std::string names;
+    for (const config_section_node_t *node = config_section_begin(config); node != config_section_end(config);
+            node = config_section_next(node)) {
+        names += std::string(config_section_name(node)) + ";";
+    }
+    return names;
+}
+
+/* Stores two sections, "Adapter" and the bonded device "aa:bb" */
+static void store_config(void)
+{
+    config_t *config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+    config_set_string(config, "Adapter", "Name", "dev", true);
+    config_set_string(config, "aa:bb", "LinkKey", "0123", true);
+    config_set_int(config, "aa:bb", "LinkKeyType", 4);
+    REQUIRE(config_save(config, NAMESPACE));
+    config_free(config);
+}
+
+TEST_CASE("config in the text format is migrated to sections", "[config]")
+{
+    test_nvs nvs;
+    /* Previous versions split the text in blobs of 1536 bytes, here in the middle of the last line */
+    std::string text = "[Adapter]\nName = dev\n\n[aa:bb]\nLinkKey = 0123\n";
+    while (text.size() + 64 < 1536 - 8) {
+        text += "# " + std::string(61, '-') + "\n";
+    }
+    text += "# " + std::string(1536 - 8 - text.size() - 3, '-') + "\n";
+    text += "LinkKeyType = 4\n";
+    nvs.set_blob("bt_cfg_key0", text.substr(0, 1536));
+    nvs.set_blob("bt_cfg_key1", text.substr(1536));
+
+    config_t *config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+    CHECK(section_names(config) == "Adapter;aa:bb;");
+    CHECK(get(config, "Adapter", "Name") == "dev");
+    CHECK(config_get_int(config, "aa:bb", "LinkKeyType", 0) == 4);
+    config_free(config);
+
+    CHECK(nvs.has_blob("bt_cfg_idx"));
+    CHECK(!nvs.has_blob("bt_cfg_key0"));
+    CHECK(!nvs.has_blob("bt_cfg_key1"));
+
+    /* The sections are read back without the text */
+    config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+    CHECK(section_names(config) == "Adapter;aa:bb;");
+    CHECK(get(config, "aa:bb", "LinkKey") == "0123");
+    config_free(config);
+}
+
+TEST_CASE("config sections are read on first use", "[config]")
+{
+    test_nvs nvs;
+    store_config();
+
+    nvs.emu.clearStats();
+    config_t *config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+    CHECK(config_has_section(config, "aa:bb"));
+    size_t index_reads = nvs.emu.getReadOps();
+
+    CHECK(get(config, "aa:bb", "LinkKey") == "0123");
+    size_t section_reads = nvs.emu.getReadOps() - index_reads;
+    CHECK(section_reads > 0);
+    CHECK(get(config, "aa:bb", "LinkKeyType") == "4");
+    CHECK(nvs.emu.getReadOps() == index_reads + section_reads);
+    config_free(config);
+}
+
+TEST_CASE("config section which cannot be read is not changed", "[config]")
+{
+    test_nvs nvs;
+    store_config();
+    config_t *config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+
+    /* nvs_open() fails while the partition is not initialized */
+    REQUIRE(nvs_flash_deinit_partition(NVS_DEFAULT_PART_NAME) == ESP_OK);
+    CHECK(get(config, "aa:bb", "LinkKey") == "");
+    config_set_string(config, "aa:bb", "LinkKey", "4567", true);
+    CHECK(!config_has_key_in_section(config, "LinkKey", (char *) "4567"));
+    CHECK(!config_save(config, NAMESPACE));
+
+    nvs.init();
+    CHECK(get(config, "aa:bb", "LinkKey") == "0123");
+    CHECK(get(config, "aa:bb", "LinkKeyType") == "4");
+    REQUIRE(config_save(config, NAMESPACE));
+    config_free(config);
+
+    config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+    CHECK(get(config, "aa:bb", "LinkKey") == "0123");
+    CHECK(get(config, "aa:bb", "LinkKeyType") == "4");
+    config_free(config);
+}
+
+TEST_CASE("config save only writes changed sections", "[config]")
+{
+    test_nvs nvs;
+    store_config();
+    config_t *config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+
+    nvs.emu.clearStats();
+    REQUIRE(config_save(config, NAMESPACE));
+    CHECK(nvs.emu.getWriteOps() == 0);
+
+    /* Setting the current value changes nothing */
+    config_set_string(config, "Adapter", "Name", "dev", true);
+    REQUIRE(config_save(config, NAMESPACE));
+    CHECK(nvs.emu.getWriteOps() == 0);
+
+    config_set_string(config, "Adapter", "Name", "other", true);
+    REQUIRE(config_save(config, NAMESPACE));
+    CHECK(nvs.emu.getWriteOps() > 0);
+    config_free(config);
+
+    config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+    CHECK(get(config, "Adapter", "Name") == "other");
+    CHECK(get(config, "aa:bb", "LinkKey") == "0123");
+    config_free(config);
+}
+
+TEST_CASE("config slots of removed sections are reused once erased", "[config]")
+{
+    test_nvs nvs;
+    store_config();
+    config_t *config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+    CHECK(nvs.has_blob("bt_cfg_s0"));
+    CHECK(nvs.has_blob("bt_cfg_s1"));
+
+    /* The slot of a removed section is not used before the index stops referring to it */
+    REQUIRE(config_remove_section(config, "Adapter"));
+    config_set_string(config, "cc:dd", "LinkKey", "4567", true);
+    REQUIRE(config_save(config, NAMESPACE));
+    CHECK(!nvs.has_blob("bt_cfg_s0"));
+    CHECK(nvs.has_blob("bt_cfg_s2"));
+
+    config_set_string(config, "ee:ff", "LinkKey", "89ab", true);
+    REQUIRE(config_save(config, NAMESPACE));
+    CHECK(nvs.has_blob("bt_cfg_s0"));
+    config_free(config);
+
+    config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+    CHECK(section_names(config) == "aa:bb;cc:dd;ee:ff;");
+    CHECK(get(config, "aa:bb", "LinkKey") == "0123");
+    CHECK(get(config, "cc:dd", "LinkKey") == "4567");
+    CHECK(get(config, "ee:ff", "LinkKey") == "89ab");
+
+    /* A section left empty is not stored */
+    REQUIRE(config_remove_key(config, "ee:ff", "LinkKey"));
+    REQUIRE(config_save(config, NAMESPACE));
+    CHECK(!nvs.has_blob("bt_cfg_s0"));
+    CHECK(config_has_section(config, "ee:ff"));
+    config_free(config);
+}
+
+TEST_CASE("config cleared by saving an empty config", "[config]")
+{
+    test_nvs nvs;
+    store_config();
+
+    /* As btc_config_clear() does */
+    config_t *config = config_new_empty();
+    REQUIRE(config != NULL);
+    REQUIRE(config_save(config, NAMESPACE));
+    config_free(config);
+
+    CHECK(!nvs.has_blob("bt_cfg_idx"));
+    CHECK(!nvs.has_blob("bt_cfg_s0"));
+    CHECK(!nvs.has_blob("bt_cfg_s1"));
+    config = config_new(NAMESPACE);
+    REQUIRE(config != NULL);
+    CHECK(section_names(config) == "");
+    config_free(config);
+}
@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+extern "C" {
+#include "osi/fixed_queue.h"
+}
+
+#include "catch.hpp"
+
+static double time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Elements are small integers, offset so that none of them is NULL */
+static void *element(uint32_t producer, uint32_t seq)
+{
+    return (void *)(uintptr_t)(((producer << 24) | seq) + 1);
+}
+
+static int elements_freed;
+
+static void element_free(void *data)
+{
+    elements_freed++;
+}
+
+static void count_ready(fixed_queue_t *queue)
+{
+    elements_freed = (int)fixed_queue_length(queue);
+}
+
+TEST_CASE("ring fixed queue keeps the fixed queue semantics", "[fixed_queue]")
+{
+    fixed_queue_t *queue = fixed_queue_new_ring(5);
+    REQUIRE(queue != NULL);
+    CHECK(fixed_queue_capacity(queue) == 8);
+    CHECK(fixed_queue_is_empty(queue));
+    CHECK(fixed_queue_try_peek_first(queue) == NULL);
+    CHECK(fixed_queue_dequeue(queue, 0) == NULL);
+    CHECK(fixed_queue_dequeue(queue, 10) == NULL);
+
+    for (uint32_t i = 0; i < 8; i++) {
+        CHECK(fixed_queue_enqueue(queue, element(0, i), 0));
+    }
+    CHECK(!fixed_queue_enqueue(queue, element(0, 8), 0));
+    CHECK(!fixed_queue_enqueue(queue, element(0, 8), 10));
+    CHECK(fixed_queue_length(queue) == 8);
+    CHECK(fixed_queue_try_peek_first(queue) == element(0, 0));
+
+    fixed_queue_register_dequeue(queue, count_ready);
+    elements_freed = 0;
+    fixed_queue_process(queue);
+    CHECK(elements_freed == 8);
+
+    /* Wraps around the ring several times */
+    for (uint32_t i = 0; i < 100; i++) {
+        CHECK(fixed_queue_dequeue(queue, FIXED_QUEUE_MAX_TIMEOUT) == element(0, i));
+        CHECK(fixed_queue_enqueue(queue, element(0, i + 8), FIXED_QUEUE_MAX_TIMEOUT));
+    }
+
+    elements_freed = 0;
+    fixed_queue_free(queue, element_free);
+    CHECK(elements_freed == 8);
+}
+
+#define STRESS_PRODUCERS    4
+#define STRESS_ELEMENTS     50000
+
+struct stress_context {
+    fixed_queue_t *queue;
+    uint32_t producer;
+    SemaphoreHandle_t done;
+};
+
+static void stress_producer(void *arg)
+{
+    stress_context *ctx = (stress_context *) arg;
+    for (uint32_t i = 0; i < STRESS_ELEMENTS; i++) {
+        fixed_queue_enqueue(ctx->queue, element(ctx->producer, i), FIXED_QUEUE_MAX_TIMEOUT);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("ring fixed queue with concurrent producers", "[fixed_queue]")
+{
+    fixed_queue_t *queue = fixed_queue_new_ring(16);
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(STRESS_PRODUCERS, 0);
+    stress_context ctx[STRESS_PRODUCERS];
+    std::vector<uint32_t> next(STRESS_PRODUCERS, 0);
+    REQUIRE(queue != NULL);
+
+    for (uint32_t p = 0; p < STRESS_PRODUCERS; p++) {
+        ctx[p] = { queue, p, done };
+        REQUIRE(xTaskCreatePinnedToCore(stress_producer, "producer", 2048, &ctx[p], 5, NULL,
+                                        p % portNUM_PROCESSORS) == pdPASS);
+    }
+
+    /* Each element is received once and in the order of its producer */
+    bool in_order = true;
+    for (uint32_t i = 0; i < STRESS_PRODUCERS * STRESS_ELEMENTS; i++) {
+        uintptr_t value = (uintptr_t)fixed_queue_dequeue(queue, FIXED_QUEUE_MAX_TIMEOUT) - 1;
+        uint32_t producer = value >> 24;
+        REQUIRE(producer < STRESS_PRODUCERS);
+        in_order &= (value & 0xffffff) == next[producer];
+        next[producer]++;
+    }
+    CHECK(in_order);
+    CHECK(fixed_queue_is_empty(queue));
+
+    for (uint32_t p = 0; p < STRESS_PRODUCERS; p++) {
+        REQUIRE(xSemaphoreTake(done, 60000) == pdTRUE);
+    }
+    vSemaphoreDelete(done);
+    fixed_queue_free(queue, NULL);
+}
+
+struct bench_context {
+    fixed_queue_t *queue;
+    uint32_t elements;
+    SemaphoreHandle_t done;
+};
+
+static void bench_producer(void *arg)
+{
+    bench_context *ctx = (bench_context *) arg;
+    for (uint32_t i = 0; i < ctx->elements; i++) {
+        fixed_queue_enqueue(ctx->queue, element(0, i), FIXED_QUEUE_MAX_TIMEOUT);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+/* Passes elements from a producer task to the test task, returns elements per second */
+static double run_queue(fixed_queue_t *queue)
+{
+    bench_context ctx = { queue, 200000, xSemaphoreCreateCounting(1, 0) };
+    REQUIRE(queue != NULL);
+    double start = time_s();
+    REQUIRE(xTaskCreatePinnedToCore(bench_producer, "producer", 2048, &ctx, 5, NULL, 0) == pdPASS);
+    for (uint32_t i = 0; i < ctx.elements; i++) {
+        REQUIRE(fixed_queue_dequeue(queue, FIXED_QUEUE_MAX_TIMEOUT) == element(0, i));
+    }
+    double seconds = time_s() - start;
+    REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+    vSemaphoreDelete(ctx.done);
+    fixed_queue_free(queue, NULL);
+    return ctx.elements / seconds;
+}
+
+/* Enqueues and dequeues bursts of elements in the test task, returns elements per second */
+static double run_bursts(fixed_queue_t *queue)
+{
+    const uint32_t bursts = 20000, burst = 16;
+    REQUIRE(queue != NULL);
+    double start = time_s();
+    for (uint32_t b = 0; b < bursts; b++) {
+        for (uint32_t i = 0; i < burst; i++) {
+            fixed_queue_enqueue(queue, element(0, i), FIXED_QUEUE_MAX_TIMEOUT);
+        }
+        for (uint32_t i = 0; i < burst; i++) {
+            fixed_queue_dequeue(queue, FIXED_QUEUE_MAX_TIMEOUT);
+        }
+    }
+    double seconds = time_s() - start;
+    fixed_queue_free(queue, NULL);
+    return bursts * burst / seconds;
+}
+
+TEST_CASE("list and ring fixed queue throughput", "[fixed_queue][timing]")
+{
+    printf("same task:    list %.0f elements/s, ring %.0f elements/s\n",
+           run_bursts(fixed_queue_new(QUEUE_SIZE_MAX)), run_bursts(fixed_queue_new_ring(QUEUE_SIZE_MAX)));
+    for (size_t capacity = 16; capacity <= 256; capacity *= 4) {
+        printf("capacity %3zu: list %.0f elements/s, ring %.0f elements/s\n", capacity,
+               run_queue(fixed_queue_new(capacity)), run_queue(fixed_queue_new_ring(capacity)));
+    }
+}
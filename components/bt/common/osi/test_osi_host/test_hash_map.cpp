@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+extern "C" {
+#include "osi/hash_map.h"
+#include "osi/hash_functions.h"
+}
+
+#include "catch.hpp"
+
+static double time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int keys_freed;
+static int data_freed;
+
+static void key_free(void *key)
+{
+    keys_freed++;
+}
+
+static void data_free(void *data)
+{
+    data_freed++;
+}
+
+static bool count_entry(hash_map_entry_t *entry, void *context)
+{
+    (*(int *)context)++;
+    return true;
+}
+
+static bool stop_at_first(hash_map_entry_t *entry, void *context)
+{
+    (*(int *)context)++;
+    return false;
+}
+
+static bool string_equality(const void *x, const void *y)
+{
+    return strcmp((const char *)x, (const char *)y) == 0;
+}
+
+TEST_CASE("hash map set, get and erase", "[hash_map]")
+{
+    std::vector<int> keys(100), values(100);
+    hash_map_t *map = hash_map_new(17, hash_function_pointer, key_free, data_free, NULL);
+    REQUIRE(map != NULL);
+    keys_freed = data_freed = 0;
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        CHECK(!hash_map_has_key(map, &keys[i]));
+        CHECK(hash_map_set(map, &keys[i], &values[i]));
+    }
+    for (size_t i = 0; i < keys.size(); i++) {
+        CHECK(hash_map_has_key(map, &keys[i]));
+        CHECK(hash_map_get(map, &keys[i]) == &values[i]);
+    }
+    CHECK(hash_map_get(map, &values[0]) == NULL);
+
+    int count = 0;
+    hash_map_foreach(map, count_entry, &count);
+    CHECK(count == 100);
+    count = 0;
+    hash_map_foreach(map, stop_at_first, &count);
+    CHECK(count == 1);
+
+    /* Erasing every other key keeps the others reachable */
+    for (size_t i = 0; i < keys.size(); i += 2) {
+        CHECK(hash_map_erase(map, &keys[i]));
+    }
+    CHECK(!hash_map_erase(map, &keys[0]));
+    CHECK(keys_freed == 50);
+    CHECK(data_freed == 50);
+    for (size_t i = 0; i < keys.size(); i++) {
+        CHECK(hash_map_get(map, &keys[i]) == (i % 2 ? &values[i] : NULL));
+    }
+
+    hash_map_clear(map);
+    CHECK(keys_freed == 100);
+    CHECK(data_freed == 100);
+    count = 0;
+    hash_map_foreach(map, count_entry, &count);
+    CHECK(count == 0);
+
+    /* The map is still usable after a clear */
+    CHECK(hash_map_set(map, &keys[1], &values[1]));
+    CHECK(hash_map_get(map, &keys[1]) == &values[1]);
+    hash_map_free(map);
+    CHECK(keys_freed == 101);
+}
+
+TEST_CASE("hash map replaces the value of an existing key", "[hash_map]")
+{
+    int key, first, second;
+    hash_map_t *map = hash_map_new(8, hash_function_pointer, key_free, data_free, NULL);
+    REQUIRE(map != NULL);
+    keys_freed = data_freed = 0;
+
+    CHECK(hash_map_set(map, &key, &first));
+    CHECK(hash_map_set(map, &key, &second));
+    CHECK(hash_map_get(map, &key) == &second);
+    /* The replaced element is released like an erased one */
+    CHECK(keys_freed == 1);
+    CHECK(data_freed == 1);
+
+    int count = 0;
+    hash_map_foreach(map, count_entry, &count);
+    CHECK(count == 1);
+    hash_map_free(map);
+    CHECK(data_freed == 2);
+}
+
+TEST_CASE("hash map with colliding keys", "[hash_map]")
+{
+    /* With a constant hash all the keys collide */
+    char keys[64][8];
+    std::vector<int> values(64);
+    hash_map_t *map = hash_map_new(8, [](const void *key) -> hash_index_t { return 42; },
+                                   NULL, NULL, string_equality);
+    REQUIRE(map != NULL);
+
+    for (int i = 0; i < 64; i++) {
+        sprintf(keys[i], "key%d", i);
+        CHECK(hash_map_set(map, keys[i], &values[i]));
+    }
+    /* Erase from the middle of the probe sequence, then from its start */
+    for (int i = 20; i < 40; i++) {
+        CHECK(hash_map_erase(map, "key0") == (i == 20));
+        CHECK(hash_map_erase(map, keys[i]));
+    }
+    for (int i = 1; i < 64; i++) {
+        char key[8];
+        sprintf(key, "key%d", i);
+        CHECK(hash_map_get(map, key) == (i >= 20 && i < 40 ? NULL : &values[i]));
+    }
+    hash_map_free(map);
+}
+
+#define BENCH_ROUNDS    20000
+
+/* Alarm-like usage: a small map of pointer keys which are set, looked up and erased */
+static void run_benchmark(size_t elements)
+{
+    std::vector<int> keys(elements), values(elements);
+    hash_map_t *map = hash_map_new(34, hash_function_pointer, NULL, NULL, NULL);
+    REQUIRE(map != NULL);
+    size_t rounds = BENCH_ROUNDS * 32 / elements;
+    size_t found = 0;
+
+    double start = time_s();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < elements; i++) {
+            hash_map_set(map, &keys[i], &values[i]);
+        }
+        for (size_t i = 0; i < elements; i++) {
+            found += hash_map_get(map, &keys[(i * 7) % elements]) != NULL;
+        }
+        for (size_t i = 0; i < elements; i++) {
+            hash_map_erase(map, &keys[i]);
+        }
+    }
+    double seconds = time_s() - start;
+
+    CHECK(found == rounds * elements);
+    printf("%4zu elements: %.0f set/get/erase per second\n", elements, rounds * elements / seconds);
+    hash_map_free(map);
+}
+
+TEST_CASE("hash map throughput", "[hash_map][timing]")
+{
+    for (size_t elements = 8; elements <= 512; elements *= 4) {
+        run_benchmark(elements);
+    }
+}
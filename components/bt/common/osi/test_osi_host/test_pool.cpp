@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+extern "C" {
+#include "osi/allocator.h"
+#include "osi/pool.h"
+}
+
+#include "catch.hpp"
+
+static double time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static osi_pool_stats_t stats_of(uint8_t class_index)
+{
+    osi_pool_stats_t stats;
+    REQUIRE(osi_pool_get_stats(class_index, &stats));
+    return stats;
+}
+
+static const size_t class_sizes[OSI_POOL_NUM_CLASSES] = {
+    OSI_POOL_SMALL_SIZE, OSI_POOL_MEDIUM_SIZE, OSI_POOL_LARGE_SIZE
+};
+
+TEST_CASE("pool buffers come from the smallest fitting class", "[pool]")
+{
+    REQUIRE(osi_pool_init());
+    /* A second init keeps the pools */
+    REQUIRE(osi_pool_init());
+
+    CHECK(osi_pool_block_size(NULL) == 0);
+    for (uint8_t i = 0; i < OSI_POOL_NUM_CLASSES; i++) {
+        osi_pool_stats_t before = stats_of(i);
+        void *smallest = osi_pool_malloc(i ? class_sizes[i - 1] + 1 : 1);
+        void *largest = osi_pool_malloc(class_sizes[i]);
+        REQUIRE(smallest != NULL);
+        REQUIRE(largest != NULL);
+        CHECK(osi_pool_block_size(smallest) == class_sizes[i]);
+        CHECK(osi_pool_block_size(largest) == class_sizes[i]);
+        memset(largest, 0xa5, class_sizes[i]);
+
+        osi_pool_stats_t during = stats_of(i);
+        CHECK(during.used == before.used + 2);
+        CHECK(during.alloc_count == before.alloc_count + 2);
+
+        osi_free(smallest);
+        osi_free(largest);
+        CHECK(stats_of(i).used == before.used);
+    }
+
+    /* Larger buffers are allocated from the heap */
+    void *heap = osi_pool_malloc(OSI_POOL_LARGE_SIZE + 1);
+    REQUIRE(heap != NULL);
+    CHECK(osi_pool_block_size(heap) == 0);
+    CHECK(!osi_pool_free(heap));
+    osi_free(heap);
+}
+
+TEST_CASE("pool falls back to the heap when a class is empty", "[pool]")
+{
+    REQUIRE(osi_pool_init());
+    osi_pool_stats_t before = stats_of(0);
+    std::vector<void *> blocks;
+
+    for (uint32_t i = 0; i < before.block_num; i++) {
+        blocks.push_back(osi_pool_malloc(OSI_POOL_SMALL_SIZE));
+        CHECK(osi_pool_block_size(blocks.back()) == OSI_POOL_SMALL_SIZE);
+    }
+    void *heap = osi_pool_malloc(OSI_POOL_SMALL_SIZE);
+    REQUIRE(heap != NULL);
+    CHECK(osi_pool_block_size(heap) == 0);
+
+    osi_pool_stats_t full = stats_of(0);
+    CHECK(full.used == full.block_num);
+    CHECK(full.max_used == full.block_num);
+    CHECK(full.miss_count == before.miss_count + 1);
+
+    /* Blocks released through osi_free_func are reused too */
+    osi_free(heap);
+    osi_free_func(blocks.back());
+    blocks.pop_back();
+    void *reused = osi_pool_malloc(1);
+    CHECK(osi_pool_block_size(reused) == OSI_POOL_SMALL_SIZE);
+    blocks.push_back(reused);
+
+    for (void *block : blocks) {
+        osi_free(block);
+    }
+    CHECK(stats_of(0).used == 0);
+    CHECK(!osi_pool_get_stats(OSI_POOL_NUM_CLASSES, NULL));
+}
+
+TEST_CASE("pool is kept while its blocks are in use", "[pool]")
+{
+    REQUIRE(osi_pool_init());
+    void *block = osi_pool_malloc(OSI_POOL_MEDIUM_SIZE);
+    REQUIRE(osi_pool_block_size(block) == OSI_POOL_MEDIUM_SIZE);
+
+    osi_pool_deinit();
+    CHECK(osi_pool_block_size(block) == OSI_POOL_MEDIUM_SIZE);
+    osi_free(block);
+
+    /* Without the pools every buffer comes from the heap */
+    osi_pool_deinit();
+    void *heap = osi_pool_malloc(1);
+    REQUIRE(heap != NULL);
+    CHECK(osi_pool_block_size(heap) == 0);
+    osi_free(heap);
+    CHECK(stats_of(1).block_size == OSI_POOL_MEDIUM_SIZE);
+    CHECK(stats_of(1).block_num == 0);
+}
+
+/* Allocates and releases bursts of packet sized buffers, returns buffers per second */
+static double run_bursts(void *(*alloc_fn)(size_t), size_t size)
+{
+    const uint32_t bursts = 50000, burst = 4;
+    void *buffers[burst];
+    double start = time_s();
+    for (uint32_t b = 0; b < bursts; b++) {
+        for (uint32_t i = 0; i < burst; i++) {
+            buffers[i] = alloc_fn(size);
+        }
+        for (uint32_t i = 0; i < burst; i++) {
+            osi_free(buffers[i]);
+        }
+    }
+    return bursts * burst / (time_s() - start);
+}
+
+static void *heap_malloc(size_t size)
+{
+    return osi_malloc(size);
+}
+
+static void *pool_malloc(size_t size)
+{
+    return osi_pool_malloc(size);
+}
+
+TEST_CASE("pool and heap allocation throughput", "[pool][timing]")
+{
+    REQUIRE(osi_pool_init());
+    for (uint8_t i = 0; i < OSI_POOL_NUM_CLASSES; i++) {
+        printf("%4zu bytes: heap %.0f buffers/s, pool %.0f buffers/s\n", class_sizes[i],
+               run_bursts(heap_malloc, class_sizes[i]), run_bursts(pool_malloc, class_sizes[i]));
+    }
+    osi_pool_deinit();
+}
@@ -132,7 +132,7 @@ osi_thread_t *osi_thread_create(const char *name, size_t stack_size, int priorit
     }
 
     for (int i = 0; i < thread->work_queue_num; i++) {
-        thread->work_queues[i] = fixed_queue_new(DEFAULT_WORK_QUEUE_CAPACITY);
+        thread->work_queues[i] = fixed_queue_new_ring(DEFAULT_WORK_QUEUE_CAPACITY);
         if (thread->work_queues[i] == NULL) {
             goto _err;
         }
@@ -27,7 +27,7 @@ typedef unsigned long long  u64_t;
 
 typedef int         bt_mesh_atomic_t;
 
-#ifndef bool
+#if !defined(__cplusplus) && !defined(bool)
 #define bool        int8_t
 #endif
 
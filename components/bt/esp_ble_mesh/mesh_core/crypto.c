@@ -564,24 +564,43 @@ static void create_net_nonce(u8_t nonce[13], const u8_t *pdu,
     sys_put_be32(iv_index, &nonce[9]);
 }
 
+int bt_mesh_privacy_key_init(struct bt_mesh_privacy_key *privacy_key)
+{
+#if !CONFIG_MBEDTLS_HARDWARE_AES
+    if (tc_aes128_set_encrypt_key(&privacy_key->sched,
+                                  privacy_key->key) == TC_CRYPTO_FAIL) {
+        return -EIO;
+    }
+#endif
+
+    return 0;
+}
+
 int bt_mesh_net_obfuscate(u8_t *pdu, u32_t iv_index,
-                          const u8_t privacy_key[16])
+                          const struct bt_mesh_privacy_key *privacy_key)
 {
     u8_t priv_rand[16] = { 0x00, 0x00, 0x00, 0x00, 0x00, };
     u8_t tmp[16] = {0};
-    int err = 0, i;
+    int i;
 
-    BT_DBG("IVIndex %u, PrivacyKey %s", iv_index, bt_hex(privacy_key, 16));
+    BT_DBG("IVIndex %u, PrivacyKey %s", iv_index, bt_hex(privacy_key->key, 16));
 
     sys_put_be32(iv_index, &priv_rand[5]);
     memcpy(&priv_rand[9], &pdu[7], 7);
 
     BT_DBG("PrivacyRandom %s", bt_hex(priv_rand, 16));
 
-    err = bt_mesh_encrypt_be(privacy_key, priv_rand, tmp);
-    if (err) {
-        return err;
+#if CONFIG_MBEDTLS_HARDWARE_AES
+    if (bt_mesh_encrypt_be(privacy_key->key, priv_rand, tmp)) {
+        return -EIO;
     }
+#else
+    /* The key schedule is only read, tinycrypt does not declare it const */
+    if (tc_aes_encrypt(tmp, priv_rand,
+                       (TCAesKeySched_t)&privacy_key->sched) == TC_CRYPTO_FAIL) {
+        return -EIO;
+    }
+#endif
 
     for (i = 0; i < 6; i++) {
         pdu[1 + i] ^= tmp[i];
@@ -12,6 +12,7 @@
 
 #include <string.h>
 #include "mesh_buf.h"
+#include "mesh_aes_encrypt.h"
 
 struct bt_mesh_sg {
     const void *data;
@@ -125,8 +126,21 @@ static inline int bt_mesh_prov_salt(const u8_t conf_salt[16],
     return bt_mesh_aes_cmac(prov_salt_key, sg, ARRAY_SIZE(sg), prov_salt);
 }
 
+/* PrivacyKey, together with its expanded AES key schedule so that the
+ * obfuscation of each Network PDU does not expand the key again. The
+ * hardware AES loads the key for every block, only the key is kept then.
+ */
+struct bt_mesh_privacy_key {
+    u8_t key[16];
+#if !CONFIG_MBEDTLS_HARDWARE_AES
+    struct tc_aes_key_sched_struct sched;
+#endif
+};
+
+int bt_mesh_privacy_key_init(struct bt_mesh_privacy_key *privacy_key);
+
 int bt_mesh_net_obfuscate(u8_t *pdu, u32_t iv_index,
-                          const u8_t privacy_key[16]);
+                          const struct bt_mesh_privacy_key *privacy_key);
 
 int bt_mesh_net_encrypt(const u8_t key[16], struct net_buf_simple *buf,
                         u32_t iv_index, bool proxy);
@@ -469,7 +469,8 @@ static int encrypt_friend_pdu(struct bt_mesh_friend *frnd, struct net_buf *buf,
                               bool master_cred)
 {
     struct bt_mesh_subnet *sub = friend_subnet_get(frnd->net_idx);
-    const u8_t *enc = NULL, *priv = NULL;
+    const struct bt_mesh_privacy_key *priv = NULL;
+    const u8_t *enc = NULL;
     u32_t iv_index = 0U;
     u16_t src = 0U;
     u8_t nid = 0U;
@@ -482,7 +483,7 @@ static int encrypt_friend_pdu(struct bt_mesh_friend *frnd, struct net_buf *buf,
 
     if (master_cred) {
         enc = sub->keys[sub->kr_flag].enc;
-        priv = sub->keys[sub->kr_flag].privacy;
+        priv = &sub->keys[sub->kr_flag].privacy;
         nid = sub->keys[sub->kr_flag].nid;
     } else {
         if (friend_cred_get(sub, frnd->lpn, &nid, &enc, &priv)) {
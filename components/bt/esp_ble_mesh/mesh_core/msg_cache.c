@@ -0,0 +1,122 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "msg_cache.h"
+
+/* Chain value of an entry which is not in any bucket */
+#define ENTRY_UNUSED    (BLE_MESH_MSG_CACHE_NONE - 1)
+
+static u16_t bucket_of(struct bt_mesh_msg_cache *cache, u64_t key)
+{
+    u32_t hash = (u32_t)key ^ (u32_t)(key >> 32);
+
+    /* Keys differ in few bits (e.g. consecutive sequence numbers), mix all
+     * of them into the bucket index.
+     */
+    hash ^= hash >> 16;
+    hash *= 0x7feb352dU;
+    hash ^= hash >> 15;
+
+    return hash & cache->mask;
+}
+
+void bt_mesh_msg_cache_reset(struct bt_mesh_msg_cache *cache)
+{
+    u32_t buckets = 1U;
+    u16_t i;
+
+    while (buckets * 2 <= BLE_MESH_MSG_CACHE_BUCKETS(cache->size)) {
+        buckets *= 2;
+    }
+    cache->mask = buckets - 1;
+    cache->next = 0U;
+
+    for (i = 0U; i < cache->size; i++) {
+        cache->chain[i] = ENTRY_UNUSED;
+    }
+    memset(cache->buckets, 0xFF, buckets * sizeof(cache->buckets[0]));
+}
+
+bool bt_mesh_msg_cache_find(struct bt_mesh_msg_cache *cache, u64_t key)
+{
+    u16_t idx = cache->buckets[bucket_of(cache, key)];
+
+    while (idx != BLE_MESH_MSG_CACHE_NONE) {
+        if (cache->keys[idx] == key) {
+            return true;
+        }
+        idx = cache->chain[idx];
+    }
+
+    return false;
+}
+
+static void unlink_entry(struct bt_mesh_msg_cache *cache, u16_t idx)
+{
+    u16_t *link = &cache->buckets[bucket_of(cache, cache->keys[idx])];
+
+    while (*link != idx) {
+        link = &cache->chain[*link];
+    }
+    *link = cache->chain[idx];
+    cache->chain[idx] = ENTRY_UNUSED;
+}
+
+u16_t bt_mesh_msg_cache_add(struct bt_mesh_msg_cache *cache, u64_t key)
+{
+    u16_t idx = cache->next;
+    u16_t *bucket = NULL;
+
+    if (cache->chain[idx] != ENTRY_UNUSED) {
+        unlink_entry(cache, idx);
+    }
+
+    bucket = &cache->buckets[bucket_of(cache, key)];
+    cache->keys[idx] = key;
+    cache->chain[idx] = *bucket;
+    *bucket = idx;
+
+    cache->next = (idx + 1) % cache->size;
+
+    return idx;
+}
+
+void bt_mesh_msg_cache_remove(struct bt_mesh_msg_cache *cache, u16_t idx)
+{
+    if (idx >= cache->size || cache->chain[idx] == ENTRY_UNUSED) {
+        return;
+    }
+
+    unlink_entry(cache, idx);
+
+    /* Rewind the next index if we are not using this entry any more */
+    if ((idx + 1) % cache->size == cache->next) {
+        cache->next = idx;
+    }
+}
+
+void bt_mesh_msg_cache_remove_matching(struct bt_mesh_msg_cache *cache,
+                                       bool (*match)(u64_t key, void *arg),
+                                       void *arg)
+{
+    u16_t i;
+
+    for (i = 0U; i < cache->size; i++) {
+        if (cache->chain[i] != ENTRY_UNUSED && match(cache->keys[i], arg)) {
+            unlink_entry(cache, i);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _BLE_MESH_MSG_CACHE_H_
+#define _BLE_MESH_MSG_CACHE_H_
+
+#include "mesh_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Set of 64-bit message keys with FIFO eviction. The entries are kept in
+ * insertion order, the oldest one is replaced when the cache is full. A hash
+ * table chains the entries of each bucket, so that looking up a key does not
+ * depend on the cache size.
+ */
+struct bt_mesh_msg_cache {
+    u16_t size;     /* Number of entries */
+    u16_t mask;     /* Number of buckets - 1 */
+    u16_t next;     /* Entry replaced by the next insertion */
+    u64_t *keys;
+    u16_t *chain;   /* Next entry in the same bucket */
+    u16_t *buckets; /* First entry of each bucket */
+};
+
+/* Terminates the entry chain of a bucket */
+#define BLE_MESH_MSG_CACHE_NONE     0xFFFF
+
+/* Number of buckets statically allocated for a cache of the given size. At
+ * least one bucket per entry is used.
+ */
+#define BLE_MESH_MSG_CACHE_BUCKETS(_size)   (2 * (_size))
+
+/* Statically define a message cache of the given size, which must be less
+ * than BLE_MESH_MSG_CACHE_NONE - 1. It must be reset before use.
+ */
+#define BLE_MESH_MSG_CACHE_DEFINE(_name, _size)                                 \
+    static u64_t _name##_keys[_size];                                           \
+    static u16_t _name##_chain[_size];                                          \
+    static u16_t _name##_buckets[BLE_MESH_MSG_CACHE_BUCKETS(_size)];            \
+    static struct bt_mesh_msg_cache _name = {                                   \
+        .size = (_size),                                                        \
+        .keys = _name##_keys,                                                   \
+        .chain = _name##_chain,                                                 \
+        .buckets = _name##_buckets,                                             \
+    }
+
+/* Remove all entries */
+void bt_mesh_msg_cache_reset(struct bt_mesh_msg_cache *cache);
+
+/* Returns true if the key is in the cache */
+bool bt_mesh_msg_cache_find(struct bt_mesh_msg_cache *cache, u64_t key);
+
+/* Add a key, replacing the oldest entry if the cache is full. Returns the
+ * index of the new entry.
+ */
+u16_t bt_mesh_msg_cache_add(struct bt_mesh_msg_cache *cache, u64_t key);
+
+/* Remove the entry with the given index. If it was the last one added, its
+ * slot is used again by the next insertion.
+ */
+void bt_mesh_msg_cache_remove(struct bt_mesh_msg_cache *cache, u16_t idx);
+
+/* Remove all entries for which match() returns true */
+void bt_mesh_msg_cache_remove_matching(struct bt_mesh_msg_cache *cache,
+                                       bool (*match)(u64_t key, void *arg),
+                                       void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLE_MESH_MSG_CACHE_H_ */
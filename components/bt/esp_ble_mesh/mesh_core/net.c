@@ -27,6 +27,8 @@
 #include "proxy_client.h"
 #include "proxy_server.h"
 #include "provisioner_main.h"
+#include "msg_cache.h"
+#include "nid_index.h"
 
 /* Minimum valid Mesh Network PDU length. The Network headers
  * themselves take up 9 bytes. After that there is a minumum of 1 byte
@@ -61,8 +63,30 @@
 static struct friend_cred friend_cred[FRIEND_CRED_COUNT];
 #endif
 
-static u64_t msg_cache[CONFIG_BLE_MESH_MSG_CACHE_SIZE];
-static u16_t msg_cache_next;
+/* Subnets returned by bt_mesh_rx_netkey_get() */
+#if defined(CONFIG_BLE_MESH_PROVISIONER)
+#define NID_INDEX_SUBNETS   (CONFIG_BLE_MESH_SUBNET_COUNT + \
+                             CONFIG_BLE_MESH_PROVISIONER_SUBNET_COUNT)
+#else
+#define NID_INDEX_SUBNETS   CONFIG_BLE_MESH_SUBNET_COUNT
+#endif
+
+static size_t nid_index_subnet_count(void);
+static bool nid_index_subnet(size_t i, struct bt_mesh_nid_keys *keys);
+static bool nid_index_cred(size_t i, struct bt_mesh_nid_keys *keys);
+
+static const struct bt_mesh_nid_index_ops nid_index_ops = {
+    .subnet_count = nid_index_subnet_count,
+    .subnet = nid_index_subnet,
+    .cred = nid_index_cred,
+};
+
+/* Candidate keys of each NID */
+BLE_MESH_NID_INDEX_DEFINE(nid_index, NID_INDEX_SUBNETS, FRIEND_CRED_COUNT,
+                          &nid_index_ops);
+
+/* Messages received before, by IV index, SEQ and SRC */
+BLE_MESH_MSG_CACHE_DEFINE(msg_cache, CONFIG_BLE_MESH_MSG_CACHE_SIZE);
 
 /* Singleton network context (the implementation only supports one) */
 struct bt_mesh_net bt_mesh = {
@@ -79,29 +103,36 @@ struct bt_mesh_net bt_mesh = {
     },
 };
 
-static u32_t dup_cache[4];
-static int   dup_cache_next;
+/* Network PDUs received before, by their obfuscated and encrypted contents */
+BLE_MESH_MSG_CACHE_DEFINE(pdu_cache, CONFIG_BLE_MESH_PDU_CACHE_SIZE);
 
 #if defined(CONFIG_BLE_MESH_RELAY_ADV_BUF)
 #define BLE_MESH_MAX_STORED_RELAY_COUNT  (CONFIG_BLE_MESH_RELAY_ADV_BUF_COUNT / 2)
 #endif
 
-static bool check_dup(struct net_buf_simple *data)
+/* A PDU received again in exactly the same form (e.g. another transmission
+ * of the same advertisement) can be dropped before it is deobfuscated, as it
+ * carries the same SRC and SEQ. Relayed copies of a message have a different
+ * TTL and therefore different obfuscated headers, they are caught by the
+ * network message cache after deobfuscation.
+ */
+static bool check_dup(struct net_buf_simple *data, struct bt_mesh_net_rx *rx)
 {
     const u8_t *tail = net_buf_simple_tail(data);
-    u32_t val = 0U;
-    int i;
+    u64_t key = 0U;
 
-    val = sys_get_be32(tail - 4) ^ sys_get_be32(tail - 8);
+    /* NetMIC and the end of the encrypted payload, combined with the IVI,
+     * NID and the obfuscated CTL, TTL, SEQ and SRC.
+     */
+    key = ((u64_t)sys_get_be32(tail - 8) << 32) | sys_get_be32(tail - 4);
+    key ^= ((u64_t)sys_get_be32(&data->data[0]) << 24) |
+           ((u64_t)sys_get_be16(&data->data[4]) << 8) | data->data[6];
 
-    for (i = 0; i < ARRAY_SIZE(dup_cache); i++) {
-        if (dup_cache[i] == val) {
-            return true;
-        }
+    if (bt_mesh_msg_cache_find(&pdu_cache, key)) {
+        return true;
     }
 
-    dup_cache[dup_cache_next++] = val;
-    dup_cache_next %= ARRAY_SIZE(dup_cache);
+    rx->pdu_cache_idx = bt_mesh_msg_cache_add(&pdu_cache, key);
 
     return false;
 }
@@ -123,34 +154,45 @@ static bool msg_cache_match(struct bt_mesh_net_rx *rx,
                             struct net_buf_simple *pdu)
 {
     u64_t hash = msg_hash(rx, pdu);
-    int i;
 
-    for (i = 0; i < ARRAY_SIZE(msg_cache); i++) {
-        if (msg_cache[i] == hash) {
-            return true;
-        }
+    if (bt_mesh_msg_cache_find(&msg_cache, hash)) {
+        return true;
     }
 
     /* Add to the cache */
-    rx->msg_cache_idx = msg_cache_next++;
-    msg_cache[rx->msg_cache_idx] = hash;
-    msg_cache_next %= ARRAY_SIZE(msg_cache);
+    rx->msg_cache_idx = bt_mesh_msg_cache_add(&msg_cache, hash);
 
     return false;
 }
 
+static void msg_caches_reset(void)
+{
+    bt_mesh_msg_cache_reset(&msg_cache);
+    bt_mesh_msg_cache_reset(&pdu_cache);
+}
+
 #if CONFIG_BLE_MESH_PROVISIONER
+struct src_range {
+    u16_t unicast_addr;
+    u8_t elem_num;
+};
+
+static bool msg_hash_src_match(u64_t hash, void *arg)
+{
+    struct src_range *range = arg;
+    u16_t src = (((u8_t)(hash >> 16)) << 8) | (u8_t)(hash >> 24);
+
+    return src >= range->unicast_addr && src < range->unicast_addr + range->elem_num;
+}
+
 void bt_mesh_msg_cache_clear(u16_t unicast_addr, u8_t elem_num)
 {
-    u16_t src = 0U;
-    int i;
+    struct src_range range = {
+        .unicast_addr = unicast_addr,
+        .elem_num = elem_num,
+    };
 
-    for (i = 0; i < ARRAY_SIZE(msg_cache); i++) {
-        src = (((u8_t)(msg_cache[i] >> 16)) << 8) | (u8_t)(msg_cache[i] >> 24);
-        if (src >= unicast_addr && src < unicast_addr + elem_num) {
-            memset(&msg_cache[i], 0x0, sizeof(msg_cache[i]));
-        }
-    }
+    bt_mesh_msg_cache_remove_matching(&msg_cache, msg_hash_src_match, &range);
 }
 #endif /* CONFIG_BLE_MESH_PROVISIONER */
 
@@ -178,18 +220,25 @@ int bt_mesh_net_keys_create(struct bt_mesh_subnet_keys *keys,
     u8_t nid = 0U;
     int err = 0;
 
-    err = bt_mesh_k2(key, p, sizeof(p), &nid, keys->enc, keys->privacy);
+    err = bt_mesh_k2(key, p, sizeof(p), &nid, keys->enc, keys->privacy.key);
     if (err) {
         BT_ERR("%s, Unable to generate NID, EncKey & PrivacyKey", __func__);
         return err;
     }
 
+    err = bt_mesh_privacy_key_init(&keys->privacy);
+    if (err) {
+        BT_ERR("%s, Unable to expand PrivacyKey", __func__);
+        return err;
+    }
+
     memcpy(keys->net, key, 16);
 
     keys->nid = nid;
+    bt_mesh_net_nid_index_invalidate();
 
     BT_DBG("NID 0x%02x EncKey %s", keys->nid, bt_hex(keys->enc, 16));
-    BT_DBG("PrivacyKey %s", bt_hex(keys->privacy, 16));
+    BT_DBG("PrivacyKey %s", bt_hex(keys->privacy.key, 16));
 
     err = bt_mesh_k3(key, keys->net_id);
     if (err) {
@@ -252,15 +301,23 @@ int friend_cred_set(struct friend_cred *cred, u8_t idx, const u8_t net_key[16])
     sys_put_be16(cred->frnd_counter, p + 7);
 
     err = bt_mesh_k2(net_key, p, sizeof(p), &cred->cred[idx].nid,
-                     cred->cred[idx].enc, cred->cred[idx].privacy);
+                     cred->cred[idx].enc, cred->cred[idx].privacy.key);
     if (err) {
         BT_ERR("%s, Unable to generate NID, EncKey & PrivacyKey", __func__);
         return err;
     }
 
+    err = bt_mesh_privacy_key_init(&cred->cred[idx].privacy);
+    if (err) {
+        BT_ERR("%s, Unable to expand PrivacyKey", __func__);
+        return err;
+    }
+
+    bt_mesh_net_nid_index_invalidate();
+
     BT_DBG("Friend NID 0x%02x EncKey %s", cred->cred[idx].nid,
            bt_hex(cred->cred[idx].enc, 16));
-    BT_DBG("Friend PrivacyKey %s", bt_hex(cred->cred[idx].privacy, 16));
+    BT_DBG("Friend PrivacyKey %s", bt_hex(cred->cred[idx].privacy.key, 16));
 
     return 0;
 }
@@ -278,6 +335,8 @@ void friend_cred_refresh(u16_t net_idx)
                    sizeof(cred->cred[0]));
         }
     }
+
+    bt_mesh_net_nid_index_invalidate();
 }
 
 int friend_cred_update(struct bt_mesh_subnet *sub)
@@ -354,6 +413,7 @@ void friend_cred_clear(struct friend_cred *cred)
     cred->lpn_counter = 0U;
     cred->frnd_counter = 0U;
     (void)memset(cred->cred, 0, sizeof(cred->cred));
+    bt_mesh_net_nid_index_invalidate();
 }
 
 int friend_cred_del(u16_t net_idx, u16_t addr)
@@ -373,7 +433,8 @@ int friend_cred_del(u16_t net_idx, u16_t addr)
 }
 
 int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
-                    const u8_t **enc, const u8_t **priv)
+                    const u8_t **enc,
+                    const struct bt_mesh_privacy_key **priv)
 {
     int i;
 
@@ -399,7 +460,7 @@ int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
         }
 
         if (priv) {
-            *priv = cred->cred[sub->kr_flag].privacy;
+            *priv = &cred->cred[sub->kr_flag].privacy;
         }
 
         return 0;
@@ -409,7 +470,8 @@ int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
 }
 #else
 int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
-                    const u8_t **enc, const u8_t **priv)
+                    const u8_t **enc,
+                    const struct bt_mesh_privacy_key **priv)
 {
     return -ENOENT;
 }
@@ -459,8 +521,7 @@ int bt_mesh_net_create(u16_t idx, u8_t flags, const u8_t key[16],
 
     BT_DBG("NetKey %s", bt_hex(key, 16));
 
-    (void)memset(msg_cache, 0, sizeof(msg_cache));
-    msg_cache_next = 0U;
+    msg_caches_reset();
 
     sub = &bt_mesh.sub[0];
 
@@ -510,6 +571,7 @@ void bt_mesh_net_revoke_keys(struct bt_mesh_subnet *sub)
     BT_DBG("idx 0x%04x", sub->net_idx);
 
     memcpy(&sub->keys[0], &sub->keys[1], sizeof(sub->keys[0]));
+    bt_mesh_net_nid_index_invalidate();
 
     for (i = 0; i < ARRAY_SIZE(bt_mesh.app_keys); i++) {
         struct bt_mesh_app_key *key = &bt_mesh.app_keys[i];
@@ -766,7 +828,8 @@ int bt_mesh_net_resend(struct bt_mesh_subnet *sub, struct net_buf *buf,
                        bool new_key, const struct bt_mesh_send_cb *cb,
                        void *cb_data)
 {
-    const u8_t *enc = NULL, *priv = NULL;
+    const struct bt_mesh_privacy_key *priv = NULL;
+    const u8_t *enc = NULL;
     u32_t seq = 0U;
     u16_t dst = 0U;
     int err = 0;
@@ -775,7 +838,7 @@ int bt_mesh_net_resend(struct bt_mesh_subnet *sub, struct net_buf *buf,
            buf->len);
 
     enc = sub->keys[new_key].enc;
-    priv = sub->keys[new_key].privacy;
+    priv = &sub->keys[new_key].privacy;
 
     err = bt_mesh_net_obfuscate(buf->data, BLE_MESH_NET_IVI_TX, priv);
     if (err) {
@@ -837,7 +900,8 @@ int bt_mesh_net_encode(struct bt_mesh_net_tx *tx, struct net_buf_simple *buf,
     const bool ctl = (tx->ctx->app_idx == BLE_MESH_KEY_UNUSED);
     u32_t seq_val = 0U;
     u8_t nid = 0U;
-    const u8_t *enc = NULL, *priv = NULL;
+    const struct bt_mesh_privacy_key *priv = NULL;
+    const u8_t *enc = NULL;
     u8_t *seq = NULL;
     int err = 0;
 
@@ -876,13 +940,13 @@ int bt_mesh_net_encode(struct bt_mesh_net_tx *tx, struct net_buf_simple *buf,
 
             nid = tx->sub->keys[tx->sub->kr_flag].nid;
             enc = tx->sub->keys[tx->sub->kr_flag].enc;
-            priv = tx->sub->keys[tx->sub->kr_flag].privacy;
+            priv = &tx->sub->keys[tx->sub->kr_flag].privacy;
         }
     } else {
         tx->friend_cred = 0U;
         nid = tx->sub->keys[tx->sub->kr_flag].nid;
         enc = tx->sub->keys[tx->sub->kr_flag].enc;
-        priv = tx->sub->keys[tx->sub->kr_flag].privacy;
+        priv = &tx->sub->keys[tx->sub->kr_flag].privacy;
     }
 
     net_buf_simple_push_u8(buf, (nid | (BLE_MESH_NET_IVI_TX & 1) << 7));
@@ -1032,7 +1096,8 @@ struct bt_mesh_subnet *bt_mesh_subnet_find(const u8_t net_id[8], u8_t flags,
 }
 
 static int net_decrypt(struct bt_mesh_subnet *sub, const u8_t *enc,
-                       const u8_t *priv, const u8_t *data,
+                       const struct bt_mesh_privacy_key *priv,
+                       const u8_t *data,
                        size_t data_len, struct bt_mesh_net_rx *rx,
                        struct net_buf_simple *buf)
 {
@@ -1070,93 +1135,85 @@ static int net_decrypt(struct bt_mesh_subnet *sub, const u8_t *enc,
     return bt_mesh_net_decrypt(enc, buf, BLE_MESH_NET_IVI_RX(rx), false);
 }
 
-#if (defined(CONFIG_BLE_MESH_LOW_POWER) || \
-     defined(CONFIG_BLE_MESH_FRIEND))
-static int friend_decrypt(struct bt_mesh_subnet *sub, const u8_t *data,
-                          size_t data_len, struct bt_mesh_net_rx *rx,
-                          struct net_buf_simple *buf)
+static size_t nid_index_subnet_count(void)
 {
-    int i;
-
-    BT_DBG("NID 0x%02x net_idx 0x%04x", NID(data), sub->net_idx);
+    return bt_mesh_rx_netkey_size();
+}
 
-    for (i = 0; i < ARRAY_SIZE(friend_cred); i++) {
-        struct friend_cred *cred = &friend_cred[i];
+static bool nid_index_subnet(size_t i, struct bt_mesh_nid_keys *keys)
+{
+    struct bt_mesh_subnet *sub = bt_mesh_rx_netkey_get(i);
 
-        if (cred->net_idx != sub->net_idx) {
-            continue;
-        }
+    if (!sub) {
+        return false;
+    }
 
-        if (NID(data) == cred->cred[0].nid &&
-                !net_decrypt(sub, cred->cred[0].enc, cred->cred[0].privacy,
-                             data, data_len, rx, buf)) {
-            return 0;
-        }
+    keys->used = (sub->net_idx != BLE_MESH_KEY_UNUSED);
+    keys->net_idx = sub->net_idx;
+    keys->kr = (sub->kr_phase != BLE_MESH_KR_NORMAL);
+    keys->nid[0] = sub->keys[0].nid;
+    keys->nid[1] = sub->keys[1].nid;
+    return true;
+}
 
-        if (sub->kr_phase == BLE_MESH_KR_NORMAL) {
-            continue;
-        }
+static bool nid_index_cred(size_t i, struct bt_mesh_nid_keys *keys)
+{
+#if FRIEND_CRED_COUNT > 0
+    struct friend_cred *cred = &friend_cred[i];
 
-        if (NID(data) == cred->cred[1].nid &&
-                !net_decrypt(sub, cred->cred[1].enc, cred->cred[1].privacy,
-                             data, data_len, rx, buf)) {
-            rx->new_key = 1U;
-            return 0;
-        }
+    if (cred->net_idx == BLE_MESH_KEY_UNUSED) {
+        return false;
     }
 
-    return -ENOENT;
-}
+    keys->used = true;
+    keys->net_idx = cred->net_idx;
+    keys->nid[0] = cred->cred[0].nid;
+    keys->nid[1] = cred->cred[1].nid;
+    return true;
+#else
+    return false;
 #endif
+}
+
+void bt_mesh_net_nid_index_invalidate(void)
+{
+    bt_mesh_nid_index_invalidate(&nid_index);
+}
 
 static bool net_find_and_decrypt(const u8_t *data, size_t data_len,
                                  struct bt_mesh_net_rx *rx,
                                  struct net_buf_simple *buf)
 {
+    const struct bt_mesh_privacy_key *priv = NULL;
+    struct bt_mesh_nid_cand cand = {0};
     struct bt_mesh_subnet *sub = NULL;
-    size_t array_size = 0U;
-    int i;
+    u16_t entry = BLE_MESH_NID_INDEX_NONE;
+    const u8_t *enc = NULL;
 
     BT_DBG("%s", __func__);
 
-    array_size = bt_mesh_rx_netkey_size();
+    while (bt_mesh_nid_index_next(&nid_index, NID(data), &entry, &cand)) {
+        sub = bt_mesh_rx_netkey_get(cand.sub);
 
-    for (i = 0; i < array_size; i++) {
-        sub = bt_mesh_rx_netkey_get(i);
-        if (!sub) {
-            BT_DBG("%s, NULL subnet", __func__);
-            continue;
-        }
-
-        if (sub->net_idx == BLE_MESH_KEY_UNUSED) {
+        if (cand.cred == BLE_MESH_NID_INDEX_NONE) {
+            enc = sub->keys[cand.new_key].enc;
+            priv = &sub->keys[cand.new_key].privacy;
+        } else {
+#if FRIEND_CRED_COUNT > 0
+            enc = friend_cred[cand.cred].cred[cand.new_key].enc;
+            priv = &friend_cred[cand.cred].cred[cand.new_key].privacy;
+#else
             continue;
-        }
-
-#if (defined(CONFIG_BLE_MESH_LOW_POWER) || defined(CONFIG_BLE_MESH_FRIEND))
-        if (!friend_decrypt(sub, data, data_len, rx, buf)) {
-            rx->friend_cred = 1;
-            rx->ctx.net_idx = sub->net_idx;
-            rx->sub = sub;
-            return true;
-        }
 #endif
-
-        if (NID(data) == sub->keys[0].nid &&
-                !net_decrypt(sub, sub->keys[0].enc, sub->keys[0].privacy,
-                             data, data_len, rx, buf)) {
-            rx->ctx.net_idx = sub->net_idx;
-            rx->sub = sub;
-            return true;
-        }
-
-        if (sub->kr_phase == BLE_MESH_KR_NORMAL) {
-            continue;
         }
 
-        if (NID(data) == sub->keys[1].nid &&
-                !net_decrypt(sub, sub->keys[1].enc, sub->keys[1].privacy,
-                             data, data_len, rx, buf)) {
-            rx->new_key = 1U;
+        if (!net_decrypt(sub, enc, priv, data, data_len, rx, buf)) {
+            if (cand.cred != BLE_MESH_NID_INDEX_NONE) {
+                rx->friend_cred = 1U;
+            }
+            if (cand.new_key) {
+                rx->new_key = 1U;
+            }
             rx->ctx.net_idx = sub->net_idx;
             rx->sub = sub;
             return true;
@@ -1188,7 +1245,8 @@ static bool relay_to_adv(enum bt_mesh_net_if net_if)
 static void bt_mesh_net_relay(struct net_buf_simple *sbuf,
                               struct bt_mesh_net_rx *rx)
 {
-    const u8_t *enc = NULL, *priv = NULL;
+    const struct bt_mesh_privacy_key *priv = NULL;
+    const u8_t *enc = NULL;
     struct net_buf *buf = NULL;
     u8_t nid = 0U, transmit = 0U;
 
@@ -1261,7 +1319,7 @@ static void bt_mesh_net_relay(struct net_buf_simple *sbuf,
     net_buf_add_mem(buf, sbuf->data, sbuf->len);
 
     enc = rx->sub->keys[rx->sub->kr_flag].enc;
-    priv = rx->sub->keys[rx->sub->kr_flag].privacy;
+    priv = &rx->sub->keys[rx->sub->kr_flag].privacy;
     nid = rx->sub->keys[rx->sub->kr_flag].nid;
 
     BT_DBG("Relaying packet. TTL is now %u", TTL(buf->data));
@@ -1330,7 +1388,10 @@ int bt_mesh_net_decode(struct net_buf_simple *data, enum bt_mesh_net_if net_if,
         return -EINVAL;
     }
 
-    if (net_if == BLE_MESH_NET_IF_ADV && check_dup(data)) {
+    rx->pdu_cache_idx = BLE_MESH_MSG_CACHE_NONE;
+    rx->msg_cache_idx = BLE_MESH_MSG_CACHE_NONE;
+
+    if (net_if == BLE_MESH_NET_IF_ADV && check_dup(data, rx)) {
         return -EINVAL;
     }
 
@@ -1456,9 +1517,8 @@ void bt_mesh_net_recv(struct net_buf_simple *data, s8_t rssi,
     */
     if (bt_mesh_trans_recv(&buf, &rx) == -EAGAIN) {
         BT_WARN("Removing rejected message from Network Message Cache");
-        msg_cache[rx.msg_cache_idx] = 0ULL;
-        /* Rewind the next index now that we're not using this entry */
-        msg_cache_next = rx.msg_cache_idx;
+        bt_mesh_msg_cache_remove(&msg_cache, rx.msg_cache_idx);
+        bt_mesh_msg_cache_remove(&pdu_cache, rx.pdu_cache_idx);
     }
 
     /* Relay if this was a group/virtual address, or if the destination
@@ -1548,6 +1608,8 @@ void bt_mesh_net_init(void)
     k_delayed_work_init(&bt_mesh.ivu_timer, ivu_refresh);
 
     k_work_init(&bt_mesh.local_work, bt_mesh_net_local);
+
+    msg_caches_reset();
 }
 
 void bt_mesh_net_deinit(bool erase)
@@ -1564,11 +1626,8 @@ void bt_mesh_net_deinit(bool erase)
     memset(friend_cred, 0, sizeof(friend_cred));
 #endif
 
-    memset(msg_cache, 0, sizeof(msg_cache));
-    msg_cache_next = 0U;
-
-    memset(dup_cache, 0, sizeof(dup_cache));
-    dup_cache_next = 0U;
+    msg_caches_reset();
+    bt_mesh_net_nid_index_invalidate();
 
     bt_mesh.iv_index = 0U;
     bt_mesh.seq = 0U;
@@ -11,6 +11,7 @@
 #define _NET_H_
 
 #include "mesh_access.h"
+#include "crypto.h"
 
 #define BLE_MESH_NET_FLAG_KR       BIT(0)
 #define BLE_MESH_NET_FLAG_IVU      BIT(1)
@@ -68,7 +69,7 @@ struct bt_mesh_subnet {
 #if defined(CONFIG_BLE_MESH_GATT_PROXY_SERVER)
         u8_t identity[16];  /* IdentityKey */
 #endif
-        u8_t privacy[16];   /* PrivacyKey */
+        struct bt_mesh_privacy_key privacy; /* PrivacyKey */
         u8_t beacon[16];    /* BeaconKey */
     } keys[2];
 };
@@ -298,6 +299,7 @@ struct bt_mesh_net_rx {
            local_match: 1, /* Matched a local element */
            friend_match: 1; /* Matched an LPN we're friends for */
     u16_t  msg_cache_idx;  /* Index of entry in message cache */
+    u16_t  pdu_cache_idx;  /* Index of entry in Network PDU cache */
 };
 
 /* Encoding context for Network/Transport data */
@@ -332,6 +334,11 @@ u8_t bt_mesh_net_flags(struct bt_mesh_subnet *sub);
 
 bool bt_mesh_kr_update(struct bt_mesh_subnet *sub, u8_t new_kr, bool new_key);
 
+/* Must be called when a subnet is added to or removed from the subnets
+ * returned by bt_mesh_rx_netkey_get(), key derivation calls it already.
+ */
+void bt_mesh_net_nid_index_invalidate(void);
+
 void bt_mesh_net_revoke_keys(struct bt_mesh_subnet *sub);
 
 int bt_mesh_net_beacon_update(struct bt_mesh_subnet *sub);
@@ -387,12 +394,13 @@ struct friend_cred {
     struct {
         u8_t nid;         /* NID */
         u8_t enc[16];     /* EncKey */
-        u8_t privacy[16]; /* PrivacyKey */
+        struct bt_mesh_privacy_key privacy; /* PrivacyKey */
     } cred[2];
 };
 
 int friend_cred_get(struct bt_mesh_subnet *sub, u16_t addr, u8_t *nid,
-                    const u8_t **enc, const u8_t **priv);
+                    const u8_t **enc,
+                    const struct bt_mesh_privacy_key **priv);
 int friend_cred_set(struct friend_cred *cred, u8_t idx, const u8_t net_key[16]);
 void friend_cred_refresh(u16_t net_idx);
 int friend_cred_update(struct bt_mesh_subnet *sub);
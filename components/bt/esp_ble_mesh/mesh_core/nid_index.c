@@ -0,0 +1,147 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "nid_index.h"
+
+/* The entries below max_subnets * 2 are the keys of the subnets, the
+ * following ones the keys of the credentials. Bit 0 is set for new keys.
+ */
+static u16_t cred_entry(struct bt_mesh_nid_index *index, u16_t cred)
+{
+    return (index->max_subnets + cred) * 2;
+}
+
+static void index_add(struct bt_mesh_nid_index *index, u16_t entry, u8_t nid)
+{
+    nid &= 0x7F;
+    index->next[entry] = index->head[nid];
+    index->head[nid] = entry;
+}
+
+static void index_build(struct bt_mesh_nid_index *index)
+{
+    struct bt_mesh_nid_keys sub_keys = {0};
+    struct bt_mesh_nid_keys keys = {0};
+    int subnets = 0;
+    int i, j;
+
+    /* Set before reading the keys, so that a key changed meanwhile makes
+     * the next lookup rebuild the index again.
+     */
+    index->valid = true;
+
+    subnets = index->ops->subnet_count();
+    if (subnets > index->max_subnets) {
+        subnets = index->max_subnets;
+    }
+    index->subnets = subnets;
+
+    (void)memset(index->head, 0xFF, sizeof(index->head));
+
+    for (i = 0; i < index->max_creds; i++) {
+        index->cred_sub[i] = BLE_MESH_NID_INDEX_NONE;
+
+        if (!index->ops->cred(i, &keys)) {
+            continue;
+        }
+
+        for (j = 0; j < subnets; j++) {
+            if (index->ops->subnet(j, &sub_keys) && sub_keys.used &&
+                    sub_keys.net_idx == keys.net_idx) {
+                index->cred_sub[i] = j;
+                break;
+            }
+        }
+    }
+
+    /* Entries are added at the head of the lists. Add them backwards, so
+     * that the subnets are tried in order, each with the keys of its
+     * friendship credentials first.
+     */
+    for (i = subnets - 1; i >= 0; i--) {
+        /* Unused subnets are indexed too, as keys may be created before
+         * the NetKeyIndex of a subnet is set.
+         */
+        if (!index->ops->subnet(i, &sub_keys)) {
+            continue;
+        }
+
+        index_add(index, i * 2 + 1, sub_keys.nid[1]);
+        index_add(index, i * 2, sub_keys.nid[0]);
+
+        for (j = index->max_creds - 1; j >= 0; j--) {
+            if (index->cred_sub[j] != i || !index->ops->cred(j, &keys)) {
+                continue;
+            }
+
+            index_add(index, cred_entry(index, j) + 1, keys.nid[1]);
+            index_add(index, cred_entry(index, j), keys.nid[0]);
+        }
+    }
+}
+
+/* Returns true if the keys of the entry are still those indexed */
+static bool entry_valid(struct bt_mesh_nid_index *index, u16_t entry, u8_t nid,
+                        struct bt_mesh_nid_cand *cand)
+{
+    struct bt_mesh_nid_keys sub_keys = {0};
+    struct bt_mesh_nid_keys keys = {0};
+
+    cand->new_key = entry & 1;
+
+    if (entry < cred_entry(index, 0)) {
+        cand->sub = entry / 2;
+        cand->cred = BLE_MESH_NID_INDEX_NONE;
+        if (!index->ops->subnet(cand->sub, &sub_keys) || !sub_keys.used) {
+            return false;
+        }
+        keys = sub_keys;
+    } else {
+        cand->cred = entry / 2 - index->max_subnets;
+        cand->sub = index->cred_sub[cand->cred];
+        if (!index->ops->cred(cand->cred, &keys) ||
+                !index->ops->subnet(cand->sub, &sub_keys) ||
+                !sub_keys.used || keys.net_idx != sub_keys.net_idx) {
+            return false;
+        }
+    }
+
+    return keys.nid[cand->new_key] == nid && (!cand->new_key || sub_keys.kr);
+}
+
+bool bt_mesh_nid_index_next(struct bt_mesh_nid_index *index, u8_t nid,
+                            u16_t *entry, struct bt_mesh_nid_cand *cand)
+{
+    nid &= 0x7F;
+
+    if (*entry == BLE_MESH_NID_INDEX_NONE) {
+        if (!index->valid ||
+                index->subnets != index->ops->subnet_count()) {
+            index_build(index);
+        }
+        *entry = index->head[nid];
+    } else {
+        *entry = index->next[*entry];
+    }
+
+    for (; *entry != BLE_MESH_NID_INDEX_NONE; *entry = index->next[*entry]) {
+        if (entry_valid(index, *entry, nid, cand)) {
+            return true;
+        }
+    }
+
+    return false;
+}
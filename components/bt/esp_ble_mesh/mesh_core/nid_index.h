@@ -0,0 +1,105 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _BLE_MESH_NID_INDEX_H_
+#define _BLE_MESH_NID_INDEX_H_
+
+#include "mesh_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Candidate keys of each NID, so that a received Network PDU is only
+ * deobfuscated and decrypted with the keys which may have been used to send
+ * it. The candidates are the two keys of each subnet and of each friendship
+ * credential, referred to by their position. The index is rebuilt for the
+ * next lookup when it is invalidated or the number of subnets changes, and
+ * each candidate is checked against the current keys before it is returned.
+ */
+
+/* Keys of a subnet or of a friendship credential */
+struct bt_mesh_nid_keys {
+    bool  used;     /* The NetKeyIndex is set */
+    u16_t net_idx;
+    bool  kr;       /* Key Refresh in progress, the new key may be used */
+    u8_t  nid[2];   /* NID of the old and the new key */
+};
+
+/* Read the current keys. subnet() returns false if there is no subnet at
+ * the position, cred() if the credential is not used. The kr field of a
+ * credential is ignored, the one of its subnet applies.
+ */
+struct bt_mesh_nid_index_ops {
+    size_t (*subnet_count)(void);
+    bool (*subnet)(size_t i, struct bt_mesh_nid_keys *keys);
+    bool (*cred)(size_t i, struct bt_mesh_nid_keys *keys);
+};
+
+struct bt_mesh_nid_index {
+    const struct bt_mesh_nid_index_ops *ops;
+    u16_t max_subnets;
+    u16_t max_creds;
+    bool  valid;
+    u16_t subnets;      /* Subnets when the index was built */
+    u16_t head[0x80];   /* First candidate of each NID */
+    u16_t *next;        /* Next candidate with the same NID */
+    u16_t *cred_sub;    /* Subnet of each credential */
+};
+
+/* A candidate key */
+struct bt_mesh_nid_cand {
+    u16_t sub;      /* Position of the subnet */
+    u16_t cred;     /* Position of the credential, BLE_MESH_NID_INDEX_NONE
+                     * for the keys of the subnet itself.
+                     */
+    u8_t  new_key;
+};
+
+/* Ends the candidates of a NID */
+#define BLE_MESH_NID_INDEX_NONE     0xFFFF
+
+/* Statically define an index of up to _subnets subnets and _creds friendship
+ * credentials. It is built on first use.
+ */
+#define BLE_MESH_NID_INDEX_DEFINE(_name, _subnets, _creds, _ops)                \
+    static u16_t _name##_next[((_subnets) + (_creds)) * 2];                     \
+    static u16_t _name##_cred_sub[(_creds) ? (_creds) : 1];                     \
+    static struct bt_mesh_nid_index _name = {                                   \
+        .ops = (_ops),                                                          \
+        .max_subnets = (_subnets),                                              \
+        .max_creds = (_creds),                                                  \
+        .next = _name##_next,                                                   \
+        .cred_sub = _name##_cred_sub,                                           \
+    }
+
+/* Rebuild the index on the next lookup */
+static inline void bt_mesh_nid_index_invalidate(struct bt_mesh_nid_index *index)
+{
+    index->valid = false;
+}
+
+/* Get the candidate following *entry with the given NID. Start with *entry
+ * set to BLE_MESH_NID_INDEX_NONE. The subnets are returned in order, each
+ * with the keys of its friendship credentials first. Returns false when
+ * there are no more candidates.
+ */
+bool bt_mesh_nid_index_next(struct bt_mesh_nid_index *index, u8_t nid,
+                            u16_t *entry, struct bt_mesh_nid_cand *cand);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLE_MESH_NID_INDEX_H_ */
@@ -131,6 +131,7 @@ int bt_mesh_provisioner_net_create(void)
     sub->node_id = BLE_MESH_NODE_IDENTITY_NOT_SUPPORTED;
 
     bt_mesh.p_sub[0] = sub;
+    bt_mesh_net_nid_index_invalidate();
 
     /* Dynamically added appkey & netkey will use these key_idx */
     bt_mesh.p_app_idx_next = 0x0000;
@@ -1341,6 +1342,7 @@ int bt_mesh_provisioner_local_net_key_add(const u8_t net_key[16], u16_t *net_idx
     sub->node_id  = BLE_MESH_NODE_IDENTITY_NOT_SUPPORTED;
 
     bt_mesh.p_sub[add] = sub;
+    bt_mesh_net_nid_index_invalidate();
 
     if (IS_ENABLED(CONFIG_BLE_MESH_SETTINGS)) {
         bt_mesh_store_p_net_idx();
@@ -31,8 +31,12 @@
  * key: "mesh/seq"    -> write/read to set/get SEQ data
  * key: "mesh/hb_pub" -> write/read to set/get CFG HB_PUB data
  * key: "mesh/cfg"    -> write/read to set/get CFG data
- * key: "mesh/rpl"    -> write/read to set/get all RPL src.
- *      key: "mesh/rpl/xxxx" -> write/read to set/get the "xxxx" RPL data
+ * key: "mesh/rplb/xxxx" -> write/read to set/get the "xxxx" block of RPL
+ *      entries, block "xxxx" holds the used entries among bt_mesh.rpl
+ *      [xxxx * RPL_BLOCK_SIZE, (xxxx + 1) * RPL_BLOCK_SIZE)
+ * key: "mesh/rpl"    -> read to get all RPL src of the previous RPL format.
+ *      key: "mesh/rpl/xxxx" -> read to get the "xxxx" RPL data, migrated
+ *      to the RPL blocks and erased when loaded
  * key: "mesh/netkey" -> write/read to set/get all NetKey Indexes
  *      key: "mesh/nk/xxxx" -> write/read to set/get the "xxxx" NetKey data
  * key: "mesh/appkey" -> write/read to set/get all AppKey Indexes
@@ -110,6 +114,20 @@ struct rpl_val {
           old_iv: 1;
 };
 
+/* Replay Protection List block storage, each block is an array of the used
+ * entries of RPL_BLOCK_SIZE consecutive RPL entries. Replayed messages only
+ * rewrite the blocks of the changed entries instead of one key per source
+ * plus the list of sources.
+ */
+#define RPL_BLOCK_SIZE  16
+#define RPL_BLOCK_COUNT ((ARRAY_SIZE(bt_mesh.rpl) + RPL_BLOCK_SIZE - 1) / RPL_BLOCK_SIZE)
+
+struct rpl_block_val {
+    u16_t src;
+    u32_t seq: 24,
+          old_iv: 1;
+} __packed;
+
 /* NetKey storage information */
 struct net_key_val {
     u8_t  kr_flag: 1,
@@ -313,8 +331,54 @@ static struct bt_mesh_rpl *rpl_alloc(u16_t src)
     return NULL;
 }
 
-static int rpl_set(const char *name)
+static void store_rpl_block(int block);
+
+static int rpl_block_set(int block)
+{
+    struct net_buf_simple *buf = NULL;
+    char get[16] = {'\0'};
+    size_t count = 0U;
+    int i;
+
+    sprintf(get, "mesh/rplb/%04x", block);
+
+    buf = bt_mesh_get_core_settings_item(get);
+    if (!buf) {
+        return 0;
+    }
+
+    count = buf->len / sizeof(struct rpl_block_val);
+    if (count > RPL_BLOCK_SIZE ||
+        block * RPL_BLOCK_SIZE + count > ARRAY_SIZE(bt_mesh.rpl)) {
+        BT_WARN("%s, RPL block %d truncated", __func__, block);
+        count = MIN(RPL_BLOCK_SIZE, ARRAY_SIZE(bt_mesh.rpl) - block * RPL_BLOCK_SIZE);
+    }
+
+    /* Entries are restored at the positions of their block, so that the
+     * block of an entry does not change.
+     */
+    for (i = 0; i < count; i++) {
+        struct bt_mesh_rpl *entry = &bt_mesh.rpl[block * RPL_BLOCK_SIZE + i];
+        struct rpl_block_val rpl = {0};
+
+        memcpy(&rpl, buf->data + i * sizeof(rpl), sizeof(rpl));
+
+        BT_INFO("Restored RPL 0x%04x: Seq 0x%06x, old_iv %u", rpl.src, rpl.seq, rpl.old_iv);
+        entry->src = rpl.src;
+        entry->seq = rpl.seq;
+        entry->old_iv = rpl.old_iv;
+    }
+
+    bt_mesh_free_buf(buf);
+    return 0;
+}
+
+/* Restore the RPL stored with one key per source by previous versions, the
+ * entries are written to the RPL blocks and the old keys are erased.
+ */
+static int rpl_legacy_set(const char *name)
 {
+    struct net_buf_simple_state state = {0};
     struct net_buf_simple *buf = NULL;
     struct bt_mesh_rpl *entry = NULL;
     struct rpl_val rpl = {0};
@@ -324,13 +388,12 @@ static int rpl_set(const char *name)
     int err = 0;
     int i;
 
-    BT_DBG("%s", __func__);
-
     buf = bt_mesh_get_core_settings_item(name);
     if (!buf) {
         return 0;
     }
 
+    net_buf_simple_save(buf, &state);
     length = buf->len;
 
     for (i = 0; i < length / SETTINGS_ITEM_SIZE; i++) {
@@ -364,11 +427,41 @@ static int rpl_set(const char *name)
         entry->old_iv = rpl.old_iv;
     }
 
+    BT_INFO("Migrate RPL to blocks");
+
+    for (i = 0; i < RPL_BLOCK_COUNT; i++) {
+        store_rpl_block(i);
+    }
+
+    net_buf_simple_restore(buf, &state);
+    for (i = 0; i < length / SETTINGS_ITEM_SIZE; i++) {
+        sprintf(get, "mesh/rpl/%04x", net_buf_simple_pull_le16(buf));
+        bt_mesh_save_core_settings(get, NULL, 0);
+    }
+    bt_mesh_save_core_settings(name, NULL, 0);
+
 free:
     bt_mesh_free_buf(buf);
     return err;
 }
 
+static int rpl_set(const char *name)
+{
+    int err = 0;
+    int i;
+
+    BT_DBG("%s", __func__);
+
+    for (i = 0; i < RPL_BLOCK_COUNT; i++) {
+        err = rpl_block_set(i);
+        if (err) {
+            return err;
+        }
+    }
+
+    return rpl_legacy_set(name);
+}
+
 static struct bt_mesh_subnet *subnet_alloc(u16_t net_idx)
 {
     int i;
@@ -1553,30 +1646,36 @@ void bt_mesh_clear_seq(void)
     bt_mesh_save_core_settings("mesh/seq", NULL, 0);
 }
 
-static void store_rpl(struct bt_mesh_rpl *entry)
+static void store_rpl_block(int block)
 {
-    struct rpl_val rpl = {0};
+    struct rpl_block_val rpl[RPL_BLOCK_SIZE];
     char name[16] = {'\0'};
+    size_t count = 0U;
     int err = 0;
+    int i;
+
+    for (i = block * RPL_BLOCK_SIZE;
+         i < MIN((block + 1) * RPL_BLOCK_SIZE, ARRAY_SIZE(bt_mesh.rpl)); i++) {
+        struct bt_mesh_rpl *entry = &bt_mesh.rpl[i];
 
-    BT_DBG("src 0x%04x seq 0x%06x old_iv %u", entry->src, entry->seq, entry->old_iv);
+        if (entry->src == BLE_MESH_ADDR_UNASSIGNED) {
+            continue;
+        }
 
-    rpl.seq = entry->seq;
-    rpl.old_iv = entry->old_iv;
+        BT_DBG("src 0x%04x seq 0x%06x old_iv %u", entry->src, entry->seq, entry->old_iv);
 
-    sprintf(name, "mesh/rpl/%04x", entry->src);
-    err = bt_mesh_save_core_settings(name, (const u8_t *)&rpl, sizeof(rpl));
-    if (err) {
-        BT_ERR("%s, Failed to save RPL %s", __func__, name);
-        return;
+        rpl[count].src = entry->src;
+        rpl[count].seq = entry->seq;
+        rpl[count].old_iv = entry->old_iv;
+        count++;
     }
 
-    err = bt_mesh_add_core_settings_item("mesh/rpl", entry->src);
+    sprintf(name, "mesh/rplb/%04x", block);
+    err = bt_mesh_save_core_settings(name, count ? (const u8_t *)rpl : NULL,
+                                     count * sizeof(rpl[0]));
     if (err) {
-        BT_ERR("%s, Failed to add 0x%04x to mesh/rpl", __func__, entry->src);
+        BT_ERR("%s, Failed to save RPL %s", __func__, name);
     }
-
-    return;
 }
 
 static void clear_rpl(void)
@@ -1591,10 +1690,14 @@ static void clear_rpl(void)
 
     bt_mesh_rpl_clear();
 
+    for (i = 0; i < RPL_BLOCK_COUNT; i++) {
+        sprintf(name, "mesh/rplb/%04x", i);
+        bt_mesh_save_core_settings(name, NULL, 0);
+    }
+
+    /* RPL of the previous format which has not been migrated */
     buf = bt_mesh_get_core_settings_item("mesh/rpl");
     if (!buf) {
-        BT_WARN("%s, Erase RPL", __func__);
-        bt_mesh_save_core_settings("mesh/rpl", NULL, 0);
         return;
     }
 
@@ -1614,16 +1717,23 @@ static void clear_rpl(void)
 
 static void store_pending_rpl(void)
 {
-    int i;
+    int i, j;
 
     BT_DBG("%s", __func__);
 
-    for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
-        struct bt_mesh_rpl *rpl = &bt_mesh.rpl[i];
+    for (i = 0; i < RPL_BLOCK_COUNT; i++) {
+        bool store = false;
+
+        for (j = i * RPL_BLOCK_SIZE;
+             j < MIN((i + 1) * RPL_BLOCK_SIZE, ARRAY_SIZE(bt_mesh.rpl)); j++) {
+            if (bt_mesh.rpl[j].store) {
+                bt_mesh.rpl[j].store = false;
+                store = true;
+            }
+        }
 
-        if (rpl->store) {
-            rpl->store = false;
-            store_rpl(rpl);
+        if (store) {
+            store_rpl_block(i);
         }
     }
 }
@@ -1988,6 +2098,9 @@ static void store_pending(struct k_work *work)
 {
     BT_DBG("%s", __func__);
 
+    /* Write each changed key once, with a single nvs commit */
+    bt_mesh_begin_core_settings_batch();
+
     if (bt_mesh_atomic_test_and_clear_bit(bt_mesh.flags, BLE_MESH_RPL_PENDING)) {
         if (!IS_ENABLED(CONFIG_BLE_MESH_NODE) || bt_mesh_is_provisioned()) {
             store_pending_rpl();
@@ -2048,6 +2161,8 @@ static void store_pending(struct k_work *work)
     if (bt_mesh_atomic_test_and_clear_bit(bt_mesh.flags, BLE_MESH_VA_PENDING)) {
         store_pending_va();
     }
+
+    bt_mesh_commit_core_settings_batch();
 }
 
 void bt_mesh_store_rpl(struct bt_mesh_rpl *entry)
@@ -2430,23 +2545,15 @@ void bt_mesh_clear_p_app_key(struct bt_mesh_app_key *key)
     clear_p_app_key(key->app_idx);
 }
 
-void bt_mesh_clear_rpl_single(u16_t src)
+void bt_mesh_clear_rpl_single(int index)
 {
-    char name[16] = {'\0'};
-    int err = 0;
-
-    if (!BLE_MESH_ADDR_IS_UNICAST(src)) {
-        BT_ERR("%s, Invalid source address 0x%04x", __func__, src);
+    if (index < 0 || index >= ARRAY_SIZE(bt_mesh.rpl)) {
+        BT_ERR("%s, Invalid RPL index %d", __func__, index);
         return;
     }
 
-    sprintf(name, "mesh/rpl/%04x", src);
-    bt_mesh_save_core_settings(name, NULL, 0);
-
-    err = bt_mesh_remove_core_settings_item("mesh/rpl", src);
-    if (err) {
-        BT_ERR("%s, Failed to remove 0x%04x from mesh/rpl", __func__, src);
-    }
+    /* Only the block of the cleared entry changes */
+    store_rpl_block(index / RPL_BLOCK_SIZE);
 }
 
 void bt_mesh_store_node_info(struct bt_mesh_node *node, bool prov)
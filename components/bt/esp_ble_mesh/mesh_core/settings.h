@@ -48,7 +48,7 @@ void bt_mesh_store_p_subnet(struct bt_mesh_subnet *sub);
 void bt_mesh_store_p_app_key(struct bt_mesh_app_key *key);
 void bt_mesh_clear_p_subnet(struct bt_mesh_subnet *sub);
 void bt_mesh_clear_p_app_key(struct bt_mesh_app_key *key);
-void bt_mesh_clear_rpl_single(u16_t src);
+void bt_mesh_clear_rpl_single(int index);
 void bt_mesh_store_node_info(struct bt_mesh_node *node, bool prov);
 void bt_mesh_clear_node_info(u16_t unicast_addr, bool prov);
 void bt_mesh_store_node_name(struct bt_mesh_node *node, bool prov);
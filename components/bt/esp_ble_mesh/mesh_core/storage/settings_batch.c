@@ -0,0 +1,187 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include <errno.h>
+
+#include "settings_batch.h"
+
+/* Maximum nvs key length, including the terminating null */
+#define KEY_SIZE        16
+
+enum {
+    RECORD_SET,
+    RECORD_ERASE,
+    RECORD_DEAD,    /* Replaced by a later record of the same key */
+};
+
+/* Staged records follow each other in the buffer, each one is a header
+ * followed by the value padded to a multiple of 4 bytes.
+ */
+struct batch_record {
+    char  key[KEY_SIZE];
+    u16_t len;
+    u8_t  state;
+    u8_t  rfu;
+};
+
+static size_t record_size(size_t len)
+{
+    return sizeof(struct batch_record) + ((len + 3) & ~3);
+}
+
+static struct batch_record *record_find(struct bt_mesh_settings_batch *batch, const char *key)
+{
+    size_t offset = 0U;
+
+    while (offset < batch->used) {
+        struct batch_record *record = (struct batch_record *)(batch->buf + offset);
+
+        if (record->state != RECORD_DEAD && !strcmp(record->key, key)) {
+            return record;
+        }
+
+        offset += record_size(record->len);
+    }
+
+    return NULL;
+}
+
+static int write_direct(nvs_handle_t handle, const char *key, const u8_t *val, size_t len)
+{
+    esp_err_t err;
+
+    if (val) {
+        err = nvs_set_blob(handle, key, val, len);
+    } else {
+        err = nvs_erase_key(handle, key);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    }
+
+    return err == ESP_OK ? 0 : -EIO;
+}
+
+void bt_mesh_settings_batch_init(struct bt_mesh_settings_batch *batch,
+                                 nvs_handle_t handle, u8_t *buf, size_t size)
+{
+    batch->handle = handle;
+    batch->buf = buf;
+    batch->size = size & ~3;
+    batch->used = 0U;
+}
+
+int bt_mesh_settings_batch_set(struct bt_mesh_settings_batch *batch,
+                               const char *key, const u8_t *val, size_t len)
+{
+    struct batch_record *record = NULL;
+    int err = 0;
+
+    if (key == NULL || strlen(key) >= KEY_SIZE) {
+        return -EINVAL;
+    }
+
+    if (val == NULL) {
+        len = 0U;
+    }
+
+    record = record_find(batch, key);
+    if (record) {
+        if (record->len == len) {
+            /* Overwrite the staged value in place */
+            record->state = val ? RECORD_SET : RECORD_ERASE;
+            if (val) {
+                memcpy(record + 1, val, len);
+            }
+            return 0;
+        }
+        record->state = RECORD_DEAD;
+    }
+
+    if (record_size(len) > batch->size) {
+        /* Keep the order of the writes of this key */
+        err = bt_mesh_settings_batch_flush(batch);
+        if (write_direct(batch->handle, key, val, len)) {
+            return -EIO;
+        }
+        return err;
+    }
+
+    if (batch->used + record_size(len) > batch->size) {
+        err = bt_mesh_settings_batch_flush(batch);
+    }
+
+    record = (struct batch_record *)(batch->buf + batch->used);
+    strcpy(record->key, key);
+    record->len = len;
+    record->state = val ? RECORD_SET : RECORD_ERASE;
+    record->rfu = 0U;
+    if (val) {
+        memcpy(record + 1, val, len);
+    }
+    batch->used += record_size(len);
+
+    return err;
+}
+
+int bt_mesh_settings_batch_get(struct bt_mesh_settings_batch *batch,
+                               const char *key, const u8_t **val, size_t *len)
+{
+    struct batch_record *record = NULL;
+
+    if (key == NULL) {
+        return -ENOENT;
+    }
+
+    record = record_find(batch, key);
+    if (!record) {
+        return -ENOENT;
+    }
+
+    *val = record->state == RECORD_SET ? (const u8_t *)(record + 1) : NULL;
+    *len = record->len;
+    return 0;
+}
+
+int bt_mesh_settings_batch_flush(struct bt_mesh_settings_batch *batch)
+{
+    size_t offset = 0U;
+    int err = 0;
+
+    if (batch->used == 0U) {
+        return 0;
+    }
+
+    while (offset < batch->used) {
+        struct batch_record *record = (struct batch_record *)(batch->buf + offset);
+
+        if (record->state != RECORD_DEAD &&
+                write_direct(batch->handle, record->key,
+                             record->state == RECORD_SET ? (const u8_t *)(record + 1) : NULL,
+                             record->len)) {
+            err = -EIO;
+        }
+
+        offset += record_size(record->len);
+    }
+
+    batch->used = 0U;
+
+    if (nvs_commit(batch->handle) != ESP_OK) {
+        err = -EIO;
+    }
+
+    return err;
+}
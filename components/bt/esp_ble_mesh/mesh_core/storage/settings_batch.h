@@ -0,0 +1,71 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _BLE_MESH_SETTINGS_BATCH_H_
+#define _BLE_MESH_SETTINGS_BATCH_H_
+
+#include <stddef.h>
+
+#include "nvs.h"
+#include "mesh_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default size of the staging buffer of a batch */
+#define BLE_MESH_SETTINGS_BATCH_SIZE    2048
+
+/* Write batch of one nvs namespace.
+ *
+ * Writes and erases are staged in a caller provided buffer, a key which is
+ * written several times before the flush is only stored once with its last
+ * value. Reads of staged keys return the staged value, so read-modify-write
+ * sequences (e.g. settings item lists) work on the batch as on nvs.
+ */
+struct bt_mesh_settings_batch {
+    nvs_handle_t handle;
+    u8_t  *buf;
+    size_t size;
+    size_t used;
+};
+
+void bt_mesh_settings_batch_init(struct bt_mesh_settings_batch *batch,
+                                 nvs_handle_t handle, u8_t *buf, size_t size);
+
+/* Stages a write of the value, or an erase of the key if val is NULL.
+ * The staged data is flushed first if the buffer is full, and values too
+ * large for the buffer are written directly.
+ * Returns 0 on success, -EINVAL for an invalid key, -EIO if nvs failed.
+ */
+int bt_mesh_settings_batch_set(struct bt_mesh_settings_batch *batch,
+                               const char *key, const u8_t *val, size_t len);
+
+/* Looks up a staged key. Returns -ENOENT if the key is not staged, otherwise
+ * 0 with *val and *len set to the staged value, *val is NULL if the key is
+ * staged for erase. The value is valid until the next set or flush.
+ */
+int bt_mesh_settings_batch_get(struct bt_mesh_settings_batch *batch,
+                               const char *key, const u8_t **val, size_t *len);
+
+/* Writes all staged keys and commits them, the batch is empty afterwards.
+ * Returns 0 on success, -EIO if any of the nvs operations failed.
+ */
+int bt_mesh_settings_batch_flush(struct bt_mesh_settings_batch *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BLE_MESH_SETTINGS_BATCH_H_ */
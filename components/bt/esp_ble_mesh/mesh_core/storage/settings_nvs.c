@@ -20,6 +20,7 @@
 
 #include "mesh_common.h"
 #include "settings_nvs.h"
+#include "settings_batch.h"
 #include "settings.h"
 
 #if CONFIG_BLE_MESH_SETTINGS
@@ -56,6 +57,11 @@ static struct settings_context settings_ctx[] = {
     },
 };
 
+/* Write batch of the core settings, see bt_mesh_begin_core_settings_batch() */
+static struct bt_mesh_settings_batch core_batch;
+static bool core_batch_active;
+static bt_mesh_mutex_t core_batch_lock;
+
 /* API used to initialize, load and commit BLE Mesh related settings */
 
 void bt_mesh_settings_foreach(void)
@@ -63,6 +69,8 @@ void bt_mesh_settings_foreach(void)
     int err = 0;
     int i;
 
+    bt_mesh_mutex_create(&core_batch_lock);
+
 #if CONFIG_BLE_MESH_SPECIFIC_PARTITION
     err = nvs_flash_init_partition(CONFIG_BLE_MESH_PARTITION_NAME);
     if (err != ESP_OK) {
@@ -119,6 +127,8 @@ void bt_mesh_settings_deforeach(void)
 #if CONFIG_BLE_MESH_SPECIFIC_PARTITION
     nvs_flash_deinit_partition(CONFIG_BLE_MESH_PARTITION_NAME);
 #endif
+
+    bt_mesh_mutex_free(&core_batch_lock);
 }
 
 /* API used to get BLE Mesh related nvs handle */
@@ -128,6 +138,63 @@ static inline nvs_handle settings_get_nvs_handle(enum settings_type type)
     return settings_ctx[type].handle;
 }
 
+/* API used to batch the writes of BLE Mesh core settings. Between begin and
+ * commit, writes of the core settings are staged in RAM and each key is only
+ * written once with its last value when the batch is committed, followed by
+ * a single nvs commit. If no memory is available for the batch, the writes
+ * go to nvs directly.
+ */
+
+void bt_mesh_begin_core_settings_batch(void)
+{
+    u8_t *buf = NULL;
+
+    bt_mesh_mutex_lock(&core_batch_lock);
+
+    if (core_batch_active) {
+        bt_mesh_mutex_unlock(&core_batch_lock);
+        return;
+    }
+
+    buf = bt_mesh_malloc(BLE_MESH_SETTINGS_BATCH_SIZE);
+    if (!buf) {
+        BT_WARN("%s, No memory for batch, write directly", __func__);
+        bt_mesh_mutex_unlock(&core_batch_lock);
+        return;
+    }
+
+    bt_mesh_settings_batch_init(&core_batch, settings_get_nvs_handle(SETTINGS_CORE),
+                                buf, BLE_MESH_SETTINGS_BATCH_SIZE);
+    core_batch_active = true;
+
+    bt_mesh_mutex_unlock(&core_batch_lock);
+}
+
+int bt_mesh_commit_core_settings_batch(void)
+{
+    int err = 0;
+
+    bt_mesh_mutex_lock(&core_batch_lock);
+
+    if (core_batch_active) {
+        err = bt_mesh_settings_batch_flush(&core_batch);
+        if (err) {
+            BT_ERR("%s, Failed to write batched settings (err %d)", __func__, err);
+        }
+
+        bt_mesh_free(core_batch.buf);
+        core_batch_active = false;
+    }
+
+    bt_mesh_mutex_unlock(&core_batch_lock);
+    return err;
+}
+
+static inline bool settings_batched(nvs_handle handle)
+{
+    return core_batch_active && handle == core_batch.handle;
+}
+
 /* API used to store/erase BLE Mesh related settings */
 
 static int settings_save(nvs_handle handle, const char *key, const u8_t *val, size_t len)
@@ -141,6 +208,18 @@ static int settings_save(nvs_handle handle, const char *key, const u8_t *val, si
 
     BT_DBG("%s, nvs %s, key %s", __func__, val ? "set" : "erase", key);
 
+    bt_mesh_mutex_lock(&core_batch_lock);
+    if (settings_batched(handle)) {
+        err = bt_mesh_settings_batch_set(&core_batch, key, val, len);
+        bt_mesh_mutex_unlock(&core_batch_lock);
+        if (err) {
+            BT_ERR("%s, Failed to %s %s data (err %d)", __func__,
+                   val ? "set" : "erase", key, err);
+        }
+        return err;
+    }
+    bt_mesh_mutex_unlock(&core_batch_lock);
+
     if (val) {
         err = nvs_set_blob(handle, key, val, len);
     } else {
@@ -176,6 +255,8 @@ int bt_mesh_save_core_settings(const char *key, const u8_t *val, size_t len)
 static int settings_load(nvs_handle handle, const char *key,
                          u8_t *buf, size_t buf_len, bool *exist)
 {
+    const u8_t *staged = NULL;
+    size_t staged_len = 0U;
     int err = 0;
 
     if (key == NULL || buf == NULL || exist == NULL) {
@@ -183,6 +264,23 @@ static int settings_load(nvs_handle handle, const char *key,
         return -EINVAL;
     }
 
+    bt_mesh_mutex_lock(&core_batch_lock);
+    if (settings_batched(handle) &&
+            bt_mesh_settings_batch_get(&core_batch, key, &staged, &staged_len) == 0) {
+        if (staged && staged_len > buf_len) {
+            bt_mesh_mutex_unlock(&core_batch_lock);
+            BT_ERR("%s, Buffer too small for %s data", __func__, key);
+            return -EIO;
+        }
+        if (staged) {
+            memcpy(buf, staged, staged_len);
+        }
+        bt_mesh_mutex_unlock(&core_batch_lock);
+        *exist = (staged != NULL);
+        return 0;
+    }
+    bt_mesh_mutex_unlock(&core_batch_lock);
+
     err = nvs_get_blob(handle, key, buf, &buf_len);
     if (err != ESP_OK) {
         if (err == ESP_ERR_NVS_NOT_FOUND) {
@@ -209,6 +307,7 @@ int bt_mesh_load_core_settings(const char *key, u8_t *buf, size_t buf_len, bool
 
 static size_t settings_get_length(nvs_handle handle, const char *key)
 {
+    const u8_t *staged = NULL;
     size_t len = 0U;
     int err = 0;
 
@@ -217,6 +316,14 @@ static size_t settings_get_length(nvs_handle handle, const char *key)
         return 0;
     }
 
+    bt_mesh_mutex_lock(&core_batch_lock);
+    if (settings_batched(handle) &&
+            bt_mesh_settings_batch_get(&core_batch, key, &staged, &len) == 0) {
+        bt_mesh_mutex_unlock(&core_batch_lock);
+        return staged ? len : 0;
+    }
+    bt_mesh_mutex_unlock(&core_batch_lock);
+
     err = nvs_get_blob(handle, key, NULL, &len);
     if (err != ESP_OK) {
         if (err != ESP_ERR_NVS_NOT_FOUND) {
@@ -30,6 +30,10 @@ extern "C" {
 void bt_mesh_settings_foreach(void);
 void bt_mesh_settings_deforeach(void);
 
+void bt_mesh_begin_core_settings_batch(void);
+
+int bt_mesh_commit_core_settings_batch(void);
+
 int bt_mesh_save_core_settings(const char *key, const u8_t *val, size_t len);
 
 int bt_mesh_load_core_settings(const char *key, u8_t *buf, size_t buf_len, bool *exist);
@@ -1638,7 +1638,7 @@ void bt_mesh_rx_reset_single(u16_t src)
         if (src == rpl->src) {
             memset(rpl, 0, sizeof(struct bt_mesh_rpl));
             if (IS_ENABLED(CONFIG_BLE_MESH_SETTINGS)) {
-                bt_mesh_clear_rpl_single(src);
+                bt_mesh_clear_rpl_single(i);
             }
         }
     }
@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+#include "msg_cache.h"
+
+#include "catch.hpp"
+
+static double time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Keys laid out like the network message cache hash: IVI and SEQ in the upper bytes, SRC in the lowest ones */
+static u64_t msg_key(u16_t src, u32_t seq)
+{
+    return ((u64_t)seq << 16) | src;
+}
+
+struct test_cache {
+    std::vector<u64_t> keys;
+    std::vector<u16_t> chain;
+    std::vector<u16_t> buckets;
+    struct bt_mesh_msg_cache cache;
+
+    explicit test_cache(u16_t size) : keys(size), chain(size), buckets(BLE_MESH_MSG_CACHE_BUCKETS(size))
+    {
+        cache.size = size;
+        cache.keys = keys.data();
+        cache.chain = chain.data();
+        cache.buckets = buckets.data();
+        bt_mesh_msg_cache_reset(&cache);
+    }
+};
+
+TEST_CASE("message cache evicts the oldest entries", "[msg_cache]")
+{
+    test_cache c(10);
+
+    for (u32_t seq = 0; seq < 25; seq++) {
+        CHECK_FALSE(bt_mesh_msg_cache_find(&c.cache, msg_key(1, seq)));
+        bt_mesh_msg_cache_add(&c.cache, msg_key(1, seq));
+        CHECK(bt_mesh_msg_cache_find(&c.cache, msg_key(1, seq)));
+    }
+    for (u32_t seq = 0; seq < 25; seq++) {
+        CHECK(bt_mesh_msg_cache_find(&c.cache, msg_key(1, seq)) == (seq >= 15));
+    }
+
+    bt_mesh_msg_cache_reset(&c.cache);
+    for (u32_t seq = 0; seq < 25; seq++) {
+        CHECK_FALSE(bt_mesh_msg_cache_find(&c.cache, msg_key(1, seq)));
+    }
+}
+
+TEST_CASE("message cache entries are removed", "[msg_cache]")
+{
+    test_cache c(8);
+
+    for (u32_t seq = 0; seq < 5; seq++) {
+        bt_mesh_msg_cache_add(&c.cache, msg_key(1, seq));
+    }
+
+    /* Removing the last entry frees its slot for the next one */
+    u16_t idx = bt_mesh_msg_cache_add(&c.cache, msg_key(1, 5));
+    bt_mesh_msg_cache_remove(&c.cache, idx);
+    CHECK_FALSE(bt_mesh_msg_cache_find(&c.cache, msg_key(1, 5)));
+    CHECK(bt_mesh_msg_cache_add(&c.cache, msg_key(1, 6)) == idx);
+
+    /* Removing an older entry leaves the others in place */
+    bt_mesh_msg_cache_remove(&c.cache, 2);
+    bt_mesh_msg_cache_remove(&c.cache, 2);
+    bt_mesh_msg_cache_remove(&c.cache, BLE_MESH_MSG_CACHE_NONE);
+    for (u32_t seq = 0; seq < 5; seq++) {
+        CHECK(bt_mesh_msg_cache_find(&c.cache, msg_key(1, seq)) == (seq != 2));
+    }
+    CHECK(bt_mesh_msg_cache_find(&c.cache, msg_key(1, 6)));
+
+    /* Eviction still works with removed entries in the ring */
+    for (u32_t seq = 100; seq < 108; seq++) {
+        bt_mesh_msg_cache_add(&c.cache, msg_key(1, seq));
+    }
+    for (u32_t seq = 0; seq < 7; seq++) {
+        CHECK_FALSE(bt_mesh_msg_cache_find(&c.cache, msg_key(1, seq)));
+    }
+    for (u32_t seq = 100; seq < 108; seq++) {
+        CHECK(bt_mesh_msg_cache_find(&c.cache, msg_key(1, seq)));
+    }
+}
+
+static bool src_match(u64_t key, void *arg)
+{
+    return (u16_t)key == *(u16_t *)arg;
+}
+
+TEST_CASE("message cache entries are removed by source", "[msg_cache]")
+{
+    test_cache c(64);
+
+    for (u32_t seq = 0; seq < 20; seq++) {
+        for (u16_t src = 1; src <= 3; src++) {
+            bt_mesh_msg_cache_add(&c.cache, msg_key(src, seq));
+        }
+    }
+    u16_t src = 2;
+    bt_mesh_msg_cache_remove_matching(&c.cache, src_match, &src);
+    for (u32_t seq = 0; seq < 20; seq++) {
+        CHECK(bt_mesh_msg_cache_find(&c.cache, msg_key(1, seq)));
+        CHECK_FALSE(bt_mesh_msg_cache_find(&c.cache, msg_key(2, seq)));
+        CHECK(bt_mesh_msg_cache_find(&c.cache, msg_key(3, seq)));
+    }
+
+    /* The removed slots are reused in order */
+    for (u32_t seq = 20; seq < 40; seq++) {
+        bt_mesh_msg_cache_add(&c.cache, msg_key(2, seq));
+        CHECK(bt_mesh_msg_cache_find(&c.cache, msg_key(2, seq)));
+    }
+}
+
+/* The cache before it was hashed: a linear scan of the ring of keys */
+struct linear_cache {
+    std::vector<u64_t> keys;
+    size_t next;
+
+    explicit linear_cache(size_t size) : keys(size, 0), next(0) {}
+
+    bool match(u64_t key)
+    {
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (keys[i] == key) {
+                return true;
+            }
+        }
+        keys[next++] = key;
+        next %= keys.size();
+        return false;
+    }
+};
+
+TEST_CASE("message cache lookup time against cache size", "[msg_cache][timing]")
+{
+    /* Every message is received three times, from the source and from two relays */
+    const u32_t messages = 20000;
+    for (u16_t size = 10; size <= 10000; size *= 10) {
+        test_cache hashed(size);
+        linear_cache linear(size);
+        u32_t hashed_dups = 0, linear_dups = 0;
+
+        double start = time_s();
+        for (u32_t i = 0; i < messages; i++) {
+            for (int copy = 0; copy < 3; copy++) {
+                u64_t key = msg_key(1 + i % 50, i / 50);
+                if (bt_mesh_msg_cache_find(&hashed.cache, key)) {
+                    hashed_dups++;
+                } else {
+                    bt_mesh_msg_cache_add(&hashed.cache, key);
+                }
+            }
+        }
+        double hashed_s = time_s() - start;
+
+        start = time_s();
+        for (u32_t i = 0; i < messages; i++) {
+            for (int copy = 0; copy < 3; copy++) {
+                if (linear.match(msg_key(1 + i % 50, i / 50))) {
+                    linear_dups++;
+                }
+            }
+        }
+        double linear_s = time_s() - start;
+
+        CHECK(hashed_dups == 2 * messages);
+        CHECK(linear_dups == hashed_dups);
+        printf("%5u entries: hashed %.1f M lookups/s, linear %.1f M lookups/s\n", size,
+               3 * messages / hashed_s / 1e6, 3 * messages / linear_s / 1e6);
+    }
+}
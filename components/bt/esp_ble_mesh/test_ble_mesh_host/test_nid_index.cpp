@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "nid_index.h"
+
+#include "catch.hpp"
+
+/* Subnets and friendship credentials as net.c sees them: a subnet position may
+ * be empty (deleted provisioner subnet), a credential may be unused.
+ */
+struct test_keys {
+    bool present;
+    struct bt_mesh_nid_keys keys;
+};
+
+static std::vector<test_keys> subnets;
+static std::vector<test_keys> creds;
+
+static size_t subnet_count(void)
+{
+    return subnets.size();
+}
+
+static bool get_keys(const std::vector<test_keys> &list, size_t i, struct bt_mesh_nid_keys *keys)
+{
+    if (i >= list.size() || !list[i].present) {
+        return false;
+    }
+    *keys = list[i].keys;
+    return true;
+}
+
+static bool get_subnet(size_t i, struct bt_mesh_nid_keys *keys)
+{
+    return get_keys(subnets, i, keys);
+}
+
+static bool get_cred(size_t i, struct bt_mesh_nid_keys *keys)
+{
+    return get_keys(creds, i, keys);
+}
+
+static const struct bt_mesh_nid_index_ops ops = { subnet_count, get_subnet, get_cred };
+
+static const u16_t max_subnets = 4;
+static const u16_t max_creds = 3;
+
+static test_keys make_keys(u16_t net_idx, u8_t nid, u8_t new_nid = 0)
+{
+    test_keys k = { true, { true, net_idx, false, { nid, new_nid } } };
+    return k;
+}
+
+/* A candidate as "s<subnet>k<key>" or "s<subnet>c<credential>k<key>" */
+static std::vector<std::string> visit(struct bt_mesh_nid_index *index, u8_t nid)
+{
+    std::vector<std::string> visited;
+    struct bt_mesh_nid_cand cand;
+    u16_t entry = BLE_MESH_NID_INDEX_NONE;
+    char name[24];
+
+    while (bt_mesh_nid_index_next(index, nid, &entry, &cand)) {
+        if (cand.cred == BLE_MESH_NID_INDEX_NONE) {
+            snprintf(name, sizeof(name), "s%uk%u", cand.sub, cand.new_key);
+        } else {
+            snprintf(name, sizeof(name), "s%uc%uk%u", cand.sub, cand.cred, cand.new_key);
+        }
+        visited.push_back(name);
+    }
+    return visited;
+}
+
+typedef std::vector<std::string> names;
+
+struct test_index {
+    std::vector<u16_t> next;
+    std::vector<u16_t> cred_sub;
+    struct bt_mesh_nid_index index;
+
+    test_index() : next((max_subnets + max_creds) * 2), cred_sub(max_creds)
+    {
+        index.ops = &ops;
+        index.max_subnets = max_subnets;
+        index.max_creds = max_creds;
+        index.valid = false;
+        index.next = next.data();
+        index.cred_sub = cred_sub.data();
+    }
+};
+
+/* Subnets 0x10 and 0x20 share NID 5, credential 0 belongs to 0x20 and credential 2 to 0x10 */
+static void setup_subnets(void)
+{
+    subnets = { make_keys(0x10, 5), make_keys(0x20, 5), make_keys(0x30, 7) };
+    creds = { make_keys(0x20, 5), test_keys(), make_keys(0x10, 9) };
+    creds[1].present = false;
+}
+
+TEST_CASE("NID candidates are the matching subnets in order, credentials first", "[mesh][nid_index]")
+{
+    setup_subnets();
+    test_index t;
+
+    CHECK(visit(&t.index, 5) == names({ "s0k0", "s1c0k0", "s1k0" }));
+    CHECK(visit(&t.index, 7) == names({ "s2k0" }));
+    CHECK(visit(&t.index, 9) == names({ "s0c2k0" }));
+    CHECK(visit(&t.index, 0x80 | 7) == names({ "s2k0" }));
+    CHECK(visit(&t.index, 1).empty());
+
+    /* New keys are not candidates outside of Key Refresh, even with a matching NID */
+    CHECK(visit(&t.index, 0).empty());
+}
+
+TEST_CASE("NID candidates follow Key Refresh", "[mesh][nid_index]")
+{
+    setup_subnets();
+    test_index t;
+    REQUIRE(visit(&t.index, 5).size() == 3);
+
+    /* Phase 1: subnet 0x20 and its credential get new keys with NID 11 */
+    subnets[1].keys.kr = true;
+    subnets[1].keys.nid[1] = 11;
+    creds[0].keys.nid[1] = 11;
+    bt_mesh_nid_index_invalidate(&t.index);
+    CHECK(visit(&t.index, 11) == names({ "s1c0k1", "s1k1" }));
+    CHECK(visit(&t.index, 5) == names({ "s0k0", "s1c0k0", "s1k0" }));
+
+    /* Back to normal: the new keys replace the old ones */
+    subnets[1].keys = { true, 0x20, false, { 11, 11 } };
+    creds[0].keys.nid[0] = 11;
+    bt_mesh_nid_index_invalidate(&t.index);
+    CHECK(visit(&t.index, 11) == names({ "s1c0k0", "s1k0" }));
+    CHECK(visit(&t.index, 5) == names({ "s0k0" }));
+}
+
+TEST_CASE("stale NID candidates are skipped until the index is rebuilt", "[mesh][nid_index]")
+{
+    setup_subnets();
+    test_index t;
+    REQUIRE(visit(&t.index, 5).size() == 3);
+
+    /* A key changed without invalidating: the old NID no longer finds it, the new one not yet */
+    subnets[0].keys.nid[0] = 6;
+    CHECK(visit(&t.index, 5) == names({ "s1c0k0", "s1k0" }));
+    CHECK(visit(&t.index, 6).empty());
+    bt_mesh_nid_index_invalidate(&t.index);
+    CHECK(visit(&t.index, 6) == names({ "s0k0" }));
+
+    /* A subnet whose NetKeyIndex is not set yet is indexed, and found once it is set */
+    subnets[2].keys.used = false;
+    bt_mesh_nid_index_invalidate(&t.index);
+    CHECK(visit(&t.index, 7).empty());
+    subnets[2].keys.used = true;
+    CHECK(visit(&t.index, 7) == names({ "s2k0" }));
+}
+
+TEST_CASE("NID candidates after subnet deletion", "[mesh][nid_index]")
+{
+    setup_subnets();
+    test_index t;
+    REQUIRE(visit(&t.index, 5).size() == 3);
+
+    /* Deleting subnet 0x20 frees its position, its credential is left without subnet */
+    subnets[1].present = false;
+    CHECK(visit(&t.index, 5) == names({ "s0k0" }));
+    bt_mesh_nid_index_invalidate(&t.index);
+    CHECK(visit(&t.index, 5) == names({ "s0k0" }));
+
+    /* A new subnet in the freed position does not take the credential */
+    subnets[1] = make_keys(0x21, 5);
+    bt_mesh_nid_index_invalidate(&t.index);
+    CHECK(visit(&t.index, 5) == names({ "s0k0", "s1k0" }));
+
+    /* A change in the number of subnets rebuilds the index without invalidation */
+    subnets.push_back(make_keys(0x40, 5));
+    CHECK(visit(&t.index, 5) == names({ "s0k0", "s1k0", "s3k0" }));
+    subnets.pop_back();
+    subnets.pop_back();
+    CHECK(visit(&t.index, 5) == names({ "s0k0", "s1k0" }));
+    CHECK(visit(&t.index, 7).empty());
+    CHECK(visit(&t.index, 9) == names({ "s0c2k0" }));
+}
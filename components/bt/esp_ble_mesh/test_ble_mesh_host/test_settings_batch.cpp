@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "nvs.h"
+#include "nvs_test_api.h"
+#include "settings_batch.h"
+#include "spi_flash_emulation.h"
+
+#include "catch.hpp"
+
+#define PARTITION_SECTORS   16
+
+static double time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Emulated nvs partition with the "mesh_core" namespace open */
+struct test_nvs {
+    SpiFlashEmulator emu;
+    nvs_handle_t handle;
+
+    test_nvs() : emu(PARTITION_SECTORS)
+    {
+        REQUIRE(nvs_flash_init_custom("mesh", 0, PARTITION_SECTORS) == ESP_OK);
+        REQUIRE(nvs_open_from_partition("mesh", "mesh_core", NVS_READWRITE, &handle) == ESP_OK);
+    }
+
+    ~test_nvs()
+    {
+        nvs_close(handle);
+        nvs_flash_deinit_partition("mesh");
+    }
+
+    size_t blob_length(const char *key)
+    {
+        size_t len = 0;
+        return nvs_get_blob(handle, key, NULL, &len) == ESP_OK ? len : 0;
+    }
+};
+
+TEST_CASE("settings batch stores the last value of each key", "[settings_batch]")
+{
+    test_nvs nvs;
+    std::vector<u8_t> buf(BLE_MESH_SETTINGS_BATCH_SIZE);
+    struct bt_mesh_settings_batch batch;
+    const u8_t *val;
+    size_t len;
+
+    REQUIRE(nvs_set_blob(nvs.handle, "mesh/old", "old", 3) == ESP_OK);
+
+    bt_mesh_settings_batch_init(&batch, nvs.handle, buf.data(), buf.size());
+    CHECK(bt_mesh_settings_batch_set(&batch, "mesh/a", (const u8_t *)"1", 1) == 0);
+    CHECK(bt_mesh_settings_batch_set(&batch, "mesh/a", (const u8_t *)"2", 1) == 0);
+    CHECK(bt_mesh_settings_batch_set(&batch, "mesh/b", (const u8_t *)"22", 2) == 0);
+    CHECK(bt_mesh_settings_batch_set(&batch, "mesh/b", (const u8_t *)"333", 3) == 0);
+    CHECK(bt_mesh_settings_batch_set(&batch, "mesh/old", NULL, 0) == 0);
+    CHECK(bt_mesh_settings_batch_set(&batch, "mesh/key_too_long", NULL, 0) == -EINVAL);
+
+    /* Staged values are read back, nvs is unchanged until the flush */
+    REQUIRE(bt_mesh_settings_batch_get(&batch, "mesh/b", &val, &len) == 0);
+    CHECK(len == 3);
+    CHECK(memcmp(val, "333", 3) == 0);
+    REQUIRE(bt_mesh_settings_batch_get(&batch, "mesh/old", &val, &len) == 0);
+    CHECK(val == NULL);
+    CHECK(bt_mesh_settings_batch_get(&batch, "mesh/c", &val, &len) == -ENOENT);
+    CHECK(nvs.blob_length("mesh/a") == 0);
+    CHECK(nvs.blob_length("mesh/old") == 3);
+
+    nvs.emu.clearStats();
+    CHECK(bt_mesh_settings_batch_flush(&batch) == 0);
+    CHECK(bt_mesh_settings_batch_get(&batch, "mesh/a", &val, &len) == -ENOENT);
+
+    char data[4] = { 0 };
+    len = sizeof(data);
+    CHECK(nvs_get_blob(nvs.handle, "mesh/a", data, &len) == ESP_OK);
+    CHECK(len == 1);
+    CHECK(data[0] == '2');
+    len = sizeof(data);
+    CHECK(nvs_get_blob(nvs.handle, "mesh/b", data, &len) == ESP_OK);
+    CHECK(len == 3);
+    CHECK(memcmp(data, "333", 3) == 0);
+    CHECK(nvs.blob_length("mesh/old") == 0);
+}
+
+TEST_CASE("settings batch flushes when its buffer is full", "[settings_batch]")
+{
+    test_nvs nvs;
+    std::vector<u8_t> buf(128);
+    struct bt_mesh_settings_batch batch;
+    u8_t large[256];
+    char key[16];
+
+    memset(large, 0xa5, sizeof(large));
+
+    bt_mesh_settings_batch_init(&batch, nvs.handle, buf.data(), buf.size());
+    for (int i = 0; i < 20; i++) {
+        u32_t val = i;
+        sprintf(key, "mesh/k/%04x", i);
+        CHECK(bt_mesh_settings_batch_set(&batch, key, (const u8_t *)&val, sizeof(val)) == 0);
+    }
+    /* Values larger than the buffer are written directly, after the staged ones */
+    CHECK(bt_mesh_settings_batch_set(&batch, "mesh/k/0001", large, sizeof(large)) == 0);
+    CHECK(nvs.blob_length("mesh/k/0001") == sizeof(large));
+    CHECK(bt_mesh_settings_batch_flush(&batch) == 0);
+
+    for (int i = 0; i < 20; i++) {
+        u32_t val = 0;
+        size_t len = sizeof(val);
+        sprintf(key, "mesh/k/%04x", i);
+        if (i == 1) {
+            CHECK(nvs.blob_length(key) == sizeof(large));
+            continue;
+        }
+        CHECK(nvs_get_blob(nvs.handle, key, &val, &len) == ESP_OK);
+        CHECK(val == (u32_t)i);
+    }
+}
+
+#define RPL_SOURCES         128
+#define RPL_BLOCK_SIZE      16
+#define RPL_RECORD_SIZE     6
+#define UPDATES_PER_WINDOW  16
+#define WINDOWS             200
+
+struct rpl_entry {
+    u16_t src;
+    u32_t seq;
+};
+
+/* Previous layout: one key per source and the list of sources, each write committed */
+static void store_rpl_per_source(nvs_handle_t handle, const rpl_entry &entry)
+{
+    char key[16];
+    u16_t list[RPL_SOURCES];
+    size_t len = sizeof(list);
+
+    sprintf(key, "mesh/rpl/%04x", entry.src);
+    REQUIRE(nvs_set_blob(handle, key, &entry.seq, sizeof(entry.seq)) == ESP_OK);
+    nvs_commit(handle);
+
+    if (nvs_get_blob(handle, "mesh/rpl", list, &len) != ESP_OK) {
+        len = 0;
+    }
+    for (size_t i = 0; i < len / sizeof(u16_t); i++) {
+        if (list[i] == entry.src) {
+            return;
+        }
+    }
+    list[len / sizeof(u16_t)] = entry.src;
+    REQUIRE(nvs_set_blob(handle, "mesh/rpl", list, len + sizeof(u16_t)) == ESP_OK);
+    nvs_commit(handle);
+}
+
+static void store_rpl_block(struct bt_mesh_settings_batch *batch, const std::vector<rpl_entry> &rpl, int block)
+{
+    u8_t val[RPL_BLOCK_SIZE * RPL_RECORD_SIZE];
+    char key[16];
+
+    for (int i = 0; i < RPL_BLOCK_SIZE; i++) {
+        const rpl_entry &entry = rpl[block * RPL_BLOCK_SIZE + i];
+        memcpy(&val[i * RPL_RECORD_SIZE], &entry.src, 2);
+        memcpy(&val[i * RPL_RECORD_SIZE + 2], &entry.seq, 4);
+    }
+    sprintf(key, "mesh/rplb/%04x", block);
+    REQUIRE(bt_mesh_settings_batch_set(batch, key, val, sizeof(val)) == 0);
+}
+
+/* Runs the store windows of a node receiving from RPL_SOURCES sources, returns the updates per second */
+static double run_rpl_updates(bool blocks, size_t *erases, size_t *flash_us)
+{
+    test_nvs nvs;
+    std::vector<u8_t> buf(BLE_MESH_SETTINGS_BATCH_SIZE);
+    struct bt_mesh_settings_batch batch;
+    std::vector<rpl_entry> rpl(RPL_SOURCES);
+    u32_t rand = 1;
+
+    for (int i = 0; i < RPL_SOURCES; i++) {
+        rpl[i].src = 0x0100 + i;
+        rpl[i].seq = 0;
+    }
+
+    bt_mesh_settings_batch_init(&batch, nvs.handle, buf.data(), buf.size());
+    nvs.emu.clearStats();
+    double start = time_s();
+    for (int w = 0; w < WINDOWS; w++) {
+        bool dirty[RPL_SOURCES / RPL_BLOCK_SIZE] = { false };
+
+        for (int i = 0; i < UPDATES_PER_WINDOW; i++) {
+            rand = rand * 1103515245 + 12345;
+            rpl_entry &entry = rpl[(rand >> 16) % RPL_SOURCES];
+            entry.seq++;
+            if (blocks) {
+                dirty[(&entry - &rpl[0]) / RPL_BLOCK_SIZE] = true;
+            } else {
+                store_rpl_per_source(nvs.handle, entry);
+            }
+        }
+
+        if (blocks) {
+            for (int b = 0; b < RPL_SOURCES / RPL_BLOCK_SIZE; b++) {
+                if (dirty[b]) {
+                    store_rpl_block(&batch, rpl, b);
+                }
+            }
+            REQUIRE(bt_mesh_settings_batch_flush(&batch) == 0);
+        }
+    }
+    double seconds = time_s() - start;
+
+    *erases = nvs.emu.getEraseOps();
+    *flash_us = nvs.emu.getTotalTime();
+    return WINDOWS * UPDATES_PER_WINDOW / seconds;
+}
+
+TEST_CASE("RPL stored per source and as batched blocks", "[settings_batch][timing]")
+{
+    size_t source_erases, source_us, block_erases, block_us;
+    double source_rate = run_rpl_updates(false, &source_erases, &source_us);
+    double block_rate = run_rpl_updates(true, &block_erases, &block_us);
+    const double updates = WINDOWS * UPDATES_PER_WINDOW;
+
+    printf("RPL per source: %.0f updates/s on host, %.0f updates/s of flash time, %zu sector erases\n",
+           source_rate, updates * 1e6 / source_us, source_erases);
+    printf("RPL blocks:     %.0f updates/s on host, %.0f updates/s of flash time, %zu sector erases\n",
+           block_rate, updates * 1e6 / block_us, block_erases);
+    CHECK(block_erases <= source_erases);
+}
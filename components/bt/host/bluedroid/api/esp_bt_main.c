@@ -132,6 +132,13 @@ esp_err_t esp_bluedroid_init(void)
     osi_mem_dbg_init();
 #endif
 
+#if UC_BT_OSI_BUF_POOL
+    if (!osi_pool_init()) {
+        LOG_ERROR("Bluedroid buffer pools initialise failed\n");
+        return ESP_ERR_NO_MEM;
+    }
+#endif
+
     btc_init();
 
     future_p = btc_main_get_future_p(BTC_MAIN_INIT_FUTURE);
@@ -199,6 +206,10 @@ esp_err_t esp_bluedroid_deinit(void)
 
     btc_deinit();
 
+#if UC_BT_OSI_BUF_POOL
+    osi_pool_deinit();
+#endif
+
     bd_already_init = false;
 
     return ESP_OK;
@@ -26,6 +26,8 @@
 #include "osi/thread.h"
 #include "esp_bt.h"
 #include "stack/hcimsgs.h"
+#include "stack/l2cdefs.h"
+#include "osi/pool.h"
 
 #if (C2H_FLOW_CONTROL_INCLUDED == TRUE)
 #include "l2c_int.h"
@@ -83,7 +85,7 @@ static void hci_hal_env_init(
     hci_hal_env.buffer_size = buffer_size;
     hci_hal_env.adv_free_num = 0;
 
-    hci_hal_env.rx_q = fixed_queue_new(max_buffer_count);
+    hci_hal_env.rx_q = fixed_queue_new_ring(max_buffer_count);
     if (hci_hal_env.rx_q) {
         fixed_queue_register_dequeue(hci_hal_env.rx_q, event_uart_has_bytes);
     } else {
@@ -326,6 +328,24 @@ static void host_send_pkt_available_cb(void)
     hci_host_task_post(OSI_THREAD_MAX_TIMEOUT);
 }
 
+// Returns the size of the buffer for a packet received from the controller
+static size_t host_recv_buffer_size(const uint8_t *data, uint16_t len)
+{
+#if UC_BT_OSI_BUF_POOL
+    // The start fragment of an L2CAP packet gets room for the whole packet, so
+    // that the packet fragmenter reassembles it in place
+    if (len >= 1 + HCI_ACL_PREAMBLE_SIZE + L2CAP_PKT_OVERHEAD && data[0] == DATA_TYPE_ACL &&
+            ((data[2] >> 4) & 0x03) == L2CAP_PKT_START) {
+        size_t full_len = 1 + HCI_ACL_PREAMBLE_SIZE + L2CAP_PKT_OVERHEAD + (data[5] | (data[6] << 8));
+
+        if (full_len > len && BT_HDR_SIZE + full_len <= OSI_POOL_LARGE_SIZE) {
+            return BT_HDR_SIZE + full_len;
+        }
+    }
+#endif
+    return BT_HDR_SIZE + len;
+}
+
 static int host_recv_pkt_cb(uint8_t *data, uint16_t len)
 {
     //Target has packet to host, malloc new buffer for packet
@@ -336,13 +356,14 @@ static int host_recv_pkt_cb(uint8_t *data, uint16_t len)
         return 0;
     }
 
-    pkt_size = BT_HDR_SIZE + len;
-    pkt = (BT_HDR *) osi_calloc(pkt_size);
+    pkt_size = host_recv_buffer_size(data, len);
+    pkt = (BT_HDR *) osi_pool_malloc(pkt_size);
 
     if (!pkt) {
         HCI_TRACE_ERROR("%s couldn't aquire memory for inbound data buffer.\n", __func__);
         return -1;
     }
+    pkt->event = 0;
     pkt->offset = 0;
     pkt->len = len;
     pkt->layer_specific = 0;
@@ -25,6 +25,7 @@
 
 #include "osi/hash_map.h"
 #include "osi/hash_functions.h"
+#include "osi/pool.h"
 #include "common/bt_trace.h"
 
 
@@ -126,6 +127,17 @@ static void fragment_and_dispatch(BT_HDR *packet)
     }
 }
 
+// The partial packet holds the bytes received so far at its offset, its ACL
+// length field already holds the length of the whole packet
+static uint16_t partial_expected_length(const BT_HDR *partial_packet)
+{
+    const uint8_t *stream = partial_packet->data + partial_packet->offset + 2;
+    uint16_t acl_length;
+
+    STREAM_TO_UINT16(acl_length, stream);
+    return acl_length + HCI_ACL_PREAMBLE_SIZE;
+}
+
 static void reassemble_and_dispatch(BT_HDR *packet)
 {
     HCI_TRACE_DEBUG("reassemble_and_dispatch\n");
@@ -163,21 +175,34 @@ static void reassemble_and_dispatch(BT_HDR *packet)
                 callbacks->reassembled(packet);
                 return;
             }
-            partial_packet = (BT_HDR *)osi_calloc(full_length + sizeof(BT_HDR));
-            partial_packet->event = packet->event;
-            partial_packet->len = full_length;
-            partial_packet->offset = packet->len;
 
-            memcpy(partial_packet->data, packet->data + packet->offset, packet->len);
+            if (osi_pool_block_size(packet) >= sizeof(BT_HDR) + packet->offset + full_length) {
+                // The HAL sized the buffer for the whole packet, reassemble in place
+                partial_packet = packet;
+            } else {
+                partial_packet = (BT_HDR *)osi_pool_malloc(full_length + sizeof(BT_HDR));
+                if (!partial_packet) {
+                    HCI_TRACE_ERROR("%s unable to allocate %d bytes for the packet. Dropping it.\n", __func__, full_length);
+                    osi_free(packet);
+                    return;
+                }
+                partial_packet->event = packet->event;
+                partial_packet->len = packet->len;
+                partial_packet->offset = 0;
+                partial_packet->layer_specific = packet->layer_specific;
+
+                memcpy(partial_packet->data, packet->data + packet->offset, packet->len);
+
+                // Free the old packet buffer, since we don't need it anymore
+                osi_free(packet);
+            }
 
             // Update the ACL data size to indicate the full expected length
-            stream = partial_packet->data;
+            stream = partial_packet->data + partial_packet->offset;
             STREAM_SKIP_UINT16(stream); // skip the handle
             UINT16_TO_STREAM(stream, full_length - HCI_ACL_PREAMBLE_SIZE);
 
             hash_map_set(partial_packets, (void *)(uintptr_t)handle, partial_packet);
-            // Free the old packet buffer, since we don't need it anymore
-            osi_free(packet);
         } else {
             if (!partial_packet) {
                 HCI_TRACE_ERROR("%s got continuation for unknown packet. Dropping it.\n", __func__);
@@ -187,26 +212,26 @@ static void reassemble_and_dispatch(BT_HDR *packet)
 
             packet->offset += HCI_ACL_PREAMBLE_SIZE; // skip ACL preamble
             packet->len -= HCI_ACL_PREAMBLE_SIZE;
-            uint16_t projected_offset = partial_packet->offset + packet->len;
-            if (projected_offset > partial_packet->len) { // len stores the expected length
-                HCI_TRACE_ERROR("%s got packet which would exceed expected length of %d. Truncating.\n", __func__, partial_packet->len);
-                packet->len = partial_packet->len - partial_packet->offset;
-                projected_offset = partial_packet->len;
+            uint16_t expected_length = partial_expected_length(partial_packet);
+            uint16_t projected_length = partial_packet->len + packet->len;
+            if (projected_length > expected_length) {
+                HCI_TRACE_ERROR("%s got packet which would exceed expected length of %d. Truncating.\n", __func__, expected_length);
+                packet->len = expected_length - partial_packet->len;
+                projected_length = expected_length;
             }
 
             memcpy(
-                partial_packet->data + partial_packet->offset,
+                partial_packet->data + partial_packet->offset + partial_packet->len,
                 packet->data + packet->offset,
                 packet->len
             );
 
             // Free the old packet buffer, since we don't need it anymore
             osi_free(packet);
-            partial_packet->offset = projected_offset;
+            partial_packet->len = projected_length;
 
-            if (partial_packet->offset == partial_packet->len) {
+            if (partial_packet->len == expected_length) {
                 hash_map_erase(partial_packets, (void *)(uintptr_t)handle);
-                partial_packet->offset = 0;
                 callbacks->reassembled(partial_packet);
             }
         }
@@ -0,0 +1,17 @@
+#define CONFIG_BT_ENABLED 1
+#define CONFIG_BT_BLUEDROID_ENABLED 1
+#define CONFIG_BT_OSI_BUF_POOL_SMALL_NUM 16
+#define CONFIG_BT_OSI_BUF_POOL_MEDIUM_NUM 16
+#define CONFIG_BT_OSI_BUF_POOL_LARGE_NUM 4
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_FREERTOS_MAX_TASK_NAME_LEN 16
+#define CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS 1
+#define CONFIG_FREERTOS_IDLE_TASK_STACKSIZE 1536
+#define CONFIG_FREERTOS_TIMER_TASK_PRIORITY 1
+#define CONFIG_FREERTOS_TIMER_TASK_STACK_DEPTH 2048
+#define CONFIG_FREERTOS_TIMER_QUEUE_LENGTH 10
+#define CONFIG_FREERTOS_QUEUE_REGISTRY_SIZE 0
+#define CONFIG_FREERTOS_SUPPORT_STATIC_ALLOCATION 1
+#define CONFIG_FREERTOS_USE_TRACE_FACILITY 1
+#define CONFIG_FREERTOS_ASSERT_FAIL_ABORT 1
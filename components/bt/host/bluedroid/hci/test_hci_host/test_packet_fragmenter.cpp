@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+extern "C" {
+#include "osi/allocator.h"
+#include "osi/pool.h"
+#include "hci/hci_internals.h"
+#include "hci/packet_fragmenter.h"
+#include "device/controller.h"
+}
+
+#include "catch.hpp"
+
+#define L2CAP_HEADER_SIZE   4
+#define START_FLAG          2
+#define CONTINUATION_FLAG   1
+
+static const uint16_t test_handle = 0x042;
+static std::vector<BT_HDR *> reassembled;
+
+/* Only used to fragment outgoing packets */
+static controller_t controller;
+
+extern "C" const controller_t *controller_get_interface(void)
+{
+    return &controller;
+}
+
+static void on_reassembled(BT_HDR *packet)
+{
+    reassembled.push_back(packet);
+}
+
+static const packet_fragmenter_callbacks_t callbacks = { NULL, on_reassembled, NULL };
+
+/* L2CAP packet with a payload of the given length */
+static std::vector<uint8_t> l2cap_packet(uint16_t length)
+{
+    std::vector<uint8_t> data = { (uint8_t) length, (uint8_t) (length >> 8), 0x40, 0x00 };
+    for (uint16_t i = 0; i < length; i++) {
+        data.push_back(i * 7);
+    }
+    return data;
+}
+
+/* ACL packet received from the controller with bytes [begin, end) of the L2CAP packet. The HAL
+ * sizes the buffer of a start fragment for the whole packet when buffer_size is set. */
+static BT_HDR *acl_fragment(const std::vector<uint8_t> &l2cap, size_t begin, size_t end, size_t buffer_size = 0)
+{
+    uint16_t acl_length = end - begin;
+    size_t size = sizeof(BT_HDR) + HCI_ACL_PREAMBLE_SIZE + acl_length;
+    BT_HDR *packet = (BT_HDR *) (buffer_size ? osi_pool_malloc(buffer_size) : osi_malloc(size));
+    REQUIRE(packet != NULL);
+
+    packet->event = MSG_HC_TO_STACK_HCI_ACL;
+    packet->len = HCI_ACL_PREAMBLE_SIZE + acl_length;
+    packet->offset = 0;
+    packet->layer_specific = 0;
+
+    uint8_t *stream = packet->data;
+    uint16_t handle = test_handle | ((begin == 0 ? START_FLAG : CONTINUATION_FLAG) << 12);
+    UINT16_TO_STREAM(stream, handle);
+    UINT16_TO_STREAM(stream, acl_length);
+    memcpy(stream, &l2cap[begin], acl_length);
+    return packet;
+}
+
+/* L2CAP packet held by a reassembled ACL packet */
+static std::vector<uint8_t> l2cap_of(const BT_HDR *packet)
+{
+    const uint8_t *data = packet->data + packet->offset;
+    return std::vector<uint8_t>(data + HCI_ACL_PREAMBLE_SIZE, data + packet->len);
+}
+
+static size_t full_buffer_size(const std::vector<uint8_t> &l2cap)
+{
+    return sizeof(BT_HDR) + HCI_ACL_PREAMBLE_SIZE + l2cap.size();
+}
+
+struct test_fragmenter {
+    const packet_fragmenter_t *fragmenter;
+
+    test_fragmenter()
+    {
+#if UC_BT_OSI_BUF_POOL
+        REQUIRE(osi_pool_init());
+#endif
+        reassembled.clear();
+        fragmenter = packet_fragmenter_get_interface();
+        fragmenter->init(&callbacks);
+    }
+
+    ~test_fragmenter()
+    {
+        fragmenter->cleanup();
+        for (BT_HDR *packet : reassembled) {
+            osi_free(packet);
+        }
+        reassembled.clear();
+#if UC_BT_OSI_BUF_POOL
+        osi_pool_deinit();
+#endif
+    }
+
+    void receive(BT_HDR *packet)
+    {
+        fragmenter->reassemble_and_dispatch(packet);
+    }
+
+    /* All the pool blocks are back in their pools once the reassembled packets are freed */
+    void check_released()
+    {
+        for (BT_HDR *packet : reassembled) {
+            osi_free(packet);
+        }
+        reassembled.clear();
+#if UC_BT_OSI_BUF_POOL
+        for (uint8_t i = 0; i < OSI_POOL_NUM_CLASSES; i++) {
+            osi_pool_stats_t stats;
+            REQUIRE(osi_pool_get_stats(i, &stats));
+            CHECK(stats.used == 0);
+        }
+#endif
+    }
+};
+
+TEST_CASE("complete ACL packet is dispatched as is", "[hci][fragmenter]")
+{
+    test_fragmenter t;
+    std::vector<uint8_t> l2cap = l2cap_packet(20);
+    BT_HDR *packet = acl_fragment(l2cap, 0, l2cap.size());
+
+    t.receive(packet);
+    REQUIRE(reassembled.size() == 1);
+    CHECK(reassembled[0] == packet);
+    CHECK(l2cap_of(packet) == l2cap);
+    t.check_released();
+}
+
+TEST_CASE("fragments reassembled to the exact length", "[hci][fragmenter]")
+{
+    test_fragmenter t;
+    std::vector<uint8_t> l2cap = l2cap_packet(600);
+
+    /* The start fragment in a buffer sized for the whole packet, then in a buffer of its own size */
+    for (size_t buffer_size : { full_buffer_size(l2cap), (size_t) 0 }) {
+        BT_HDR *start = acl_fragment(l2cap, 0, 100, buffer_size);
+        t.receive(start);
+        t.receive(acl_fragment(l2cap, 100, 400));
+        CHECK(reassembled.empty());
+        t.receive(acl_fragment(l2cap, 400, l2cap.size()));
+
+        REQUIRE(reassembled.size() == 1);
+        CHECK(reassembled[0]->len == HCI_ACL_PREAMBLE_SIZE + l2cap.size());
+        CHECK(l2cap_of(reassembled[0]) == l2cap);
+#if UC_BT_OSI_BUF_POOL
+        /* Reassembled in place, or copied to a pool block */
+        CHECK((reassembled[0] == start) == (buffer_size != 0));
+        CHECK(osi_pool_block_size(reassembled[0]) >= full_buffer_size(l2cap));
+#else
+        CHECK(reassembled[0] != start);
+#endif
+        t.check_released();
+    }
+}
+
+TEST_CASE("fragment exceeding the packet length is truncated", "[hci][fragmenter]")
+{
+    test_fragmenter t;
+    std::vector<uint8_t> l2cap = l2cap_packet(300);
+    std::vector<uint8_t> received = l2cap;
+    received.insert(received.end(), 50, 0xEE);
+
+    t.receive(acl_fragment(received, 0, 200, full_buffer_size(l2cap)));
+    t.receive(acl_fragment(received, 200, received.size()));
+
+    REQUIRE(reassembled.size() == 1);
+    CHECK(l2cap_of(reassembled[0]) == l2cap);
+    t.check_released();
+}
+
+TEST_CASE("start fragment while assembling drops the unfinished packet", "[hci][fragmenter]")
+{
+    test_fragmenter t;
+    std::vector<uint8_t> dropped = l2cap_packet(500);
+    std::vector<uint8_t> l2cap = l2cap_packet(250);
+
+    t.receive(acl_fragment(dropped, 0, 100, full_buffer_size(dropped)));
+    t.receive(acl_fragment(dropped, 100, 200));
+    t.receive(acl_fragment(l2cap, 0, 100));
+    t.receive(acl_fragment(l2cap, 100, l2cap.size()));
+
+    REQUIRE(reassembled.size() == 1);
+    CHECK(l2cap_of(reassembled[0]) == l2cap);
+
+    /* A continuation without a start fragment is dropped too */
+    t.receive(acl_fragment(l2cap, 100, l2cap.size()));
+    CHECK(reassembled.size() == 1);
+    t.check_released();
+}
+
+TEST_CASE("fragments reassembled in a heap buffer when the pool is empty", "[hci][fragmenter]")
+{
+    test_fragmenter t;
+    std::vector<uint8_t> l2cap = l2cap_packet(600);
+#if UC_BT_OSI_BUF_POOL
+    osi_pool_stats_t before;
+    REQUIRE(osi_pool_get_stats(OSI_POOL_NUM_CLASSES - 1, &before));
+    std::vector<void *> blocks;
+    for (uint32_t i = 0; i < before.block_num; i++) {
+        blocks.push_back(osi_pool_malloc(OSI_POOL_LARGE_SIZE));
+    }
+#endif
+
+    t.receive(acl_fragment(l2cap, 0, 100));
+    t.receive(acl_fragment(l2cap, 100, l2cap.size()));
+
+    REQUIRE(reassembled.size() == 1);
+    CHECK(l2cap_of(reassembled[0]) == l2cap);
+    CHECK(osi_pool_block_size(reassembled[0]) == 0);
+#if UC_BT_OSI_BUF_POOL
+    osi_pool_stats_t after;
+    REQUIRE(osi_pool_get_stats(OSI_POOL_NUM_CLASSES - 1, &after));
+    CHECK(after.miss_count == before.miss_count + 1);
+    for (void *block : blocks) {
+        osi_free(block);
+    }
+#endif
+    t.check_released();
+}
@@ -50,6 +50,8 @@ static const char *TAG = "esp-tls";
 #define _esp_tls_server_session_delete      esp_mbedtls_server_session_delete
 #endif  /* CONFIG_ESP_TLS_SERVER */
 #define _esp_tls_get_bytes_avail            esp_mbedtls_get_bytes_avail
+#define _esp_tls_get_client_session         esp_mbedtls_get_client_session
+#define _esp_tls_free_client_session        esp_mbedtls_free_client_session
 #define _esp_tls_init_global_ca_store       esp_mbedtls_init_global_ca_store
 #define _esp_tls_set_global_ca_store        esp_mbedtls_set_global_ca_store                 /*!< Callback function for setting global CA store data for TLS/SSL */
 #define _esp_tls_get_global_ca_store        esp_mbedtls_get_global_ca_store
@@ -65,6 +67,8 @@ static const char *TAG = "esp-tls";
 #define _esp_tls_server_session_delete      esp_wolfssl_server_session_delete
 #endif  /* CONFIG_ESP_TLS_SERVER */
 #define _esp_tls_get_bytes_avail            esp_wolfssl_get_bytes_avail
+#define _esp_tls_get_client_session         esp_wolfssl_get_client_session
+#define _esp_tls_free_client_session        esp_wolfssl_free_client_session
 #define _esp_tls_init_global_ca_store       esp_wolfssl_init_global_ca_store
 #define _esp_tls_set_global_ca_store        esp_wolfssl_set_global_ca_store                 /*!< Callback function for setting global CA store data for TLS/SSL */
 #define _esp_tls_free_global_ca_store       esp_wolfssl_free_global_ca_store                /*!< Callback function for freeing global ca store for TLS/SSL */
@@ -456,6 +460,16 @@ ssize_t esp_tls_get_bytes_avail(esp_tls_t *tls)
     return _esp_tls_get_bytes_avail(tls);
 }
 
+esp_tls_client_session_t *esp_tls_get_client_session(esp_tls_t *tls)
+{
+    return _esp_tls_get_client_session(tls);
+}
+
+void esp_tls_free_client_session(esp_tls_client_session_t *session)
+{
+    _esp_tls_free_client_session(session);
+}
+
 esp_err_t esp_tls_get_conn_sockfd(esp_tls_t *tls, int *sockfd)
 {
     if (!tls || !sockfd) {
@@ -109,6 +109,11 @@ typedef struct psk_key_hint {
     const char* hint;                       /*!< hint in PSK authentication mode in string format */
 } psk_hint_key_t;
 
+/**
+ *  @brief ESP-TLS client session, to resume the TLS session of a connection on a new connection to the same server
+ */
+typedef struct esp_tls_client_session esp_tls_client_session_t;
+
 /**
  * @brief      ESP-TLS configuration parameters
  *
@@ -201,6 +206,10 @@ typedef struct esp_tls_cfg {
                                             /*!< Function pointer to esp_crt_bundle_attach. Enables the use of certification
                                                  bundle for server verification, must be enabled in menuconfig */
 
+    esp_tls_client_session_t *client_session; /*!< If non-NULL, session of an earlier connection to the same server, as returned
+                                                 by esp_tls_get_client_session(), which the handshake tries to resume.
+                                                 The session must stay valid until the connection is established */
+
 } esp_tls_cfg_t;
 
 #ifdef CONFIG_ESP_TLS_SERVER
@@ -557,6 +566,29 @@ void esp_tls_free_global_ca_store(void);
  */
 esp_err_t esp_tls_get_and_clear_last_error(esp_tls_error_handle_t h, int *esp_tls_code, int *esp_tls_flags);
 
+/**
+ * @brief      Get a copy of the TLS session of an established client connection
+ *
+ * The session can be passed in esp_tls_cfg_t::client_session of a new connection to the same
+ * server, whose handshake then resumes it instead of doing a full handshake, if the server agrees.
+ *
+ * @note       Only supported with mbedtls, NULL is returned with wolfSSL.
+ *
+ * @param[in]  tls  pointer to esp_tls_t
+ *
+ * @return
+ *             - Pointer to the session, to be freed with esp_tls_free_client_session()
+ *             - NULL if the connection is not established or no memory is available
+ */
+esp_tls_client_session_t *esp_tls_get_client_session(esp_tls_t *tls);
+
+/**
+ * @brief      Free a session returned by esp_tls_get_client_session()
+ *
+ * @param[in]  session  pointer to the session, can be NULL
+ */
+void esp_tls_free_client_session(esp_tls_client_session_t *session);
+
 #if CONFIG_ESP_TLS_USING_MBEDTLS
 /**
  * @brief      Get the pointer to the global CA store currently being used.
@@ -45,6 +45,10 @@ typedef struct esp_tls_pki_t {
     unsigned int privkey_password_len;
 } esp_tls_pki_t;
 
+struct esp_tls_client_session {
+    mbedtls_ssl_session saved_session;
+};
+
 esp_err_t esp_create_mbedtls_handle(const char *hostname, size_t hostlen, const void *cfg, esp_tls_t *tls)
 {
     assert(cfg != NULL);
@@ -98,6 +102,16 @@ esp_err_t esp_create_mbedtls_handle(const char *hostname, size_t hostlen, const
     }
     mbedtls_ssl_set_bio(&tls->ssl, &tls->server_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
 
+    const esp_tls_client_session_t *session = tls->role == ESP_TLS_CLIENT ? ((const esp_tls_cfg_t *)cfg)->client_session : NULL;
+    if (session != NULL) {
+        /* The session is copied. If it can't be set, a full handshake is done instead */
+        if ((ret = mbedtls_ssl_set_session(&tls->ssl, &session->saved_session)) != 0) {
+            ESP_LOGW(TAG, "mbedtls_ssl_set_session returned -0x%x", -ret);
+        } else {
+            ESP_LOGD(TAG, "Resuming the saved client session");
+        }
+    }
+
     return ESP_OK;
 
 exit:
@@ -211,6 +225,34 @@ ssize_t esp_mbedtls_get_bytes_avail(esp_tls_t *tls)
     return mbedtls_ssl_get_bytes_avail(&tls->ssl);
 }
 
+esp_tls_client_session_t *esp_mbedtls_get_client_session(esp_tls_t *tls)
+{
+    if (tls == NULL || tls->role != ESP_TLS_CLIENT || tls->conn_state != ESP_TLS_DONE) {
+        return NULL;
+    }
+    esp_tls_client_session_t *session = calloc(1, sizeof(esp_tls_client_session_t));
+    if (session == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate the client session");
+        return NULL;
+    }
+    mbedtls_ssl_session_init(&session->saved_session);
+    int ret = mbedtls_ssl_get_session(&tls->ssl, &session->saved_session);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "mbedtls_ssl_get_session returned -0x%x", -ret);
+        esp_mbedtls_free_client_session(session);
+        return NULL;
+    }
+    return session;
+}
+
+void esp_mbedtls_free_client_session(esp_tls_client_session_t *session)
+{
+    if (session) {
+        mbedtls_ssl_session_free(&session->saved_session);
+        free(session);
+    }
+}
+
 void esp_mbedtls_cleanup(esp_tls_t *tls)
 {
     if (!tls) {
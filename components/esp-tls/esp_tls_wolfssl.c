@@ -397,6 +397,16 @@ ssize_t esp_wolfssl_get_bytes_avail(esp_tls_t *tls)
     return wolfSSL_pending( (WOLFSSL *)tls->priv_ssl);
 }
 
+esp_tls_client_session_t *esp_wolfssl_get_client_session(esp_tls_t *tls)
+{
+    /* Sessions are not resumed with wolfssl, the connections do full handshakes */
+    return NULL;
+}
+
+void esp_wolfssl_free_client_session(esp_tls_client_session_t *session)
+{
+}
+
 void esp_wolfssl_conn_delete(esp_tls_t *tls)
 {
     if (tls != NULL) {
@@ -50,6 +50,16 @@ void esp_mbedtls_conn_delete(esp_tls_t *tls);
  */
 ssize_t esp_mbedtls_get_bytes_avail(esp_tls_t *tls);
 
+/**
+ * Internal Callback for mbedtls_get_client_session
+ */
+esp_tls_client_session_t *esp_mbedtls_get_client_session(esp_tls_t *tls);
+
+/**
+ * Internal Callback for freeing a session returned by esp_mbedtls_get_client_session
+ */
+void esp_mbedtls_free_client_session(esp_tls_client_session_t *session);
+
 /**
  * Internal Callback for creating ssl handle for mbedtls
  */
@@ -55,6 +55,16 @@ void esp_wolfssl_conn_delete(esp_tls_t *tls);
  */
 ssize_t esp_wolfssl_get_bytes_avail(esp_tls_t *tls);
 
+/**
+ * Internal Callback for getting the client session, not supported with wolfssl
+ */
+esp_tls_client_session_t *esp_wolfssl_get_client_session(esp_tls_t *tls);
+
+/**
+ * Internal Callback for freeing a client session, not supported with wolfssl
+ */
+void esp_wolfssl_free_client_session(esp_tls_client_session_t *session);
+
 /**
  * Callback function for setting global CA store data for TLS/SSL using wolfssl
  */
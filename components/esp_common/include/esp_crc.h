@@ -28,6 +28,11 @@ extern "C" {
 * CRC-8        x8+x2+x1+1                                              0x07
 * CRC16-CCITT  x16+x12+x5+1                                            0x1021
 * CRC32        x32+x26+x23+x22+x16+x12+x11+x10+x8+x7+x5+x4+x2+x1+1     0x04c11db7
+* CRC-7        x7+x3+1                                                 0x09
+*
+* esp_crc32_le(), esp_crc16_be() and esp_crc7() are table driven and run from flash,
+* see ESP_CRC_SLICE_BY_8. Where the flash cache may be disabled use the ROM functions.
+* The other functions call the ROM.
 ********************************************************************************/
 
 /**
@@ -38,10 +43,9 @@ extern "C" {
 * @param len: Length of the data buffer
 * @return CRC32 value
 */
-static inline uint32_t esp_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len)
-{
-    return crc32_le(crc, buf, len);
-}
+uint32_t esp_crc32_le(uint32_t crc, uint8_t const *buf, uint32_t len);
+
+#if defined(CONFIG_IDF_TARGET_ESP32)
 
 /**
 * @brief CRC32 value in big endian.
@@ -69,6 +73,8 @@ static inline uint16_t esp_crc16_le(uint16_t crc, uint8_t const *buf, uint32_t l
     return crc16_le(crc, buf, len);
 }
 
+#endif
+
 /**
 * @brief CRC16 value in big endian.
 *
@@ -77,10 +83,9 @@ static inline uint16_t esp_crc16_le(uint16_t crc, uint8_t const *buf, uint32_t l
 * @param len: Length of the data buffer
 * @return CRC16 value
 */
-static inline uint16_t esp_crc16_be(uint16_t crc, uint8_t const *buf, uint32_t len)
-{
-    return crc16_be(crc, buf, len);
-}
+uint16_t esp_crc16_be(uint16_t crc, uint8_t const *buf, uint32_t len);
+
+#if defined(CONFIG_IDF_TARGET_ESP32)
 
 /**
 * @brief CRC8 value in little endian.
@@ -107,6 +112,17 @@ static inline uint8_t esp_crc8_be(uint8_t crc, uint8_t const *buf, uint32_t len)
 {
     return crc8_be(crc, buf, len);
 }
+#endif
+
+/**
+* @brief CRC-7 value, as used by SD commands.
+*
+* @param crc: Initial CRC value (result of last calculation or 0 for the first time)
+* @param buf: Data buffer that used to calculate the CRC value
+* @param len: Length of the data buffer
+* @return CRC-7 value in the low 7 bits
+*/
+uint8_t esp_crc7(uint8_t crc, uint8_t const *buf, uint32_t len);
 
 #ifdef __cplusplus
 }
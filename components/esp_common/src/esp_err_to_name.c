@@ -267,6 +267,10 @@ static const esp_err_msg_t esp_err_msg_table[] = {
                                                                                 essentially first boot of firmware image
                                                                                 post upgrade and hence firmware upgrade
                                                                                 is not possible */
+#   endif
+#   ifdef      ESP_ERR_OTA_DELTA_INVALID
+    ERR_TBL_IT(ESP_ERR_OTA_DELTA_INVALID),                      /*  5383 0x1507 Error if a delta patch is malformed
+                                                                                or was made for a different base image */
 #   endif
     // components/efuse/include/esp_efuse.h
 #   ifdef      ESP_ERR_EFUSE
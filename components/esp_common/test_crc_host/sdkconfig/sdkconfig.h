@@ -0,0 +1,3 @@
+#pragma once
+
+#define CONFIG_ESP_CRC_SLICE_BY_8 1
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "esp_crc.h"
+
+#include "catch.hpp"
+
+/* Bit at a time reference implementations, with the conventions of the ROM functions */
+static uint32_t ref_crc32_le(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+static uint16_t ref_crc16_be(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return ~crc;
+}
+
+static uint8_t ref_crc7(uint8_t crc, const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        for (int b = 7; b >= 0; b--) {
+            int bit = ((crc >> 6) ^ (buf[i] >> b)) & 1;
+            crc = ((crc << 1) & 0x7f) ^ (bit ? 0x09 : 0);
+        }
+    }
+    return crc;
+}
+
+/* The byte at a time table lookup that the ROM functions and the old copies in the tree use */
+static uint32_t bytewise_crc32_le(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            table[i] = ~ref_crc32_le(0xFFFFFFFF, (const uint8_t *)&i, 1);
+        }
+    }
+    crc = ~crc;
+    while (len-- > 0) {
+        crc = table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static std::vector<uint8_t> random_data(size_t len)
+{
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < len; i++) {
+        data[i] = rand();
+    }
+    return data;
+}
+
+TEST_CASE("check values of the CRC catalogue", "[crc]")
+{
+    const uint8_t *check = (const uint8_t *)"123456789";
+    CHECK(esp_crc32_le(0, check, 9) == 0xCBF43926);                 // CRC-32
+    CHECK((uint16_t)~esp_crc16_be((uint16_t)~0x0000, check, 9) == 0x31C3);  // CRC-16/XMODEM
+    CHECK((uint16_t)~esp_crc16_be((uint16_t)~0xFFFF, check, 9) == 0x29B1);  // CRC-16/CCITT-FALSE
+    CHECK(esp_crc7(0, check, 9) == 0x75);                           // CRC-7/MMC
+}
+
+TEST_CASE("CRCs match the reference for any length and alignment", "[crc]")
+{
+    std::vector<uint8_t> data = random_data(256 + 8);
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len <= 256; len++) {
+            const uint8_t *p = data.data() + offset;
+            uint32_t crc32 = rand();
+            uint16_t crc16 = rand();
+            uint8_t crc7 = rand() & 0x7f;
+            REQUIRE(esp_crc32_le(crc32, p, len) == ref_crc32_le(crc32, p, len));
+            REQUIRE(esp_crc16_be(crc16, p, len) == ref_crc16_be(crc16, p, len));
+            REQUIRE(esp_crc7(crc7, p, len) == ref_crc7(crc7, p, len));
+        }
+    }
+}
+
+TEST_CASE("CRC of several buffers equals the CRC of their concatenation", "[crc]")
+{
+    std::vector<uint8_t> data = random_data(4096);
+    uint32_t crc32 = 0;
+    uint16_t crc16 = 0;
+    uint8_t crc7 = 0;
+    for (size_t pos = 0; pos < data.size(); ) {
+        size_t len = std::min(data.size() - pos, (size_t) rand() % 100);
+        crc32 = esp_crc32_le(crc32, data.data() + pos, len);
+        crc16 = esp_crc16_be(crc16, data.data() + pos, len);
+        crc7 = esp_crc7(crc7, data.data() + pos, len);
+        pos += len;
+    }
+    CHECK(crc32 == esp_crc32_le(0, data.data(), data.size()));
+    CHECK(crc16 == esp_crc16_be(0, data.data(), data.size()));
+    CHECK(crc7 == esp_crc7(0, data.data(), data.size()));
+}
+
+/* Keeps the CRC16 loop from being optimized out */
+static volatile uint16_t s_sink;
+
+TEST_CASE("CRC throughput", "[crc][benchmark]")
+{
+    /* NVS entries, a wear levelling state and a flash sector */
+    const size_t sizes[] = { 32, 128, 4096 };
+    for (size_t size : sizes) {
+        std::vector<uint8_t> data = random_data(size);
+        const size_t total = 64 * 1024 * 1024;
+        const size_t rounds = total / size;
+        uint32_t crc = 0;
+
+        clock_t start = clock();
+        for (size_t i = 0; i < rounds; i++) {
+            crc = bytewise_crc32_le(crc, data.data(), size);
+        }
+        double bytewise = (double)(clock() - start) / CLOCKS_PER_SEC;
+        uint32_t bytewise_crc = crc;
+
+        crc = 0;
+        start = clock();
+        for (size_t i = 0; i < rounds; i++) {
+            crc = esp_crc32_le(crc, data.data(), size);
+        }
+        double sliced = (double)(clock() - start) / CLOCKS_PER_SEC;
+        REQUIRE(crc == bytewise_crc);
+
+        uint16_t crc16 = 0;
+        start = clock();
+        for (size_t i = 0; i < rounds; i++) {
+            crc16 = esp_crc16_be(crc16, data.data(), size);
+        }
+        double sliced16 = (double)(clock() - start) / CLOCKS_PER_SEC;
+        s_sink = crc16;
+
+        printf("%4d byte buffers: CRC32 byte at a time %.0f MB/s, slice-by-8 %.0f MB/s; CRC16 slice-by-8 %.0f MB/s\n",
+               (int)size, total / 1048576.0 / bytewise, total / 1048576.0 / sliced, total / 1048576.0 / sliced16);
+    }
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_event.h"
+
+#include "catch.hpp"
+
+ESP_EVENT_DEFINE_BASE(TEST_EVENTS);
+
+#define EVENTS_PER_PRODUCER     100000
+#define HANDLER_COUNT           32
+
+static double time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Every producer posts the numbers 0 .. EVENTS_PER_PRODUCER - 1 as event data, to event ids 0 .. id_count - 1 in turn */
+struct event_context {
+    esp_event_loop_handle_t loop;
+    int32_t id_count;
+    uint32_t expected;
+    uint32_t received;
+    uint64_t sum;
+    uint32_t post_failures;
+    SemaphoreHandle_t done;
+};
+
+static portMUX_TYPE s_failures_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void handler(void *arg, esp_event_base_t base, int32_t id, void *data)
+{
+    event_context *ctx = (event_context *) arg;
+    ctx->sum += *(uint32_t *) data;
+    if (++ctx->received == ctx->expected) {
+        xSemaphoreGive(ctx->done);
+    }
+}
+
+static void producer(void *arg)
+{
+    event_context *ctx = (event_context *) arg;
+    for (uint32_t i = 0; i < EVENTS_PER_PRODUCER; i++) {
+        if (esp_event_post_to(ctx->loop, TEST_EVENTS, i % ctx->id_count, &i, sizeof(i), portMAX_DELAY) != ESP_OK) {
+            portENTER_CRITICAL(&s_failures_lock);
+            ctx->post_failures++;
+            portEXIT_CRITICAL(&s_failures_lock);
+        }
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+/* Posts from a producer task on each core to a loop task on loop_core, returns events per second */
+static double run_event_loop(event_context &ctx, int loop_core)
+{
+    esp_event_loop_args_t args = {
+        .queue_size = 32,
+        .task_name = "loop",
+        .task_priority = 6,
+        .task_stack_size = 2048,
+        .task_core_id = loop_core,
+    };
+    REQUIRE(esp_event_loop_create(&args, &ctx.loop) == ESP_OK);
+    for (int32_t id = 0; id < ctx.id_count; id++) {
+        REQUIRE(esp_event_handler_register_with(ctx.loop, TEST_EVENTS, id, handler, &ctx) == ESP_OK);
+    }
+    ctx.expected = EVENTS_PER_PRODUCER * portNUM_PROCESSORS;
+    ctx.done = xSemaphoreCreateCounting(portNUM_PROCESSORS + 1, 0);
+
+    double start = time_s();
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        REQUIRE(xTaskCreatePinnedToCore(producer, "producer", 2048, &ctx, 5, NULL, core) == pdPASS);
+    }
+    for (int i = 0; i < portNUM_PROCESSORS + 1; i++) {
+        REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+    }
+    double seconds = time_s() - start;
+
+    REQUIRE(esp_event_loop_delete(ctx.loop) == ESP_OK);
+    vSemaphoreDelete(ctx.done);
+    return ctx.received / seconds;
+}
+
+TEST_CASE("events posted from both cores are all delivered", "[esp_event][timing]")
+{
+    const uint64_t sum = (uint64_t) EVENTS_PER_PRODUCER * (EVENTS_PER_PRODUCER - 1) / 2 * portNUM_PROCESSORS;
+    for (int loop_core = 0; loop_core < portNUM_PROCESSORS; loop_core++) {
+        event_context ctx = { NULL, 1, 0, 0, 0, 0, NULL };
+        double rate = run_event_loop(ctx, loop_core);
+        CHECK(ctx.post_failures == 0);
+        CHECK(ctx.received == ctx.expected);
+        CHECK(ctx.sum == sum);
+        printf("loop task on core %d, one handler: %.0f events/s\n", loop_core, rate);
+    }
+}
+
+TEST_CASE("event dispatch with many registered handlers", "[esp_event][timing]")
+{
+    event_context ctx = { NULL, HANDLER_COUNT, 0, 0, 0, 0, NULL };
+    double rate = run_event_loop(ctx, 0);
+    CHECK(ctx.post_failures == 0);
+    CHECK(ctx.received == ctx.expected);
+    printf("loop task on core 0, %d handlers for different ids: %.0f events/s\n", HANDLER_COUNT, rate);
+}
+
+TEST_CASE("events dispatched by esp_event_loop_run in the posting task", "[esp_event][timing]")
+{
+    const uint32_t batch = 64;
+    event_context ctx = { NULL, 1, EVENTS_PER_PRODUCER, 0, 0, 0, xSemaphoreCreateBinary() };
+    esp_event_loop_args_t args = {
+        .queue_size = (int32_t) batch,
+        .task_name = NULL,
+    };
+    REQUIRE(esp_event_loop_create(&args, &ctx.loop) == ESP_OK);
+    REQUIRE(esp_event_handler_register_with(ctx.loop, TEST_EVENTS, ESP_EVENT_ANY_ID, handler, &ctx) == ESP_OK);
+
+    double start = time_s();
+    for (uint32_t i = 0; i < EVENTS_PER_PRODUCER; i++) {
+        REQUIRE(esp_event_post_to(ctx.loop, TEST_EVENTS, 0, &i, sizeof(i), 0) == ESP_OK);
+        if (i % batch == batch - 1 || i == EVENTS_PER_PRODUCER - 1) {
+            /* With no ticks to run, every call dispatches at most one event */
+            for (uint32_t j = 0; j <= i % batch; j++) {
+                REQUIRE(esp_event_loop_run(ctx.loop, 0) == ESP_OK);
+            }
+        }
+    }
+    double seconds = time_s() - start;
+    CHECK(ctx.received == EVENTS_PER_PRODUCER);
+    printf("no loop task, batches of %u: %.0f events/s\n", batch, EVENTS_PER_PRODUCER / seconds);
+
+    REQUIRE(esp_event_loop_delete(ctx.loop) == ESP_OK);
+    vSemaphoreDelete(ctx.done);
+}
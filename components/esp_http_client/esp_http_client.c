@@ -14,6 +14,10 @@
 
 
 #include <string.h>
+#include <sys/queue.h>
+#include <sys/select.h>
+#include <sys/param.h>
+#include <unistd.h>
 
 #include "esp_system.h"
 #include "esp_log.h"
@@ -23,6 +27,7 @@
 #include "esp_transport_tcp.h"
 #include "http_utils.h"
 #include "http_auth.h"
+#include "http_conn_pool.h"
 #include "sdkconfig.h"
 #include "esp_http_client.h"
 #include "errno.h"
@@ -84,6 +89,36 @@ typedef enum {
     HTTP_STATE_RES_COMPLETE_DATA,
     HTTP_STATE_CLOSE
 } esp_http_state_t;
+
+/**
+ * Request queued with esp_http_client_queue_request()
+ */
+typedef struct esp_http_pipeline_req {
+    esp_http_client_method_t            method;
+    char                                *path;      /*!< path and query, allocated along with the request */
+    char                                *data;      /*!< body, allocated along with the request */
+    int                                 data_len;
+    void                                *ctx;
+    int                                 retries;    /*!< times the request was sent on a connection that failed */
+    STAILQ_ENTRY(esp_http_pipeline_req) next;
+} esp_http_pipeline_req_t;
+
+STAILQ_HEAD(esp_http_pipeline_list, esp_http_pipeline_req);
+
+typedef struct {
+    struct esp_http_pipeline_list   pending;        /*!< requests not sent yet */
+    struct esp_http_pipeline_list   in_flight;      /*!< requests sent (or being sent) in the order of their responses */
+    int                             in_flight_count;
+    int                             queued_count;   /*!< requests in pending and in_flight */
+    int                             depth;          /*!< max in_flight_count */
+    esp_http_pipeline_req_t         *tx_req;        /*!< request being written, the last one in in_flight */
+    esp_http_pipeline_req_t         *finished_req;  /*!< request whose response was just parsed, reported once the parser returns */
+    int                             tx_head_len;    /*!< length of the request head in the request buffer */
+    int                             tx_offset;      /*!< bytes of head and body of tx_req written so far */
+    bool                            close_after;    /*!< server closes the connection after the current response */
+    bool                            registered;     /*!< client is in the list driven by esp_http_client_process() */
+} esp_http_pipeline_t;
+
 /**
  * HTTP client class
  */
@@ -119,6 +154,10 @@ struct esp_http_client {
     bool                        first_line_prepared;
     int                         header_index;
     bool                        is_async;
+    bool                        is_pooled_transport;    /*!< transport was taken over from the connection pool and is not part of transport_list */
+    http_conn_pool_tls_t        pool_tls;               /*!< TLS settings of https connections, pooled connections must match them */
+    esp_http_pipeline_t         pipeline;
+    STAILQ_ENTRY(esp_http_client) pipeline_next;
 };
 
 typedef struct esp_http_client esp_http_client_t;
@@ -139,6 +178,13 @@ static const char *DEFAULT_HTTP_PROTOCOL = "HTTP/1.1";
 static const char *DEFAULT_HTTP_PATH = "/";
 static int DEFAULT_MAX_REDIRECT = 10;
 static int DEFAULT_TIMEOUT_MS = 5000;
+/* Max time esp_http_client_process() waits in select() while an async connect is in progress */
+#define PIPELINE_CONNECT_POLL_MS (10)
+/* Times a queued request is sent again after the connection it was sent on failed */
+#define PIPELINE_MAX_RETRIES (1)
+
+/* Clients with queued requests, driven by esp_http_client_process() */
+static STAILQ_HEAD(, esp_http_client) s_pipeline_clients = STAILQ_HEAD_INITIALIZER(s_pipeline_clients);
 
 static const char *HTTP_METHOD_MAPPING[] = {
     "GET",
@@ -156,6 +202,7 @@ static const char *HTTP_METHOD_MAPPING[] = {
 static esp_err_t esp_http_client_request_send(esp_http_client_handle_t client, int write_len);
 static esp_err_t esp_http_client_connect(esp_http_client_handle_t client);
 static esp_err_t esp_http_client_send_post_data(esp_http_client_handle_t client);
+static void http_pipeline_abort(esp_http_client_handle_t client);
 
 static esp_err_t http_dispatch_event(esp_http_client_t *client, esp_http_client_event_id_t event_id, void *data, int len)
 {
@@ -178,6 +225,10 @@ static int http_on_message_begin(http_parser *parser)
 
     client->response->is_chunked = false;
     client->is_chunk_complete = false;
+    esp_http_pipeline_req_t *req = STAILQ_FIRST(&client->pipeline.in_flight);
+    if (req) {
+        client->event.request_ctx = req->ctx;
+    }
     return 0;
 }
 
@@ -236,6 +287,11 @@ static int http_on_headers_complete(http_parser *parser)
     client->response->data_process = 0;
     ESP_LOGD(TAG, "http_on_headers_complete, status=%d, offset=%d, nread=%d", parser->status_code, client->response->data_offset, parser->nread);
     client->state = HTTP_STATE_RES_COMPLETE_HEADER;
+    esp_http_pipeline_req_t *req = STAILQ_FIRST(&client->pipeline.in_flight);
+    if (req && req->method == HTTP_METHOD_HEAD) {
+        /* Tell the parser that the response to HEAD has no body despite its Content-Length */
+        return 1;
+    }
     return 0;
 }
 
@@ -260,6 +316,25 @@ static int http_on_message_complete(http_parser *parser)
     ESP_LOGD(TAG, "http_on_message_complete, parser=%x", (int)parser);
     esp_http_client_handle_t client = parser->data;
     client->is_chunk_complete = true;
+    esp_http_pipeline_req_t *req = STAILQ_FIRST(&client->pipeline.in_flight);
+    if (req) {
+        esp_http_pipeline_t *pipeline = &client->pipeline;
+        STAILQ_REMOVE_HEAD(&pipeline->in_flight, next);
+        pipeline->in_flight_count--;
+        if (req == pipeline->tx_req) {
+            /* Server responded before the whole request was sent, the connection can't be used any further */
+            pipeline->tx_req = NULL;
+            pipeline->close_after = true;
+        }
+        if (!http_should_keep_alive(parser)) {
+            pipeline->close_after = true;
+        }
+        client->response->buffer->raw_len = 0;
+        /* The event handler may call back into the client, so the request is reported once
+         * http_parser_execute() has returned. Pausing makes it return right after this response. */
+        pipeline->finished_req = req;
+        http_parser_pause(parser, 1);
+    }
     return 0;
 }
 
@@ -425,6 +500,7 @@ static esp_err_t _set_config(esp_http_client_handle_t client, const esp_http_cli
     if (config->is_async) {
         client->is_async = true;
     }
+    client->pipeline.depth = config->pipeline_depth > 1 ? config->pipeline_depth : 1;
 
     return ESP_OK;
 }
@@ -512,6 +588,8 @@ esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *co
         ESP_LOGE(TAG, "Error allocate memory");
         goto error;
     }
+    STAILQ_INIT(&client->pipeline.pending);
+    STAILQ_INIT(&client->pipeline.in_flight);
 
     _success = (
                    (client->transport_list = esp_transport_list_init()) &&
@@ -553,6 +631,12 @@ esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *co
     if (config->skip_cert_common_name_check) {
         esp_transport_ssl_skip_common_name_check(ssl);
     }
+
+    client->pool_tls.cert_pem = config->use_global_ca_store ? NULL : config->cert_pem;
+    client->pool_tls.client_cert_pem = config->client_cert_pem;
+    client->pool_tls.client_key_pem = config->client_key_pem;
+    client->pool_tls.use_global_ca_store = config->use_global_ca_store;
+    client->pool_tls.skip_cert_common_name_check = config->skip_cert_common_name_check;
 #endif
 
     if (_set_config(client, config) != ESP_OK) {
@@ -614,11 +698,58 @@ error:
     return NULL;
 }
 
+#ifdef CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+static bool esp_http_client_is_reusable(esp_http_client_handle_t client)
+{
+    if (client->transport == NULL || client->is_async) {
+        return false;
+    }
+    /* esp_http_client_perform() goes back to HTTP_STATE_CONNECTED only for keep-alive responses */
+    if (client->state == HTTP_STATE_CONNECTED) {
+        return true;
+    }
+    return client->state == HTTP_STATE_RES_COMPLETE_HEADER
+           && esp_http_client_is_complete_data_received(client)
+           && http_should_keep_alive(client->parser);
+}
+
+/* TLS settings the pooled connections of the client are keyed with, none for plain http */
+static const http_conn_pool_tls_t *esp_http_client_pool_tls(esp_http_client_handle_t client)
+{
+    if (client->connection_info.scheme && strcasecmp(client->connection_info.scheme, "https") == 0) {
+        return &client->pool_tls;
+    }
+    return NULL;
+}
+
+static void esp_http_client_release_connection(esp_http_client_handle_t client)
+{
+    if (!esp_http_client_is_reusable(client)) {
+        return;
+    }
+    esp_transport_handle_t transport = client->transport;
+    if (!client->is_pooled_transport
+            && esp_transport_list_remove(client->transport_list, transport) != ESP_OK) {
+        return;
+    }
+    http_conn_pool_release(client->connection_info.scheme, client->connection_info.host, client->connection_info.port,
+                           esp_http_client_pool_tls(client), transport);
+    client->transport = NULL;
+    client->is_pooled_transport = false;
+    /* The connection lives on in the pool, so no disconnect event */
+    client->state = HTTP_STATE_UNINIT;
+}
+#endif
+
 esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
 {
     if (client == NULL) {
         return ESP_FAIL;
     }
+    http_pipeline_abort(client);
+#ifdef CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+    esp_http_client_release_connection(client);
+#endif
     esp_http_client_close(client);
     esp_transport_list_destroy(client->transport_list);
     http_header_destroy(client->request->headers);
@@ -992,6 +1123,28 @@ int esp_http_client_fetch_headers(esp_http_client_handle_t client)
     return client->response->content_length;
 }
 
+/* Connect the transport of the client, resuming the TLS session of an earlier connection to the server if one is saved */
+static int esp_http_client_transport_connect(esp_http_client_handle_t client)
+{
+#if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_SESSIONS > 0
+    const http_conn_pool_tls_t *tls = esp_http_client_pool_tls(client);
+    if (tls) {
+        esp_tls_client_session_t *session = http_conn_pool_take_session(client->connection_info.host, client->connection_info.port, tls);
+        esp_transport_ssl_set_client_session(client->transport, session);
+        int ret = esp_transport_connect(client->transport, client->connection_info.host, client->connection_info.port, client->timeout_ms);
+        esp_transport_ssl_set_client_session(client->transport, NULL);
+        esp_tls_free_client_session(session);
+        if (ret >= 0) {
+            /* The session of this connection, resumed or new, is the one to resume next time */
+            http_conn_pool_save_session(client->connection_info.host, client->connection_info.port, tls,
+                                        esp_transport_ssl_get_client_session(client->transport));
+        }
+        return ret;
+    }
+#endif
+    return esp_transport_connect(client->transport, client->connection_info.host, client->connection_info.port, client->timeout_ms);
+}
+
 static esp_err_t esp_http_client_connect(esp_http_client_handle_t client)
 {
     esp_err_t err;
@@ -1008,6 +1161,20 @@ static esp_err_t esp_http_client_connect(esp_http_client_handle_t client)
     }
 
     if (client->state < HTTP_STATE_CONNECTED) {
+#ifdef CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+        if (!client->is_async) {
+            esp_transport_handle_t pooled = http_conn_pool_acquire(client->connection_info.scheme, client->connection_info.host, client->connection_info.port,
+                                                                   esp_http_client_pool_tls(client));
+            if (pooled) {
+                ESP_LOGD(TAG, "Reuse pooled connection to: %s://%s:%d", client->connection_info.scheme, client->connection_info.host, client->connection_info.port);
+                client->transport = pooled;
+                client->is_pooled_transport = true;
+                client->state = HTTP_STATE_CONNECTED;
+                http_dispatch_event(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+                return ESP_OK;
+            }
+        }
+#endif
         ESP_LOGD(TAG, "Begin connect to: %s://%s:%d", client->connection_info.scheme, client->connection_info.host, client->connection_info.port);
         client->transport = esp_transport_list_get_transport(client->transport_list, client->connection_info.scheme);
         if (client->transport == NULL) {
@@ -1020,7 +1187,7 @@ static esp_err_t esp_http_client_connect(esp_http_client_handle_t client)
             return ESP_ERR_HTTP_INVALID_TRANSPORT;
         }
         if (!client->is_async) {
-            if (esp_transport_connect(client->transport, client->connection_info.host, client->connection_info.port, client->timeout_ms) < 0) {
+            if (esp_http_client_transport_connect(client) < 0) {
                 ESP_LOGE(TAG, "Connection failed, sock < 0");
                 return ESP_ERR_HTTP_CONNECT;
             }
@@ -1086,6 +1253,8 @@ static esp_err_t esp_http_client_request_send(esp_http_client_handle_t client, i
 {
     int first_line_len = 0;
     if (!client->first_line_prepared) {
+        /* A new request: header values handed out by esp_http_client_get_header() may move from now on */
+        http_header_release_values(client->request->headers);
         if ((first_line_len = http_client_prepare_first_line(client, write_len)) < 0) {
             return first_line_len;
         }
@@ -1210,6 +1379,13 @@ esp_err_t esp_http_client_close(esp_http_client_handle_t client)
     if (client->state >= HTTP_STATE_INIT) {
         http_dispatch_event(client, HTTP_EVENT_DISCONNECTED, esp_transport_get_error_handle(client->transport), 0);
         client->state = HTTP_STATE_INIT;
+        if (client->is_pooled_transport) {
+            /* A connection taken over from the pool is not in our transport list, and is of no use once closed */
+            esp_transport_handle_t transport = client->transport;
+            client->transport = NULL;
+            client->is_pooled_transport = false;
+            return esp_transport_destroy(transport);
+        }
         return esp_transport_close(client->transport);
     }
     return ESP_OK;
@@ -1316,6 +1492,11 @@ void esp_http_client_add_auth(esp_http_client_handle_t client)
     }
 }
 
+void esp_http_client_flush_connection_pool(void)
+{
+    http_conn_pool_flush();
+}
+
 int esp_http_client_read_response(esp_http_client_handle_t client, char *buffer, int len)
 {
     int read_len = 0;
@@ -1328,3 +1509,360 @@ int esp_http_client_read_response(esp_http_client_handle_t client, char *buffer,
     }
     return read_len;
 }
+
+static void http_pipeline_register(esp_http_client_handle_t client)
+{
+    if (!client->pipeline.registered) {
+        STAILQ_INSERT_TAIL(&s_pipeline_clients, client, pipeline_next);
+        client->pipeline.registered = true;
+    }
+}
+
+static void http_pipeline_unregister(esp_http_client_handle_t client)
+{
+    if (client->pipeline.registered) {
+        STAILQ_REMOVE(&s_pipeline_clients, client, esp_http_client, pipeline_next);
+        client->pipeline.registered = false;
+    }
+}
+
+static void http_pipeline_fail_request(esp_http_client_handle_t client, esp_http_pipeline_req_t *req)
+{
+    ESP_LOGE(TAG, "Request %s %s failed", HTTP_METHOD_MAPPING[req->method], req->path);
+    client->event.request_ctx = req->ctx;
+    http_dispatch_event(client, HTTP_EVENT_ERROR, NULL, 0);
+    client->event.request_ctx = NULL;
+    free(req);
+    client->pipeline.queued_count--;
+}
+
+/* Count a failed attempt for every request of the list, and fail those that ran out of retries */
+static void http_pipeline_retry(esp_http_client_handle_t client, struct esp_http_pipeline_list *list)
+{
+    struct esp_http_pipeline_list retry = STAILQ_HEAD_INITIALIZER(retry);
+    esp_http_pipeline_req_t *req;
+    while ((req = STAILQ_FIRST(list)) != NULL) {
+        STAILQ_REMOVE_HEAD(list, next);
+        if (++req->retries > PIPELINE_MAX_RETRIES) {
+            http_pipeline_fail_request(client, req);
+        } else {
+            STAILQ_INSERT_TAIL(&retry, req, next);
+        }
+    }
+    /* The event handler may have queued new requests meanwhile, keep them behind the retried ones */
+    STAILQ_CONCAT(&retry, list);
+    STAILQ_CONCAT(list, &retry);
+}
+
+/* Close the connection and put the requests that got no response back in front of the pending ones */
+static void http_pipeline_reset_connection(esp_http_client_handle_t client, bool failed)
+{
+    esp_http_pipeline_t *pipeline = &client->pipeline;
+    esp_http_client_close(client);
+    pipeline->tx_req = NULL;
+    pipeline->close_after = false;
+    pipeline->in_flight_count = 0;
+    if (failed) {
+        http_pipeline_retry(client, &pipeline->in_flight);
+    }
+    STAILQ_CONCAT(&pipeline->in_flight, &pipeline->pending);
+    STAILQ_CONCAT(&pipeline->pending, &pipeline->in_flight);
+}
+
+/* Called on cleanup: the queued requests will never be performed */
+static void http_pipeline_abort(esp_http_client_handle_t client)
+{
+    esp_http_pipeline_t *pipeline = &client->pipeline;
+    esp_http_pipeline_req_t *req;
+    http_pipeline_unregister(client);
+    if (!STAILQ_EMPTY(&pipeline->in_flight)) {
+        /* Responses are still on their way, the connection can't be reused */
+        esp_http_client_close(client);
+    }
+    pipeline->tx_req = NULL;
+    pipeline->in_flight_count = 0;
+    STAILQ_CONCAT(&pipeline->in_flight, &pipeline->pending);
+    while ((req = STAILQ_FIRST(&pipeline->in_flight)) != NULL) {
+        STAILQ_REMOVE_HEAD(&pipeline->in_flight, next);
+        http_pipeline_fail_request(client, req);
+    }
+}
+
+static int http_pipeline_prepare_head(esp_http_client_handle_t client, esp_http_pipeline_req_t *req)
+{
+    char *buffer = client->request->buffer->data;
+    int head_len = snprintf(buffer, client->buffer_size_tx, "%s %s %s\r\n",
+                            HTTP_METHOD_MAPPING[req->method], req->path, DEFAULT_HTTP_PROTOCOL);
+    if (head_len >= client->buffer_size_tx) {
+        ESP_LOGE(TAG, "Out of buffer");
+        return -1;
+    }
+    http_header_set_format(client->request->headers, "Content-Length", "%d", req->data_len);
+
+    int header_len = client->buffer_size_tx - head_len;
+    http_header_generate_string(client->request->headers, 0, buffer + head_len, &header_len);
+    head_len += header_len;
+    /* The whole head is sent from the request buffer, so all headers and the terminating empty line have to fit */
+    if (head_len < 4 || memcmp(buffer + head_len - 4, "\r\n\r\n", 4) != 0) {
+        ESP_LOGE(TAG, "Out of buffer");
+        return -1;
+    }
+    return head_len;
+}
+
+static int http_pipeline_write(esp_http_client_handle_t client, const char *buffer, int len)
+{
+    errno = 0;
+    int wlen = esp_transport_write(client->transport, buffer, len, 0);
+    if (wlen < 0 && client->is_async && errno == EAGAIN) {
+        return 0;
+    }
+    return wlen;
+}
+
+/* Write as much of the queued requests as the pipeline depth and the socket allow, false on connection error */
+static bool http_pipeline_send(esp_http_client_handle_t client, bool *progress)
+{
+    esp_http_pipeline_t *pipeline = &client->pipeline;
+    while (true) {
+        esp_http_pipeline_req_t *req = pipeline->tx_req;
+        if (req == NULL) {
+            if (pipeline->close_after || pipeline->in_flight_count >= pipeline->depth
+                    || (req = STAILQ_FIRST(&pipeline->pending)) == NULL) {
+                return true;
+            }
+            STAILQ_REMOVE_HEAD(&pipeline->pending, next);
+            if ((pipeline->tx_head_len = http_pipeline_prepare_head(client, req)) < 0) {
+                http_pipeline_fail_request(client, req);
+                *progress = true;
+                continue;
+            }
+            STAILQ_INSERT_TAIL(&pipeline->in_flight, req, next);
+            pipeline->in_flight_count++;
+            pipeline->tx_req = req;
+            pipeline->tx_offset = 0;
+        }
+
+        int total_len = pipeline->tx_head_len + req->data_len;
+        if (pipeline->tx_offset < total_len) {
+            int wlen;
+            if (pipeline->tx_offset < pipeline->tx_head_len) {
+                wlen = http_pipeline_write(client, client->request->buffer->data + pipeline->tx_offset,
+                                           pipeline->tx_head_len - pipeline->tx_offset);
+            } else {
+                wlen = http_pipeline_write(client, req->data + pipeline->tx_offset - pipeline->tx_head_len,
+                                           total_len - pipeline->tx_offset);
+            }
+            if (wlen < 0) {
+                ESP_LOGE(TAG, "Error write request");
+                return false;
+            }
+            if (wlen == 0) {
+                return true;
+            }
+            pipeline->tx_offset += wlen;
+            *progress = true;
+        }
+        if (pipeline->tx_offset == total_len) {
+            ESP_LOGD(TAG, "Sent %s %s", HTTP_METHOD_MAPPING[req->method], req->path);
+            pipeline->tx_req = NULL;
+        }
+    }
+}
+
+static void http_pipeline_finish_request(esp_http_client_handle_t client)
+{
+    esp_http_pipeline_req_t *req = client->pipeline.finished_req;
+    if (req == NULL) {
+        return;
+    }
+    client->pipeline.finished_req = NULL;
+    client->event.request_ctx = req->ctx;
+    http_dispatch_event(client, HTTP_EVENT_ON_FINISH, NULL, 0);
+    client->event.request_ctx = NULL;
+    free(req);
+    client->pipeline.queued_count--;
+}
+
+/* Feed received data to the parser, reporting each complete response outside of the parser callbacks */
+static int http_pipeline_parse(esp_http_client_handle_t client, const char *data, int len)
+{
+    int parsed = 0;
+    do {
+        parsed += http_parser_execute(client->parser, client->parser_settings, data + parsed, len - parsed);
+        if (HTTP_PARSER_ERRNO(client->parser) != HPE_PAUSED) {
+            break;
+        }
+        http_parser_pause(client->parser, 0);
+        http_pipeline_finish_request(client);
+    } while (parsed < len);
+    return parsed;
+}
+
+/* Parse the responses received so far, false on connection or parse error */
+static bool http_pipeline_receive(esp_http_client_handle_t client, bool *progress)
+{
+    esp_http_pipeline_t *pipeline = &client->pipeline;
+    esp_http_buffer_t *res_buffer = client->response->buffer;
+    while (!STAILQ_EMPTY(&pipeline->in_flight) && !pipeline->close_after) {
+        errno = 0;
+        int rlen = esp_transport_read(client->transport, res_buffer->data, client->buffer_size_rx, 0);
+        if (rlen == 0 || (rlen < 0 && client->is_async && errno == EAGAIN)) {
+            return true;
+        }
+        *progress = true;
+        if (rlen < 0) {
+            /* Completes a response delimited by the connection close, any other one is cut off */
+            http_pipeline_parse(client, res_buffer->data, 0);
+            return pipeline->close_after;
+        }
+        int parsed = http_pipeline_parse(client, res_buffer->data, rlen);
+        res_buffer->raw_len = 0;
+        if (parsed != rlen && !pipeline->close_after) {
+            ESP_LOGE(TAG, "Error parse response: %s", http_errno_description(HTTP_PARSER_ERRNO(client->parser)));
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Advance the queued requests of a client as far as possible without waiting, true if anything was done */
+static bool http_pipeline_step(esp_http_client_handle_t client)
+{
+    esp_http_pipeline_t *pipeline = &client->pipeline;
+    bool progress = false;
+
+    if (client->state < HTTP_STATE_CONNECTED) {
+        if (STAILQ_EMPTY(&pipeline->pending)) {
+            return false;
+        }
+        esp_err_t err = esp_http_client_connect(client);
+        if (err == ESP_ERR_HTTP_CONNECTING) {
+            return false;
+        }
+        if (err != ESP_OK) {
+            esp_transport_close(client->transport);
+            http_pipeline_retry(client, &pipeline->pending);
+            return true;
+        }
+        progress = true;
+    }
+
+    if (!http_pipeline_send(client, &progress) || !http_pipeline_receive(client, &progress)) {
+        http_pipeline_reset_connection(client, true);
+        return true;
+    }
+    if (pipeline->close_after) {
+        http_pipeline_reset_connection(client, false);
+        return true;
+    }
+    return progress;
+}
+
+static bool http_pipeline_step_all(int *outstanding)
+{
+    bool progress = false;
+    *outstanding = 0;
+    esp_http_client_handle_t client = STAILQ_FIRST(&s_pipeline_clients);
+    while (client != NULL) {
+        esp_http_client_handle_t next = STAILQ_NEXT(client, pipeline_next);
+        if (http_pipeline_step(client)) {
+            progress = true;
+        }
+        if (client->pipeline.queued_count == 0) {
+            /* The connection is kept open for requests queued later */
+            http_pipeline_unregister(client);
+        } else {
+            *outstanding += client->pipeline.queued_count;
+        }
+        client = next;
+    }
+    return progress;
+}
+
+static void http_pipeline_wait(int timeout_ms)
+{
+    fd_set readset;
+    fd_set writeset;
+    int max_fd = -1;
+    FD_ZERO(&readset);
+    FD_ZERO(&writeset);
+
+    esp_http_client_handle_t client;
+    STAILQ_FOREACH(client, &s_pipeline_clients, pipeline_next) {
+        int sock = client->state >= HTTP_STATE_CONNECTED ? esp_transport_get_socket(client->transport) : -1;
+        if (sock < 0) {
+            /* Asynchronous connect in progress, poll it */
+            timeout_ms = MIN(timeout_ms, PIPELINE_CONNECT_POLL_MS);
+            continue;
+        }
+        if (!STAILQ_EMPTY(&client->pipeline.in_flight)) {
+            FD_SET(sock, &readset);
+        }
+        if (client->pipeline.tx_req) {
+            FD_SET(sock, &writeset);
+        }
+        max_fd = MAX(max_fd, sock);
+    }
+
+    if (max_fd < 0) {
+        usleep(timeout_ms * 1000);
+        return;
+    }
+    struct timeval timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    select(max_fd + 1, &readset, &writeset, NULL, &timeout);
+}
+
+esp_err_t esp_http_client_queue_request(esp_http_client_handle_t client, esp_http_client_method_t method, const char *path,
+                                        const char *data, int data_len, void *request_ctx)
+{
+    if (client == NULL || method < 0 || method >= HTTP_METHOD_MAX || data_len < 0 || (data == NULL && data_len > 0)) {
+        ESP_LOGE(TAG, "Invalid request");
+        return ESP_ERR_INVALID_ARG;
+    }
+    const char *query = NULL;
+    if (path == NULL) {
+        path = client->connection_info.path;
+        query = client->connection_info.query;
+    }
+    int path_len = strlen(path) + (query ? strlen(query) + 1 : 0);
+
+    esp_http_pipeline_req_t *req = calloc(1, sizeof(esp_http_pipeline_req_t) + path_len + 1 + data_len);
+    HTTP_MEM_CHECK(TAG, req, return ESP_ERR_NO_MEM);
+    req->method = method;
+    req->ctx = request_ctx;
+    req->path = (char *)(req + 1);
+    strcpy(req->path, path);
+    if (query) {
+        strcat(req->path, "?");
+        strcat(req->path, query);
+    }
+    req->data = req->path + path_len + 1;
+    req->data_len = data_len;
+    if (data_len > 0) {
+        memcpy(req->data, data, data_len);
+    }
+
+    http_header_release_values(client->request->headers);
+    STAILQ_INSERT_TAIL(&client->pipeline.pending, req, next);
+    client->pipeline.queued_count++;
+    http_pipeline_register(client);
+    return ESP_OK;
+}
+
+int esp_http_client_process(int timeout_ms)
+{
+    int outstanding;
+    bool progress = http_pipeline_step_all(&outstanding);
+    if (!progress && outstanding > 0 && timeout_ms > 0) {
+        http_pipeline_wait(timeout_ms);
+        progress = true;
+    }
+    while (progress && outstanding > 0) {
+        progress = http_pipeline_step_all(&outstanding);
+    }
+    return outstanding;
+}
@@ -55,6 +55,7 @@ typedef struct esp_http_client_event {
     void *user_data;                        /*!< user_data context, from esp_http_client_config_t user_data */
     char *header_key;                       /*!< For HTTP_EVENT_ON_HEADER event_id, it's store current http header key */
     char *header_value;                     /*!< For HTTP_EVENT_ON_HEADER event_id, it's store current http header value */
+    void *request_ctx;                      /*!< request_ctx of the queued request this event belongs to, see `esp_http_client_queue_request` */
 } esp_http_client_event_t;
 
 
@@ -122,6 +123,7 @@ typedef struct {
     bool                        is_async;                 /*!< Set asynchronous mode, only supported with HTTPS for now */
     bool                        use_global_ca_store;      /*!< Use a global ca_store for all the connections in which this bool is set. */
     bool                        skip_cert_common_name_check;    /*!< Skip any validation of server certificate CN field */
+    int                         pipeline_depth;           /*!< Max requests queued with `esp_http_client_queue_request` that are sent ahead of their responses, 0 or 1 disables pipelining */
 } esp_http_client_config_t;
 
 /**
@@ -239,6 +241,10 @@ esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char
  * @brief      Get http request header.
  *             The value parameter will be set to NULL if there is no header which is same as
  *             the key specified, otherwise the address of header value will be assigned to value parameter.
+ *             The value is owned by the client. It stays valid until the same header is set again or deleted,
+ *             the next request is started by `esp_http_client_open`, `esp_http_client_perform` or
+ *             `esp_http_client_queue_request`, or the client is cleaned up. Until then, setting or deleting
+ *             other headers does not affect it.
  *             This function must be called after `esp_http_client_init`.
  *
  * @param[in]  client  The esp_http_client handle
@@ -441,6 +447,8 @@ esp_err_t esp_http_client_close(esp_http_client_handle_t client);
  *             It is the opposite of the esp_http_client_init function and must be called with the same handle as input that a esp_http_client_init call returned.
  *             This might close all connections this handle has used and possibly has kept open until now.
  *             Don't call this function if you intend to transfer more files, re-using handles is a key to good performance with esp_http_client.
+ *             With CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL enabled, a keep-alive connection whose response has been
+ *             fully read is not closed but kept for the next client to the same scheme, host and port.
  *
  * @param[in]  client  The esp_http_client handle
  *
@@ -511,6 +519,56 @@ bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client);
 
 int esp_http_client_read_response(esp_http_client_handle_t client, char *buffer, int len);
 
+/**
+ * @brief      Close all idle connections kept in the shared connection pool,
+ *             e.g. before the network interface goes down.
+ *             Does nothing if CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL is disabled.
+ */
+void esp_http_client_flush_connection_pool(void);
+
+/**
+ * @brief      Queue a request to be performed by `esp_http_client_process`.
+ *
+ *             Queued requests of one client are sent over its keep-alive connection in order. Up to `pipeline_depth`
+ *             of them are written before their responses arrive (HTTP/1.1 pipelining), so only queue idempotent
+ *             requests on a client with `pipeline_depth` > 1: a request that was sent on a connection that failed
+ *             is sent again once on a new connection.
+ *             The response is reported through the event handler; `request_ctx` of the events tells which request
+ *             they belong to. HTTP_EVENT_ON_FINISH ends a successful request, HTTP_EVENT_ERROR a failed one.
+ *             Redirects and authentication challenges are not followed for queued requests.
+ *
+ * @note       Do not mix queued requests with `esp_http_client_perform`/`esp_http_client_open` on the same client.
+ *             Queue requests, process them and cleanup the clients from the same task.
+ *
+ * @param[in]  client       The esp_http_client handle
+ * @param[in]  method       The HTTP method of the request
+ * @param[in]  path         Path and query of the request, NULL to use the path and query of the client
+ * @param[in]  data         Request body, copied by this function, can be NULL
+ * @param[in]  data_len     Length of the request body
+ * @param[in]  request_ctx  Opaque pointer passed back in the events of this request
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ *     - ESP_ERR_NO_MEM
+ */
+esp_err_t esp_http_client_queue_request(esp_http_client_handle_t client, esp_http_client_method_t method, const char *path,
+                                        const char *data, int data_len, void *request_ctx);
+
+/**
+ * @brief      Drive all clients with queued requests: connect, send requests and dispatch the events of
+ *             received responses, without blocking on any single connection.
+ *             Waits up to timeout_ms for one of the connections to become ready if there was nothing to do.
+ *
+ * @note       Connecting is blocking (up to the client `timeout_ms`) unless the client was configured with `is_async`.
+ *
+ * @param[in]  timeout_ms   Max time to wait for network activity, 0 to only do what can be done without waiting
+ *
+ * @return
+ *     - Number of queued requests that are not finished yet, over all clients
+ */
+int esp_http_client_process(int timeout_ms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,385 @@
+// Copyright 2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/lock.h>
+#include "sys/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "http_utils.h"
+#include "http_conn_pool.h"
+
+#ifdef CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL
+
+static const char *TAG = "HTTP_CONN_POOL";
+
+#define POOL_IDLE_TIMEOUT_US    ((int64_t)CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_IDLE_TIMEOUT_MS * 1000)
+
+#ifdef CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_SESSIONS
+#define POOL_MAX_SESSIONS       CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_SESSIONS
+#else
+#define POOL_MAX_SESSIONS       0   /* no https */
+#endif
+
+/**
+ * Idle connection, with the origin it is connected to
+ */
+typedef struct http_conn_pool_item {
+    char                    *scheme;    /*!< "http" or "https" */
+    char                    *host;      /*!< Host name as given in the URL */
+    int                     port;       /*!< Port number */
+    http_conn_pool_tls_t    tls;        /*!< TLS settings, all zero for none */
+    esp_transport_handle_t  transport;  /*!< Connected transport */
+    int64_t                 idle_since; /*!< Time the connection was returned to the pool, in microseconds */
+    STAILQ_ENTRY(http_conn_pool_item) next;
+} http_conn_pool_item_t;
+
+/**
+ * TLS session saved for the next connection to the host
+ */
+typedef struct http_conn_pool_session {
+    char                        *host;      /*!< Host name as given in the URL */
+    int                         port;       /*!< Port number */
+    http_conn_pool_tls_t        tls;        /*!< TLS settings of the connection the session was established on */
+    esp_tls_client_session_t    *session;   /*!< The session */
+    STAILQ_ENTRY(http_conn_pool_session) next;
+} http_conn_pool_session_t;
+
+/* Oldest connection first */
+static STAILQ_HEAD(http_conn_pool, http_conn_pool_item) s_pool = STAILQ_HEAD_INITIALIZER(s_pool);
+static int s_pool_count;
+/* Least recently saved session first */
+static STAILQ_HEAD(http_conn_pool_sessions, http_conn_pool_session) s_sessions = STAILQ_HEAD_INITIALIZER(s_sessions);
+static int s_session_count;
+static _lock_t s_pool_lock;
+
+static const http_conn_pool_tls_t s_no_tls;
+
+static bool pool_tls_equal(const http_conn_pool_tls_t *a, const http_conn_pool_tls_t *b)
+{
+    return a->cert_pem == b->cert_pem
+           && a->client_cert_pem == b->client_cert_pem
+           && a->client_key_pem == b->client_key_pem
+           && a->use_global_ca_store == b->use_global_ca_store
+           && a->skip_cert_common_name_check == b->skip_cert_common_name_check;
+}
+
+static bool pool_item_matches(const http_conn_pool_item_t *item, const char *scheme, const char *host, int port,
+                              const http_conn_pool_tls_t *tls)
+{
+    return item->port == port
+           && strcasecmp(item->scheme, scheme) == 0
+           && strcasecmp(item->host, host) == 0
+           && pool_tls_equal(&item->tls, tls);
+}
+
+static void pool_item_free(http_conn_pool_item_t *item)
+{
+    if (item->transport) {
+        esp_transport_destroy(item->transport);
+    }
+    free(item->scheme);
+    free(item->host);
+    free(item);
+}
+
+/* Must be called with s_pool_lock held */
+static void pool_remove(http_conn_pool_item_t *item)
+{
+    STAILQ_REMOVE(&s_pool, item, http_conn_pool_item, next);
+    s_pool_count--;
+}
+
+/* Must be called with s_pool_lock held. Expired items are moved to `expired`, to be freed outside the lock */
+static void pool_collect_expired(struct http_conn_pool *expired, int64_t now)
+{
+    http_conn_pool_item_t *item = STAILQ_FIRST(&s_pool);
+    while (item != NULL && now - item->idle_since >= POOL_IDLE_TIMEOUT_US) {
+        pool_remove(item);
+        STAILQ_INSERT_TAIL(expired, item, next);
+        item = STAILQ_FIRST(&s_pool);
+    }
+}
+
+static void pool_free_all(struct http_conn_pool *items)
+{
+    http_conn_pool_item_t *item = STAILQ_FIRST(items);
+    http_conn_pool_item_t *tmp;
+    while (item != NULL) {
+        tmp = STAILQ_NEXT(item, next);
+        ESP_LOGD(TAG, "Closing idle connection to %s://%s:%d", item->scheme, item->host, item->port);
+        pool_item_free(item);
+        item = tmp;
+    }
+    STAILQ_INIT(items);
+}
+
+/* Take the most recently returned connection to the origin out of the pool,
+ * as it is the least likely to have been closed by the server */
+static http_conn_pool_item_t *pool_take(const char *scheme, const char *host, int port, const http_conn_pool_tls_t *tls)
+{
+    struct http_conn_pool garbage = STAILQ_HEAD_INITIALIZER(garbage);
+    http_conn_pool_item_t *item, *found = NULL;
+
+    _lock_acquire(&s_pool_lock);
+    pool_collect_expired(&garbage, esp_timer_get_time());
+    STAILQ_FOREACH(item, &s_pool, next) {
+        if (pool_item_matches(item, scheme, host, port, tls)) {
+            found = item;
+        }
+    }
+    if (found) {
+        pool_remove(found);
+    }
+    _lock_release(&s_pool_lock);
+
+    pool_free_all(&garbage);
+    return found;
+}
+
+esp_transport_handle_t http_conn_pool_acquire(const char *scheme, const char *host, int port, const http_conn_pool_tls_t *tls)
+{
+    if (scheme == NULL || host == NULL) {
+        return NULL;
+    }
+    if (tls == NULL) {
+        tls = &s_no_tls;
+    }
+
+    http_conn_pool_item_t *item;
+    while ((item = pool_take(scheme, host, port, tls)) != NULL) {
+        /* An idle keep-alive connection must not be readable: that would be either
+         * a close notification from the server or unexpected data */
+        if (esp_transport_poll_read(item->transport, 0) == 0) {
+            esp_transport_handle_t transport = item->transport;
+            item->transport = NULL;
+            pool_item_free(item);
+            ESP_LOGD(TAG, "Reusing connection to %s://%s:%d", scheme, host, port);
+            return transport;
+        }
+        ESP_LOGD(TAG, "Pooled connection to %s://%s:%d is stale", scheme, host, port);
+        pool_item_free(item);
+    }
+    return NULL;
+}
+
+void http_conn_pool_release(const char *scheme, const char *host, int port, const http_conn_pool_tls_t *tls, esp_transport_handle_t t)
+{
+    if (t == NULL) {
+        return;
+    }
+    if (tls == NULL) {
+        tls = &s_no_tls;
+    }
+    http_conn_pool_item_t *item = calloc(1, sizeof(http_conn_pool_item_t));
+    HTTP_MEM_CHECK(TAG, item, goto error);
+    item->scheme = strdup(scheme);
+    HTTP_MEM_CHECK(TAG, item->scheme, goto error);
+    item->host = strdup(host);
+    HTTP_MEM_CHECK(TAG, item->host, goto error);
+    item->port = port;
+    item->tls = *tls;
+    item->transport = t;
+
+    struct http_conn_pool garbage = STAILQ_HEAD_INITIALIZER(garbage);
+    int64_t now = esp_timer_get_time();
+    item->idle_since = now;
+
+    _lock_acquire(&s_pool_lock);
+    pool_collect_expired(&garbage, now);
+
+    /* Make room, evicting the oldest connection to the same origin or, failing that, the oldest one overall */
+    int same_origin = 0;
+    http_conn_pool_item_t *oldest_same_origin = NULL;
+    http_conn_pool_item_t *it;
+    STAILQ_FOREACH(it, &s_pool, next) {
+        if (pool_item_matches(it, scheme, host, port, tls)) {
+            if (oldest_same_origin == NULL) {
+                oldest_same_origin = it;
+            }
+            same_origin++;
+        }
+    }
+    if (same_origin >= CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_PER_HOST) {
+        pool_remove(oldest_same_origin);
+        STAILQ_INSERT_TAIL(&garbage, oldest_same_origin, next);
+    } else if (s_pool_count >= CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_CONNECTIONS) {
+        it = STAILQ_FIRST(&s_pool);
+        pool_remove(it);
+        STAILQ_INSERT_TAIL(&garbage, it, next);
+    }
+    STAILQ_INSERT_TAIL(&s_pool, item, next);
+    s_pool_count++;
+    _lock_release(&s_pool_lock);
+
+    ESP_LOGD(TAG, "Keeping connection to %s://%s:%d for reuse", scheme, host, port);
+    pool_free_all(&garbage);
+    return;
+
+error:
+    if (item) {
+        free(item->scheme);
+        free(item->host);
+        free(item);
+    }
+    esp_transport_destroy(t);
+}
+
+static void pool_session_free(http_conn_pool_session_t *item)
+{
+    if (item) {
+        esp_tls_free_client_session(item->session);
+        free(item->host);
+        free(item);
+    }
+}
+
+/* Must be called with s_pool_lock held */
+static http_conn_pool_session_t *pool_session_take(const char *host, int port, const http_conn_pool_tls_t *tls)
+{
+    http_conn_pool_session_t *item;
+    STAILQ_FOREACH(item, &s_sessions, next) {
+        if (item->port == port && strcasecmp(item->host, host) == 0 && pool_tls_equal(&item->tls, tls)) {
+            STAILQ_REMOVE(&s_sessions, item, http_conn_pool_session, next);
+            s_session_count--;
+            return item;
+        }
+    }
+    return NULL;
+}
+
+esp_tls_client_session_t *http_conn_pool_take_session(const char *host, int port, const http_conn_pool_tls_t *tls)
+{
+    if (host == NULL || tls == NULL) {
+        return NULL;
+    }
+    _lock_acquire(&s_pool_lock);
+    http_conn_pool_session_t *item = pool_session_take(host, port, tls);
+    _lock_release(&s_pool_lock);
+
+    if (item == NULL) {
+        return NULL;
+    }
+    esp_tls_client_session_t *session = item->session;
+    item->session = NULL;
+    pool_session_free(item);
+    ESP_LOGD(TAG, "Resuming TLS session with %s:%d", host, port);
+    return session;
+}
+
+void http_conn_pool_save_session(const char *host, int port, const http_conn_pool_tls_t *tls, esp_tls_client_session_t *session)
+{
+    if (session == NULL) {
+        return;
+    }
+    if (host == NULL || tls == NULL || POOL_MAX_SESSIONS == 0) {
+        esp_tls_free_client_session(session);
+        return;
+    }
+    http_conn_pool_session_t *item = calloc(1, sizeof(http_conn_pool_session_t));
+    HTTP_MEM_CHECK(TAG, item, goto error);
+    item->host = strdup(host);
+    HTTP_MEM_CHECK(TAG, item->host, goto error);
+    item->port = port;
+    item->tls = *tls;
+    item->session = session;
+
+    _lock_acquire(&s_pool_lock);
+    http_conn_pool_session_t *replaced = pool_session_take(host, port, tls);
+    http_conn_pool_session_t *evicted = NULL;
+    if (replaced == NULL && s_session_count >= POOL_MAX_SESSIONS) {
+        evicted = STAILQ_FIRST(&s_sessions);
+        STAILQ_REMOVE_HEAD(&s_sessions, next);
+        s_session_count--;
+    }
+    STAILQ_INSERT_TAIL(&s_sessions, item, next);
+    s_session_count++;
+    _lock_release(&s_pool_lock);
+
+    pool_session_free(replaced);
+    pool_session_free(evicted);
+    return;
+
+error:
+    if (item) {
+        free(item->host);
+        free(item);
+    }
+    esp_tls_free_client_session(session);
+}
+
+void http_conn_pool_flush(void)
+{
+    struct http_conn_pool garbage = STAILQ_HEAD_INITIALIZER(garbage);
+    struct http_conn_pool_sessions sessions = STAILQ_HEAD_INITIALIZER(sessions);
+
+    _lock_acquire(&s_pool_lock);
+    pool_collect_expired(&garbage, INT64_MAX);
+    STAILQ_CONCAT(&sessions, &s_sessions);
+    s_session_count = 0;
+    _lock_release(&s_pool_lock);
+
+    pool_free_all(&garbage);
+    http_conn_pool_session_t *item;
+    while ((item = STAILQ_FIRST(&sessions)) != NULL) {
+        STAILQ_REMOVE_HEAD(&sessions, next);
+        pool_session_free(item);
+    }
+}
+
+int http_conn_pool_idle_count(void)
+{
+    _lock_acquire(&s_pool_lock);
+    int count = s_pool_count;
+    _lock_release(&s_pool_lock);
+    return count;
+}
+
+#else /* !CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL */
+
+esp_transport_handle_t http_conn_pool_acquire(const char *scheme, const char *host, int port, const http_conn_pool_tls_t *tls)
+{
+    return NULL;
+}
+
+void http_conn_pool_release(const char *scheme, const char *host, int port, const http_conn_pool_tls_t *tls, esp_transport_handle_t t)
+{
+    esp_transport_destroy(t);
+}
+
+esp_tls_client_session_t *http_conn_pool_take_session(const char *host, int port, const http_conn_pool_tls_t *tls)
+{
+    return NULL;
+}
+
+void http_conn_pool_save_session(const char *host, int port, const http_conn_pool_tls_t *tls, esp_tls_client_session_t *session)
+{
+    esp_tls_free_client_session(session);
+}
+
+void http_conn_pool_flush(void)
+{
+}
+
+int http_conn_pool_idle_count(void)
+{
+    return 0;
+}
+
+#endif /* CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL */
@@ -18,6 +18,8 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <sys/param.h>
 #include "esp_log.h"
 #include "http_header.h"
 #include "http_utils.h"
@@ -25,45 +27,261 @@
 static const char *TAG = "HTTP_HEADER";
 #define HEADER_BUFFER (1024)
 
+/* Number of hash buckets, a power of 2 */
+#define HEADER_HASH_BUCKETS (16)
+/* Default size of the arena chunks the items, keys and values are allocated from */
+#define HEADER_ARENA_CHUNK (512)
+/* Values get some slack so that e.g. a growing Content-Length can be updated in place */
+#define HEADER_VALUE_ALIGN (8)
+/* Values formatted by http_header_set_format() up to this length don't need a heap buffer */
+#define HEADER_FORMAT_BUFFER (64)
+
 /**
  * dictionary item struct, with key-value pair
  */
 typedef struct http_header_item {
     char *key;                          /*!< key */
     char *value;                        /*!< value */
+    int key_len;                        /*!< strlen(key) */
+    int value_len;                      /*!< strlen(value) */
+    int value_size;                     /*!< bytes reserved for value */
+    uint32_t hash;                      /*!< hash of the lowercase key */
+    struct http_header_item *hash_next; /*!< Next item in the same hash bucket */
     STAILQ_ENTRY(http_header_item) next;   /*!< Point to next entry */
 } http_header_item_t;
 
-STAILQ_HEAD(http_header, http_header_item);
+/**
+ * Arena chunk, items and strings are carved out of it and only released all at once
+ */
+typedef struct http_header_chunk {
+    struct http_header_chunk *next;
+    int size;
+    int used;
+    char data[] __attribute__((aligned(sizeof(void *))));
+} http_header_chunk_t;
+
+STAILQ_HEAD(http_header_list, http_header_item);
+
+struct http_header {
+    struct http_header_list items;                      /*!< items in insertion order */
+    http_header_item_t *buckets[HEADER_HASH_BUCKETS];   /*!< items by hash of the key */
+    http_header_chunk_t *chunks;                        /*!< arena, the chunk allocated from is the first one */
+    int live;                                           /*!< arena bytes used by the current items */
+    int used;                                           /*!< arena bytes handed out since the last reset */
+    bool value_lent;                                    /*!< http_header_get() returned a value, items must not move until it is released */
+};
+
+static uint32_t http_header_hash(const char *key, int len)
+{
+    /* FNV-1a over the lowercase key, header names are case insensitive */
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        hash ^= (uint8_t)tolower((unsigned char)key[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void http_header_trim(const char **str, int *len)
+{
+    const char *start = *str;
+    const char *end = start + *len;
+    while (start < end && isspace((unsigned char)*start)) {
+        start++;
+    }
+    while (end > start && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    *str = start;
+    *len = end - start;
+}
+
+static http_header_chunk_t *http_header_chunk_new(int size)
+{
+    http_header_chunk_t *chunk = malloc(sizeof(http_header_chunk_t) + size);
+    HTTP_MEM_CHECK(TAG, chunk, return NULL);
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+static void http_header_chunks_free(http_header_chunk_t *chunk)
+{
+    while (chunk) {
+        http_header_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+static int http_header_arena_size(int size)
+{
+    return (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+}
+
+static bool http_header_arena_fits(http_header_handle_t header, int size)
+{
+    return header->chunks && header->chunks->used + size <= header->chunks->size;
+}
+
+static void *http_header_arena_alloc(http_header_handle_t header, int size)
+{
+    size = http_header_arena_size(size);
+    if (!http_header_arena_fits(header, size)) {
+        http_header_chunk_t *chunk = http_header_chunk_new(MAX(size, HEADER_ARENA_CHUNK));
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = header->chunks;
+        header->chunks = chunk;
+    }
+    void *mem = header->chunks->data + header->chunks->used;
+    header->chunks->used += size;
+    header->used += size;
+    return mem;
+}
+
+static int http_header_item_footprint(http_header_item_t *item)
+{
+    return http_header_arena_size(sizeof(http_header_item_t))
+           + http_header_arena_size(item->key_len + 1)
+           + http_header_arena_size(item->value_size);
+}
+
+static http_header_item_t *http_header_find(http_header_handle_t header, const char *key, int key_len, uint32_t hash)
+{
+    http_header_item_t *item = header->buckets[hash & (HEADER_HASH_BUCKETS - 1)];
+    while (item) {
+        if (item->hash == hash && item->key_len == key_len && strncasecmp(item->key, key, key_len) == 0) {
+            return item;
+        }
+        item = item->hash_next;
+    }
+    return NULL;
+}
 
+static void http_header_unlink(http_header_handle_t header, http_header_item_t *item)
+{
+    http_header_item_t **link = &header->buckets[item->hash & (HEADER_HASH_BUCKETS - 1)];
+    while (*link != item) {
+        link = &(*link)->hash_next;
+    }
+    *link = item->hash_next;
+    STAILQ_REMOVE(&header->items, item, http_header_item, next);
+    header->live -= http_header_item_footprint(item);
+}
+
+static http_header_item_t *http_header_new_item(http_header_handle_t header, const char *key, int key_len, uint32_t hash,
+                                               const char *value, int value_len)
+{
+    int value_size = (value_len + HEADER_VALUE_ALIGN) & ~(HEADER_VALUE_ALIGN - 1);
+    http_header_item_t *item = http_header_arena_alloc(header, sizeof(http_header_item_t));
+    HTTP_MEM_CHECK(TAG, item, return NULL);
+    item->key = http_header_arena_alloc(header, key_len + 1);
+    HTTP_MEM_CHECK(TAG, item->key, return NULL);
+    item->value = http_header_arena_alloc(header, value_size);
+    HTTP_MEM_CHECK(TAG, item->value, return NULL);
+
+    memcpy(item->key, key, key_len);
+    item->key[key_len] = 0;
+    item->key_len = key_len;
+    memcpy(item->value, value, value_len);
+    item->value[value_len] = 0;
+    item->value_len = value_len;
+    item->value_size = value_size;
+    item->hash = hash;
+    item->hash_next = header->buckets[hash & (HEADER_HASH_BUCKETS - 1)];
+    header->buckets[hash & (HEADER_HASH_BUCKETS - 1)] = item;
+    STAILQ_INSERT_TAIL(&header->items, item, next);
+    header->live += http_header_item_footprint(item);
+    return item;
+}
+
+/*
+ * Replaced values and deleted items stay in the arena until the next clean, which a long lived
+ * header list (e.g. the request headers of a client) never sees. Move the live items to a fresh
+ * chunk once the garbage outweighs them, with room for `extra` bytes more.
+ * Returns the old chunks, to be freed by the caller once nothing refers to them any more.
+ */
+static http_header_chunk_t *http_header_compact(http_header_handle_t header, int extra)
+{
+    http_header_chunk_t *chunk = http_header_chunk_new(MAX(header->live + extra, HEADER_ARENA_CHUNK));
+    if (chunk == NULL) {
+        return NULL;
+    }
+    struct http_header_list old_items = STAILQ_HEAD_INITIALIZER(old_items);
+    http_header_chunk_t *old_chunks = header->chunks;
+    http_header_item_t *item;
+
+    STAILQ_CONCAT(&old_items, &header->items);
+    memset(header->buckets, 0, sizeof(header->buckets));
+    header->chunks = chunk;
+    header->live = 0;
+    header->used = 0;
+    while ((item = STAILQ_FIRST(&old_items)) != NULL) {
+        STAILQ_REMOVE_HEAD(&old_items, next);
+        /* Fits in the new chunk, can't fail */
+        http_header_new_item(header, item->key, item->key_len, item->hash, item->value, item->value_len);
+    }
+    return old_chunks;
+}
+
+static esp_err_t http_header_set_n(http_header_handle_t header, const char *key, int key_len, const char *value, int value_len)
+{
+    http_header_trim(&key, &key_len);
+    http_header_trim(&value, &value_len);
+    uint32_t hash = http_header_hash(key, key_len);
+    http_header_item_t *item = http_header_find(header, key, key_len, hash);
+
+    if (item && value_len < item->value_size) {
+        memmove(item->value, value, value_len);
+        item->value[value_len] = 0;
+        item->value_len = value_len;
+        return ESP_OK;
+    }
+    if (item) {
+        http_header_unlink(header, item);
+    }
+
+    /* key and value may point into the arena, so the old chunks are kept until they are copied */
+    http_header_chunk_t *garbage = NULL;
+    int size = http_header_arena_size(sizeof(http_header_item_t)) + http_header_arena_size(key_len + 1)
+               + http_header_arena_size(value_len + HEADER_VALUE_ALIGN);
+    if (!http_header_arena_fits(header, size) && !header->value_lent && header->used - header->live > header->live) {
+        garbage = http_header_compact(header, size);
+    }
+    esp_err_t err = ESP_OK;
+    if (http_header_new_item(header, key, key_len, hash, value, value_len) == NULL) {
+        err = ESP_ERR_NO_MEM;
+    }
+    http_header_chunks_free(garbage);
+    return err;
+}
 
 http_header_handle_t http_header_init(void)
 {
     http_header_handle_t header = calloc(1, sizeof(struct http_header));
     HTTP_MEM_CHECK(TAG, header, return NULL);
-    STAILQ_INIT(header);
+    STAILQ_INIT(&header->items);
     return header;
 }
 
 esp_err_t http_header_destroy(http_header_handle_t header)
 {
     esp_err_t err = http_header_clean(header);
+    http_header_chunks_free(header->chunks);
     free(header);
     return err;
 }
 
 http_header_item_handle_t http_header_get_item(http_header_handle_t header, const char *key)
 {
-    http_header_item_handle_t item;
     if (header == NULL || key == NULL) {
         return NULL;
     }
-    STAILQ_FOREACH(item, header, next) {
-        if (strcasecmp(item->key, key) == 0) {
-            return item;
-        }
-    }
-    return NULL;
+    int key_len = strlen(key);
+    return http_header_find(header, key, key_len, http_header_hash(key, key_len));
 }
 
 esp_err_t http_header_get(http_header_handle_t header, const char *key, char **value)
@@ -72,6 +290,8 @@ esp_err_t http_header_get(http_header_handle_t header, const char *key, char **v
 
     item = http_header_get_item(header, key);
     if (item) {
+        /* The caller may hold on to the value while other headers are set */
+        header->value_lent = true;
         *value = item->value;
     } else {
         *value = NULL;
@@ -80,62 +300,27 @@ esp_err_t http_header_get(http_header_handle_t header, const char *key, char **v
     return ESP_OK;
 }
 
-static esp_err_t http_header_new_item(http_header_handle_t header, const char *key, const char *value)
+esp_err_t http_header_release_values(http_header_handle_t header)
 {
-    http_header_item_handle_t item;
-
-    item = calloc(1, sizeof(http_header_item_t));
-    HTTP_MEM_CHECK(TAG, item, return ESP_ERR_NO_MEM);
-    http_utils_assign_string(&item->key, key, 0);
-    HTTP_MEM_CHECK(TAG, item->key, goto _header_new_item_exit);
-    http_utils_trim_whitespace(&item->key);
-    http_utils_assign_string(&item->value, value, 0);
-    HTTP_MEM_CHECK(TAG, item->value, goto _header_new_item_exit);
-    http_utils_trim_whitespace(&item->value);
-    STAILQ_INSERT_TAIL(header, item, next);
+    header->value_lent = false;
     return ESP_OK;
-_header_new_item_exit:
-    free(item->key);
-    free(item->value);
-    return ESP_ERR_NO_MEM;
 }
 
 esp_err_t http_header_set(http_header_handle_t header, const char *key, const char *value)
 {
-    http_header_item_handle_t item;
-
     if (value == NULL) {
         return http_header_delete(header, key);
     }
-
-    item = http_header_get_item(header, key);
-
-    if (item) {
-        free(item->value);
-        item->value = strdup(value);
-        http_utils_trim_whitespace(&item->value);
-        return ESP_OK;
-    }
-    return http_header_new_item(header, key, value);
+    return http_header_set_n(header, key, strlen(key), value, strlen(value));
 }
 
 esp_err_t http_header_set_from_string(http_header_handle_t header, const char *key_value_data)
 {
-    char *eq_ch;
-    char *p_str;
-
-    p_str = strdup(key_value_data);
-    HTTP_MEM_CHECK(TAG, p_str, return ESP_ERR_NO_MEM);
-    eq_ch = strchr(p_str, ':');
+    const char *eq_ch = strchr(key_value_data, ':');
     if (eq_ch == NULL) {
-        free(p_str);
         return ESP_ERR_INVALID_ARG;
     }
-    *eq_ch = 0;
-
-    http_header_set(header, p_str, eq_ch + 1);
-    free(p_str);
-    return ESP_OK;
+    return http_header_set_n(header, key_value_data, eq_ch - key_value_data, eq_ch + 1, strlen(eq_ch + 1));
 }
 
 
@@ -143,10 +328,7 @@ esp_err_t http_header_delete(http_header_handle_t header, const char *key)
 {
     http_header_item_handle_t item = http_header_get_item(header, key);
     if (item) {
-        STAILQ_REMOVE(header, item, http_header_item, next);
-        free(item->key);
-        free(item->value);
-        free(item);
+        http_header_unlink(header, item);
     } else {
         return ESP_ERR_NOT_FOUND;
     }
@@ -157,17 +339,25 @@ esp_err_t http_header_delete(http_header_handle_t header, const char *key)
 int http_header_set_format(http_header_handle_t header, const char *key, const char *format, ...)
 {
     va_list argptr;
-    int len = 0;
-    char *buf = NULL;
+    char small_buf[HEADER_FORMAT_BUFFER];
+    char *buf = small_buf;
     va_start(argptr, format);
-    len = vasprintf(&buf, format, argptr);
-    HTTP_MEM_CHECK(TAG, buf, return 0);
+    int len = vsnprintf(small_buf, sizeof(small_buf), format, argptr);
     va_end(argptr);
-    if (buf == NULL) {
+    if (len < 0) {
         return 0;
     }
-    http_header_set(header, key, buf);
-    free(buf);
+    if (len >= (int)sizeof(small_buf)) {
+        buf = malloc(len + 1);
+        HTTP_MEM_CHECK(TAG, buf, return 0);
+        va_start(argptr, format);
+        vsnprintf(buf, len + 1, format, argptr);
+        va_end(argptr);
+    }
+    http_header_set_n(header, key, strlen(key), buf, len);
+    if (buf != small_buf) {
+        free(buf);
+    }
     return len;
 }
 
@@ -180,10 +370,10 @@ int http_header_generate_string(http_header_handle_t header, int index, char *bu
     bool is_end = false;
 
     // iterate over the header entries to calculate buffer size and determine last item
-    STAILQ_FOREACH(item, header, next) {
-        if (item->value && idx >= index) {
-            siz += strlen(item->key);
-            siz += strlen(item->value);
+    STAILQ_FOREACH(item, &header->items, next) {
+        if (idx >= index) {
+            siz += item->key_len;
+            siz += item->value_len;
             siz += 4; //': ' and '\r\n'
         }
         idx ++;
@@ -208,8 +398,8 @@ int http_header_generate_string(http_header_handle_t header, int index, char *bu
     // iterate again over the header entries to write only the fitting indeces
     int str_len = 0;
     idx = 0;
-    STAILQ_FOREACH(item, header, next) {
-        if (item->value && idx >= index && idx < ret_idx) {
+    STAILQ_FOREACH(item, &header->items, next) {
+        if (idx >= index && idx < ret_idx) {
             str_len += snprintf(buffer + str_len, *buffer_len - str_len, "%s: %s\r\n", item->key, item->value);
         }
         idx ++;
@@ -224,23 +414,34 @@ int http_header_generate_string(http_header_handle_t header, int index, char *bu
 
 esp_err_t http_header_clean(http_header_handle_t header)
 {
-    http_header_item_handle_t item = STAILQ_FIRST(header), tmp;
-    while (item != NULL) {
-        tmp = STAILQ_NEXT(item, next);
-        free(item->key);
-        free(item->value);
-        free(item);
-        item = tmp;
+    STAILQ_INIT(&header->items);
+    memset(header->buckets, 0, sizeof(header->buckets));
+    header->live = 0;
+    header->used = 0;
+    header->value_lent = false;
+    if (header->chunks) {
+        /* Keep the most recent chunk for the next request */
+        http_header_chunks_free(header->chunks->next);
+        header->chunks->next = NULL;
+        header->chunks->used = 0;
     }
-    STAILQ_INIT(header);
     return ESP_OK;
 }
 
+int http_header_memory_size(http_header_handle_t header)
+{
+    int size = sizeof(struct http_header);
+    for (http_header_chunk_t *chunk = header->chunks; chunk; chunk = chunk->next) {
+        size += sizeof(http_header_chunk_t) + chunk->size;
+    }
+    return size;
+}
+
 int http_header_count(http_header_handle_t header)
 {
     http_header_item_handle_t item;
     int count = 0;
-    STAILQ_FOREACH(item, header, next) {
+    STAILQ_FOREACH(item, &header->items, next) {
         count ++;
     }
     return count;
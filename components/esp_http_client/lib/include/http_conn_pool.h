@@ -0,0 +1,110 @@
+// Copyright 2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _HTTP_CONN_POOL_H_
+#define _HTTP_CONN_POOL_H_
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_transport.h"
+#include "esp_tls.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * TLS settings an https connection was established with. A pooled connection is only
+ * handed to a client with the same settings, so that no client gets a session its own
+ * configuration would have rejected. Certificates and keys are compared by address.
+ */
+typedef struct {
+    const char  *cert_pem;                      /*!< Server CA certificate */
+    const char  *client_cert_pem;               /*!< Client certificate */
+    const char  *client_key_pem;                /*!< Client key */
+    bool        use_global_ca_store;            /*!< Server verified against the global CA store */
+    bool        skip_cert_common_name_check;    /*!< Server certificate CN not checked */
+} http_conn_pool_tls_t;
+
+/**
+ * @brief      Take an idle keep-alive connection to scheme://host:port out of the pool.
+ *             Connections which were idle for too long, or which were closed by the server
+ *             in the meantime, are destroyed instead of being returned.
+ *
+ * @param[in]  scheme  The scheme ("http" or "https")
+ * @param[in]  host    The host
+ * @param[in]  port    The port
+ * @param[in]  tls     TLS settings the connection must have been established with, NULL for none
+ *
+ * @return
+ *     - Connected transport, owned by the caller from now on
+ *     - NULL if there is no usable connection in the pool
+ */
+esp_transport_handle_t http_conn_pool_acquire(const char *scheme, const char *host, int port, const http_conn_pool_tls_t *tls);
+
+/**
+ * @brief      Hand a connected transport over to the pool, so that other clients can reuse it.
+ *             The pool always takes ownership. If the per-host or the total limit is reached,
+ *             the oldest idle connection is closed to make room.
+ *
+ * @param[in]  scheme  The scheme the transport is connected with
+ * @param[in]  host    The host the transport is connected to
+ * @param[in]  port    The port the transport is connected to
+ * @param[in]  tls     TLS settings the transport was connected with, NULL for none
+ * @param[in]  t       The connected transport, not part of any transport list
+ */
+void http_conn_pool_release(const char *scheme, const char *host, int port, const http_conn_pool_tls_t *tls, esp_transport_handle_t t);
+
+/**
+ * @brief      Take the TLS session saved for host:port out of the session cache, to resume it on a new connection.
+ *             Sessions are cached with the TLS settings of their connection, like pooled connections.
+ *
+ * @param[in]  host  The host
+ * @param[in]  port  The port
+ * @param[in]  tls   TLS settings of the new connection
+ *
+ * @return
+ *     - The session, owned by the caller from now on
+ *     - NULL if no session is saved for host:port and these settings
+ */
+esp_tls_client_session_t *http_conn_pool_take_session(const char *host, int port, const http_conn_pool_tls_t *tls);
+
+/**
+ * @brief      Save the TLS session of a new connection to host:port, replacing the session saved before.
+ *             The cache always takes ownership. If it is full, the least recently saved session is freed.
+ *
+ * @param[in]  host     The host the connection is established to
+ * @param[in]  port     The port the connection is established to
+ * @param[in]  tls      TLS settings the connection was established with
+ * @param[in]  session  The session, can be NULL
+ */
+void http_conn_pool_save_session(const char *host, int port, const http_conn_pool_tls_t *tls, esp_tls_client_session_t *session);
+
+/**
+ * @brief      Close and destroy all idle connections in the pool, and free the saved TLS sessions
+ */
+void http_conn_pool_flush(void);
+
+/**
+ * @brief      Number of idle connections currently held by the pool
+ *
+ * @return     Number of connections
+ */
+int http_conn_pool_idle_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -35,7 +35,8 @@ typedef struct http_header_item *http_header_item_handle_t;
 http_header_handle_t http_header_init(void);
 
 /**
- * @brief      Cleanup and free all http header pairs
+ * @brief      Remove all http header pairs in one step,
+ *             keeping one chunk of their memory for the next ones
  *
  * @param[in]  header  The header
  *
@@ -85,6 +86,9 @@ int http_header_set_format(http_header_handle_t header, const char *key, const c
 /**
  * @brief      Get a value of header in header list
  *             The address of the value will be assign set to `value` parameter or NULL if no header with the key exists in the list
+ *             The value stays valid until the same key is set again or deleted, or the list is cleaned. Once a value
+ *             was returned, the storage is not compacted any more until the next clean or `http_header_release_values`,
+ *             so setting other keys does not move it.
  *
  * @param[in]  header  The header
  * @param[in]  key     The key
@@ -96,6 +100,26 @@ int http_header_set_format(http_header_handle_t header, const char *key, const c
  */
 esp_err_t http_header_get(http_header_handle_t header, const char *key, char **value);
 
+/**
+ * @brief      Tell that the values returned by `http_header_get` are not used any more,
+ *             so that the storage can be compacted again. Setting other keys may move the values after that.
+ *
+ * @param[in]  header  The header
+ *
+ * @return
+ *     - ESP_OK
+ */
+esp_err_t http_header_release_values(http_header_handle_t header);
+
+/**
+ * @brief      Get the bytes of memory held by the header storage
+ *
+ * @param[in]  header  The header
+ *
+ * @return     The size of the memory
+ */
+int http_header_memory_size(http_header_handle_t header);
+
 /**
  * @brief      Create HTTP header string from the header with index, output string to buffer with buffer_len
  *             Also return the last index of header was generated
@@ -0,0 +1,7 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <csignal>
+
+/* Like lwIP, fail writes to sockets closed by the peer with EPIPE instead of raising SIGPIPE */
+static const bool s_sigpipe_ignored = std::signal(SIGPIPE, SIG_IGN) != SIG_ERR;
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "esp_err.h"
+
+typedef struct esp_tls_last_error {
+    esp_err_t last_error;
+    int esp_tls_error_code;
+    int esp_tls_flags;
+} esp_tls_last_error_t;
+
+typedef esp_tls_last_error_t *esp_tls_error_handle_t;
+
+typedef struct psk_key_hint psk_hint_key_t;
+
+typedef struct esp_tls_client_session esp_tls_client_session_t;
+
+void esp_tls_free_client_session(esp_tls_client_session_t *session);
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <strings.h>
+
+typedef struct in_addr ip_addr_t;
+#define ipaddr_ntoa(addr) inet_ntoa(*(const struct in_addr *)(addr))
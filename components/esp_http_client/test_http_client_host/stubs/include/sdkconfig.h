@@ -0,0 +1,9 @@
+#pragma once
+
+#define CONFIG_LOG_DEFAULT_LEVEL 1
+#define CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL 1
+#define CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_PER_HOST 2
+#define CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_CONNECTIONS 4
+#define CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_IDLE_TIMEOUT_MS 300
+#define CONFIG_ESP_HTTP_CLIENT_ENABLE_HTTPS 1
+#define CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_SESSIONS 2
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Locks are not lazily initialized on the host, all of them share one recursive mutex */
+typedef int _lock_t;
+
+void _lock_acquire(_lock_t *lock);
+void _lock_release(_lock_t *lock);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,44 @@
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/lock.h>
+
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_http_client.h"
+#include "http_auth.h"
+
+static pthread_mutex_t s_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+void _lock_acquire(_lock_t *lock)
+{
+    pthread_mutex_lock(&s_lock);
+}
+
+void _lock_release(_lock_t *lock)
+{
+    pthread_mutex_unlock(&s_lock);
+}
+
+uint32_t esp_random(void)
+{
+    return (uint32_t)rand();
+}
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Authentication is not exercised by the host tests */
+char *http_auth_digest(const char *username, const char *password, esp_http_auth_data_t *auth_data)
+{
+    return NULL;
+}
+
+char *http_auth_basic(const char *username, const char *password)
+{
+    return NULL;
+}
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_transport.h"
+#include "esp_transport_tcp.h"
+#include "esp_transport_ssl.h"
+
+/* Stand-in for the TLS transport: a TCP connection which starts with a "TLS <session id>\r\n"
+ * line, answered by the test server with the id of the session it resumed or created */
+
+struct esp_tls_client_session {
+    unsigned id;
+};
+
+typedef struct {
+    esp_transport_handle_t tcp;
+    esp_tls_client_session_t *resume;
+    unsigned session_id;
+} transport_ssl_t;
+
+static int ssl_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    char line[32];
+    ssl->session_id = 0;
+    if (esp_transport_connect(ssl->tcp, host, port, timeout_ms) < 0) {
+        return -1;
+    }
+    int len = snprintf(line, sizeof(line), "TLS %u\r\n", ssl->resume ? ssl->resume->id : 0);
+    if (esp_transport_write(ssl->tcp, line, len, timeout_ms) != len) {
+        return -1;
+    }
+    for (len = 0; len < 2 || memcmp(line + len - 2, "\r\n", 2) != 0; len++) {
+        if (len == sizeof(line) - 1 || esp_transport_read(ssl->tcp, line + len, 1, timeout_ms) != 1) {
+            return -1;
+        }
+    }
+    line[len] = 0;
+    return sscanf(line, "TLS %u", &ssl->session_id) == 1 ? 0 : -1;
+}
+
+static int ssl_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    return esp_transport_read(ssl->tcp, buffer, len, timeout_ms);
+}
+
+static int ssl_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    return esp_transport_write(ssl->tcp, buffer, len, timeout_ms);
+}
+
+static int ssl_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    return esp_transport_poll_read(ssl->tcp, timeout_ms);
+}
+
+static int ssl_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    return esp_transport_poll_write(ssl->tcp, timeout_ms);
+}
+
+static int ssl_close(esp_transport_handle_t t)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    ssl->session_id = 0;
+    return esp_transport_close(ssl->tcp);
+}
+
+static int ssl_get_socket(esp_transport_handle_t t)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    return esp_transport_get_socket(ssl->tcp);
+}
+
+static int ssl_destroy(esp_transport_handle_t t)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    esp_transport_destroy(ssl->tcp);
+    free(ssl);
+    return 0;
+}
+
+esp_transport_handle_t esp_transport_ssl_init(void)
+{
+    esp_transport_handle_t t = esp_transport_init();
+    transport_ssl_t *ssl = calloc(1, sizeof(transport_ssl_t));
+    ssl->tcp = esp_transport_tcp_init();
+    esp_transport_set_context_data(t, ssl);
+    esp_transport_set_func(t, ssl_connect, ssl_read, ssl_write, ssl_close, ssl_poll_read, ssl_poll_write, ssl_destroy);
+    esp_transport_set_get_socket_func(t, ssl_get_socket);
+    return t;
+}
+
+/* The certificates are only compared by the connection pool */
+void esp_transport_ssl_enable_global_ca_store(esp_transport_handle_t t)
+{
+}
+
+void esp_transport_ssl_set_cert_data(esp_transport_handle_t t, const char *data, int len)
+{
+}
+
+void esp_transport_ssl_set_client_cert_data(esp_transport_handle_t t, const char *data, int len)
+{
+}
+
+void esp_transport_ssl_set_client_key_data(esp_transport_handle_t t, const char *data, int len)
+{
+}
+
+void esp_transport_ssl_skip_common_name_check(esp_transport_handle_t t)
+{
+}
+
+void esp_transport_ssl_set_client_session(esp_transport_handle_t t, esp_tls_client_session_t *session)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    ssl->resume = session;
+}
+
+esp_tls_client_session_t *esp_transport_ssl_get_client_session(esp_transport_handle_t t)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    if (ssl->session_id == 0) {
+        return NULL;
+    }
+    esp_tls_client_session_t *session = malloc(sizeof(esp_tls_client_session_t));
+    session->id = ssl->session_id;
+    return session;
+}
+
+void esp_tls_free_client_session(esp_tls_client_session_t *session)
+{
+    free(session);
+}
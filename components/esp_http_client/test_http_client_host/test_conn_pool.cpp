@@ -0,0 +1,195 @@
+#include "catch.hpp"
+#include "esp_http_client.h"
+#include "http_conn_pool.h"
+#include "esp_transport_tcp.h"
+
+#include "test_server.hpp"
+
+#include <chrono>
+#include <thread>
+
+static esp_http_client_handle_t new_client(const TestServer &server, const char *scheme = "http", const char *cert_pem = NULL)
+{
+    std::string url = server.url(scheme);
+    esp_http_client_config_t config = {};
+    config.url = url.c_str();
+    config.cert_pem = cert_pem;
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    REQUIRE(client != NULL);
+    return client;
+}
+
+static void get_once(const TestServer &server, const char *scheme = "http", const char *cert_pem = NULL)
+{
+    esp_http_client_handle_t client = new_client(server, scheme, cert_pem);
+    REQUIRE(esp_http_client_perform(client) == ESP_OK);
+    REQUIRE(esp_http_client_get_status_code(client) == 200);
+    esp_http_client_cleanup(client);
+}
+
+TEST_CASE("keep-alive connection is reused by the next client", "[conn_pool]")
+{
+    TestServer server;
+    for (int i = 0; i < 5; i++) {
+        get_once(server);
+    }
+    CHECK(server.requests == 5);
+    CHECK(server.accepted == 1);
+    CHECK(http_conn_pool_idle_count() == 1);
+
+    esp_http_client_flush_connection_pool();
+    CHECK(http_conn_pool_idle_count() == 0);
+}
+
+TEST_CASE("connections closed by the server are not pooled", "[conn_pool]")
+{
+    TestServer server;
+    server.keep_alive = false;
+    for (int i = 0; i < 3; i++) {
+        get_once(server);
+    }
+    CHECK(server.requests == 3);
+    CHECK(server.accepted == 3);
+    CHECK(http_conn_pool_idle_count() == 0);
+}
+
+TEST_CASE("idle connections expire", "[conn_pool]")
+{
+    TestServer server;
+    get_once(server);
+    CHECK(http_conn_pool_idle_count() == 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_IDLE_TIMEOUT_MS + 50));
+    get_once(server);
+    CHECK(server.accepted == 2);
+    esp_http_client_flush_connection_pool();
+}
+
+TEST_CASE("stale pooled connection is replaced by a new one", "[conn_pool]")
+{
+    TestServer server;
+    get_once(server);
+    server.drop_idle = true;
+    while (server.drop_idle) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    get_once(server);
+    CHECK(server.requests == 2);
+    CHECK(server.accepted == 2);
+    esp_http_client_flush_connection_pool();
+}
+
+TEST_CASE("per-host limit of idle connections", "[conn_pool]")
+{
+    TestServer server;
+    const int n = CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_PER_HOST + 1;
+    esp_http_client_handle_t clients[n];
+    for (int i = 0; i < n; i++) {
+        clients[i] = new_client(server);
+        REQUIRE(esp_http_client_perform(clients[i]) == ESP_OK);
+    }
+    CHECK(server.accepted == n);
+    for (int i = 0; i < n; i++) {
+        esp_http_client_cleanup(clients[i]);
+    }
+    CHECK(http_conn_pool_idle_count() == CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_PER_HOST);
+
+    /* The pooled connections are all usable */
+    for (int i = 0; i < n; i++) {
+        clients[i] = new_client(server);
+        REQUIRE(esp_http_client_perform(clients[i]) == ESP_OK);
+    }
+    CHECK(server.accepted == n + 1);
+    for (int i = 0; i < n; i++) {
+        esp_http_client_cleanup(clients[i]);
+    }
+    esp_http_client_flush_connection_pool();
+}
+
+TEST_CASE("https connections are only shared between clients with the same TLS settings", "[conn_pool]")
+{
+    TestServer server;
+    const char *ca_a = "ca a", *ca_b = "ca b";
+    http_conn_pool_tls_t tls_a = {}, tls_b = {}, tls_no_cn = {};
+    tls_a.cert_pem = ca_a;
+    tls_b.cert_pem = ca_b;
+    tls_no_cn.cert_pem = ca_a;
+    tls_no_cn.skip_cert_common_name_check = true;
+
+    /* The pool does not care about the transport type, a TCP connection stands in for TLS */
+    esp_transport_handle_t t = esp_transport_tcp_init();
+    REQUIRE(t != NULL);
+    REQUIRE(esp_transport_connect(t, "127.0.0.1", server.port, 1000) >= 0);
+    http_conn_pool_release("https", "127.0.0.1", server.port, &tls_a, t);
+    CHECK(http_conn_pool_idle_count() == 1);
+
+    CHECK(http_conn_pool_acquire("https", "127.0.0.1", server.port, NULL) == NULL);
+    CHECK(http_conn_pool_acquire("https", "127.0.0.1", server.port, &tls_b) == NULL);
+    CHECK(http_conn_pool_acquire("https", "127.0.0.1", server.port, &tls_no_cn) == NULL);
+    CHECK(http_conn_pool_idle_count() == 1);
+
+    http_conn_pool_tls_t same = tls_a;
+    CHECK(http_conn_pool_acquire("https", "127.0.0.1", server.port, &same) == t);
+    CHECK(http_conn_pool_idle_count() == 0);
+    esp_transport_destroy(t);
+}
+
+TEST_CASE("TLS session is resumed after the server closed the connection", "[conn_pool]")
+{
+    TestServer server;
+    server.tls = true;
+    server.keep_alive = false;
+    for (int i = 0; i < 4; i++) {
+        get_once(server, "https");
+    }
+    CHECK(server.requests == 4);
+    CHECK(server.accepted == 4);
+    CHECK(http_conn_pool_idle_count() == 0);
+    CHECK(server.full_handshakes == 1);
+    CHECK(server.resumed_handshakes == 3);
+
+    /* The server forgot the session: a full handshake, whose session is resumed next time */
+    server.resume_sessions = false;
+    get_once(server, "https");
+    server.resume_sessions = true;
+    get_once(server, "https");
+    CHECK(server.full_handshakes == 2);
+    CHECK(server.resumed_handshakes == 4);
+
+    /* Sessions are gone after a flush */
+    esp_http_client_flush_connection_pool();
+    get_once(server, "https");
+    CHECK(server.full_handshakes == 3);
+    esp_http_client_flush_connection_pool();
+}
+
+TEST_CASE("TLS sessions are only resumed with the same TLS settings", "[conn_pool]")
+{
+    TestServer server;
+    server.tls = true;
+    server.keep_alive = false;
+    const char *ca_a = "ca a", *ca_b = "ca b";
+
+    get_once(server, "https", ca_a);
+    get_once(server, "https", ca_b);
+    CHECK(server.full_handshakes == 2);
+    get_once(server, "https", ca_a);
+    get_once(server, "https", ca_b);
+    CHECK(server.full_handshakes == 2);
+    CHECK(server.resumed_handshakes == 2);
+
+    /* Plain http connections don't take part */
+    server.tls = false;
+    get_once(server);
+    server.tls = true;
+    CHECK(server.full_handshakes == 2);
+
+    /* Only CONFIG_ESP_HTTP_CLIENT_CONNECTION_POOL_MAX_SESSIONS are kept, the least recently saved one goes */
+    const char *ca_c = "ca c";
+    get_once(server, "https", ca_c);
+    CHECK(server.full_handshakes == 3);
+    get_once(server, "https", ca_a);
+    CHECK(server.full_handshakes == 4);
+    get_once(server, "https", ca_c);
+    CHECK(server.resumed_handshakes == 3);
+    esp_http_client_flush_connection_pool();
+}
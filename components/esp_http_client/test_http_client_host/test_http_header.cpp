@@ -0,0 +1,163 @@
+#include "catch.hpp"
+#include "http_header.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+extern "C" esp_err_t http_header_set_from_string(http_header_handle_t header, const char *key_value_data);
+
+static std::string get(http_header_handle_t header, const char *key)
+{
+    char *value = NULL;
+    REQUIRE(http_header_get(header, key, &value) == ESP_OK);
+    return value ? value : "<none>";
+}
+
+static std::string generate(http_header_handle_t header)
+{
+    char buf[1024];
+    int len = sizeof(buf);
+    http_header_generate_string(header, 0, buf, &len);
+    return std::string(buf, len);
+}
+
+TEST_CASE("header lookup is case insensitive and values are trimmed", "[http_header]")
+{
+    http_header_handle_t header = http_header_init();
+    REQUIRE(header != NULL);
+    CHECK(http_header_set(header, "Content-Type", "  text/plain ") == ESP_OK);
+    CHECK(http_header_set_from_string(header, " X-Custom :  value") == ESP_OK);
+    CHECK(get(header, "content-type") == "text/plain");
+    CHECK(get(header, "CONTENT-TYPE") == "text/plain");
+    CHECK(get(header, "x-custom") == "value");
+    CHECK(get(header, "Content") == "<none>");
+    http_header_destroy(header);
+}
+
+TEST_CASE("headers keep their insertion order", "[http_header]")
+{
+    http_header_handle_t header = http_header_init();
+    http_header_set(header, "Host", "example.com");
+    http_header_set(header, "User-Agent", "test");
+    http_header_set_format(header, "Content-Length", "%d", 5);
+    http_header_set(header, "host", "example.org");
+    CHECK(generate(header) == "Host: example.org\r\nUser-Agent: test\r\nContent-Length: 5\r\n\r\n");
+
+    CHECK(http_header_delete(header, "user-agent") == ESP_OK);
+    CHECK(http_header_delete(header, "user-agent") == ESP_ERR_NOT_FOUND);
+    CHECK(http_header_set(header, "Content-Length", NULL) == ESP_OK);
+    CHECK(generate(header) == "Host: example.org\r\n\r\n");
+
+    http_header_clean(header);
+    CHECK(get(header, "Host") == "<none>");
+    int len = 64;
+    char buf[64];
+    CHECK(http_header_generate_string(header, 0, buf, &len) == 0);
+    http_header_destroy(header);
+}
+
+TEST_CASE("long values and values set from the store itself", "[http_header]")
+{
+    http_header_handle_t header = http_header_init();
+    std::string long_value(2000, 'x');
+    http_header_set(header, "Authorization", long_value.c_str());
+    CHECK(get(header, "authorization") == long_value);
+    http_header_set_format(header, "X-Long", "%s-%d", long_value.c_str(), 1);
+    CHECK(get(header, "x-long") == long_value + "-1");
+
+    char *value = NULL;
+    http_header_get(header, "Authorization", &value);
+    http_header_set(header, "X-Copy", value);
+    CHECK(get(header, "X-Copy") == long_value);
+    http_header_destroy(header);
+}
+
+TEST_CASE("memory of replaced values is reclaimed", "[http_header]")
+{
+    http_header_handle_t header = http_header_init();
+    http_header_set(header, "Host", "example.com");
+    for (int i = 0; i < 100000; i++) {
+        std::string value(i % 300, 'a' + i % 26);
+        http_header_set(header, "X-Value", value.c_str());
+        http_header_set_format(header, "Content-Length", "%d", i);
+        /* Checked without http_header_get(), which stops the compaction */
+        REQUIRE(generate(header).find("X-Value: " + value + "\r\n") != std::string::npos);
+        if (i % 7 == 0) {
+            http_header_delete(header, "X-Value");
+        }
+    }
+    CHECK(get(header, "Host") == "example.com");
+    CHECK(get(header, "Content-Length") == "99999");
+    http_header_destroy(header);
+}
+
+TEST_CASE("values returned by get are not moved by other sets", "[http_header]")
+{
+    http_header_handle_t header = http_header_init();
+    http_header_set(header, "Host", "example.com");
+    char *host = NULL;
+    REQUIRE(http_header_get(header, "Host", &host) == ESP_OK);
+    REQUIRE(host != NULL);
+    /* Enough garbage to compact the store many times over */
+    int moved = 0;
+    for (int i = 0; i < 2000; i++) {
+        std::string value(i % 300, 'a' + i % 26);
+        http_header_set(header, "X-Value", value.c_str());
+        http_header_delete(header, "X-Value");
+        char *again = NULL;
+        http_header_get(header, "Host", &again);
+        moved += again != host;
+    }
+    CHECK(moved == 0);
+    CHECK(std::string(host) == "example.com");
+
+    /* Once released, as at the start of a client request, the garbage is reclaimed again */
+    http_header_release_values(header);
+    int max_size = 0;
+    for (int i = 0; i < 2000; i++) {
+        std::string value(i % 300, 'a' + i % 26);
+        http_header_set(header, "X-Value", value.c_str());
+        http_header_delete(header, "X-Value");
+        http_header_set(header, "X-Other", NULL);
+        http_header_set(header, "X-Other", value.c_str());
+        max_size = std::max(max_size, http_header_memory_size(header));
+    }
+    CHECK(max_size < 4096);
+    CHECK(get(header, "Host") == "example.com");
+
+    /* After a clean the values are new, and compacted again */
+    http_header_clean(header);
+    http_header_set(header, "Host", "example.org");
+    for (int i = 0; i < 2000; i++) {
+        http_header_set(header, "X-Value", std::string(i % 300, 'x').c_str());
+    }
+    CHECK(get(header, "Host") == "example.org");
+    http_header_destroy(header);
+}
+
+TEST_CASE("header store performance", "[http_header][perf]")
+{
+    /* Many custom headers, as e.g. signed object storage requests carry */
+    const int n_headers = 24, n_requests = 20000;
+    char keys[n_headers][32];
+    for (int i = 0; i < n_headers; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "X-Amz-Meta-Header-%d", i);
+    }
+    http_header_handle_t header = http_header_init();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < n_requests; r++) {
+        for (int i = 0; i < n_headers; i++) {
+            http_header_set(header, keys[i], "some value of the header");
+        }
+        for (int i = 0; i < n_headers; i++) {
+            char *value;
+            http_header_get(header, keys[n_headers - 1 - i], &value);
+        }
+        http_header_clean(header);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    printf("http_header: %.2f us per request with %d headers\n", us / n_requests, n_headers);
+    http_header_destroy(header);
+}
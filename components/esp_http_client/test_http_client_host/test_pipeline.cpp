@@ -0,0 +1,218 @@
+#include "catch.hpp"
+#include "esp_http_client.h"
+#include "http_conn_pool.h"
+
+#include "test_server.hpp"
+
+#include <vector>
+
+/* What the event handler saw of the queued requests, indexed by request_ctx */
+struct Results {
+    std::vector<std::string> bodies;
+    std::vector<int> finish_order;
+    std::vector<int> errors;
+    /* Requests whose data was received before the previous request was reported finished */
+    int data_before_finish = 0;
+    /* Client closed by the handler when this request finishes */
+    esp_http_client_handle_t close_client = NULL;
+    int close_on_finish = -1;
+};
+
+static esp_err_t event_handler(esp_http_client_event_t *evt)
+{
+    Results *results = (Results *)evt->user_data;
+    int id = (int)(intptr_t)evt->request_ctx;
+    switch (evt->event_id) {
+    case HTTP_EVENT_ON_DATA:
+        if (id > 0 && results->finish_order.size() < (size_t)id) {
+            results->data_before_finish++;
+        }
+        results->bodies[id].append((const char *)evt->data, evt->data_len);
+        break;
+    case HTTP_EVENT_ON_FINISH:
+        results->finish_order.push_back(id);
+        if (id == results->close_on_finish) {
+            /* Calls back into the client while its responses are being parsed */
+            esp_http_client_close(results->close_client);
+        }
+        break;
+    case HTTP_EVENT_ERROR:
+        results->errors.push_back(id);
+        break;
+    default:
+        break;
+    }
+    return ESP_OK;
+}
+
+static esp_http_client_handle_t new_pipelined_client(const std::string &url, int depth, Results *results)
+{
+    esp_http_client_config_t config = {};
+    config.url = url.c_str();
+    config.pipeline_depth = depth;
+    config.event_handler = event_handler;
+    config.user_data = results;
+    config.timeout_ms = 1000;
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    REQUIRE(client != NULL);
+    return client;
+}
+
+static void process_all(void)
+{
+    int rounds = 0;
+    while (esp_http_client_process(100) > 0) {
+        REQUIRE(++rounds < 100);
+    }
+}
+
+TEST_CASE("queued requests are pipelined on one connection", "[pipeline]")
+{
+    TestServer server;
+    const int n = 8;
+    /* Would never respond if the client waited for each response before sending the next request */
+    server.hold_until = 4;
+    Results results;
+    results.bodies.resize(n);
+    esp_http_client_handle_t client = new_pipelined_client(server.url(), 4, &results);
+    for (int i = 0; i < n; i++) {
+        std::string path = "/" + std::to_string(i);
+        REQUIRE(esp_http_client_queue_request(client, HTTP_METHOD_GET, path.c_str(), NULL, 0, (void *)(intptr_t)i) == ESP_OK);
+    }
+    process_all();
+
+    CHECK(results.errors.empty());
+    REQUIRE(results.finish_order.size() == n);
+    for (int i = 0; i < n; i++) {
+        CHECK(results.finish_order[i] == i);
+        CHECK(results.bodies[i] == "/" + std::to_string(i));
+    }
+    CHECK(server.requests == n);
+    CHECK(server.accepted == 1);
+    esp_http_client_cleanup(client);
+    esp_http_client_flush_connection_pool();
+}
+
+TEST_CASE("finished requests are reported outside of the response parser", "[pipeline]")
+{
+    TestServer server;
+    const int n = 4;
+    /* All the responses are sent at once, so they are parsed from the same buffer */
+    server.hold_until = n;
+    Results results;
+    results.bodies.resize(n);
+    esp_http_client_handle_t client = new_pipelined_client(server.url(), n, &results);
+    results.close_client = client;
+    results.close_on_finish = 1;
+    for (int i = 0; i < n; i++) {
+        std::string path = "/" + std::to_string(i);
+        REQUIRE(esp_http_client_queue_request(client, HTTP_METHOD_GET, path.c_str(), NULL, 0, (void *)(intptr_t)i) == ESP_OK);
+    }
+    process_all();
+
+    /* The requests after the close complete, either from the data already received or sent again */
+    CHECK(results.errors.empty());
+    CHECK(results.finish_order == std::vector<int>({0, 1, 2, 3}));
+    CHECK(results.data_before_finish == 0);
+    for (int i = 0; i < n; i++) {
+        CHECK(results.bodies[i] == "/" + std::to_string(i));
+    }
+    esp_http_client_cleanup(client);
+    esp_http_client_flush_connection_pool();
+}
+
+TEST_CASE("one task drives requests of many clients", "[pipeline]")
+{
+    const int n_clients = 3, n_requests = 3;
+    TestServer servers[n_clients];
+    Results results[n_clients];
+    esp_http_client_handle_t clients[n_clients];
+    for (int c = 0; c < n_clients; c++) {
+        results[c].bodies.resize(n_requests);
+        clients[c] = new_pipelined_client(servers[c].url(), 2, &results[c]);
+        for (int i = 0; i < n_requests; i++) {
+            std::string data = "client " + std::to_string(c) + " upload " + std::to_string(i);
+            REQUIRE(esp_http_client_queue_request(clients[c], HTTP_METHOD_POST, NULL, data.c_str(), data.size(), (void *)(intptr_t)i) == ESP_OK);
+        }
+    }
+    process_all();
+
+    for (int c = 0; c < n_clients; c++) {
+        CHECK(results[c].errors.empty());
+        CHECK(results[c].finish_order.size() == n_requests);
+        for (int i = 0; i < n_requests; i++) {
+            CHECK(results[c].bodies[i] == "client " + std::to_string(c) + " upload " + std::to_string(i));
+        }
+        CHECK(servers[c].accepted == 1);
+        esp_http_client_cleanup(clients[c]);
+    }
+    esp_http_client_flush_connection_pool();
+}
+
+TEST_CASE("requests without response are resent when the server closes the connection", "[pipeline]")
+{
+    TestServer server;
+    server.keep_alive = false;
+    const int n = 3;
+    Results results;
+    results.bodies.resize(n);
+    esp_http_client_handle_t client = new_pipelined_client(server.url(), n, &results);
+    for (int i = 0; i < n; i++) {
+        REQUIRE(esp_http_client_queue_request(client, HTTP_METHOD_GET, "/", NULL, 0, (void *)(intptr_t)i) == ESP_OK);
+    }
+    process_all();
+
+    CHECK(results.errors.empty());
+    CHECK(results.finish_order == std::vector<int>({0, 1, 2}));
+    CHECK(server.accepted == n);
+    esp_http_client_cleanup(client);
+}
+
+TEST_CASE("response to HEAD has no body", "[pipeline]")
+{
+    TestServer server;
+    Results results;
+    results.bodies.resize(2);
+    esp_http_client_handle_t client = new_pipelined_client(server.url(), 2, &results);
+    REQUIRE(esp_http_client_queue_request(client, HTTP_METHOD_HEAD, "/head", NULL, 0, (void *)0) == ESP_OK);
+    REQUIRE(esp_http_client_queue_request(client, HTTP_METHOD_GET, "/get", NULL, 0, (void *)1) == ESP_OK);
+    process_all();
+
+    CHECK(results.finish_order == std::vector<int>({0, 1}));
+    CHECK(results.bodies[0].empty());
+    CHECK(results.bodies[1] == "/get");
+    esp_http_client_cleanup(client);
+    esp_http_client_flush_connection_pool();
+}
+
+TEST_CASE("queued requests fail when the server is unreachable", "[pipeline]")
+{
+    std::string url;
+    {
+        TestServer server;
+        url = server.url();
+    }
+    Results results;
+    results.bodies.resize(2);
+    esp_http_client_handle_t client = new_pipelined_client(url, 2, &results);
+    REQUIRE(esp_http_client_queue_request(client, HTTP_METHOD_GET, NULL, NULL, 0, (void *)0) == ESP_OK);
+    REQUIRE(esp_http_client_queue_request(client, HTTP_METHOD_GET, NULL, NULL, 0, (void *)1) == ESP_OK);
+    CHECK(esp_http_client_process(100) == 0);
+
+    CHECK(results.finish_order.empty());
+    CHECK(results.errors == std::vector<int>({0, 1}));
+    esp_http_client_cleanup(client);
+}
+
+TEST_CASE("requests still queued fail on cleanup", "[pipeline]")
+{
+    TestServer server;
+    Results results;
+    results.bodies.resize(1);
+    esp_http_client_handle_t client = new_pipelined_client(server.url(), 1, &results);
+    REQUIRE(esp_http_client_queue_request(client, HTTP_METHOD_GET, NULL, NULL, 0, (void *)0) == ESP_OK);
+    esp_http_client_cleanup(client);
+
+    CHECK(results.errors == std::vector<int>({0}));
+    CHECK(esp_http_client_process(0) == 0);
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/* Minimal keep-alive HTTP/1.1 server on the loopback interface, counting the connections it accepts.
+ * With `tls` set, each connection starts with the handshake of the TLS transport stand-in */
+class TestServer {
+public:
+    TestServer()
+    {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+        listen(listen_fd, 8);
+        socklen_t len = sizeof(addr);
+        getsockname(listen_fd, (struct sockaddr *)&addr, &len);
+        port = ntohs(addr.sin_port);
+        thread = std::thread(&TestServer::run, this);
+    }
+
+    ~TestServer()
+    {
+        stop = true;
+        thread.join();
+        for (auto &c : clients) {
+            close(c.first);
+        }
+        close(listen_fd);
+    }
+
+    std::string url(const char *scheme = "http") const
+    {
+        return std::string(scheme) + "://127.0.0.1:" + std::to_string(port) + "/";
+    }
+
+    int port;
+    std::atomic<int> accepted{0};
+    std::atomic<int> requests{0};
+    std::atomic<bool> keep_alive{true};
+    std::atomic<bool> drop_idle{false};
+    /* Responses are held back until this many requests were received */
+    std::atomic<int> hold_until{0};
+    std::atomic<bool> tls{false};
+    /* Sessions are forgotten, as by a server restart, while this is cleared */
+    std::atomic<bool> resume_sessions{true};
+    std::atomic<int> full_handshakes{0};
+    std::atomic<int> resumed_handshakes{0};
+
+private:
+    void run()
+    {
+        while (!stop) {
+            fd_set readset;
+            FD_ZERO(&readset);
+            FD_SET(listen_fd, &readset);
+            int max_fd = listen_fd;
+            if (drop_idle) {
+                for (auto &c : clients) {
+                    close(c.first);
+                }
+                clients.clear();
+                handshaken.clear();
+                drop_idle = false;
+            }
+            for (auto &c : clients) {
+                FD_SET(c.first, &readset);
+                max_fd = std::max(max_fd, c.first);
+            }
+            struct timeval tv = { 0, 10000 };
+            if (select(max_fd + 1, &readset, NULL, NULL, &tv) <= 0) {
+                continue;
+            }
+            if (FD_ISSET(listen_fd, &readset)) {
+                int fd = accept(listen_fd, NULL, NULL);
+                if (fd >= 0) {
+                    clients[fd] = "";
+                    accepted++;
+                }
+            }
+            for (auto it = clients.begin(); it != clients.end();) {
+                if (FD_ISSET(it->first, &readset) && !serve(it->first, it->second)) {
+                    close(it->first);
+                    handshaken.erase(it->first);
+                    it = clients.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    /* Answers every complete request with its path, or its body if it has one */
+    bool serve(int fd, std::string &pending)
+    {
+        char buf[512];
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) {
+            return false;
+        }
+        pending.append(buf, len);
+        if (tls && handshaken.count(fd) == 0) {
+            size_t eol = pending.find("\r\n");
+            if (eol == std::string::npos) {
+                return true;
+            }
+            if (!handshake(fd, pending.substr(0, eol))) {
+                return false;
+            }
+            pending.erase(0, eol + 2);
+            handshaken.insert(fd);
+            if (pending.empty()) {
+                return true;
+            }
+        }
+        size_t end;
+        std::string responses;
+        while ((end = pending.find("\r\n\r\n")) != std::string::npos) {
+            std::string head = pending.substr(0, end + 4);
+            size_t body_len = 0;
+            size_t cl = head.find("Content-Length: ");
+            if (cl != std::string::npos) {
+                body_len = std::stoul(head.substr(cl + 16));
+            }
+            if (pending.size() < end + 4 + body_len) {
+                break;
+            }
+            std::string body = pending.substr(end + 4, body_len);
+            pending.erase(0, end + 4 + body_len);
+            requests++;
+
+            size_t path_start = head.find(' ') + 1;
+            std::string path = head.substr(path_start, head.find(' ', path_start) - path_start);
+            bool is_head = head.compare(0, 5, "HEAD ") == 0;
+            if (body.empty()) {
+                body = path;
+            }
+            responses += "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+            responses += keep_alive ? "\r\n" : "Connection: close\r\n\r\n";
+            if (!is_head) {
+                responses += body;
+            }
+            if (!keep_alive) {
+                break;
+            }
+        }
+        held += responses;
+        if (requests < hold_until) {
+            return true;
+        }
+        bool ok = write(fd, held.data(), held.size()) == (ssize_t)held.size();
+        held.clear();
+        return ok && keep_alive;
+    }
+
+    /* Resumes the session the client asks for if it is known, creates a new one otherwise */
+    bool handshake(int fd, const std::string &hello)
+    {
+        unsigned id = 0;
+        if (sscanf(hello.c_str(), "TLS %u", &id) != 1) {
+            return false;
+        }
+        if (!resume_sessions) {
+            sessions.clear();
+        }
+        if (id != 0 && sessions.count(id)) {
+            resumed_handshakes++;
+        } else {
+            full_handshakes++;
+            id = ++last_session;
+            sessions.insert(id);
+        }
+        std::string reply = "TLS " + std::to_string(id) + "\r\n";
+        return write(fd, reply.data(), reply.size()) == (ssize_t)reply.size();
+    }
+
+    int listen_fd;
+    std::map<int, std::string> clients;
+    std::set<int> handshaken;
+    std::set<unsigned> sessions;
+    unsigned last_session = 0;
+    std::string held;
+    std::atomic<bool> stop{false};
+    std::thread thread;
+};
@@ -1502,6 +1502,47 @@ typedef struct httpd_ws_frame {
  */
 esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *pkt, size_t max_len);
 
+/**
+ * @brief Receive and parse only the header of a WebSocket frame
+ *
+ * This is the streaming counterpart of httpd_ws_recv_frame(). It fills in the
+ * type, FIN flag and total payload length of the frame, but leaves the payload
+ * in the socket so that it can be fetched in pieces of any size with
+ * httpd_ws_recv_frame_payload(). Large frames can thus be processed without a
+ * buffer for the whole frame. pkt->payload is not used.
+ *
+ * @note The whole payload must be consumed before the handler returns,
+ *       otherwise the next frame will not be parsed correctly.
+ *
+ * @param[in]   req         Current request
+ * @param[out]  pkt         WebSocket frame information
+ * @return
+ *  - ESP_OK                    : On successful
+ *  - ESP_FAIL                  : Socket errors occurs
+ *  - ESP_ERR_INVALID_STATE     : Handshake was not done yet, or frame is not masked
+ *  - ESP_ERR_INVALID_ARG       : Argument is invalid (null or non-WebSocket)
+ */
+esp_err_t httpd_ws_recv_frame_header(httpd_req_t *req, httpd_ws_frame_t *pkt);
+
+/**
+ * @brief Receive the next piece of the payload of a WebSocket frame
+ *
+ * Must be preceded by a call to httpd_ws_recv_frame_header(). Data is read
+ * from the socket straight into buf and unmasked in place. At most buf_len
+ * bytes are returned, possibly fewer if less data is available at the moment.
+ *
+ * @param[in]   req         Current request
+ * @param[out]  buf         Buffer for the payload piece
+ * @param[in]   buf_len     Length of buf
+ * @return
+ *  - Bytes     : Number of payload bytes copied to buf
+ *  - 0         : The whole payload of the frame has been received
+ *  - HTTPD_SOCK_ERR_INVALID  : Invalid arguments
+ *  - HTTPD_SOCK_ERR_TIMEOUT  : Timeout/interrupted while calling socket recv()
+ *  - HTTPD_SOCK_ERR_FAIL     : Unrecoverable error while calling socket recv()
+ */
+int httpd_ws_recv_frame_payload(httpd_req_t *req, uint8_t *buf, size_t buf_len);
+
 /**
  * @brief Construct and send a WebSocket frame
  * @param[in]   req     Current request
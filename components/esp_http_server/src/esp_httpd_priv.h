@@ -100,6 +100,9 @@ struct httpd_req_aux {
     bool ws_handshake_detect;                       /*!< WebSocket handshake detection flag */
     httpd_ws_type_t ws_type;                        /*!< WebSocket frame type */
     bool ws_final;                                  /*!< WebSocket FIN bit (final frame or not) */
+    uint8_t ws_mask_key[4];                         /*!< Masking key of the frame being received */
+    size_t ws_payload_len;                          /*!< Payload length of the frame being received */
+    size_t ws_payload_offset;                       /*!< Amount of payload already handed to the application */
 #endif
 };
 
@@ -23,6 +23,7 @@
 
 #include <esp_http_server.h>
 #include "esp_httpd_priv.h"
+#include "ws_mask.h"
 
 #ifdef CONFIG_HTTPD_WS_SUPPORT
 
@@ -139,21 +140,7 @@ static esp_err_t httpd_ws_check_req(httpd_req_t *req)
     return ESP_OK;
 }
 
-static esp_err_t httpd_ws_unmask_payload(uint8_t *payload, size_t len, const uint8_t *mask_key)
-{
-    if (len < 1 || !payload) {
-        ESP_LOGW(TAG, LOG_FMT("Invalid payload provided"));
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    for (size_t idx = 0; idx < len; idx++) {
-        payload[idx] = (payload[idx] ^ mask_key[idx % 4]);
-    }
-
-    return ESP_OK;
-}
-
-esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len)
+esp_err_t httpd_ws_recv_frame_header(httpd_req_t *req, httpd_ws_frame_t *frame)
 {
     esp_err_t ret = httpd_ws_check_req(req);
     if (ret != ESP_OK) {
@@ -218,16 +205,9 @@ esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t
                     ((uint64_t)length_bytes[7]));
     }
 
-    /* We only accept the incoming packet length that is smaller than the max_len (or it will overflow the buffer!) */
-    if (frame->len > max_len) {
-        ESP_LOGW(TAG, LOG_FMT("WS Message too long"));
-        return ESP_ERR_INVALID_SIZE;
-    }
-
     /* If this frame is masked, dump the mask as well */
-    uint8_t mask_key[4] = { 0 };
     if (masked) {
-        if (httpd_recv_with_opt(req, (char *)mask_key, sizeof(mask_key), false) <= 0) {
+        if (httpd_recv_with_opt(req, (char *)aux->ws_mask_key, sizeof(aux->ws_mask_key), false) <= 0) {
             ESP_LOGW(TAG, LOG_FMT("Failed to receive mask key"));
             return ESP_FAIL;
         }
@@ -238,6 +218,51 @@ esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t
         return ESP_ERR_INVALID_STATE;
     }
 
+    /* Payload is fetched later, piece by piece, by httpd_ws_recv_frame_payload() */
+    aux->ws_payload_len = frame->len;
+    aux->ws_payload_offset = 0;
+    return ESP_OK;
+}
+
+int httpd_ws_recv_frame_payload(httpd_req_t *req, uint8_t *buf, size_t buf_len)
+{
+    if (httpd_ws_check_req(req) != ESP_OK || !buf) {
+        return HTTPD_SOCK_ERR_INVALID;
+    }
+
+    struct httpd_req_aux *aux = req->aux;
+    size_t remaining = aux->ws_payload_len - aux->ws_payload_offset;
+    if (remaining == 0) {
+        return 0;
+    }
+
+    /* Return whatever arrives first, so that the caller's buffer
+     * can be much smaller than the frame */
+    int ret = httpd_recv_with_opt(req, (char *)buf, MIN(buf_len, remaining), true);
+    if (ret <= 0) {
+        ESP_LOGW(TAG, LOG_FMT("Failed to receive payload"));
+        return ret < 0 ? ret : HTTPD_SOCK_ERR_FAIL;
+    }
+
+    /* Unmask payload, continuing with the key phase of the previous piece */
+    ws_mask_payload(buf, ret, aux->ws_mask_key, aux->ws_payload_offset);
+    aux->ws_payload_offset += ret;
+    return ret;
+}
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len)
+{
+    esp_err_t ret = httpd_ws_recv_frame_header(req, frame);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    /* We only accept the incoming packet length that is smaller than the max_len (or it will overflow the buffer!) */
+    if (frame->len > max_len) {
+        ESP_LOGW(TAG, LOG_FMT("WS Message too long"));
+        return ESP_ERR_INVALID_SIZE;
+    }
+
     /* Receive buffer */
     /* If there's nothing to receive, return and stop here. */
     if (frame->len == 0) {
@@ -249,14 +274,16 @@ esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t
         return ESP_FAIL;
     }
 
-    if (httpd_recv_with_opt(req, (char *)frame->payload, frame->len, false) <= 0) {
-        ESP_LOGW(TAG, LOG_FMT("Failed to receive payload"));
-        return ESP_FAIL;
+    /* A socket read may return less than asked for, so keep going until the frame is complete */
+    size_t received = 0;
+    while (received < frame->len) {
+        int len = httpd_ws_recv_frame_payload(req, frame->payload + received, frame->len - received);
+        if (len <= 0) {
+            return ESP_FAIL;
+        }
+        received += len;
     }
 
-    /* Unmask payload */
-    httpd_ws_unmask_payload(frame->payload, frame->len, mask_key);
-
     return ESP_OK;
 }
 
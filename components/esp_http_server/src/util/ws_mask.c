@@ -0,0 +1,66 @@
+// Copyright 2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+
+#include "ws_mask.h"
+
+/* Native word size: 32 bits on the chip, 64 bits on most hosts.
+ * The payload buffer is accessed through this type, so it may alias bytes. */
+typedef uintptr_t __attribute__((__may_alias__)) ws_word_t;
+
+void ws_mask_payload(uint8_t *buf, size_t len, const uint8_t mask_key[4], size_t offset)
+{
+    size_t phase = offset & 3;
+
+    /* Byte-wise head, until the buffer is word aligned */
+    while (len > 0 && ((uintptr_t)buf & (sizeof(ws_word_t) - 1)) != 0) {
+        *buf++ ^= mask_key[phase];
+        phase = (phase + 1) & 3;
+        len--;
+    }
+
+    if (len >= sizeof(ws_word_t)) {
+        /* Repeat the key, rotated to the current phase, over a whole word.
+         * Building it in memory order keeps this independent of endianness. */
+        uint8_t pattern[sizeof(ws_word_t)];
+        for (size_t i = 0; i < sizeof(pattern); i++) {
+            pattern[i] = mask_key[(phase + i) & 3];
+        }
+        ws_word_t mask_word;
+        memcpy(&mask_word, pattern, sizeof(mask_word));
+
+        ws_word_t *word = (ws_word_t *)buf;
+        /* Unrolled twice to keep the loop overhead out of the way */
+        while (len >= 2 * sizeof(ws_word_t)) {
+            word[0] ^= mask_word;
+            word[1] ^= mask_word;
+            word += 2;
+            len -= 2 * sizeof(ws_word_t);
+        }
+        if (len >= sizeof(ws_word_t)) {
+            *word++ ^= mask_word;
+            len -= sizeof(ws_word_t);
+        }
+        /* Word size is a multiple of 4, so the phase is unchanged */
+        buf = (uint8_t *)word;
+    }
+
+    /* Byte-wise tail */
+    while (len > 0) {
+        *buf++ ^= mask_key[phase];
+        phase = (phase + 1) & 3;
+        len--;
+    }
+}
@@ -0,0 +1,53 @@
+// Copyright 2020 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * \file ws_mask.h
+ * \brief WebSocket payload masking
+ *
+ * RFC6455 masking XORs every payload byte with one of the four bytes
+ * of the masking key. Applying the same operation twice restores the
+ * original data, so this is used for both masking and unmasking.
+ */
+#ifndef _WS_MASK_H_
+#define _WS_MASK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Mask (or unmask) a part of a WebSocket payload in place
+ *
+ *      The buffer is processed a machine word at a time once it is
+ *      aligned, so the cost per byte is much lower than for a plain
+ *      byte loop. Because a payload may be received in several pieces,
+ *      the caller passes the offset of the first byte of the buffer
+ *      within the whole payload, which selects the masking key phase.
+ *
+ * @param[inout] buf      payload bytes to be (un)masked
+ * @param[in]    len      number of bytes in buf
+ * @param[in]    mask_key the 4 byte masking key of the frame
+ * @param[in]    offset   offset of buf[0] from the start of the frame payload
+ */
+void ws_mask_payload(uint8_t *buf, size_t len, const uint8_t mask_key[4], size_t offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ! _WS_MASK_H_ */
@@ -0,0 +1,92 @@
+#include "catch.hpp"
+#include "ws_mask.h"
+
+#include <string.h>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+
+static const uint8_t mask_key[4] = { 0x37, 0xfa, 0x21, 0x3d };
+
+/* Straightforward byte loop, as used before ws_mask_payload() */
+static void reference_mask(uint8_t *buf, size_t len, const uint8_t *key, size_t offset)
+{
+    for (size_t idx = 0; idx < len; idx++) {
+        buf[idx] ^= key[(idx + offset) % 4];
+    }
+}
+
+static void fill_pattern(std::vector<uint8_t> &buf)
+{
+    for (size_t i = 0; i < buf.size(); i++) {
+        buf[i] = (uint8_t)(i * 7 + 3);
+    }
+}
+
+TEST_CASE("masking matches byte-wise reference for all alignments and offsets", "[ws_mask]")
+{
+    for (size_t align = 0; align < 16; align++) {
+        for (size_t len = 0; len < 70; len++) {
+            for (size_t offset = 0; offset < 8; offset++) {
+                std::vector<uint8_t> expected(align + len);
+                fill_pattern(expected);
+                std::vector<uint8_t> actual(expected);
+
+                reference_mask(expected.data() + align, len, mask_key, offset);
+                ws_mask_payload(actual.data() + align, len, mask_key, offset);
+                REQUIRE(memcmp(expected.data(), actual.data(), expected.size()) == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("unmasking in pieces gives the same result as in one go", "[ws_mask]")
+{
+    const size_t len = 4099;
+    std::vector<uint8_t> whole(len);
+    fill_pattern(whole);
+    std::vector<uint8_t> pieces(whole);
+
+    ws_mask_payload(whole.data(), len, mask_key, 0);
+
+    size_t piece_sizes[] = { 1, 3, 5, 17, 64, 129, 1000 };
+    size_t offset = 0;
+    for (size_t i = 0; offset < len; i++) {
+        size_t n = std::min(piece_sizes[i % (sizeof(piece_sizes) / sizeof(piece_sizes[0]))], len - offset);
+        ws_mask_payload(pieces.data() + offset, n, mask_key, offset);
+        offset += n;
+    }
+    REQUIRE(memcmp(whole.data(), pieces.data(), len) == 0);
+
+    /* Masking twice restores the data */
+    std::vector<uint8_t> original(len);
+    fill_pattern(original);
+    ws_mask_payload(whole.data(), len, mask_key, 0);
+    REQUIRE(memcmp(whole.data(), original.data(), len) == 0);
+}
+
+TEST_CASE("masking throughput", "[ws_mask][benchmark]")
+{
+    const size_t len = 64 * 1024;
+    const int rounds = 2000;
+    std::vector<uint8_t> buf(len);
+    fill_pattern(buf);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        reference_mask(buf.data(), len, mask_key, i);
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        ws_mask_payload(buf.data(), len, mask_key, i);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double mbytes = (double)len * rounds / (1024 * 1024);
+    double bytewise_s = std::chrono::duration<double>(mid - start).count();
+    double wordwise_s = std::chrono::duration<double>(end - mid).count();
+    printf("byte-wise: %.1f MB/s, word-wise: %.1f MB/s\n", mbytes / bytewise_s, mbytes / wordwise_s);
+
+    /* Keep the result alive so that nothing is optimized away */
+    REQUIRE(buf.size() == len);
+}
@@ -1,3 +1,5 @@
 COMPONENT_SRCDIRS := src
 
 COMPONENT_ADD_INCLUDEDIRS := include
+
+COMPONENT_PRIV_INCLUDEDIRS := private_include
@@ -72,6 +72,10 @@ esp_err_t esp_https_ota(const esp_http_client_config_t *config);
  * should be appended to `cert_pem` member of `http_config`, which is a part of `ota_config`.
  * In case of error, this API explicitly sets `handle` to NULL.
  *
+ * The server may send the image compressed by `otacompress.py` from the esp_https_ota component,
+ * which is detected from its header and decompressed while it is downloaded. This needs a window
+ * buffer of the size chosen when compressing (4 kB by default) and a second buffer of the HTTP buffer size.
+ *
  * @param[in]   ota_config       pointer to esp_https_ota_config_t structure
  * @param[out]  handle           pointer to an allocated data of type `esp_https_ota_handle_t`
  *                               which will be initialised in this function
@@ -0,0 +1,258 @@
+#!/usr/bin/env python
+#
+# otacompress compresses app images for OTA updates - esp_https_ota recognizes
+# the header and decompresses the image while it is being downloaded
+#
+# Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+from __future__ import print_function, division
+import argparse
+import struct
+import sys
+import zlib
+
+__version__ = '1.0'
+
+HEADER_MAGIC = b"ESPZ"
+HEADER_VERSION = 1
+HEADER_FMT = "<4sBBBBII"
+
+CODEC_NONE = 0
+CODEC_HEATSHRINK = 1
+
+DEFAULT_WINDOW_BITS = 12
+DEFAULT_LOOKAHEAD_BITS = 5
+# Number of earlier positions tried for each match, more compress better but slower
+MAX_CHAIN = 64
+
+quiet = False
+
+
+def status(msg):
+    if not quiet:
+        print(msg)
+
+
+class BitWriter(object):
+
+    def __init__(self):
+        self.out = bytearray()
+        self.bits = 0
+        self.count = 0
+
+    def write(self, value, nbits):
+        self.bits = (self.bits << nbits) | value
+        self.count += nbits
+        while self.count >= 8:
+            self.count -= 8
+            self.out.append((self.bits >> self.count) & 0xFF)
+        self.bits &= (1 << self.count) - 1
+
+    def flush(self):
+        if self.count:
+            self.out.append((self.bits << (8 - self.count)) & 0xFF)
+            self.bits = self.count = 0
+        return bytes(self.out)
+
+
+class BitReader(object):
+
+    def __init__(self, data):
+        self.data = bytearray(data)
+        self.pos = 0
+        self.bits = 0
+        self.count = 0
+
+    def read(self, nbits):
+        """ Return the next nbits as an integer, or None at the end of the data """
+        while self.count < nbits:
+            if self.pos == len(self.data):
+                return None
+            self.bits = (self.bits << 8) | self.data[self.pos]
+            self.pos += 1
+            self.count += 8
+        self.count -= nbits
+        value = (self.bits >> self.count) & ((1 << nbits) - 1)
+        self.bits &= (1 << self.count) - 1
+        return value
+
+
+def _match_len(data, a, b, max_len):
+    """ Length of the common prefix of data[a:] and data[b:], up to max_len """
+    length = 0
+    step = 8
+    while length < max_len:
+        step = min(step, max_len - length)
+        if data[a + length:a + length + step] == data[b + length:b + length + step]:
+            length += step
+        elif step > 1:
+            step = 1
+        else:
+            break
+    return length
+
+
+def _longest_match(data, pos, candidates, window, max_len):
+    best_len = 0
+    best_pos = 0
+    max_len = min(max_len, len(data) - pos)
+    for cand in reversed(candidates[-MAX_CHAIN:]):
+        if pos - cand > window:
+            break
+        # Only a candidate that matches one more byte than the best so far can be longer
+        if data[cand + best_len:cand + best_len + 1] != data[pos + best_len:pos + best_len + 1]:
+            continue
+        length = _match_len(data, cand, pos, max_len)
+        if length > best_len:
+            best_len = length
+            best_pos = cand
+            if length == max_len:
+                break
+    return best_len, best_pos
+
+
+def heatshrink_compress(data, window_bits=DEFAULT_WINDOW_BITS, lookahead_bits=DEFAULT_LOOKAHEAD_BITS):
+    """ LZSS compression in the bit stream format of heatshrink
+
+    A set bit is followed by a literal byte. A clear bit is followed by the distance
+    minus one (window_bits) and the length minus one (lookahead_bits) of a copy from
+    the output produced so far. All fields are stored most significant bit first.
+    """
+    data = bytes(data)
+    window = 1 << window_bits
+    max_len = 1 << lookahead_bits
+    # Copies shorter than this take more bits than the literals
+    min_len = (1 + window_bits + lookahead_bits) // 9 + 1
+
+    out = BitWriter()
+    chains = {}
+    pos = 0
+
+    def insert(p):
+        key = data[p:p + 3]
+        if len(key) == 3:
+            chains.setdefault(key, []).append(p)
+
+    while pos < len(data):
+        length, match = _longest_match(data, pos, chains.get(data[pos:pos + 3], []), window, max_len)
+        if length >= min_len and length < max_len:
+            # Lazy matching: a literal is better if the next position starts a longer copy
+            next_length, _ = _longest_match(data, pos + 1, chains.get(data[pos + 1:pos + 4], []), window, max_len)
+            if next_length > length + 1:
+                length = 0
+        if length >= min_len:
+            out.write(0, 1)
+            out.write(pos - match - 1, window_bits)
+            out.write(length - 1, lookahead_bits)
+            for p in range(pos, pos + length):
+                insert(p)
+            pos += length
+        else:
+            out.write(1, 1)
+            out.write(ord(data[pos:pos + 1]), 8)
+            insert(pos)
+            pos += 1
+    return out.flush()
+
+
+def heatshrink_decompress(data, window_bits, lookahead_bits, size):
+    reader = BitReader(data)
+    out = bytearray()
+    while len(out) < size:
+        tag = reader.read(1)
+        if tag is None:
+            break
+        if tag:
+            out.append(reader.read(8))
+        else:
+            distance = reader.read(window_bits) + 1
+            length = reader.read(lookahead_bits) + 1
+            for _ in range(length):
+                out.append(out[-distance])
+    return bytes(out)
+
+
+def compress_image(image, window_bits=DEFAULT_WINDOW_BITS, lookahead_bits=DEFAULT_LOOKAHEAD_BITS):
+    """ Return the compressed image, with the header esp_https_ota uses to detect it """
+    payload = heatshrink_compress(image, window_bits, lookahead_bits)
+    header = struct.pack(HEADER_FMT, HEADER_MAGIC, HEADER_VERSION, CODEC_HEATSHRINK,
+                         window_bits, lookahead_bits, len(image), zlib.crc32(image) & 0xffffffff)
+    status("Compressed %d bytes to %d bytes (%d%%)" %
+           (len(image), len(header) + len(payload), 100 * (len(header) + len(payload)) // max(len(image), 1)))
+    return header + payload
+
+
+def decompress_image(data):
+    """ Return the app image from a compressed image, as the device rebuilds it """
+    header_len = struct.calcsize(HEADER_FMT)
+    magic, version, codec, window_bits, lookahead_bits, size, crc = struct.unpack(HEADER_FMT, data[:header_len])
+    if magic != HEADER_MAGIC or version != HEADER_VERSION:
+        raise RuntimeError("Not a compressed app image or unsupported version")
+    if codec == CODEC_NONE:
+        image = data[header_len:]
+    elif codec == CODEC_HEATSHRINK:
+        image = heatshrink_decompress(data[header_len:], window_bits, lookahead_bits, size)
+    else:
+        raise RuntimeError("Unknown codec %d" % codec)
+    if len(image) != size or zlib.crc32(image) & 0xffffffff != crc:
+        raise RuntimeError("Decompressed image doesn't match the header")
+    return image
+
+
+def main():
+    global quiet
+
+    parser = argparse.ArgumentParser("ESP-IDF OTA Image Compression Tool")
+
+    parser.add_argument("--quiet", "-q", help="suppress stderr messages", action="store_true")
+
+    subparsers = parser.add_subparsers(dest="operation", help="run otacompress -h for additional help")
+
+    compress_parser = subparsers.add_parser("compress", help="compress an app image")
+    compress_parser.add_argument("input", help="app image")
+    compress_parser.add_argument("--output", "-o", help="file to write the compressed image to", required=True)
+    compress_parser.add_argument("--window-bits", "-w", help="log2 of the window size, the device allocates a buffer of this size",
+                                 type=int, choices=range(8, 15), default=DEFAULT_WINDOW_BITS)
+    compress_parser.add_argument("--lookahead-bits", "-l", help="log2 of the longest copy",
+                                 type=int, choices=range(3, 9), default=DEFAULT_LOOKAHEAD_BITS)
+
+    decompress_parser = subparsers.add_parser("decompress", help="decompress a compressed app image")
+    decompress_parser.add_argument("input", help="compressed app image")
+    decompress_parser.add_argument("--output", "-o", help="file to write the app image to", required=True)
+
+    args = parser.parse_args()
+
+    quiet = args.quiet
+
+    if args.operation is None:
+        parser.print_help()
+        sys.exit(1)
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+    if args.operation == "compress":
+        data = compress_image(data, args.window_bits, args.lookahead_bits)
+    else:
+        data = decompress_image(data)
+    with open(args.output, "wb") as f:
+        f.write(data)
+    status("Wrote %s" % args.output)
+
+
+if __name__ == '__main__':
+    try:
+        main()
+    except RuntimeError as e:
+        print("A fatal error occurred: %s" % e, file=sys.stderr)
+        sys.exit(2)
@@ -0,0 +1,107 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _OTA_DECOMPRESS_H_
+#define _OTA_DECOMPRESS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Header of a compressed app image, as written by otacompress.py. All integers are little endian.
+ *
+ *   uint32 magic ("ESPZ"), uint8 version, uint8 codec, uint8 window_bits, uint8 lookahead_bits,
+ *   uint32 image_size, uint32 image_crc
+ */
+#define OTA_COMPRESSED_HEADER_SIZE      16
+
+#define OTA_CODEC_NONE                  0   /*!< Image is stored as is */
+#define OTA_CODEC_HEATSHRINK            1   /*!< LZSS in the bit stream format of heatshrink */
+
+#define OTA_DECOMPRESS_MAX_WINDOW_BITS  14  /*!< Largest window accepted, the window buffer is allocated from the heap */
+
+typedef struct ota_decompress *ota_decompress_handle_t;
+
+/**
+ * @brief      Check whether data received from the server starts with a compressed image header
+ *
+ * @param[in]  data  First bytes received
+ * @param[in]  len   Number of bytes in data, at least OTA_COMPRESSED_HEADER_SIZE to get a definite answer
+ *
+ * @return     true if data starts with the header magic
+ */
+bool ota_decompress_is_compressed(const void *data, size_t len);
+
+/**
+ * @brief      Create a decompressor from a compressed image header
+ *
+ * @param[in]  header      OTA_COMPRESSED_HEADER_SIZE bytes of header
+ * @param[out] out_handle  The decompressor
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_ERR_NOT_SUPPORTED if the version, codec or its parameters are not supported
+ *  - ESP_ERR_NO_MEM
+ */
+esp_err_t ota_decompress_init(const void *header, ota_decompress_handle_t *out_handle);
+
+/**
+ * @brief      Decompress the next part of the stream
+ *
+ * Consumes input until the input is used up or the output buffer is full, whichever comes first.
+ * Compressed data can be passed in chunks of any size.
+ *
+ * @param[in]     handle    The decompressor
+ * @param[inout]  in        Compressed data, advanced past the data consumed
+ * @param[inout]  in_len    Length of compressed data, decreased by the length consumed
+ * @param[out]    out       Buffer for the decompressed data
+ * @param[in]     out_size  Size of the buffer
+ *
+ * @return
+ *  - Number of bytes written to out
+ *  - -1 if the stream is corrupted
+ */
+int ota_decompress_run(ota_decompress_handle_t handle, const uint8_t **in, size_t *in_len, uint8_t *out, size_t out_size);
+
+/**
+ * @brief      Size of the decompressed image, as declared in the header
+ */
+uint32_t ota_decompress_get_image_size(ota_decompress_handle_t handle);
+
+/**
+ * @brief      Check that the complete image was decompressed and matches the header
+ *
+ * @return
+ *  - ESP_OK
+ *  - ESP_ERR_INVALID_SIZE if fewer bytes than declared were decompressed
+ *  - ESP_ERR_INVALID_CRC if the decompressed image doesn't match the checksum in the header
+ */
+esp_err_t ota_decompress_check(ota_decompress_handle_t handle);
+
+/**
+ * @brief      Free the decompressor
+ */
+void ota_decompress_deinit(ota_decompress_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OTA_DECOMPRESS_H_ */
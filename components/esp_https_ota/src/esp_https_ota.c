@@ -19,6 +19,8 @@
 #include <esp_log.h>
 #include <esp_ota_ops.h>
 #include <errno.h>
+#include <sys/param.h>
+#include "ota_decompress.h"
 
 #define IMAGE_HEADER_SIZE sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t) + 1
 #define DEFAULT_OTA_BUF_SIZE IMAGE_HEADER_SIZE
@@ -39,6 +41,13 @@ struct esp_https_ota_handle {
     size_t ota_upgrade_buf_size;
     int binary_file_len;
     esp_https_ota_state state;
+    char header_buf[OTA_COMPRESSED_HEADER_SIZE];  /* read ahead to detect a compressed image */
+    size_t header_len;
+    size_t header_pos;
+    ota_decompress_handle_t decompress;             /* NULL unless the server sends a compressed image */
+    uint8_t *compressed_buf;
+    const uint8_t *compressed_pos;
+    size_t compressed_len;                          /* compressed bytes not decompressed yet */
 };
 
 typedef struct esp_https_ota_handle esp_https_ota_t;
@@ -119,6 +128,82 @@ static void _http_cleanup(esp_http_client_handle_t client)
     esp_http_client_cleanup(client);
 }
 
+/* Reads from the HTTP stream, starting with the bytes read ahead by _read_image_header() */
+static int _http_read(esp_https_ota_t *handle, char *buf, size_t len)
+{
+    if (handle->header_pos < handle->header_len) {
+        size_t n = MIN(len, handle->header_len - handle->header_pos);
+        memcpy(buf, handle->header_buf + handle->header_pos, n);
+        handle->header_pos += n;
+        return n;
+    }
+    return esp_http_client_read(handle->http_client, buf, len);
+}
+
+/* Reads up to `len` bytes of the app image, decompressing it if the server sends a compressed image */
+static int _ota_read(esp_https_ota_t *handle, char *buf, size_t len)
+{
+    if (handle->decompress == NULL) {
+        return _http_read(handle, buf, len);
+    }
+    size_t n = 0;
+    while (n < len) {
+        if (handle->compressed_len == 0) {
+            /* Return what is there instead of waiting for more data */
+            if (n > 0) {
+                break;
+            }
+            int data_read = _http_read(handle, (char *)handle->compressed_buf, handle->ota_upgrade_buf_size);
+            if (data_read <= 0) {
+                break;
+            }
+            handle->compressed_pos = handle->compressed_buf;
+            handle->compressed_len = data_read;
+        }
+        int ret = ota_decompress_run(handle->decompress, &handle->compressed_pos, &handle->compressed_len,
+                                     (uint8_t *)buf + n, len - n);
+        if (ret < 0) {
+            return -1;
+        }
+        n += ret;
+    }
+    return n;
+}
+
+/* Reads the start of the response to find out if the server sends a compressed image */
+static esp_err_t _read_image_header(esp_https_ota_t *handle)
+{
+    while (handle->header_len < sizeof(handle->header_buf)) {
+        int data_read = esp_http_client_read(handle->http_client, handle->header_buf + handle->header_len,
+                                             sizeof(handle->header_buf) - handle->header_len);
+        if (data_read <= 0) {
+            break;
+        }
+        handle->header_len += data_read;
+    }
+    if (!ota_decompress_is_compressed(handle->header_buf, handle->header_len)) {
+        return ESP_OK;
+    }
+    if (handle->header_len < OTA_COMPRESSED_HEADER_SIZE) {
+        ESP_LOGE(TAG, "Compressed image header is incomplete");
+        return ESP_FAIL;
+    }
+    esp_err_t err = ota_decompress_init(handle->header_buf, &handle->decompress);
+    if (err != ESP_OK) {
+        return err;
+    }
+    handle->header_len = 0;
+    handle->compressed_buf = malloc(handle->ota_upgrade_buf_size);
+    if (!handle->compressed_buf) {
+        ESP_LOGE(TAG, "Couldn't allocate memory to compressed data buffer");
+        ota_decompress_deinit(handle->decompress);
+        handle->decompress = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Image is compressed, %d bytes uncompressed", ota_decompress_get_image_size(handle->decompress));
+    return ESP_OK;
+}
+
 static esp_err_t _ota_write(esp_https_ota_t *https_ota_handle, const void *buffer, size_t buf_len)
 {
     if (buffer == NULL || https_ota_handle == NULL) {
@@ -197,6 +282,12 @@ esp_err_t esp_https_ota_begin(esp_https_ota_config_t *ota_config, esp_https_ota_
     }
     https_ota_handle->ota_upgrade_buf_size = alloc_size;
 
+    err = _read_image_header(https_ota_handle);
+    if (err != ESP_OK) {
+        free(https_ota_handle->ota_upgrade_buf);
+        goto http_cleanup;
+    }
+
     https_ota_handle->binary_file_len = 0;
     *handle = (esp_https_ota_handle_t)https_ota_handle;
     https_ota_handle->state = ESP_HTTPS_OTA_BEGIN;
@@ -232,9 +323,10 @@ esp_err_t esp_https_ota_get_img_desc(esp_https_ota_handle_t https_ota_handle, es
      * are not sent in a single packet.
      */
     while (data_read_size > 0 && !esp_https_ota_is_complete_data_received(https_ota_handle)) {
-        data_read = esp_http_client_read(handle->http_client,
-                                          (handle->ota_upgrade_buf + bytes_read),
-                                          data_read_size);
+        data_read = _ota_read(handle, (handle->ota_upgrade_buf + bytes_read), data_read_size);
+        if (data_read < 0) {
+            break;
+        }
         /*
          * As esp_http_client_read never returns negative error code, we rely on
          * `errno` to check for underlying transport connectivity closure if any
@@ -271,7 +363,10 @@ esp_err_t esp_https_ota_perform(esp_https_ota_handle_t https_ota_handle)
     int data_read;
     switch (handle->state) {
         case ESP_HTTPS_OTA_BEGIN:
-            err = esp_ota_begin(handle->update_partition, OTA_SIZE_UNKNOWN, &handle->update_handle);
+            /* The size of a compressed image is known in advance, erase only what it needs */
+            err = esp_ota_begin(handle->update_partition,
+                                handle->decompress ? ota_decompress_get_image_size(handle->decompress) : OTA_SIZE_UNKNOWN,
+                                &handle->update_handle);
             if (err != ESP_OK) {
                 ESP_LOGE(TAG, "esp_ota_begin failed (%s)", esp_err_to_name(err));
                 return err;
@@ -285,10 +380,11 @@ esp_err_t esp_https_ota_perform(esp_https_ota_handle_t https_ota_handle)
             }
             /* falls through */
         case ESP_HTTPS_OTA_IN_PROGRESS:
-            data_read = esp_http_client_read(handle->http_client,
-                                             handle->ota_upgrade_buf,
-                                             handle->ota_upgrade_buf_size);
-            if (data_read == 0) {
+            data_read = _ota_read(handle, handle->ota_upgrade_buf, handle->ota_upgrade_buf_size);
+            if (data_read < 0) {
+                ESP_LOGE(TAG, "Compressed image is corrupted");
+                return ESP_ERR_OTA_VALIDATE_FAILED;
+            } else if (data_read == 0) {
                 /*
                  *  esp_https_ota_is_complete_data_received is added to check whether
                  *  complete image is received.
@@ -308,7 +404,10 @@ esp_err_t esp_https_ota_perform(esp_https_ota_handle_t https_ota_handle)
                     return ESP_ERR_HTTPS_OTA_IN_PROGRESS;
                 }
                 ESP_LOGI(TAG, "Connection closed");
-            } else if (data_read > 0) {
+                if (handle->decompress && ota_decompress_check(handle->decompress) != ESP_OK) {
+                    return ESP_ERR_OTA_VALIDATE_FAILED;
+                }
+            } else {
                 return _ota_write(handle, (const void *)handle->ota_upgrade_buf, data_read);
             }
             handle->state = ESP_HTTPS_OTA_SUCCESS;
@@ -347,6 +446,8 @@ esp_err_t esp_https_ota_finish(esp_https_ota_handle_t https_ota_handle)
             if (handle->ota_upgrade_buf) {
                 free(handle->ota_upgrade_buf);
             }
+            free(handle->compressed_buf);
+            ota_decompress_deinit(handle->decompress);
             if (handle->http_client) {
                 _http_cleanup(handle->http_client);
             }
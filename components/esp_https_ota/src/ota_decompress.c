@@ -0,0 +1,230 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_crc.h"
+#include "ota_decompress.h"
+
+#define HEADER_MAGIC    "ESPZ"
+#define HEADER_VERSION  1
+
+static const char *TAG = "ota_decompress";
+
+typedef enum {
+    STATE_TAG,
+    STATE_LITERAL,
+    STATE_INDEX,
+    STATE_COUNT,
+    STATE_COPY,
+} decompress_state_t;
+
+struct ota_decompress {
+    uint8_t codec;
+    uint8_t window_bits;
+    uint8_t lookahead_bits;
+    decompress_state_t state;
+    uint32_t bits;          /* bit buffer, the lowest bit_count bits are not consumed yet */
+    uint8_t bit_count;
+    uint16_t index;         /* distance of the copy in progress */
+    uint16_t count;         /* bytes left of the copy in progress */
+    uint32_t image_size;
+    uint32_t image_crc;
+    uint32_t written;
+    uint32_t crc;
+    uint32_t window_mask;
+    uint8_t *window;        /* the last (1 << window_bits) bytes of output */
+};
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool ota_decompress_is_compressed(const void *data, size_t len)
+{
+    return len >= strlen(HEADER_MAGIC) && memcmp(data, HEADER_MAGIC, strlen(HEADER_MAGIC)) == 0;
+}
+
+esp_err_t ota_decompress_init(const void *header, ota_decompress_handle_t *out_handle)
+{
+    const uint8_t *h = (const uint8_t *)header;
+    if (!ota_decompress_is_compressed(header, OTA_COMPRESSED_HEADER_SIZE) || h[4] != HEADER_VERSION) {
+        ESP_LOGE(TAG, "Unsupported compressed image version");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    uint8_t codec = h[5], window_bits = h[6], lookahead_bits = h[7];
+    if (codec == OTA_CODEC_HEATSHRINK) {
+        if (window_bits < 4 || window_bits > OTA_DECOMPRESS_MAX_WINDOW_BITS || lookahead_bits < 3 || lookahead_bits >= window_bits) {
+            ESP_LOGE(TAG, "Unsupported window (%d bits) or lookahead (%d bits)", window_bits, lookahead_bits);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    } else if (codec != OTA_CODEC_NONE) {
+        ESP_LOGE(TAG, "Unsupported codec %d", codec);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ota_decompress_handle_t d = calloc(1, sizeof(struct ota_decompress));
+    if (d == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (codec == OTA_CODEC_HEATSHRINK) {
+        d->window = calloc(1, 1 << window_bits);
+        if (d->window == NULL) {
+            free(d);
+            return ESP_ERR_NO_MEM;
+        }
+        d->window_mask = (1 << window_bits) - 1;
+    }
+    d->codec = codec;
+    d->window_bits = window_bits;
+    d->lookahead_bits = lookahead_bits;
+    d->state = STATE_TAG;
+    d->image_size = get_u32(h + 8);
+    d->image_crc = get_u32(h + 12);
+    ESP_LOGD(TAG, "Compressed image, codec %d, %d bytes uncompressed", codec, d->image_size);
+    *out_handle = d;
+    return ESP_OK;
+}
+
+/* Returns the next n bits of the stream in *value, or false if more input is needed */
+static inline bool get_bits(ota_decompress_handle_t d, const uint8_t **in, const uint8_t *end, uint8_t n, uint16_t *value)
+{
+    while (d->bit_count < n) {
+        if (*in == end) {
+            return false;
+        }
+        d->bits = (d->bits << 8) | *(*in)++;
+        d->bit_count += 8;
+    }
+    d->bit_count -= n;
+    *value = (d->bits >> d->bit_count) & ((1 << n) - 1);
+    return true;
+}
+
+static int heatshrink_run(ota_decompress_handle_t d, const uint8_t **in, const uint8_t *end, uint8_t *out, size_t out_size)
+{
+    uint8_t *const window = d->window;
+    const uint32_t mask = d->window_mask;
+    uint32_t head = d->written;
+    size_t n = 0;
+    uint16_t value;
+
+    while (n < out_size) {
+        switch (d->state) {
+        case STATE_TAG:
+            if (!get_bits(d, in, end, 1, &value)) {
+                goto out;
+            }
+            d->state = value ? STATE_LITERAL : STATE_INDEX;
+            break;
+        case STATE_LITERAL:
+            if (!get_bits(d, in, end, 8, &value)) {
+                goto out;
+            }
+            window[head++ & mask] = value;
+            out[n++] = value;
+            d->state = STATE_TAG;
+            break;
+        case STATE_INDEX:
+            if (!get_bits(d, in, end, d->window_bits, &value)) {
+                goto out;
+            }
+            d->index = value + 1;
+            d->state = STATE_COUNT;
+            break;
+        case STATE_COUNT:
+            if (!get_bits(d, in, end, d->lookahead_bits, &value)) {
+                goto out;
+            }
+            if (d->index > head) {
+                ESP_LOGE(TAG, "Copy from before the start of the image");
+                return -1;
+            }
+            d->count = value + 1;
+            d->state = STATE_COPY;
+            break;
+        case STATE_COPY: {
+            size_t len = d->count < out_size - n ? d->count : out_size - n;
+            for (size_t i = 0; i < len; i++) {
+                uint8_t c = window[(head - d->index) & mask];
+                window[head++ & mask] = c;
+                out[n++] = c;
+            }
+            d->count -= len;
+            if (d->count == 0) {
+                d->state = STATE_TAG;
+            }
+            break;
+        }
+        }
+    }
+out:
+    return n;
+}
+
+int ota_decompress_run(ota_decompress_handle_t d, const uint8_t **in, size_t *in_len, uint8_t *out, size_t out_size)
+{
+    const uint8_t *start = *in;
+    int n;
+
+    if (out_size > d->image_size - d->written) {
+        out_size = d->image_size - d->written;
+    }
+    if (d->codec == OTA_CODEC_NONE) {
+        n = *in_len < out_size ? *in_len : out_size;
+        memcpy(out, *in, n);
+        *in += n;
+    } else {
+        n = heatshrink_run(d, in, start + *in_len, out, out_size);
+        if (n < 0) {
+            return n;
+        }
+    }
+    d->crc = esp_crc32_le(d->crc, out, n);
+    d->written += n;
+    if (d->written == d->image_size) {
+        /* Whatever follows the image is padding of the bit stream */
+        *in = start + *in_len;
+    }
+    *in_len -= *in - start;
+    return n;
+}
+
+uint32_t ota_decompress_get_image_size(ota_decompress_handle_t d)
+{
+    return d->image_size;
+}
+
+esp_err_t ota_decompress_check(ota_decompress_handle_t d)
+{
+    if (d->written != d->image_size) {
+        ESP_LOGE(TAG, "Image incomplete, %d of %d bytes decompressed", d->written, d->image_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (d->crc != d->image_crc) {
+        ESP_LOGE(TAG, "Decompressed image doesn't match the checksum in the header");
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+void ota_decompress_deinit(ota_decompress_handle_t d)
+{
+    if (d) {
+        free(d->window);
+        free(d);
+    }
+}
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include "ota_decompress.h"
+
+#include "catch.hpp"
+
+typedef std::vector<uint8_t> data_t;
+
+static data_t read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    REQUIRE(f != NULL);
+    data_t data;
+    uint8_t buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + len);
+    }
+    fclose(f);
+    return data;
+}
+
+static void write_file(const char *path, const data_t &data)
+{
+    FILE *f = fopen(path, "wb");
+    REQUIRE(f != NULL);
+    REQUIRE(fwrite(data.data(), 1, data.size(), f) == data.size());
+    fclose(f);
+}
+
+static uint32_t get_u32(const data_t &data, size_t pos)
+{
+    return data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | ((uint32_t)data[pos + 3] << 24);
+}
+
+/* The loadable segments of ESP32 application ELF files in the tree are what an app image mostly consists of */
+static data_t make_app_image(void)
+{
+    const char *elf_files[] = {
+        "../../espcoredump/test/test.elf",
+        "../../../tools/esp_app_trace/test/sysview/test.elf",
+    };
+    data_t image(24, 0);
+    image[0] = 0xE9;
+    for (const char *path : elf_files) {
+        data_t elf = read_file(path);
+        uint32_t phoff = get_u32(elf, 28);
+        uint16_t phentsize = elf[42] | (elf[43] << 8);
+        uint16_t phnum = elf[44] | (elf[45] << 8);
+        for (int i = 0; i < phnum; i++) {
+            size_t ph = phoff + i * phentsize;
+            if (get_u32(elf, ph) == 1 /* PT_LOAD */) {
+                uint32_t offset = get_u32(elf, ph + 4);
+                uint32_t size = get_u32(elf, ph + 16);
+                image.insert(image.end(), elf.begin() + offset, elf.begin() + offset + size);
+            }
+        }
+    }
+    return image;
+}
+
+static data_t compress(const data_t &image, const std::string &args = "")
+{
+    write_file("image.bin", image);
+    std::string cmd = "python ../otacompress.py -q compress " + args + " image.bin -o image_compressed.bin";
+    REQUIRE(system(cmd.c_str()) == 0);
+    return read_file("image_compressed.bin");
+}
+
+/* Decompresses with input and output in chunks of varying size, like esp_https_ota does with HTTP reads */
+static esp_err_t decompress(const data_t &compressed, data_t &out, size_t max_chunk)
+{
+    ota_decompress_handle_t handle;
+    REQUIRE(ota_decompress_is_compressed(compressed.data(), compressed.size()));
+    REQUIRE(ota_decompress_init(compressed.data(), &handle) == ESP_OK);
+    out.clear();
+    uint8_t buf[2048];
+    size_t pos = OTA_COMPRESSED_HEADER_SIZE;
+    esp_err_t err = ESP_OK;
+    while (pos < compressed.size()) {
+        size_t chunk = std::min(compressed.size() - pos, (size_t) 1 + rand() % max_chunk);
+        const uint8_t *in = compressed.data() + pos;
+        size_t in_len = chunk;
+        while (in_len > 0) {
+            int n = ota_decompress_run(handle, &in, &in_len, buf, 1 + rand() % sizeof(buf));
+            if (n < 0) {
+                err = ESP_FAIL;
+                break;
+            }
+            out.insert(out.end(), buf, buf + n);
+        }
+        pos += chunk;
+    }
+    if (err == ESP_OK) {
+        err = ota_decompress_check(handle);
+    }
+    ota_decompress_deinit(handle);
+    return err;
+}
+
+TEST_CASE("compressed app image is decompressed from chunks of any size", "[ota_decompress]")
+{
+    data_t image = make_app_image();
+    data_t compressed = compress(image);
+    CHECK(compressed.size() < image.size() * 3 / 4);
+
+    data_t out;
+    CHECK(decompress(compressed, out, 1) == ESP_OK);
+    CHECK(out == image);
+    CHECK(decompress(compressed, out, 4096) == ESP_OK);
+    CHECK(out == image);
+}
+
+TEST_CASE("bytes transferred and decompression time per MB", "[ota_decompress][timing]")
+{
+    data_t image = make_app_image();
+    const char *configs[] = { "-w 10 -l 4", "-w 12 -l 5", "-w 14 -l 5" };
+    for (const char *args : configs) {
+        data_t compressed = compress(image, args);
+        data_t out;
+        out.reserve(image.size());
+        const int rounds = 20;
+        clock_t start = clock();
+        for (int i = 0; i < rounds; i++) {
+            REQUIRE(decompress(compressed, out, 1460) == ESP_OK);
+        }
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+        REQUIRE(out == image);
+        printf("%s: %d -> %d bytes transferred (%.1f%%), %.1f ms CPU per MB of image\n", args,
+               (int)image.size(), (int)compressed.size(), 100.0 * compressed.size() / image.size(),
+               seconds * 1000 / rounds / (image.size() / 1048576.0));
+    }
+}
+
+TEST_CASE("truncated or corrupted compressed image is detected", "[ota_decompress]")
+{
+    data_t image = make_app_image();
+    data_t compressed = compress(image);
+    data_t out;
+
+    data_t truncated(compressed.begin(), compressed.end() - 100);
+    CHECK(decompress(truncated, out, 1000) == ESP_ERR_INVALID_SIZE);
+
+    data_t corrupted(compressed);
+    corrupted[corrupted.size() / 2] ^= 0x10;
+    CHECK(decompress(corrupted, out, 1000) != ESP_OK);
+}
+
+TEST_CASE("only images with a supported header are decompressed", "[ota_decompress]")
+{
+    data_t image = make_app_image();
+    CHECK_FALSE(ota_decompress_is_compressed(image.data(), image.size()));
+
+    data_t compressed = compress(image);
+    ota_decompress_handle_t handle;
+    data_t header(compressed.begin(), compressed.begin() + OTA_COMPRESSED_HEADER_SIZE);
+    header[5] = 0x7f; /* codec */
+    CHECK(ota_decompress_init(header.data(), &handle) == ESP_ERR_NOT_SUPPORTED);
+    header[5] = OTA_CODEC_HEATSHRINK;
+    header[6] = OTA_DECOMPRESS_MAX_WINDOW_BITS + 1;
+    CHECK(ota_decompress_init(header.data(), &handle) == ESP_ERR_NOT_SUPPORTED);
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
+
+#include "catch.hpp"
+
+#define STREAM_SIZE     (4 * 1024 * 1024)
+#define MAX_ITEM_SIZE   128
+
+static double time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The producer sends a byte stream where each byte is the low byte of its offset, in items of varying size */
+struct stream_context {
+    RingbufHandle_t buf;
+    RingbufferType_t type;
+    size_t received;
+    bool corrupted;
+    SemaphoreHandle_t done;
+};
+
+static void check_data(stream_context *ctx, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *) data;
+    for (size_t i = 0; i < size; i++) {
+        if (p[i] != (uint8_t) (ctx->received + i)) {
+            ctx->corrupted = true;
+        }
+    }
+    ctx->received += size;
+}
+
+static void producer(void *arg)
+{
+    stream_context *ctx = (stream_context *) arg;
+    uint8_t item[MAX_ITEM_SIZE];
+    size_t sent = 0;
+    for (int n = 0; sent < STREAM_SIZE; n++) {
+        size_t size = 1 + (n * 37) % MAX_ITEM_SIZE;
+        if (size > STREAM_SIZE - sent) {
+            size = STREAM_SIZE - sent;
+        }
+        for (size_t i = 0; i < size; i++) {
+            item[i] = (uint8_t) (sent + i);
+        }
+        xRingbufferSend(ctx->buf, item, size, portMAX_DELAY);
+        sent += size;
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void consumer(void *arg)
+{
+    stream_context *ctx = (stream_context *) arg;
+    while (ctx->received < STREAM_SIZE) {
+        if (ctx->type == RINGBUF_TYPE_ALLOWSPLIT) {
+            void *head, *tail;
+            size_t head_size, tail_size;
+            xRingbufferReceiveSplit(ctx->buf, &head, &tail, &head_size, &tail_size, portMAX_DELAY);
+            check_data(ctx, head, head_size);
+            vRingbufferReturnItem(ctx->buf, head);
+            if (tail != NULL) {
+                check_data(ctx, tail, tail_size);
+                vRingbufferReturnItem(ctx->buf, tail);
+            }
+        } else {
+            size_t size;
+            void *data = xRingbufferReceive(ctx->buf, &size, portMAX_DELAY);
+            check_data(ctx, data, size);
+            vRingbufferReturnItem(ctx->buf, data);
+        }
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("ring buffer throughput between tasks", "[ringbuf][timing]")
+{
+    const struct {
+        RingbufferType_t type;
+        const char *name;
+    } types[] = {
+        { RINGBUF_TYPE_NOSPLIT, "no-split" },
+        { RINGBUF_TYPE_ALLOWSPLIT, "allow-split" },
+        { RINGBUF_TYPE_BYTEBUF, "byte buffer" },
+    };
+    for (auto &t : types) {
+        for (int consumer_core = 0; consumer_core < portNUM_PROCESSORS; consumer_core++) {
+            stream_context ctx = { xRingbufferCreate(1024, t.type), t.type, 0, false, xSemaphoreCreateCounting(2, 0) };
+            REQUIRE(ctx.buf != NULL);
+            double start = time_s();
+            REQUIRE(xTaskCreatePinnedToCore(consumer, "consumer", 2048, &ctx, 6, NULL, consumer_core) == pdPASS);
+            REQUIRE(xTaskCreatePinnedToCore(producer, "producer", 2048, &ctx, 6, NULL, 0) == pdPASS);
+            REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+            REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+            double seconds = time_s() - start;
+            CHECK(ctx.received == STREAM_SIZE);
+            CHECK_FALSE(ctx.corrupted);
+            printf("%s, producer on core 0, consumer on core %d: %.1f MB/s\n", t.name, consumer_core,
+                   STREAM_SIZE / seconds / (1024 * 1024));
+            vRingbufferDelete(ctx.buf);
+            vSemaphoreDelete(ctx.done);
+        }
+    }
+}
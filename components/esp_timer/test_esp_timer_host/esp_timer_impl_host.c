@@ -0,0 +1,162 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+#include "esp_timer_impl.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+/**
+ * @file esp_timer_impl_host.c
+ * @brief Implementation of chip-specific part of esp_timer for the FreeRTOS POSIX port
+ *
+ * The counter is CLOCK_MONOTONIC. An alarm thread waits for the alarm time and
+ * then delivers the alarm interrupt to core 0 with vPortSimulateInterrupt(),
+ * like the timer interrupt allocated on the PRO CPU on the target.
+ */
+
+/* Shortest period the alarm thread can keep up with under host scheduling */
+#define MIN_PERIOD_US   50
+
+static intr_handler_t s_alarm_handler;
+static portMUX_TYPE s_time_update_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* s_lock protects the alarm state below, it is never held while the alarm interrupt runs */
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_alarm_changed;
+static pthread_t s_alarm_thread;
+static bool s_running;
+static uint64_t s_alarm = UINT64_MAX;
+static int64_t s_start_us;
+
+static int64_t monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint64_t esp_timer_impl_get_counter_reg(void)
+{
+    return monotonic_us() - __atomic_load_n(&s_start_us, __ATOMIC_RELAXED);
+}
+
+int64_t esp_timer_impl_get_time(void)
+{
+    return esp_timer_impl_get_counter_reg();
+}
+
+int64_t esp_timer_get_time(void) __attribute__((alias("esp_timer_impl_get_time")));
+
+uint64_t esp_timer_impl_get_alarm_reg(void)
+{
+    pthread_mutex_lock(&s_lock);
+    uint64_t alarm = s_alarm;
+    pthread_mutex_unlock(&s_lock);
+    return alarm;
+}
+
+void esp_timer_impl_set_alarm(uint64_t timestamp)
+{
+    pthread_mutex_lock(&s_lock);
+    s_alarm = timestamp;
+    pthread_cond_signal(&s_alarm_changed);
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void *alarm_thread(void *arg)
+{
+    pthread_mutex_lock(&s_lock);
+    while (s_running) {
+        if (s_alarm == UINT64_MAX) {
+            pthread_cond_wait(&s_alarm_changed, &s_lock);
+            continue;
+        }
+        int64_t alarm_us = s_start_us + s_alarm;
+        if (monotonic_us() < alarm_us) {
+            struct timespec abstime = {
+                .tv_sec = alarm_us / 1000000,
+                .tv_nsec = (alarm_us % 1000000) * 1000,
+            };
+            pthread_cond_timedwait(&s_alarm_changed, &s_lock, &abstime);
+            continue;
+        }
+        /* Like the target the alarm fires once, esp_timer sets the next one from its task */
+        s_alarm = UINT64_MAX;
+        pthread_mutex_unlock(&s_lock);
+        vPortSimulateInterrupt(0, s_alarm_handler, NULL);
+        pthread_mutex_lock(&s_lock);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return NULL;
+}
+
+void esp_timer_impl_update_apb_freq(uint32_t apb_ticks_per_us)
+{
+}
+
+void esp_timer_impl_advance(int64_t time_diff_us)
+{
+    pthread_mutex_lock(&s_lock);
+    __atomic_sub_fetch(&s_start_us, time_diff_us, __ATOMIC_RELAXED);
+    pthread_cond_signal(&s_alarm_changed);
+    pthread_mutex_unlock(&s_lock);
+}
+
+esp_err_t esp_timer_impl_init(intr_handler_t alarm_handler)
+{
+    pthread_condattr_t attr;
+
+    s_alarm_handler = alarm_handler;
+    s_alarm = UINT64_MAX;
+    s_start_us = monotonic_us();
+    s_running = true;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s_alarm_changed, &attr);
+    pthread_condattr_destroy(&attr);
+    if (pthread_create(&s_alarm_thread, NULL, alarm_thread, NULL) != 0) {
+        pthread_cond_destroy(&s_alarm_changed);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void esp_timer_impl_deinit(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_running = false;
+    pthread_cond_signal(&s_alarm_changed);
+    pthread_mutex_unlock(&s_lock);
+    pthread_join(s_alarm_thread, NULL);
+    pthread_cond_destroy(&s_alarm_changed);
+}
+
+uint64_t esp_timer_impl_get_min_period_us(void)
+{
+    return MIN_PERIOD_US;
+}
+
+void esp_timer_impl_lock(void)
+{
+    portENTER_CRITICAL(&s_time_update_lock);
+}
+
+void esp_timer_impl_unlock(void)
+{
+    portEXIT_CRITICAL(&s_time_update_lock);
+}
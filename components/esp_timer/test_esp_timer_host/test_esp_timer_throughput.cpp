@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+#include "catch.hpp"
+
+static void init_esp_timer(void)
+{
+    /* esp_timer stays initialized for the following test cases */
+    esp_err_t err = esp_timer_init();
+    REQUIRE((err == ESP_OK || err == ESP_ERR_INVALID_STATE));
+}
+
+static esp_timer_handle_t create_timer(esp_timer_cb_t callback, void *arg)
+{
+    esp_timer_create_args_t args = {
+        .callback = callback,
+        .arg = arg,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "test",
+    };
+    esp_timer_handle_t timer;
+    REQUIRE(esp_timer_create(&args, &timer) == ESP_OK);
+    return timer;
+}
+
+struct fire_log {
+    std::vector<int64_t> times;
+    size_t expected;
+    SemaphoreHandle_t done;
+};
+
+static void log_fire(void *arg)
+{
+    fire_log *log = (fire_log *) arg;
+    log->times.push_back(esp_timer_get_time());
+    if (log->times.size() == log->expected) {
+        xSemaphoreGive(log->done);
+    }
+}
+
+TEST_CASE("one-shot timers fire in order and not before their timeout", "[esp_timer]")
+{
+    init_esp_timer();
+    const uint64_t timeouts[] = { 30000, 10000, 20000, 5000 };
+    const size_t count = sizeof(timeouts) / sizeof(timeouts[0]);
+    fire_log logs[count];
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(count, 0);
+    esp_timer_handle_t timers[count];
+
+    int64_t start = esp_timer_get_time();
+    for (size_t i = 0; i < count; i++) {
+        logs[i].expected = 1;
+        logs[i].done = done;
+        timers[i] = create_timer(log_fire, &logs[i]);
+        REQUIRE(esp_timer_start_once(timers[i], timeouts[i]) == ESP_OK);
+    }
+    for (size_t i = 0; i < count; i++) {
+        REQUIRE(xSemaphoreTake(done, 1000) == pdTRUE);
+    }
+    for (size_t i = 0; i < count; i++) {
+        REQUIRE(logs[i].times.size() == 1);
+        CHECK(logs[i].times[0] >= start + (int64_t) timeouts[i]);
+        printf("%6llu us timeout fired %lld us late\n", (unsigned long long) timeouts[i],
+               (long long) (logs[i].times[0] - start - timeouts[i]));
+        for (size_t j = 0; j < count; j++) {
+            if (timeouts[j] < timeouts[i]) {
+                CHECK(logs[j].times[0] <= logs[i].times[0]);
+            }
+        }
+        CHECK(esp_timer_delete(timers[i]) == ESP_OK);
+    }
+    vSemaphoreDelete(done);
+}
+
+TEST_CASE("periodic timer fires once per period", "[esp_timer]")
+{
+    init_esp_timer();
+    const uint64_t period = 1000;
+    fire_log log = { {}, 100, xSemaphoreCreateBinary() };
+    esp_timer_handle_t timer = create_timer(log_fire, &log);
+
+    int64_t start = esp_timer_get_time();
+    REQUIRE(esp_timer_start_periodic(timer, period) == ESP_OK);
+    REQUIRE(xSemaphoreTake(log.done, 1000) == pdTRUE);
+    REQUIRE(esp_timer_stop(timer) == ESP_OK);
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    /* Late firings don't shift the following alarms */
+    for (size_t i = 0; i < log.expected; i++) {
+        CHECK(log.times[i] >= start + (int64_t) ((i + 1) * period));
+    }
+    printf("%zu periods of %llu us took %lld us\n", log.expected, (unsigned long long) period, (long long) elapsed);
+    CHECK(esp_timer_stop(timer) == ESP_ERR_INVALID_STATE);
+    CHECK(esp_timer_delete(timer) == ESP_OK);
+    vSemaphoreDelete(log.done);
+}
+
+struct rearm_context {
+    esp_timer_handle_t timer;
+    uint32_t remaining;
+    SemaphoreHandle_t done;
+};
+
+static void rearm(void *arg)
+{
+    rearm_context *ctx = (rearm_context *) arg;
+    if (--ctx->remaining == 0) {
+        xSemaphoreGive(ctx->done);
+    } else {
+        esp_timer_start_once(ctx->timer, 0);
+    }
+}
+
+TEST_CASE("one-shot timer re-armed from its callback", "[esp_timer][timing]")
+{
+    init_esp_timer();
+    const uint32_t dispatches = 20000;
+    rearm_context ctx = { NULL, dispatches, xSemaphoreCreateBinary() };
+    ctx.timer = create_timer(rearm, &ctx);
+
+    int64_t start = esp_timer_get_time();
+    REQUIRE(esp_timer_start_once(ctx.timer, 0) == ESP_OK);
+    REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+    int64_t elapsed = esp_timer_get_time() - start;
+    printf("re-armed one-shot timer: %.0f dispatches/s\n", dispatches * 1e6 / elapsed);
+
+    CHECK(esp_timer_delete(ctx.timer) == ESP_OK);
+    vSemaphoreDelete(ctx.done);
+}
+
+struct start_stop_context {
+    uint32_t iterations;
+    uint32_t failures;
+    SemaphoreHandle_t done;
+};
+
+static portMUX_TYPE s_failures_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void never_called(void *arg)
+{
+}
+
+static void start_stop_task(void *arg)
+{
+    start_stop_context *ctx = (start_stop_context *) arg;
+    esp_timer_handle_t timer = create_timer(never_called, NULL);
+    for (uint32_t i = 0; i < ctx->iterations; i++) {
+        if (esp_timer_start_once(timer, 1000000) != ESP_OK || esp_timer_stop(timer) != ESP_OK) {
+            portENTER_CRITICAL(&s_failures_lock);
+            ctx->failures++;
+            portEXIT_CRITICAL(&s_failures_lock);
+        }
+    }
+    esp_timer_delete(timer);
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("timer start and stop from both cores", "[esp_timer][timing]")
+{
+    init_esp_timer();
+    /* Timers armed far in the future by other tasks, to make the list walk realistic */
+    std::vector<esp_timer_handle_t> background;
+    for (int i = 0; i < 16; i++) {
+        background.push_back(create_timer(never_called, NULL));
+        REQUIRE(esp_timer_start_once(background.back(), 10000000 + i) == ESP_OK);
+    }
+
+    for (int tasks = 1; tasks <= portNUM_PROCESSORS; tasks++) {
+        start_stop_context ctx = { 100000, 0, xSemaphoreCreateCounting(portNUM_PROCESSORS, 0) };
+        int64_t start = esp_timer_get_time();
+        for (int core = 0; core < tasks; core++) {
+            REQUIRE(xTaskCreatePinnedToCore(start_stop_task, "start_stop", 2048, &ctx, 5, NULL, core) == pdPASS);
+        }
+        for (int i = 0; i < tasks; i++) {
+            REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+        CHECK(ctx.failures == 0);
+        printf("start/stop from %d core(s): %.0f pairs/s\n", tasks, tasks * ctx.iterations * 1e6 / elapsed);
+        vSemaphoreDelete(ctx.done);
+    }
+
+    for (esp_timer_handle_t timer : background) {
+        CHECK(esp_timer_stop(timer) == ESP_OK);
+        CHECK(esp_timer_delete(timer) == ESP_OK);
+    }
+}
@@ -94,6 +94,35 @@ class ESPCoreDumpError(RuntimeError):
         super(ESPCoreDumpError, self).__init__(message)
 
 
+def lzss_decompress(data, window_bits, lookahead_bits, size):
+    """ Decompresses LZSS data in the bit stream format of heatshrink, as written by the core dump compressor
+
+    A set bit is followed by a literal byte. A clear bit is followed by the distance minus one
+    (window_bits) and the length minus one (lookahead_bits) of a copy from the data decompressed
+    so far. All fields are stored most significant bit first. Decompression stops after size bytes,
+    what follows is padding of the last byte.
+    """
+    bits = ''.join(format(b, '08b') for b in bytearray(data))
+    out = bytearray()
+    pos = 0
+    while len(out) < size:
+        literal = pos < len(bits) and bits[pos] == '1'
+        end = pos + 9 if literal else pos + 1 + window_bits + lookahead_bits
+        if end > len(bits):
+            raise ESPCoreDumpError("Compressed core dump is truncated")
+        if literal:
+            out.append(int(bits[pos + 1:end], 2))
+        else:
+            distance = int(bits[pos + 1:pos + 1 + window_bits], 2) + 1
+            length = int(bits[pos + 1 + window_bits:end], 2) + 1
+            if distance > len(out):
+                raise ESPCoreDumpError("Compressed core dump is corrupted")
+            for _ in range(length):
+                out.append(out[-distance])
+        pos = end
+    return bytes(out[:size])
+
+
 class BinStruct(object):
     """Binary structure representation
 
@@ -605,6 +634,8 @@ class ESPCoreDumpLoader(ESPCoreDumpVersion):
     ESP_COREDUMP_VERSION_BIN_V2 = ESPCoreDumpVersion.make_dump_ver(0, 2)
     ESP_COREDUMP_VERSION_ELF_CRC32 = ESPCoreDumpVersion.make_dump_ver(1, 0)
     ESP_COREDUMP_VERSION_ELF_SHA256 = ESPCoreDumpVersion.make_dump_ver(1, 1)
+    ESP_COREDUMP_VERSION_ELF_LZSS_CRC32 = ESPCoreDumpVersion.make_dump_ver(2, 0)
+    ESP_COREDUMP_VERSION_ELF_LZSS_SHA256 = ESPCoreDumpVersion.make_dump_ver(2, 1)
     ESP_CORE_DUMP_INFO_TYPE = 8266
     ESP_CORE_DUMP_TASK_INFO_TYPE = 678
     ESP_CORE_DUMP_EXTRA_INFO_TYPE = 677
@@ -613,6 +644,11 @@ class ESPCoreDumpLoader(ESPCoreDumpVersion):
     ESP_COREDUMP_BIN_V1_HDR_SZ = struct.calcsize(ESP_COREDUMP_BIN_V1_HDR_FMT)
     ESP_COREDUMP_HDR_FMT = '<5L'
     ESP_COREDUMP_HDR_SZ = struct.calcsize(ESP_COREDUMP_HDR_FMT)
+    # compressed ELF header: uncompressed length, window bits, lookahead bits
+    ESP_COREDUMP_LZSS_HDR_FMT = '<LBBH'
+    ESP_COREDUMP_LZSS_HDR_SZ = struct.calcsize(ESP_COREDUMP_LZSS_HDR_FMT)
+    # length of compressed dumps printed to UART
+    ESP_COREDUMP_LENGTH_UNKNOWN = 0xffffffff
     ESP_COREDUMP_TSK_HDR_FMT = '<3L'
     ESP_COREDUMP_TSK_HDR_SZ = struct.calcsize(ESP_COREDUMP_TSK_HDR_FMT)
     ESP_COREDUMP_MEM_SEG_HDR_FMT = '<2L'
@@ -764,14 +800,17 @@ class ESPCoreDumpLoader(ESPCoreDumpVersion):
         """
         core_off = off
         self.set_version(self.hdr['ver'])
-        if self.dump_ver == self.ESP_COREDUMP_VERSION_ELF_CRC32:
+        if self.dump_ver in (self.ESP_COREDUMP_VERSION_ELF_CRC32, self.ESP_COREDUMP_VERSION_ELF_LZSS_CRC32):
             checksum_len = self.ESP_COREDUMP_CRC_SZ
-        elif self.dump_ver == self.ESP_COREDUMP_VERSION_ELF_SHA256:
+        elif self.dump_ver in (self.ESP_COREDUMP_VERSION_ELF_SHA256, self.ESP_COREDUMP_VERSION_ELF_LZSS_SHA256):
             checksum_len = self.ESP_COREDUMP_SHA256_SZ
         else:
             raise ESPCoreDumpLoaderError("Core dump version '%d' is not supported!" % self.dump_ver)
         core_elf = ESPCoreDumpElfFile()
-        data = self.read_data(core_off, self.hdr['tot_len'] - checksum_len - self.ESP_COREDUMP_HDR_SZ)
+        if self.dump_ver in (self.ESP_COREDUMP_VERSION_ELF_LZSS_CRC32, self.ESP_COREDUMP_VERSION_ELF_LZSS_SHA256):
+            data = self._decompress_elf(core_off, checksum_len)
+        else:
+            data = self.read_data(core_off, self.hdr['tot_len'] - checksum_len - self.ESP_COREDUMP_HDR_SZ)
         with open(core_fname, 'w+b') as fce:
             try:
                 fce.write(data)
@@ -801,6 +840,21 @@ class ESPCoreDumpLoader(ESPCoreDumpVersion):
                 logging.warning("Failed to extract ELF core dump image into file %s. (Reason: %s)" % (core_fname, e))
         return core_fname
 
+    def _decompress_elf(self, off, checksum_len):
+        """ Reads the compressed ELF that follows the core dump header and decompresses it
+        """
+        data = self.read_data(off, self.ESP_COREDUMP_LZSS_HDR_SZ)
+        elf_len, window_bits, lookahead_bits, _ = struct.unpack_from(self.ESP_COREDUMP_LZSS_HDR_FMT, data)
+        off += self.ESP_COREDUMP_LZSS_HDR_SZ
+        if self.hdr['tot_len'] == self.ESP_COREDUMP_LENGTH_UNKNOWN:
+            # printed to UART before the length was known, the checksum ends the dump
+            data = self.read_data(off, -1)[:-checksum_len]
+        else:
+            data = self.read_data(off, self.hdr['tot_len'] - checksum_len - self.ESP_COREDUMP_HDR_SZ - self.ESP_COREDUMP_LZSS_HDR_SZ)
+        elf = lzss_decompress(data, window_bits, lookahead_bits, elf_len)
+        logging.debug("Decompressed ELF %d -> %d bytes", len(data), len(elf))
+        return elf
+
     def _extract_bin_corefile(self, core_fname=None, rom_elf=None, off=0):
         """Creates core dump ELF file
         """
@@ -932,7 +986,8 @@ class ESPCoreDumpLoader(ESPCoreDumpVersion):
             core_fname = fce.name
         self.set_version(self.hdr['ver'])
         if self.chip_ver == ESPCoreDumpVersion.ESP_CORE_DUMP_CHIP_ESP32S2 or self.chip_ver == ESPCoreDumpVersion.ESP_CORE_DUMP_CHIP_ESP32:
-            if self.dump_ver == self.ESP_COREDUMP_VERSION_ELF_CRC32 or self.dump_ver == self.ESP_COREDUMP_VERSION_ELF_SHA256:
+            if self.dump_ver in (self.ESP_COREDUMP_VERSION_ELF_CRC32, self.ESP_COREDUMP_VERSION_ELF_SHA256,
+                                 self.ESP_COREDUMP_VERSION_ELF_LZSS_CRC32, self.ESP_COREDUMP_VERSION_ELF_LZSS_SHA256):
                 return self._extract_elf_corefile(core_fname, off + self.ESP_COREDUMP_HDR_SZ, exe_name)
             elif self.dump_ver == self.ESP_COREDUMP_VERSION_BIN_V2:
                 return self._extract_bin_corefile(core_fname, rom_elf, off + self.ESP_COREDUMP_HDR_SZ)
@@ -1160,18 +1215,23 @@ class ESPCoreDumpFlashLoader(ESPCoreDumpLoader):
         self.set_version(coredump_ver_data)
         if self.chip_ver != ESPCoreDumpVersion.ESP_CORE_DUMP_CHIP_ESP32S2 and self.chip_ver != ESPCoreDumpVersion.ESP_CORE_DUMP_CHIP_ESP32:
             raise ESPCoreDumpLoaderError("Invalid core dump chip version: '%s', should be <= '0x%x'" % (self.chip_ver, self.ESP_CORE_DUMP_CHIP_ESP32S2))
-        if self.dump_ver == self.ESP_COREDUMP_VERSION_ELF_CRC32 or self.dump_ver == self.ESP_COREDUMP_VERSION_BIN_V1 \
-                or self.dump_ver == self.ESP_COREDUMP_VERSION_BIN_V2:
+        # the length of compressed dumps is written last and is not covered by the checksum
+        if self.dump_ver in (self.ESP_COREDUMP_VERSION_ELF_LZSS_CRC32, self.ESP_COREDUMP_VERSION_ELF_LZSS_SHA256):
+            cs_start = self.ESP_COREDUMP_FLASH_LEN_SZ
+        else:
+            cs_start = 0
+        if self.dump_ver in (self.ESP_COREDUMP_VERSION_ELF_CRC32, self.ESP_COREDUMP_VERSION_ELF_LZSS_CRC32,
+                             self.ESP_COREDUMP_VERSION_BIN_V1, self.ESP_COREDUMP_VERSION_BIN_V2):
             logging.debug("Dump size = %d, crc off = 0x%x", self.dump_sz, self.dump_sz - self.ESP_COREDUMP_CRC_SZ)
             data = self.read_data(self.dump_sz - self.ESP_COREDUMP_CRC_SZ, self.ESP_COREDUMP_CRC_SZ)
             dump_crc, = struct.unpack_from(self.ESP_COREDUMP_CRC_FMT, data)
-            data = self.read_data(0, self.dump_sz - self.ESP_COREDUMP_CRC_SZ)
+            data = self.read_data(cs_start, self.dump_sz - cs_start - self.ESP_COREDUMP_CRC_SZ)
             data_crc = binascii.crc32(data) & 0xffffffff
             if dump_crc != data_crc:
                 raise ESPCoreDumpLoaderError("Invalid core dump CRC %x, should be %x" % (data_crc, dump_crc))
-        elif self.dump_ver == self.ESP_COREDUMP_VERSION_ELF_SHA256:
+        elif self.dump_ver in (self.ESP_COREDUMP_VERSION_ELF_SHA256, self.ESP_COREDUMP_VERSION_ELF_LZSS_SHA256):
             dump_sha256 = self.read_data(self.dump_sz - self.ESP_COREDUMP_SHA256_SZ, self.ESP_COREDUMP_SHA256_SZ)
-            data = self.read_data(0, self.dump_sz - self.ESP_COREDUMP_SHA256_SZ)
+            data = self.read_data(cs_start, self.dump_sz - cs_start - self.ESP_COREDUMP_SHA256_SZ)
             data_sha256 = sha256(data)
             data_sha256_str = data_sha256.hexdigest()
             dump_sha256_str = binascii.hexlify(dump_sha256).decode('ascii')
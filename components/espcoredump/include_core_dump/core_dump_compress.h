@@ -0,0 +1,63 @@
+// Copyright 2015-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef ESP_CORE_DUMP_COMPRESS_H_
+#define ESP_CORE_DUMP_COMPRESS_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LZSS in the bit stream format of heatshrink: a set bit is followed by a literal byte, a clear bit by
+// the distance minus one (window bits) and the length minus one (lookahead bits) of a copy from the
+// data decompressed so far. All fields are stored most significant bit first.
+#define COREDUMP_COMPRESS_WINDOW_BITS       10
+#define COREDUMP_COMPRESS_LOOKAHEAD_BITS    6
+
+typedef esp_err_t (*core_dump_compress_out_t)(void *priv, void *data, uint32_t data_len);
+
+/** compressed ELF header, follows the core dump header uncompressed */
+typedef struct _core_dump_compress_header_t
+{
+    uint32_t elf_len;           // ELF length after decompression
+    uint8_t  window_bits;       // log2 of the largest copy distance
+    uint8_t  lookahead_bits;    // log2 of the longest copy
+    uint16_t reserved;
+} core_dump_compress_header_t;
+
+/**
+ * Write the compressed ELF header and start compressing. The compressed data is passed to out,
+ * which has the signature of the core dump backend write function.
+ */
+esp_err_t esp_core_dump_compress_start(core_dump_compress_out_t out, void *out_priv, uint32_t elf_len);
+
+/**
+ * Compress the next part of the ELF. Has the signature of the core dump backend write function,
+ * so it can be put between the ELF writer and the backend. priv is not used.
+ */
+esp_err_t esp_core_dump_compress_write(void *priv, void *data, uint32_t data_len);
+
+/**
+ * Compress and output the data still buffered. Returns the number of compressed bytes written
+ * since esp_core_dump_compress_start() in out_len.
+ */
+esp_err_t esp_core_dump_compress_finish(uint32_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
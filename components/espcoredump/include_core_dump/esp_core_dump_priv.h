@@ -45,25 +45,45 @@ extern "C" {
 #define COREDUMP_VERSION_MAKE(_maj_, _min_)    ((((COREDUMP_VERSION_CHIP)&0xFFFF) << 16) | (((_maj_)&0xFF) << 8) | (((_min_)&0xFF) << 0))
 #define COREDUMP_VERSION_BIN                0
 #define COREDUMP_VERSION_ELF                1
+#define COREDUMP_VERSION_ELF_LZSS           2
 // legacy bin coredumps (before IDF v4.1) has version set to 1
 #define COREDUMP_VERSION_BIN_LEGACY         COREDUMP_VERSION_MAKE(COREDUMP_VERSION_BIN, 1) // -> 0x0001
 #define COREDUMP_VERSION_BIN_CURRENT        COREDUMP_VERSION_MAKE(COREDUMP_VERSION_BIN, 2) // -> 0x0002
 #define COREDUMP_VERSION_ELF_CRC32          COREDUMP_VERSION_MAKE(COREDUMP_VERSION_ELF, 0) // -> 0x0100
 #define COREDUMP_VERSION_ELF_SHA256         COREDUMP_VERSION_MAKE(COREDUMP_VERSION_ELF, 1) // -> 0x0101
+#define COREDUMP_VERSION_ELF_LZSS_CRC32     COREDUMP_VERSION_MAKE(COREDUMP_VERSION_ELF_LZSS, 0) // -> 0x0200
+#define COREDUMP_VERSION_ELF_LZSS_SHA256    COREDUMP_VERSION_MAKE(COREDUMP_VERSION_ELF_LZSS, 1) // -> 0x0201
 #define COREDUMP_CURR_TASK_MARKER           0xDEADBEEF
 #define COREDUMP_CURR_TASK_NOT_FOUND        -1
 
 #if CONFIG_ESP32_COREDUMP_DATA_FORMAT_ELF
 #if CONFIG_ESP32_COREDUMP_CHECKSUM_CRC32
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+#define COREDUMP_VERSION                    COREDUMP_VERSION_ELF_LZSS_CRC32
+#else
 #define COREDUMP_VERSION                    COREDUMP_VERSION_ELF_CRC32
+#endif
 #elif CONFIG_ESP32_COREDUMP_CHECKSUM_SHA256
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+#define COREDUMP_VERSION                    COREDUMP_VERSION_ELF_LZSS_SHA256
+#else
 #define COREDUMP_VERSION                    COREDUMP_VERSION_ELF_SHA256
+#endif
 #define COREDUMP_SHA256_LEN                 32
 #endif
 #else
 #define COREDUMP_VERSION                    COREDUMP_VERSION_BIN_CURRENT
 #endif
 
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+// The length of a compressed dump is only known when all of it has been written, so the backend
+// stores it last (flash) or leaves it unset (UART). It is not covered by the checksum.
+#define COREDUMP_CHECKSUM_START             sizeof(uint32_t)
+#define COREDUMP_LENGTH_UNKNOWN             0xFFFFFFFF
+#else
+#define COREDUMP_CHECKSUM_START             0
+#endif
+
 typedef esp_err_t (*esp_core_dump_write_prepare_t)(void *priv, uint32_t *data_len);
 typedef esp_err_t (*esp_core_dump_write_start_t)(void *priv);
 typedef esp_err_t (*esp_core_dump_write_end_t)(void *priv);
@@ -0,0 +1,171 @@
+// Copyright 2015-2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stdbool.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "core_dump_compress.h"
+
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+
+#define WINDOW_SIZE     (1 << COREDUMP_COMPRESS_WINDOW_BITS)
+#define MAX_LEN         (1 << COREDUMP_COMPRESS_LOOKAHEAD_BITS)
+// shorter copies don't take fewer bits than literals
+#define MIN_LEN         3
+#define HASH_BITS       9
+#define OUT_BUF_SIZE    64
+
+// Core dumps are written from the panic handler, so all the state is static
+static struct {
+    core_dump_compress_out_t out;
+    void *out_priv;
+    esp_err_t err;
+    uint32_t fill;                      // bytes in buf
+    uint32_t pos;                       // next byte of buf to compress, what precedes it is the window
+    uint32_t bits;                      // output bits not written yet, the lowest bit_count bits
+    uint32_t bit_count;
+    uint32_t out_len;                   // compressed bytes in out_buf
+    uint32_t out_total;
+    uint16_t head[1 << HASH_BITS];      // last position + 1 with each hash, 0 if none
+    uint8_t buf[2 * WINDOW_SIZE];
+    uint8_t out_buf[OUT_BUF_SIZE];
+} s_comp;
+
+static inline uint32_t hash3(const uint8_t *p)
+{
+    uint32_t v = (p[0] << 16) | (p[1] << 8) | p[2];
+    return (v * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static void flush_out(void)
+{
+    if (s_comp.out_len > 0 && s_comp.err == ESP_OK) {
+        s_comp.err = s_comp.out(s_comp.out_priv, s_comp.out_buf, s_comp.out_len);
+    }
+    s_comp.out_total += s_comp.out_len;
+    s_comp.out_len = 0;
+}
+
+static inline void put_bits(uint32_t value, uint32_t count)
+{
+    s_comp.bits = (s_comp.bits << count) | value;
+    s_comp.bit_count += count;
+    while (s_comp.bit_count >= 8) {
+        s_comp.bit_count -= 8;
+        s_comp.out_buf[s_comp.out_len++] = s_comp.bits >> s_comp.bit_count;
+        if (s_comp.out_len == OUT_BUF_SIZE) {
+            flush_out();
+        }
+    }
+    s_comp.bits &= (1 << s_comp.bit_count) - 1;
+}
+
+// Compresses while there is a full lookahead of input, or all of the input when flushing
+static void compress(bool flush)
+{
+    uint8_t *const buf = s_comp.buf;
+
+    while (s_comp.pos < s_comp.fill && (flush || s_comp.fill - s_comp.pos >= MAX_LEN)) {
+        uint32_t pos = s_comp.pos;
+        uint32_t avail = s_comp.fill - pos;
+        uint32_t max_len = avail < MAX_LEN ? avail : MAX_LEN;
+        uint32_t len = 0, dist = 0;
+
+        if (avail >= MIN_LEN) {
+            uint32_t h = hash3(buf + pos);
+            uint32_t cand = s_comp.head[h];
+            s_comp.head[h] = pos + 1;
+            if (cand != 0 && pos - (cand - 1) <= WINDOW_SIZE) {
+                const uint8_t *match = buf + cand - 1;
+                while (len < max_len && match[len] == buf[pos + len]) {
+                    len++;
+                }
+                dist = pos - (cand - 1);
+            }
+        }
+        if (len >= MIN_LEN) {
+            put_bits(0, 1);
+            put_bits(dist - 1, COREDUMP_COMPRESS_WINDOW_BITS);
+            put_bits(len - 1, COREDUMP_COMPRESS_LOOKAHEAD_BITS);
+            // later copies may start inside this one
+            for (uint32_t i = 1; i < len && pos + i + MIN_LEN <= s_comp.fill; i++) {
+                s_comp.head[hash3(buf + pos + i)] = pos + i + 1;
+            }
+            s_comp.pos += len;
+        } else {
+            put_bits(0x100 | buf[pos], 9);
+            s_comp.pos++;
+        }
+    }
+}
+
+// Drops the oldest half of the buffer, which is out of reach of the window
+static void slide(void)
+{
+    memmove(s_comp.buf, s_comp.buf + WINDOW_SIZE, s_comp.fill - WINDOW_SIZE);
+    s_comp.fill -= WINDOW_SIZE;
+    s_comp.pos -= WINDOW_SIZE;
+    for (int i = 0; i < (1 << HASH_BITS); i++) {
+        s_comp.head[i] = s_comp.head[i] > WINDOW_SIZE ? s_comp.head[i] - WINDOW_SIZE : 0;
+    }
+}
+
+esp_err_t esp_core_dump_compress_start(core_dump_compress_out_t out, void *out_priv, uint32_t elf_len)
+{
+    core_dump_compress_header_t hdr = {
+        .elf_len = elf_len,
+        .window_bits = COREDUMP_COMPRESS_WINDOW_BITS,
+        .lookahead_bits = COREDUMP_COMPRESS_LOOKAHEAD_BITS,
+    };
+
+    memset(&s_comp, 0, sizeof(s_comp));
+    s_comp.out = out;
+    s_comp.out_priv = out_priv;
+    return out(out_priv, &hdr, sizeof(hdr));
+}
+
+esp_err_t esp_core_dump_compress_write(void *priv, void *data, uint32_t data_len)
+{
+    const uint8_t *src = (const uint8_t *)data;
+
+    while (data_len > 0 && s_comp.err == ESP_OK) {
+        if (s_comp.fill == sizeof(s_comp.buf)) {
+            slide();
+        }
+        uint32_t len = sizeof(s_comp.buf) - s_comp.fill;
+        if (len > data_len) {
+            len = data_len;
+        }
+        memcpy(s_comp.buf + s_comp.fill, src, len);
+        s_comp.fill += len;
+        src += len;
+        data_len -= len;
+        compress(false);
+    }
+    return s_comp.err;
+}
+
+esp_err_t esp_core_dump_compress_finish(uint32_t *out_len)
+{
+    compress(true);
+    if (s_comp.bit_count > 0) {
+        put_bits(0, 8 - s_comp.bit_count);
+    }
+    flush_out();
+    if (out_len) {
+        *out_len = s_comp.out_total;
+    }
+    return s_comp.err;
+}
+
+#endif
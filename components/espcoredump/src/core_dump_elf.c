@@ -17,6 +17,7 @@
 #include "esp_ota_ops.h"
 #include "sdkconfig.h"
 #include "core_dump_elf.h"
+#include "core_dump_compress.h"
 
 #define ELF_CLASS ELFCLASS32
 
@@ -595,6 +596,9 @@ esp_err_t esp_core_dump_write_elf(void *frame, core_dump_write_config_t *write_c
     int ret = esp_core_dump_do_write_elf_pass(&self, frame, tasks, task_num);
     if (ret < 0) return ret;
     tot_len += ret;
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    uint32_t elf_len = ret;
+#endif
     ESP_COREDUMP_LOG_PROCESS("Core dump tot_len=%lu, tasks processed: %d, broken tasks: %d",
                                 tot_len, task_num, self.bad_tasks_num);
     ESP_COREDUMP_LOG_PROCESS("============== Data size = %d bytes ============", tot_len);
@@ -627,14 +631,34 @@ esp_err_t esp_core_dump_write_elf(void *frame, core_dump_write_config_t *write_c
     dump_hdr.tasks_num = task_num; // broken tasks are repaired
     dump_hdr.tcb_sz = tcb_sz;
     dump_hdr.mem_segs_num = 0;
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    // the backend has reserved the length word, it is written when the compressed length is known
+    err = write_cfg->write(write_cfg->priv,
+                            (void*)&dump_hdr.version,
+                            sizeof(core_dump_header_t) - sizeof(dump_hdr.data_len));
+#else
     err = write_cfg->write(write_cfg->priv,
                             (void*)&dump_hdr,
                             sizeof(core_dump_header_t));
+#endif
     if (err != ESP_OK) {
         ESP_COREDUMP_LOGE("Failed to write core dump header (%d)!", err);
         return err;
     }
 
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    // ELF data goes through the compressor on its way to the backend
+    static core_dump_write_config_t compress_cfg;
+    err = esp_core_dump_compress_start(write_cfg->write, write_cfg->priv, elf_len);
+    if (err != ESP_OK) {
+        ESP_COREDUMP_LOGE("Failed to write compression header (%d)!", err);
+        return err;
+    }
+    compress_cfg = *write_cfg;
+    compress_cfg.write = esp_core_dump_compress_write;
+    self.write_cfg = &compress_cfg;
+#endif
+
     self.elf_stage = ELF_STAGE_PLACE_HEADERS;
     // set initial offset to elf segments data area
     self.elf_next_data_offset = sizeof(elfhdr) + ELF_SEG_HEADERS_COUNT(&self, task_num) * sizeof(elf_phdr);
@@ -651,11 +675,21 @@ esp_err_t esp_core_dump_write_elf(void *frame, core_dump_write_config_t *write_c
     write_len += ret;
     ESP_COREDUMP_LOG_PROCESS("=========== Data written size = %d bytes ==========", write_len);
 
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    uint32_t compressed_len;
+    err = esp_core_dump_compress_finish(&compressed_len);
+    if (err != ESP_OK) {
+        ESP_COREDUMP_LOGE("Failed to write compressed data (%d)!", err);
+        return err;
+    }
+    ESP_COREDUMP_LOGI("Compressed ELF %u -> %u bytes", elf_len, compressed_len);
+#else
     // Get checksum size
     write_len += esp_core_dump_checksum_finish(write_cfg->priv, NULL);
     if (write_len != tot_len) {
         ESP_COREDUMP_LOGD("Write ELF failed (wrong length): %d != %d.", tot_len, write_len);
     }
+#endif
     // Write end, update checksum
     if (write_cfg->end) {
         err = write_cfg->end(write_cfg->priv);
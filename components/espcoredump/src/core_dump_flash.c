@@ -84,7 +84,15 @@ static esp_err_t esp_core_dump_flash_write_data(void *priv, uint8_t *data, uint3
     core_dump_write_data_t *wr_data = (core_dump_write_data_t *)priv;
     uint32_t written = 0, wr_sz;
 
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    // space is only checked up front for uncompressed dumps, compressed ones fail when they don't fit
+    if ((wr_data->off + wr_data->cached_bytes + data_size) >= s_core_flash_config.partition.size) {
+        ESP_COREDUMP_LOGE("Not enough space to save compressed core dump!");
+        return ESP_ERR_NO_MEM;
+    }
+#else
     assert((wr_data->off + data_size) < s_core_flash_config.partition.size);
+#endif
 
     if (wr_data->cached_bytes) {
         if ((sizeof(wr_data->cached_data)-wr_data->cached_bytes) > data_size)
@@ -142,6 +150,16 @@ static esp_err_t esp_core_dump_flash_write_prepare(void *priv, uint32_t *data_le
     uint32_t cs_len;
     cs_len = esp_core_dump_checksum_finish(wr_data, NULL);
 
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    // add space for checksum
+    *data_len += cs_len;
+    // LZSS stores incompressible data in 9 bits per byte, erase as much as the worst case
+    // or the whole partition if that is less
+    uint32_t erase_len = *data_len + *data_len / 8 + 16;
+    if (erase_len > s_core_flash_config.partition.size) {
+        erase_len = s_core_flash_config.partition.size;
+    }
+#else
     // check for available space in partition
     if ((*data_len + cs_len) > s_core_flash_config.partition.size) {
         ESP_COREDUMP_LOGE("Not enough space to save core dump!");
@@ -149,11 +167,13 @@ static esp_err_t esp_core_dump_flash_write_prepare(void *priv, uint32_t *data_le
     }
     // add space for checksum
     *data_len += cs_len;
+    uint32_t erase_len = *data_len;
+#endif
 
     memset(wr_data, 0, sizeof(core_dump_write_data_t));
 
-    sec_num = *data_len / SPI_FLASH_SEC_SIZE;
-    if (*data_len % SPI_FLASH_SEC_SIZE) {
+    sec_num = erase_len / SPI_FLASH_SEC_SIZE;
+    if (erase_len % SPI_FLASH_SEC_SIZE) {
         sec_num++;
     }
     ESP_COREDUMP_LOGI("Erase flash %d bytes @ 0x%x", sec_num * SPI_FLASH_SEC_SIZE, s_core_flash_config.partition.start + 0);
@@ -170,6 +190,10 @@ static esp_err_t esp_core_dump_flash_write_start(void *priv)
 {
     core_dump_write_data_t *wr_data = (core_dump_write_data_t *)priv;
     esp_core_dump_checksum_init(wr_data);
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    // leave the length word erased until the end
+    wr_data->off = COREDUMP_CHECKSUM_START;
+#endif
     return ESP_OK;
 }
 
@@ -191,12 +215,26 @@ static esp_err_t esp_core_dump_flash_write_end(void *priv)
         esp_core_dump_checksum_update(wr_data, &wr_data->cached_data, sizeof(wr_data->cached_data));
         wr_data->off += sizeof(wr_data->cached_data);
     }
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    if ((wr_data->off + cs_len) > s_core_flash_config.partition.size) {
+        ESP_COREDUMP_LOGE("Not enough space to save compressed core dump!");
+        return ESP_ERR_NO_MEM;
+    }
+#endif
     err = ESP_COREDUMP_FLASH_WRITE(s_core_flash_config.partition.start + wr_data->off, checksum, cs_len);
     if (err != ESP_OK) {
         ESP_COREDUMP_LOGE("Failed to flush cached data to flash (%d)!", err);
         return err;
     }
     wr_data->off += cs_len;
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    // the dump is valid from here on
+    err = ESP_COREDUMP_FLASH_WRITE(s_core_flash_config.partition.start + 0, &wr_data->off, sizeof(wr_data->off));
+    if (err != ESP_OK) {
+        ESP_COREDUMP_LOGE("Failed to write core dump length (%d)!", err);
+        return err;
+    }
+#endif
     ESP_COREDUMP_LOGI("Write end offset 0x%x, check sum length %d", wr_data->off, cs_len);
 #if LOG_LOCAL_LEVEL >= ESP_LOG_DEBUG
     union
@@ -319,7 +357,8 @@ esp_err_t esp_core_dump_image_get(size_t* out_addr, size_t *out_size)
     crc--; // Point to CRC field
 
     // Calculate CRC over core dump data except for CRC field
-    core_dump_crc_t cur_crc = crc32_le(0, (uint8_t const *)core_data, *out_size - sizeof(core_dump_crc_t));
+    core_dump_crc_t cur_crc = crc32_le(0, (uint8_t const *)core_data + COREDUMP_CHECKSUM_START,
+                                       *out_size - COREDUMP_CHECKSUM_START - sizeof(core_dump_crc_t));
     if (*crc != cur_crc) {
         ESP_LOGD(TAG, "Core dump CRC offset 0x%x, data size: %u",
                 (uint32_t)((uint32_t)crc - (uint32_t)core_data), *out_size);
@@ -335,7 +374,8 @@ esp_err_t esp_core_dump_image_get(size_t* out_addr, size_t *out_size)
     unsigned char sha_output[COREDUMP_SHA256_LEN];
     mbedtls_sha256_context ctx;
     ESP_LOGI(TAG, "Calculate SHA256 for coredump:");
-    (void)esp_core_dump_sha(&ctx, core_data, *out_size - COREDUMP_SHA256_LEN, sha_output);
+    (void)esp_core_dump_sha(&ctx, (uint8_t const *)core_data + COREDUMP_CHECKSUM_START,
+                            *out_size - COREDUMP_CHECKSUM_START - COREDUMP_SHA256_LEN, sha_output);
     if (memcmp((uint8_t*)sha256_ptr, (uint8_t*)sha_output, COREDUMP_SHA256_LEN) != 0) {
         ESP_LOGE(TAG, "Core dump data SHA256 check failed:");
         esp_core_dump_print_sha256("Calculated SHA256", (uint8_t*)sha_output);
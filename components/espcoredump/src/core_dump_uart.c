@@ -60,6 +60,14 @@ static esp_err_t esp_core_dump_uart_write_start(void *priv)
     core_dump_write_data_t *wr_data = (core_dump_write_data_t *)priv;
     esp_core_dump_checksum_init(wr_data);
     ets_printf(DRAM_STR("================= CORE DUMP START =================\r\n"));
+#if CONFIG_ESP32_COREDUMP_COMPRESS
+    // the compressed length is not known yet, espcoredump.py takes all the data up to the end marker
+    char buf[8 + 4];
+    uint32_t data_len = COREDUMP_LENGTH_UNKNOWN;
+    esp_core_dump_b64_encode((const uint8_t *)&data_len, sizeof(data_len), (uint8_t *)buf);
+    ets_printf(DRAM_STR("%s\r\n"), buf);
+    wr_data->off += sizeof(data_len);
+#endif
     return err;
 }
 
@@ -0,0 +1,4 @@
+# pragma once
+#define CONFIG_IDF_TARGET_ESP32 1
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+#define CONFIG_ESP32_COREDUMP_COMPRESS 1
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "core_dump_compress.h"
+#include "esp32/rom/crc.h"
+
+#include "catch.hpp"
+
+typedef std::vector<uint8_t> data_t;
+
+#define DUMP_VERSION_ELF_LZSS_CRC32     0x00000200
+#define DUMP_LENGTH_UNKNOWN             0xFFFFFFFF
+#define ELF_HDR_SIZE                    52
+#define ELF_PHDR_SIZE                   32
+#define STACK_FILL                      0xA5
+
+static void put_u32(data_t &data, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        data.push_back(value >> (8 * i));
+    }
+}
+
+static void set_u32(data_t &data, size_t pos, uint32_t value)
+{
+    for (int i = 0; i < 4; i++) {
+        data[pos + i] = value >> (8 * i);
+    }
+}
+
+static void put_u16(data_t &data, uint16_t value)
+{
+    data.push_back(value & 0xFF);
+    data.push_back(value >> 8);
+}
+
+/* Words like those on task stacks: code and data addresses, small integers and random values */
+static void put_stack_words(data_t &data, size_t len)
+{
+    for (size_t i = 0; i < len; i += 4) {
+        switch (rand() % 4) {
+        case 0:
+            put_u32(data, 0x400d0000 + (rand() % 0x8000) * 4);
+            break;
+        case 1:
+            put_u32(data, 0x3ffb0000 + (rand() % 0x4000) * 4);
+            break;
+        case 2:
+            put_u32(data, rand() % 256);
+            break;
+        default:
+            put_u32(data, rand());
+            break;
+        }
+    }
+}
+
+struct segment_t {
+    uint32_t type;
+    uint32_t vaddr;
+    data_t data;
+};
+
+/* An ELF core file laid out like esp_core_dump_write_elf does: a note segment with the registers
+ * of each task, then the TCB and the stack of each task. Stacks are mostly unused fill. */
+static data_t make_elf(int task_num, bool random_stacks = false)
+{
+    std::vector<segment_t> segs;
+    segment_t notes = { 4 /* PT_NOTE */, 0, data_t() };
+    for (int i = 0; i < task_num; i++) {
+        put_u32(notes.data, 5);      // "CORE" with the terminator
+        put_u32(notes.data, 200);
+        put_u32(notes.data, 1);      // NT_PRSTATUS
+        const char name[8] = "CORE";
+        notes.data.insert(notes.data.end(), name, name + sizeof(name));
+        put_stack_words(notes.data, 200);
+    }
+    segs.push_back(notes);
+    for (int i = 0; i < task_num; i++) {
+        segment_t tcb = { 1 /* PT_LOAD */, 0x3ffb8000 + i * 0x200u, data_t() };
+        put_stack_words(tcb.data, 356);
+        segs.push_back(tcb);
+        segment_t stack = { 1 /* PT_LOAD */, 0x3ffc0000 + i * 0x1000u, data_t() };
+        size_t stack_size = 1024 * (2 + i % 4);
+        size_t used = random_stacks ? stack_size : stack_size / 4 + rand() % (stack_size / 4);
+        if (random_stacks) {
+            for (size_t j = 0; j < stack_size; j++) {
+                stack.data.push_back(rand());
+            }
+        } else {
+            stack.data.resize(stack_size - used, STACK_FILL);
+            put_stack_words(stack.data, used);
+        }
+        segs.push_back(stack);
+    }
+
+    const uint8_t ident[16] = { 0x7f, 'E', 'L', 'F', 1 /* 32 bit */, 1 /* little endian */, 1 };
+    data_t elf(ident, ident + sizeof(ident));
+    put_u16(elf, 4);    // ET_CORE
+    put_u16(elf, 0x5E); // EM_XTENSA
+    put_u32(elf, 1);
+    put_u32(elf, 0);
+    put_u32(elf, ELF_HDR_SIZE);
+    put_u32(elf, 0);
+    put_u32(elf, 0);
+    put_u16(elf, ELF_HDR_SIZE);
+    put_u16(elf, ELF_PHDR_SIZE);
+    put_u16(elf, segs.size());
+    put_u16(elf, 0);
+    put_u16(elf, 0);
+    put_u16(elf, 0);
+    uint32_t offset = ELF_HDR_SIZE + segs.size() * ELF_PHDR_SIZE;
+    for (const segment_t &seg : segs) {
+        put_u32(elf, seg.type);
+        put_u32(elf, offset);
+        put_u32(elf, seg.vaddr);
+        put_u32(elf, seg.vaddr);
+        put_u32(elf, seg.data.size());
+        put_u32(elf, seg.data.size());
+        put_u32(elf, 6);    // PF_R | PF_W
+        put_u32(elf, 0);
+        offset += seg.data.size();
+    }
+    for (const segment_t &seg : segs) {
+        elf.insert(elf.end(), seg.data.begin(), seg.data.end());
+    }
+    return elf;
+}
+
+/* Backend writing to memory, with the checksum the flash and UART backends keep */
+struct mem_backend_t {
+    data_t data;
+    uint32_t crc;
+    size_t max_size;
+};
+
+static esp_err_t mem_write(void *priv, void *data, uint32_t data_len)
+{
+    mem_backend_t *mem = (mem_backend_t *)priv;
+    if (mem->data.size() + data_len > mem->max_size) {
+        return ESP_ERR_NO_MEM;
+    }
+    mem->data.insert(mem->data.end(), (uint8_t *)data, (uint8_t *)data + data_len);
+    mem->crc = crc32_le(mem->crc, (uint8_t *)data, data_len);
+    return ESP_OK;
+}
+
+/* Writes a compressed dump of elf like the flash backend stores it: length word, core dump header,
+ * compressed ELF and CRC32 of all but the length word. The ELF is passed in pieces of varying size
+ * like the ELF writer passes headers and segments. */
+static esp_err_t write_dump(const data_t &elf, data_t &dump, bool length_known = true, size_t max_size = SIZE_MAX)
+{
+    mem_backend_t mem = { data_t(4, 0xFF), 0, max_size };
+    uint32_t hdr[4] = { DUMP_VERSION_ELF_LZSS_CRC32, 0, 0, 0 };
+    REQUIRE(mem_write(&mem, hdr, sizeof(hdr)) == ESP_OK);
+
+    esp_err_t err = esp_core_dump_compress_start(mem_write, &mem, elf.size());
+    for (size_t pos = 0; pos < elf.size() && err == ESP_OK; ) {
+        size_t len = 1 + rand() % 3000;
+        len = std::min(len, elf.size() - pos);
+        err = esp_core_dump_compress_write(NULL, (void *)(elf.data() + pos), len);
+        pos += len;
+    }
+    uint32_t compressed_len = 0;
+    if (err == ESP_OK) {
+        err = esp_core_dump_compress_finish(&compressed_len);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    CHECK(compressed_len == mem.data.size() - 4 - sizeof(hdr) - sizeof(core_dump_compress_header_t));
+    uint32_t crc = mem.crc;
+    put_u32(mem.data, crc);
+    set_u32(mem.data, 0, length_known ? mem.data.size() : DUMP_LENGTH_UNKNOWN);
+    dump = mem.data;
+    return ESP_OK;
+}
+
+static data_t read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    REQUIRE(f != NULL);
+    data_t data;
+    uint8_t buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + len);
+    }
+    fclose(f);
+    return data;
+}
+
+static void write_file(const char *path, const data_t &data)
+{
+    FILE *f = fopen(path, "wb");
+    REQUIRE(f != NULL);
+    REQUIRE(fwrite(data.data(), 1, data.size(), f) == data.size());
+    fclose(f);
+}
+
+/* Extracts the ELF from the dump with espcoredump.py */
+static data_t extract_elf(const data_t &dump)
+{
+    write_file("coredump.bin", dump);
+    remove("coredump.elf");
+    std::string cmd = "python -c \"import sys; sys.path.insert(0, '..'); import espcoredump; "
+                      "espcoredump.ESPCoreDumpFileLoader('coredump.bin').create_corefile('coredump.elf')\"";
+    REQUIRE(system(cmd.c_str()) == 0);
+    return read_file("coredump.elf");
+}
+
+TEST_CASE("compressed core dump is decompressed by espcoredump.py", "[espcoredump]")
+{
+    data_t elf = make_elf(20);
+    data_t dump;
+    REQUIRE(write_dump(elf, dump) == ESP_OK);
+    printf("ELF of %d bytes compressed to a dump of %d bytes (%.1f%%)\n",
+           (int)elf.size(), (int)dump.size(), 100.0 * dump.size() / elf.size());
+    CHECK(dump.size() < elf.size() * 3 / 5);
+
+    uint32_t crc = crc32_le(0, dump.data() + 4, dump.size() - 8);
+    CHECK(memcmp(&crc, dump.data() + dump.size() - 4, 4) == 0);
+    CHECK(extract_elf(dump) == elf);
+}
+
+TEST_CASE("compressed core dump of unknown length is decompressed up to the checksum", "[espcoredump]")
+{
+    data_t elf = make_elf(3);
+    data_t dump;
+    REQUIRE(write_dump(elf, dump, false) == ESP_OK);
+    CHECK(extract_elf(dump) == elf);
+}
+
+TEST_CASE("incompressible core dump grows no more than the flash backend erases", "[espcoredump]")
+{
+    data_t elf = make_elf(4, true);
+    data_t dump;
+    REQUIRE(write_dump(elf, dump) == ESP_OK);
+    CHECK(dump.size() <= elf.size() + elf.size() / 8 + 16 + 20 + sizeof(core_dump_compress_header_t) + 4);
+    CHECK(extract_elf(dump) == elf);
+}
+
+TEST_CASE("compressed core dump larger than the storage fails", "[espcoredump]")
+{
+    data_t elf = make_elf(4, true);
+    data_t dump;
+    CHECK(write_dump(elf, dump, true, elf.size() / 2) == ESP_ERR_NO_MEM);
+}
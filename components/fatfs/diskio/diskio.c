@@ -11,13 +11,191 @@
 #include <string.h>
 #include <time.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <sys/time.h>
 #include "diskio_impl.h"
 #include "ffconf.h"
 #include "ff.h"
+#include "sdkconfig.h"
 
 static ff_diskio_impl_t * s_impls[FF_VOLUMES] = { NULL };
 
+#if CONFIG_FATFS_SECTOR_CACHE_SIZE > 0
+/**
+ * Sector cache of a drive.
+ *
+ * Single sector reads and writes, which is what FatFs does for FAT and directory
+ * sectors and for partial data sectors, go through CONFIG_FATFS_SECTOR_CACHE_SIZE
+ * cached sectors, replaced in least recently used order. Writes are kept in the
+ * cache until FatFs syncs (CTRL_SYNC) or the drive is unregistered. Multi-sector
+ * transfers go directly to the driver, keeping the cached sectors coherent.
+ */
+typedef struct {
+    DWORD sector;
+    uint32_t last_use;
+    bool valid;
+    bool dirty;
+} ff_cache_entry_t;
+
+typedef struct {
+    BYTE *data;                 /* cached sectors, sector_size bytes each */
+    UINT sector_size;
+    uint32_t use_counter;
+    ff_diskio_cache_stats_t stats;
+    ff_cache_entry_t entries[CONFIG_FATFS_SECTOR_CACHE_SIZE];
+} ff_sector_cache_t;
+
+static ff_sector_cache_t * s_caches[FF_VOLUMES] = { NULL };
+
+static ff_sector_cache_t * cache_get(BYTE pdrv)
+{
+    ff_sector_cache_t *cache = s_caches[pdrv];
+    if (cache) {
+        return cache;
+    }
+    WORD sector_size = FF_MIN_SS;
+#if FF_MAX_SS != FF_MIN_SS
+    if (s_impls[pdrv]->ioctl(pdrv, GET_SECTOR_SIZE, &sector_size) != RES_OK
+            || sector_size < FF_MIN_SS || sector_size > FF_MAX_SS) {
+        return NULL;
+    }
+#endif
+    cache = calloc(1, sizeof(ff_sector_cache_t));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->data = ff_memalloc(CONFIG_FATFS_SECTOR_CACHE_SIZE * sector_size);
+    if (cache->data == NULL) {
+        free(cache);
+        return NULL;
+    }
+    cache->sector_size = sector_size;
+    s_caches[pdrv] = cache;
+    return cache;
+}
+
+static inline BYTE * cache_data(ff_sector_cache_t *cache, int index)
+{
+    return cache->data + index * cache->sector_size;
+}
+
+static int cache_find(ff_sector_cache_t *cache, DWORD sector)
+{
+    for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SIZE; i++) {
+        if (cache->entries[i].valid && cache->entries[i].sector == sector) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static DRESULT cache_write_back(BYTE pdrv, ff_sector_cache_t *cache, int index)
+{
+    ff_cache_entry_t *entry = &cache->entries[index];
+    DRESULT res = s_impls[pdrv]->write(pdrv, cache_data(cache, index), entry->sector, 1);
+    if (res == RES_OK) {
+        entry->dirty = false;
+        cache->stats.writebacks++;
+    }
+    return res;
+}
+
+/* Get an entry for a sector not in the cache, writing back the least recently used one if needed */
+static DRESULT cache_evict(BYTE pdrv, ff_sector_cache_t *cache, int *out_index)
+{
+    int victim = 0;
+    for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SIZE; i++) {
+        if (!cache->entries[i].valid) {
+            victim = i;
+            break;
+        }
+        if (cache->entries[i].last_use < cache->entries[victim].last_use) {
+            victim = i;
+        }
+    }
+    if (cache->entries[victim].valid && cache->entries[victim].dirty) {
+        DRESULT res = cache_write_back(pdrv, cache, victim);
+        if (res != RES_OK) {
+            return res;
+        }
+    }
+    cache->entries[victim].valid = false;
+    *out_index = victim;
+    return RES_OK;
+}
+
+static inline void cache_use(ff_sector_cache_t *cache, int index, DWORD sector)
+{
+    cache->entries[index].sector = sector;
+    cache->entries[index].valid = true;
+    cache->entries[index].last_use = ++cache->use_counter;
+}
+
+/* Write back dirty sectors in ascending order, so that drivers see sequential writes */
+static DRESULT cache_flush(BYTE pdrv)
+{
+    ff_sector_cache_t *cache = s_caches[pdrv];
+    if (!cache) {
+        return RES_OK;
+    }
+    for (;;) {
+        int next = -1;
+        for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SIZE; i++) {
+            ff_cache_entry_t *entry = &cache->entries[i];
+            if (entry->valid && entry->dirty && (next < 0 || entry->sector < cache->entries[next].sector)) {
+                next = i;
+            }
+        }
+        if (next < 0) {
+            return RES_OK;
+        }
+        DRESULT res = cache_write_back(pdrv, cache, next);
+        if (res != RES_OK) {
+            return res;
+        }
+    }
+}
+
+static void cache_free(BYTE pdrv)
+{
+    ff_sector_cache_t *cache = s_caches[pdrv];
+    if (cache) {
+        s_caches[pdrv] = NULL;
+        ff_memfree(cache->data);
+        free(cache);
+    }
+}
+
+esp_err_t ff_diskio_get_cache_stats(BYTE pdrv, ff_diskio_cache_stats_t* out_stats)
+{
+    if (pdrv >= FF_VOLUMES || out_stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_caches[pdrv] == NULL) {
+        memset(out_stats, 0, sizeof(*out_stats));
+    } else {
+        *out_stats = s_caches[pdrv]->stats;
+    }
+    return ESP_OK;
+}
+
+void ff_diskio_reset_cache_stats(BYTE pdrv)
+{
+    if (pdrv < FF_VOLUMES && s_caches[pdrv]) {
+        memset(&s_caches[pdrv]->stats, 0, sizeof(ff_diskio_cache_stats_t));
+    }
+}
+#else
+esp_err_t ff_diskio_get_cache_stats(BYTE pdrv, ff_diskio_cache_stats_t* out_stats)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void ff_diskio_reset_cache_stats(BYTE pdrv)
+{
+}
+#endif // CONFIG_FATFS_SECTOR_CACHE_SIZE > 0
+
 #if FF_MULTI_PARTITION		/* Multiple partition configuration */
 PARTITION VolToPart[] = {
     {0, 0},    /* Logical drive 0 ==> Physical drive 0, auto detection */
@@ -42,6 +220,10 @@ void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t* discio_impl)
     assert(pdrv < FF_VOLUMES);
 
     if (s_impls[pdrv]) {
+#if CONFIG_FATFS_SECTOR_CACHE_SIZE > 0
+        cache_flush(pdrv);
+        cache_free(pdrv);
+#endif
         ff_diskio_impl_t* im = s_impls[pdrv];
         s_impls[pdrv] = NULL;
         free(im);
@@ -59,6 +241,11 @@ void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t* discio_impl)
 
 DSTATUS ff_disk_initialize (BYTE pdrv)
 {
+#if CONFIG_FATFS_SECTOR_CACHE_SIZE > 0
+    /* The medium may have been changed since the volume was last mounted */
+    cache_flush(pdrv);
+    cache_free(pdrv);
+#endif
     return s_impls[pdrv]->init(pdrv);
 }
 DSTATUS ff_disk_status (BYTE pdrv)
@@ -67,14 +254,86 @@ DSTATUS ff_disk_status (BYTE pdrv)
 }
 DRESULT ff_disk_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count)
 {
+#if CONFIG_FATFS_SECTOR_CACHE_SIZE > 0
+    ff_sector_cache_t *cache = cache_get(pdrv);
+    if (cache && count == 1) {
+        int index = cache_find(cache, sector);
+        if (index >= 0) {
+            cache->stats.hits++;
+        } else {
+            cache->stats.misses++;
+            DRESULT res = cache_evict(pdrv, cache, &index);
+            if (res != RES_OK) {
+                return res;
+            }
+            res = s_impls[pdrv]->read(pdrv, cache_data(cache, index), sector, 1);
+            if (res != RES_OK) {
+                return res;
+            }
+            cache->entries[index].dirty = false;
+        }
+        cache_use(cache, index, sector);
+        memcpy(buff, cache_data(cache, index), cache->sector_size);
+        return RES_OK;
+    }
+    DRESULT res = s_impls[pdrv]->read(pdrv, buff, sector, count);
+    if (cache && res == RES_OK) {
+        /* Sectors not written back yet are newer than what was read */
+        for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SIZE; i++) {
+            ff_cache_entry_t *entry = &cache->entries[i];
+            if (entry->valid && entry->dirty && entry->sector - sector < count) {
+                memcpy(buff + (entry->sector - sector) * cache->sector_size, cache_data(cache, i), cache->sector_size);
+            }
+        }
+    }
+    return res;
+#else
     return s_impls[pdrv]->read(pdrv, buff, sector, count);
+#endif
 }
 DRESULT ff_disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count)
 {
+#if CONFIG_FATFS_SECTOR_CACHE_SIZE > 0
+    ff_sector_cache_t *cache = cache_get(pdrv);
+    if (cache && count == 1) {
+        int index = cache_find(cache, sector);
+        if (index < 0) {
+            DRESULT res = cache_evict(pdrv, cache, &index);
+            if (res != RES_OK) {
+                return res;
+            }
+        }
+        cache_use(cache, index, sector);
+        cache->entries[index].dirty = true;
+        memcpy(cache_data(cache, index), buff, cache->sector_size);
+        return RES_OK;
+    }
+    DRESULT res = s_impls[pdrv]->write(pdrv, buff, sector, count);
+    if (cache && res == RES_OK) {
+        /* Keep cached copies of the written sectors up to date */
+        for (int i = 0; i < CONFIG_FATFS_SECTOR_CACHE_SIZE; i++) {
+            ff_cache_entry_t *entry = &cache->entries[i];
+            if (entry->valid && entry->sector - sector < count) {
+                memcpy(cache_data(cache, i), buff + (entry->sector - sector) * cache->sector_size, cache->sector_size);
+                entry->dirty = false;
+            }
+        }
+    }
+    return res;
+#else
     return s_impls[pdrv]->write(pdrv, buff, sector, count);
+#endif
 }
 DRESULT ff_disk_ioctl (BYTE pdrv, BYTE cmd, void* buff)
 {
+#if CONFIG_FATFS_SECTOR_CACHE_SIZE > 0
+    if (cmd == CTRL_SYNC) {
+        DRESULT res = cache_flush(pdrv);
+        if (res != RES_OK) {
+            return res;
+        }
+    }
+#endif
     return s_impls[pdrv]->ioctl(pdrv, cmd, buff);
 }
 
@@ -66,6 +66,36 @@ void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t* discio_impl);
  */
 esp_err_t ff_diskio_get_drive(BYTE* out_pdrv);
 
+/**
+ * Statistics of the sector cache of a drive, see CONFIG_FATFS_SECTOR_CACHE_SIZE
+ */
+typedef struct {
+    uint32_t hits;          /*!< single sector reads served from the cache */
+    uint32_t misses;        /*!< single sector reads which had to be read from the drive */
+    uint32_t writebacks;    /*!< cached sectors written to the drive */
+} ff_diskio_cache_stats_t;
+
+/**
+ * Get statistics of the sector cache of a drive
+ *
+ * The statistics are reset when the drive is registered or mounted.
+ *
+ * @param   pdrv                drive number
+ * @param   out_stats           pointer to the structure to fill
+ *
+ * @return  ESP_OK                  on success
+ *          ESP_ERR_INVALID_ARG     if pdrv or out_stats is invalid
+ *          ESP_ERR_NOT_SUPPORTED   if the sector cache is disabled in menuconfig
+ */
+esp_err_t ff_diskio_get_cache_stats(BYTE pdrv, ff_diskio_cache_stats_t* out_stats);
+
+/**
+ * Reset statistics of the sector cache of a drive
+ *
+ * @param   pdrv                drive number
+ */
+void ff_diskio_reset_cache_stats(BYTE pdrv);
+
 
 #ifdef __cplusplus
 }
@@ -13,13 +13,17 @@
 // limitations under the License.
 
 #include <string.h>
+#include <stdlib.h>
 #include "diskio_impl.h"
 #include "ffconf.h"
 #include "ff.h"
+#include "esp_flash_encrypt.h"
 #include "esp_log.h"
 #include "diskio_wl.h"
 #include "wear_levelling.h"
 #include "esp_compiler.h"
+#include "esp_spi_flash.h"
+#include "sdkconfig.h"
 
 static const char* TAG = "ff_diskio_spiflash";
 
@@ -28,6 +32,156 @@ wl_handle_t ff_wl_handles[FF_VOLUMES] = {
         WL_INVALID_HANDLE,
 };
 
+/* Bytes of old sector contents compared at a time when checking if a write needs an erase */
+#define FF_WL_CHECK_CHUNK 128
+
+/**
+ * Erase avoidance state of a volume.
+ *
+ * NOR flash can clear bits without an erase, so a FAT sector write only needs an erase if the
+ * new data sets a bit that is clear on flash. This is checked against the old contents
+ * before every write, and FAT sectors seen fully erased are remembered, so that appending
+ * to a file normally writes without any erase.
+ *
+ * With FAT sectors smaller than a flash sector, writes are also gathered per flash sector
+ * until FatFs writes to another flash sector or syncs, and each run of consecutive sectors
+ * is then erased (if needed) and written in one go instead of one flash sector
+ * read-modify-write per FAT sector.
+ */
+typedef struct {
+    uint32_t *erased;       /*!< bit per FAT sector, set if the sector is known to be erased */
+    DWORD sector_count;
+    UINT sectors_per_flash_sector;
+#if CONFIG_FATFS_WL_WRITE_BUFFER
+    BYTE *buffer;           /*!< FAT sectors written to the buffered flash sector */
+    DWORD buffer_sector;    /*!< first FAT sector of the buffered flash sector */
+    uint32_t dirty;         /*!< bit per FAT sector of the buffered flash sector, set if it is in the buffer */
+#endif
+} ff_wl_state_t;
+
+static ff_wl_state_t s_wl_state[FF_VOLUMES];
+
+static inline bool ff_wl_is_erased(ff_wl_state_t *state, DWORD sector)
+{
+    return state->erased[sector / 32] & (1u << (sector % 32));
+}
+
+static inline void ff_wl_set_erased(ff_wl_state_t *state, DWORD sector, bool erased)
+{
+    if (erased) {
+        state->erased[sector / 32] |= 1u << (sector % 32);
+    } else {
+        state->erased[sector / 32] &= ~(1u << (sector % 32));
+    }
+}
+
+/* Compare the old contents of sectors [sector, sector + count) with the data to write, and
+ * learn the erased state of all FAT sectors in the flash sectors read along the way */
+static esp_err_t ff_wl_needs_erase(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count, bool *needs_erase)
+{
+    wl_handle_t wl_handle = ff_wl_handles[pdrv];
+    ff_wl_state_t *state = &s_wl_state[pdrv];
+    size_t sector_size = wl_sector_size(wl_handle);
+    uint32_t old[FF_WL_CHECK_CHUNK / sizeof(uint32_t)];
+
+    /* Flash contents are encrypted, so bits can't be compared with the plaintext being written */
+    *needs_erase = true;
+    if (esp_flash_encryption_enabled()) {
+        return ESP_OK;
+    }
+    *needs_erase = false;
+    UINT i;
+    for (i = 0; i < count && ff_wl_is_erased(state, sector + i); i++) {
+    }
+    if (i == count) {
+        return ESP_OK;
+    }
+
+    DWORD first = sector / state->sectors_per_flash_sector * state->sectors_per_flash_sector;
+    DWORD last = (sector + count - 1) / state->sectors_per_flash_sector * state->sectors_per_flash_sector
+                 + state->sectors_per_flash_sector;
+    for (DWORD s = first; s < last && s < state->sector_count; s++) {
+        const uint32_t *new_data = (s >= sector && s < sector + count) ?
+                                   (const uint32_t *)(buff + (s - sector) * sector_size) : NULL;
+        uint32_t all = UINT32_MAX;
+        for (size_t offset = 0; offset < sector_size; offset += sizeof(old)) {
+            esp_err_t err = wl_read(wl_handle, s * sector_size + offset, old, sizeof(old));
+            if (unlikely(err != ESP_OK)) {
+                return err;
+            }
+            for (int w = 0; w < sizeof(old) / sizeof(uint32_t); w++) {
+                all &= old[w];
+                if (new_data) {
+                    uint32_t new_word;
+                    memcpy(&new_word, &new_data[offset / sizeof(uint32_t) + w], sizeof(new_word));
+                    if ((old[w] & new_word) != new_word) {
+                        *needs_erase = true;
+                    }
+                }
+            }
+        }
+        ff_wl_set_erased(state, s, all == UINT32_MAX);
+    }
+    return ESP_OK;
+}
+
+static DRESULT ff_wl_write_run(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
+{
+    wl_handle_t wl_handle = ff_wl_handles[pdrv];
+    ff_wl_state_t *state = &s_wl_state[pdrv];
+    size_t sector_size = wl_sector_size(wl_handle);
+    bool needs_erase = true;
+
+    esp_err_t err = ff_wl_needs_erase(pdrv, buff, sector, count, &needs_erase);
+    if (unlikely(err != ESP_OK)) {
+        ESP_LOGE(TAG, "wl_read failed (%d)", err);
+        return RES_ERROR;
+    }
+    if (needs_erase) {
+        err = wl_erase_range(wl_handle, sector * sector_size, count * sector_size);
+        if (unlikely(err != ESP_OK)) {
+            ESP_LOGE(TAG, "wl_erase_range failed (%d)", err);
+            return RES_ERROR;
+        }
+    }
+    for (UINT i = 0; i < count; i++) {
+        ff_wl_set_erased(state, sector + i, false);
+    }
+    err = wl_write(wl_handle, sector * sector_size, buff, count * sector_size);
+    if (unlikely(err != ESP_OK)) {
+        ESP_LOGE(TAG, "wl_write failed (%d)", err);
+        return RES_ERROR;
+    }
+    return RES_OK;
+}
+
+#if CONFIG_FATFS_WL_WRITE_BUFFER
+static DRESULT ff_wl_flush(BYTE pdrv)
+{
+    ff_wl_state_t *state = &s_wl_state[pdrv];
+    size_t sector_size = wl_sector_size(ff_wl_handles[pdrv]);
+    UINT i = 0;
+    while (state->dirty) {
+        /* Find the next run of consecutive buffered sectors */
+        while (!(state->dirty & (1u << i))) {
+            i++;
+        }
+        UINT count = 0;
+        while (i + count < state->sectors_per_flash_sector && (state->dirty & (1u << (i + count)))) {
+            count++;
+        }
+        DRESULT res = ff_wl_write_run(pdrv, state->buffer + i * sector_size, state->buffer_sector + i, count);
+        if (res != RES_OK) {
+            /* Keep this run and the ones after it buffered, so that the next sync retries them */
+            return res;
+        }
+        state->dirty &= ~(((1u << count) - 1) << i);
+        i += count;
+    }
+    return RES_OK;
+}
+#endif
+
 DSTATUS ff_wl_initialize (BYTE pdrv)
 {
     return 0;
@@ -48,6 +202,20 @@ DRESULT ff_wl_read (BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
         ESP_LOGE(TAG, "wl_read failed (%d)", err);
         return RES_ERROR;
     }
+#if CONFIG_FATFS_WL_WRITE_BUFFER
+    /* Sectors still in the write buffer are newer than what's on flash */
+    ff_wl_state_t *state = &s_wl_state[pdrv];
+    if (state->dirty && sector < state->buffer_sector + state->sectors_per_flash_sector
+            && sector + count > state->buffer_sector) {
+        size_t sector_size = wl_sector_size(wl_handle);
+        for (UINT i = 0; i < state->sectors_per_flash_sector; i++) {
+            DWORD s = state->buffer_sector + i;
+            if ((state->dirty & (1u << i)) && s >= sector && s < sector + count) {
+                memcpy(buff + (s - sector) * sector_size, state->buffer + i * sector_size, sector_size);
+            }
+        }
+    }
+#endif
     return RES_OK;
 }
 
@@ -56,17 +224,31 @@ DRESULT ff_wl_write (BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
     ESP_LOGV(TAG, "ff_wl_write - pdrv=%i, sector=%i, count=%i\n", (unsigned int)pdrv, (unsigned int)sector, (unsigned int)count);
     wl_handle_t wl_handle = ff_wl_handles[pdrv];
     assert(wl_handle + 1);
-    esp_err_t err = wl_erase_range(wl_handle, sector * wl_sector_size(wl_handle), count * wl_sector_size(wl_handle));
-    if (unlikely(err != ESP_OK)) {
-        ESP_LOGE(TAG, "wl_erase_range failed (%d)", err);
-        return RES_ERROR;
-    }
-    err = wl_write(wl_handle, sector * wl_sector_size(wl_handle), buff, count * wl_sector_size(wl_handle));
-    if (unlikely(err != ESP_OK)) {
-        ESP_LOGE(TAG, "wl_write failed (%d)", err);
-        return RES_ERROR;
+#if CONFIG_FATFS_WL_WRITE_BUFFER
+    ff_wl_state_t *state = &s_wl_state[pdrv];
+    if (state->buffer) {
+        size_t sector_size = wl_sector_size(wl_handle);
+        for (UINT i = 0; i < count; i++) {
+            DWORD s = sector + i;
+            if (s < state->buffer_sector || s >= state->buffer_sector + state->sectors_per_flash_sector) {
+                DRESULT res = ff_wl_flush(pdrv);
+                if (res != RES_OK) {
+                    return res;
+                }
+                state->buffer_sector = s / state->sectors_per_flash_sector * state->sectors_per_flash_sector;
+            }
+            UINT index = s - state->buffer_sector;
+            memcpy(state->buffer + index * sector_size, buff + i * sector_size, sector_size);
+            state->dirty |= 1u << index;
+        }
+        if (state->dirty == (1u << state->sectors_per_flash_sector) - 1) {
+            /* Whole flash sector buffered, nothing to gather any more */
+            return ff_wl_flush(pdrv);
+        }
+        return RES_OK;
     }
-    return RES_OK;
+#endif
+    return ff_wl_write_run(pdrv, buff, sector, count);
 }
 
 DRESULT ff_wl_ioctl (BYTE pdrv, BYTE cmd, void *buff)
@@ -76,7 +258,11 @@ DRESULT ff_wl_ioctl (BYTE pdrv, BYTE cmd, void *buff)
     assert(wl_handle + 1);
     switch (cmd) {
     case CTRL_SYNC:
+#if CONFIG_FATFS_WL_WRITE_BUFFER
+        return ff_wl_flush(pdrv);
+#else
         return RES_OK;
+#endif
     case GET_SECTOR_COUNT:
         *((DWORD *) buff) = wl_size(wl_handle) / wl_sector_size(wl_handle);
         return RES_OK;
@@ -90,6 +276,15 @@ DRESULT ff_wl_ioctl (BYTE pdrv, BYTE cmd, void *buff)
 }
 
 
+static void ff_wl_free_state(ff_wl_state_t *state)
+{
+    free(state->erased);
+#if CONFIG_FATFS_WL_WRITE_BUFFER
+    free(state->buffer);
+#endif
+    memset(state, 0, sizeof(ff_wl_state_t));
+}
+
 esp_err_t ff_diskio_register_wl_partition(BYTE pdrv, wl_handle_t flash_handle)
 {
     if (pdrv >= FF_VOLUMES) {
@@ -102,6 +297,24 @@ esp_err_t ff_diskio_register_wl_partition(BYTE pdrv, wl_handle_t flash_handle)
         .write = &ff_wl_write,
         .ioctl = &ff_wl_ioctl
     };
+    ff_wl_state_t *state = &s_wl_state[pdrv];
+    ff_wl_free_state(state);
+    size_t sector_size = wl_sector_size(flash_handle);
+    state->sector_count = wl_size(flash_handle) / sector_size;
+    state->sectors_per_flash_sector = sector_size < SPI_FLASH_SEC_SIZE ? SPI_FLASH_SEC_SIZE / sector_size : 1;
+    state->erased = calloc((state->sector_count + 31) / 32, sizeof(uint32_t));
+    if (state->erased == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+#if CONFIG_FATFS_WL_WRITE_BUFFER
+    if (state->sectors_per_flash_sector > 1) {
+        state->buffer = malloc(SPI_FLASH_SEC_SIZE);
+        if (state->buffer == NULL) {
+            ff_wl_free_state(state);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+#endif
     ff_wl_handles[pdrv] = flash_handle;
     ff_diskio_register(pdrv, &wl_impl);
     return ESP_OK;
@@ -121,6 +334,10 @@ void ff_diskio_clear_pdrv_wl(wl_handle_t flash_handle)
 {
     for (int i = 0; i < FF_VOLUMES; i++) {
         if (flash_handle == ff_wl_handles[i]) {
+#if CONFIG_FATFS_WL_WRITE_BUFFER
+            ff_wl_flush(i);
+#endif
+            ff_wl_free_state(&s_wl_state[i]);
             ff_wl_handles[i] = WL_INVALID_HANDLE;
         }
     }
@@ -1636,6 +1636,39 @@ static DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* FAT handling - Get cluster containing an offset without moving fptr   */
+/*-----------------------------------------------------------------------*/
+
+static DWORD file_clust (	/* 0xFFFFFFFF:Disk error, 1:Internal error, >=2:Cluster number */
+	FIL* fp,		/* Pointer to the file object */
+	FSIZE_t ofs		/* File offset to be converted to cluster# (< file size) */
+)
+{
+	DWORD clst, bcs;
+	FSIZE_t pos;
+	FATFS *fs = fp->obj.fs;
+
+
+#if FF_USE_FASTSEEK
+	if (fp->cltbl) return clmt_clust(fp, ofs);	/* Get cluster# from the CLMT */
+#endif
+	bcs = (DWORD)fs->csize * SS(fs);	/* Cluster size in byte */
+	if (fp->fptr > 0 && (fp->fptr - 1) / bcs <= ofs / bcs) {	/* Follow the chain from the current cluster if possible */
+		clst = fp->clust; pos = (fp->fptr - 1) / bcs * bcs;
+	} else {							/* Else follow it from the origin */
+		clst = fp->obj.sclust; pos = 0;
+	}
+	for ( ; pos + bcs <= ofs; pos += bcs) {
+		clst = get_fat(&fp->obj, clst);
+		if (clst <= 1 || clst == 0xFFFFFFFF) return clst;
+	}
+	return clst;
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Fill a cluster with zeros                        */
 /*-----------------------------------------------------------------------*/
@@ -3829,6 +3862,96 @@ FRESULT f_read (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Read File at an Offset                                                */
+/*-----------------------------------------------------------------------*/
+/* Unlike f_lseek + f_read, this doesn't move the file pointer, so the
+/  sector cache of the file is only used if it already holds the data. */
+
+FRESULT f_pread (
+	FIL* fp, 	/* Pointer to the file object */
+	void* buff,	/* Pointer to data buffer */
+	UINT btr,	/* Number of bytes to read */
+	FSIZE_t ofs,	/* File offset to read from */
+	UINT* br	/* Pointer to number of bytes read */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD clst = 0, sect;
+	FSIZE_t remain;
+	UINT rcnt, cc, csect;
+	BYTE *rbuff = (BYTE*)buff;
+
+
+	*br = 0;	/* Clear read byte counter */
+	res = validate(&fp->obj, &fs);				/* Check validity of the file object */
+	if (res != FR_OK || (res = (FRESULT)fp->err) != FR_OK) LEAVE_FF(fs, res);	/* Check validity */
+	if (!(fp->flag & FA_READ)) LEAVE_FF(fs, FR_DENIED); /* Check access mode */
+	if (ofs >= fp->obj.objsize) LEAVE_FF(fs, FR_OK);
+	remain = fp->obj.objsize - ofs;
+	if (btr > remain) btr = (UINT)remain;		/* Truncate btr by remaining bytes */
+
+	for ( ;  btr;								/* Repeat until btr bytes read */
+		btr -= rcnt, *br += rcnt, rbuff += rcnt, ofs += rcnt) {
+		csect = (UINT)(ofs / SS(fs) & (fs->csize - 1));	/* Sector offset in the cluster */
+		if (clst == 0) {						/* First sector? */
+			clst = file_clust(fp, ofs);
+		} else if (csect == 0 && ofs % SS(fs) == 0) {	/* On the cluster boundary? */
+#if FF_USE_FASTSEEK
+			if (fp->cltbl) {
+				clst = clmt_clust(fp, ofs);		/* Get cluster# from the CLMT */
+			} else
+#endif
+			{
+				clst = get_fat(&fp->obj, clst);	/* Follow cluster chain on the FAT */
+			}
+		}
+		if (clst < 2) ABORT(fs, FR_INT_ERR);
+		if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+		sect = clst2sect(fs, clst);				/* Get current sector */
+		if (sect == 0) ABORT(fs, FR_INT_ERR);
+		sect += csect;
+		cc = btr / SS(fs);
+		if (ofs % SS(fs) == 0 && cc > 0) {		/* Read maximum contiguous sectors directly */
+			if (csect + cc > fs->csize) {		/* Clip at cluster boundary */
+				cc = fs->csize - csect;
+			}
+			if (disk_read(fs->pdrv, rbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
+#if !FF_FS_READONLY		/* Replace read sectors with cached data if they are dirty */
+			if (fs->wflag && fs->winsect - sect < cc) {
+				mem_cpy(rbuff + ((fs->winsect - sect) * SS(fs)), fs->win, SS(fs));
+			}
+#if !FF_FS_TINY
+			if ((fp->flag & FA_DIRTY) && fp->sect - sect < cc) {
+				mem_cpy(rbuff + ((fp->sect - sect) * SS(fs)), fp->buf, SS(fs));
+			}
+#endif
+#endif
+			rcnt = SS(fs) * cc;					/* Number of bytes transferred */
+			continue;
+		}
+		rcnt = SS(fs) - (UINT)(ofs % SS(fs));	/* Number of bytes left in the sector */
+		if (rcnt > btr) rcnt = btr;				/* Clip it by btr if needed */
+#if !FF_FS_TINY
+		if (fp->sect == sect) {					/* Sector is in the file's cache */
+			mem_cpy(rbuff, fp->buf + ofs % SS(fs), rcnt);
+			continue;
+		}
+#endif
+		if (move_window(fs, sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window */
+		mem_cpy(rbuff, fs->win + ofs % SS(fs), rcnt);	/* Extract partial sector */
+#if !FF_FS_TINY
+		fs->winsect = 0xFFFFFFFF;				/* Data sectors are written bypassing the window, so don't keep it */
+#endif
+	}
+
+	LEAVE_FF(fs, FR_OK);
+}
+
+
+
+
 #if !FF_FS_READONLY
 /*-----------------------------------------------------------------------*/
 /* Write File                                                            */
@@ -3921,12 +4044,15 @@ FRESULT f_write (
 			if (fp->fptr >= fp->obj.objsize) {	/* Avoid silly cache filling on the growing edge */
 				if (sync_window(fs) != FR_OK) ABORT(fs, FR_DISK_ERR);
 				fs->winsect = sect;
+				mem_set(fs->win, 0xFF, SS(fs));	/* Keep the part beyond eof erased, so that flash drivers can append without an erase */
 			}
 #else
-			if (fp->sect != sect && 		/* Fill sector cache with file data */
-				fp->fptr < fp->obj.objsize &&
-				disk_read(fs->pdrv, fp->buf, sect, 1) != RES_OK) {
-					ABORT(fs, FR_DISK_ERR);
+			if (fp->sect != sect) {
+				if (fp->fptr < fp->obj.objsize) {	/* Fill sector cache with file data */
+					if (disk_read(fs->pdrv, fp->buf, sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+				} else {
+					mem_set(fp->buf, 0xFF, SS(fs));	/* Keep the part beyond eof erased, so that flash drivers can append without an erase */
+				}
 			}
 #endif
 			fp->sect = sect;
@@ -3951,6 +4077,101 @@ FRESULT f_write (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Write File at an Offset                                               */
+/*-----------------------------------------------------------------------*/
+/* Doesn't move the file pointer and doesn't extend the file: writing
+/  stops at the end of the file, which is reflected by *bw. */
+
+FRESULT f_pwrite (
+	FIL* fp,			/* Pointer to the file object */
+	const void* buff,	/* Pointer to the data to be written */
+	UINT btw,			/* Number of bytes to write */
+	FSIZE_t ofs,		/* File offset to write to */
+	UINT* bw			/* Pointer to number of bytes written */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD clst = 0, sect;
+	FSIZE_t remain;
+	UINT wcnt, cc, csect;
+	const BYTE *wbuff = (const BYTE*)buff;
+
+
+	*bw = 0;	/* Clear write byte counter */
+	res = validate(&fp->obj, &fs);			/* Check validity of the file object */
+	if (res != FR_OK || (res = (FRESULT)fp->err) != FR_OK) LEAVE_FF(fs, res);	/* Check validity */
+	if (!(fp->flag & FA_WRITE)) LEAVE_FF(fs, FR_DENIED);	/* Check access mode */
+	if (ofs >= fp->obj.objsize) LEAVE_FF(fs, FR_OK);
+	remain = fp->obj.objsize - ofs;
+	if (btw > remain) btw = (UINT)remain;	/* Truncate btw at the end of the file */
+
+	for ( ;  btw;							/* Repeat until all data written */
+		btw -= wcnt, *bw += wcnt, wbuff += wcnt, ofs += wcnt) {
+		csect = (UINT)(ofs / SS(fs) & (fs->csize - 1));	/* Sector offset in the cluster */
+		if (clst == 0) {					/* First sector? */
+			clst = file_clust(fp, ofs);
+		} else if (csect == 0 && ofs % SS(fs) == 0) {	/* On the cluster boundary? */
+#if FF_USE_FASTSEEK
+			if (fp->cltbl) {
+				clst = clmt_clust(fp, ofs);	/* Get cluster# from the CLMT */
+			} else
+#endif
+			{
+				clst = get_fat(&fp->obj, clst);	/* Follow cluster chain on the FAT */
+			}
+		}
+		if (clst < 2) ABORT(fs, FR_INT_ERR);
+		if (clst == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+		sect = clst2sect(fs, clst);			/* Get current sector */
+		if (sect == 0) ABORT(fs, FR_INT_ERR);
+		sect += csect;
+		cc = btw / SS(fs);
+		if (ofs % SS(fs) == 0 && cc > 0) {	/* Write maximum contiguous sectors directly */
+			if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
+				cc = fs->csize - csect;
+			}
+			if (disk_write(fs->pdrv, wbuff, sect, cc) != RES_OK) ABORT(fs, FR_DISK_ERR);
+			if (fs->winsect - sect < cc) {	/* Refill sector caches if they get invalidated by the direct write */
+				mem_cpy(fs->win, wbuff + ((fs->winsect - sect) * SS(fs)), SS(fs));
+				fs->wflag = 0;
+			}
+#if !FF_FS_TINY
+			if (fp->sect - sect < cc) {
+				mem_cpy(fp->buf, wbuff + ((fp->sect - sect) * SS(fs)), SS(fs));
+				fp->flag &= (BYTE)~FA_DIRTY;
+			}
+#endif
+			wcnt = SS(fs) * cc;				/* Number of bytes transferred */
+			continue;
+		}
+		wcnt = SS(fs) - (UINT)(ofs % SS(fs));	/* Number of bytes left in the sector */
+		if (wcnt > btw) wcnt = btw;			/* Clip it by btw if needed */
+#if !FF_FS_TINY
+		if (fp->sect == sect) {				/* Sector is in the file's cache */
+			mem_cpy(fp->buf + ofs % SS(fs), wbuff, wcnt);
+			fp->flag |= FA_DIRTY;
+			continue;
+		}
+#endif
+		if (move_window(fs, sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window */
+		mem_cpy(fs->win + ofs % SS(fs), wbuff, wcnt);	/* Fit data to the sector */
+		fs->wflag = 1;
+#if !FF_FS_TINY
+		if (sync_window(fs) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Data sectors are read bypassing the window, so write it through */
+		fs->winsect = 0xFFFFFFFF;
+#endif
+	}
+
+	fp->flag |= FA_MODIFIED;				/* Set file change flag */
+
+	LEAVE_FF(fs, FR_OK);
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Synchronize the File                                                  */
 /*-----------------------------------------------------------------------*/
@@ -4407,6 +4628,66 @@ FRESULT f_lseek (
 
 
 
+#if FF_USE_FASTSEEK
+/*-----------------------------------------------------------------------*/
+/* Switch Fast Seek Mode                                                 */
+/*-----------------------------------------------------------------------*/
+/* Same as setting fp->cltbl and calling f_lseek(fp, CREATE_LINKMAP), but
+/  the file object refers to the table only once it is complete, so other
+/  tasks using the file never see a partially created table. */
+
+FRESULT f_fastseek (
+	FIL* fp,		/* Pointer to the file object */
+	DWORD* tbl		/* CLMT with its size in tbl[0], or null to disable fast seek */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD cl, pcl, ncl, tcl, tlen, ulen, *tp;
+
+
+	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
+	if (res == FR_OK) res = (FRESULT)fp->err;
+#if FF_FS_EXFAT && !FF_FS_READONLY
+	if (res == FR_OK && fs->fs_type == FS_EXFAT) {
+		res = fill_last_frag(&fp->obj, fp->clust, 0xFFFFFFFF);	/* Fill last fragment on the FAT if needed */
+	}
+#endif
+	if (res != FR_OK) LEAVE_FF(fs, res);
+
+	if (!tbl) {						/* Disable fast seek mode */
+		fp->cltbl = 0;
+		LEAVE_FF(fs, FR_OK);
+	}
+	tp = tbl;
+	tlen = *tp++; ulen = 2;			/* Given table size and required table size */
+	cl = fp->obj.sclust;			/* Origin of the chain */
+	if (cl != 0) {
+		do {
+			/* Get a fragment */
+			tcl = cl; ncl = 0; ulen += 2;	/* Top, length and used items */
+			do {
+				pcl = cl; ncl++;
+				cl = get_fat(&fp->obj, cl);
+				if (cl <= 1) ABORT(fs, FR_INT_ERR);
+				if (cl == 0xFFFFFFFF) ABORT(fs, FR_DISK_ERR);
+			} while (cl == pcl + 1);
+			if (ulen <= tlen) {		/* Store the length and top of the fragment */
+				*tp++ = ncl; *tp++ = tcl;
+			}
+		} while (cl < fs->n_fatent);	/* Repeat until end of chain */
+	}
+	*tbl = ulen;					/* Number of items used */
+	if (ulen > tlen) LEAVE_FF(fs, FR_NOT_ENOUGH_CORE);	/* Given table size is smaller than required */
+	*tp = 0;						/* Terminate table */
+	fp->cltbl = tbl;				/* Enable fast seek mode */
+
+	LEAVE_FF(fs, FR_OK);
+}
+#endif
+
+
+
 #if FF_FS_MINIMIZE <= 1
 /*-----------------------------------------------------------------------*/
 /* Create a Directory Object                                             */
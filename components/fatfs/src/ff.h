@@ -284,7 +284,10 @@ FRESULT f_open (FIL* fp, const TCHAR* path, BYTE mode);				/* Open or create a f
 FRESULT f_close (FIL* fp);											/* Close an open file object */
 FRESULT f_read (FIL* fp, void* buff, UINT btr, UINT* br);			/* Read data from the file */
 FRESULT f_write (FIL* fp, const void* buff, UINT btw, UINT* bw);	/* Write data to the file */
+FRESULT f_pread (FIL* fp, void* buff, UINT btr, FSIZE_t ofs, UINT* br);	/* Read data from an offset without moving the file pointer */
+FRESULT f_pwrite (FIL* fp, const void* buff, UINT btw, FSIZE_t ofs, UINT* bw);	/* Write data to an offset without moving the file pointer */
 FRESULT f_lseek (FIL* fp, FSIZE_t ofs);								/* Move file pointer of the file object */
+FRESULT f_fastseek (FIL* fp, DWORD* tbl);							/* Enable or disable fast seek mode of the file object */
 FRESULT f_truncate (FIL* fp);										/* Truncate the file */
 FRESULT f_sync (FIL* fp);											/* Flush cached data of the writing file */
 FRESULT f_opendir (FF_DIR* dp, const TCHAR* path);						/* Open a directory */
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "ff.h"
+#include "diskio_impl.h"
+#include "diskio_wl.h"
+#include "wear_levelling.h"
+#include "esp_spi_flash.h"
+
+#include "catch.hpp"
+
+/* ff_wl_* built with CONFIG_FATFS_WL_WRITE_BUFFER, on top of a wear levelling layer kept in RAM
+ * with 512 byte sectors, so that every FAT sector write goes through the write buffer */
+
+static const size_t wl_sector = 512;
+static const size_t flash_sectors = 4;
+static std::vector<uint8_t> flash(flash_sectors * SPI_FLASH_SEC_SIZE, 0xff);
+static const ff_diskio_impl_t *impl;
+static int erase_count;
+static int write_count;
+static int fail_write_at = -1;
+
+extern "C" {
+
+void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t *discio_impl)
+{
+    impl = discio_impl;
+}
+
+esp_err_t wl_erase_range(wl_handle_t handle, size_t start_addr, size_t size)
+{
+    memset(&flash[start_addr], 0xff, size);
+    erase_count++;
+    return ESP_OK;
+}
+
+esp_err_t wl_write(wl_handle_t handle, size_t dest_addr, const void *src, size_t size)
+{
+    if (write_count++ == fail_write_at) {
+        return ESP_FAIL;
+    }
+    const uint8_t *data = (const uint8_t *) src;
+    for (size_t i = 0; i < size; i++) {
+        flash[dest_addr + i] &= data[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t wl_read(wl_handle_t handle, size_t src_addr, void *dest, size_t size)
+{
+    memcpy(dest, &flash[src_addr], size);
+    return ESP_OK;
+}
+
+size_t wl_size(wl_handle_t handle)
+{
+    return flash.size();
+}
+
+size_t wl_sector_size(wl_handle_t handle)
+{
+    return wl_sector;
+}
+
+}
+
+static void register_wl_buffer(void)
+{
+    std::fill(flash.begin(), flash.end(), 0xff);
+    erase_count = 0;
+    write_count = 0;
+    fail_write_at = -1;
+    REQUIRE(ff_diskio_register_wl_partition(0, 0) == ESP_OK);
+    REQUIRE(impl != NULL);
+}
+
+static std::vector<uint8_t> sector_data(uint8_t seed)
+{
+    std::vector<uint8_t> data(wl_sector);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = seed + i;
+    }
+    return data;
+}
+
+static bool flash_has(DWORD sector, const std::vector<uint8_t> &data)
+{
+    return memcmp(&flash[sector * wl_sector], data.data(), wl_sector) == 0;
+}
+
+TEST_CASE("buffered sectors are read back and written to flash on sync", "[fatfs][diskio_wl]")
+{
+    register_wl_buffer();
+    std::vector<uint8_t> a = sector_data(1), b = sector_data(2);
+    std::vector<uint8_t> out(wl_sector);
+
+    REQUIRE(impl->write(0, a.data(), 1, 1) == RES_OK);
+    REQUIRE(impl->write(0, b.data(), 2, 1) == RES_OK);
+    CHECK(write_count == 0);
+    CHECK(!flash_has(1, a));
+
+    /* Reads see the buffered sectors before they reach flash */
+    REQUIRE(impl->read(0, out.data(), 2, 1) == RES_OK);
+    CHECK(out == b);
+
+    /* Sectors 1 and 2 are one run, written without an erase since flash is blank */
+    REQUIRE(impl->ioctl(0, CTRL_SYNC, NULL) == RES_OK);
+    CHECK(write_count == 1);
+    CHECK(erase_count == 0);
+    CHECK(flash_has(1, a));
+    CHECK(flash_has(2, b));
+
+    /* Overwriting a sector needs an erase */
+    REQUIRE(impl->write(0, b.data(), 1, 1) == RES_OK);
+    REQUIRE(impl->ioctl(0, CTRL_SYNC, NULL) == RES_OK);
+    CHECK(erase_count == 1);
+    CHECK(flash_has(1, b));
+    CHECK(flash_has(2, b));
+
+    ff_diskio_clear_pdrv_wl(0);
+}
+
+TEST_CASE("writing to another flash sector flushes the buffer", "[fatfs][diskio_wl]")
+{
+    register_wl_buffer();
+    const DWORD per_flash_sector = SPI_FLASH_SEC_SIZE / wl_sector;
+    std::vector<uint8_t> a = sector_data(3), b = sector_data(4);
+
+    REQUIRE(impl->write(0, a.data(), 0, 1) == RES_OK);
+    REQUIRE(impl->write(0, b.data(), per_flash_sector, 1) == RES_OK);
+    CHECK(write_count == 1);
+    CHECK(flash_has(0, a));
+    CHECK(!flash_has(per_flash_sector, b));
+
+    /* A whole flash sector is written as soon as it is buffered */
+    std::vector<uint8_t> whole(SPI_FLASH_SEC_SIZE, 0x5a);
+    REQUIRE(impl->write(0, whole.data(), 2 * per_flash_sector, per_flash_sector) == RES_OK);
+    CHECK(write_count == 3);
+    CHECK(memcmp(&flash[2 * SPI_FLASH_SEC_SIZE], whole.data(), whole.size()) == 0);
+    CHECK(flash_has(per_flash_sector, b));
+
+    ff_diskio_clear_pdrv_wl(0);
+}
+
+TEST_CASE("sectors not written by a failed sync stay buffered", "[fatfs][diskio_wl]")
+{
+    register_wl_buffer();
+    std::vector<uint8_t> a = sector_data(5), b = sector_data(6), c = sector_data(7);
+    std::vector<uint8_t> out(wl_sector);
+
+    /* Three runs: sector 0, sector 2 and sector 4 */
+    REQUIRE(impl->write(0, a.data(), 0, 1) == RES_OK);
+    REQUIRE(impl->write(0, b.data(), 2, 1) == RES_OK);
+    REQUIRE(impl->write(0, c.data(), 4, 1) == RES_OK);
+
+    /* The second run fails to write */
+    fail_write_at = 1;
+    CHECK(impl->ioctl(0, CTRL_SYNC, NULL) == RES_ERROR);
+    CHECK(flash_has(0, a));
+    CHECK(!flash_has(4, c));
+    REQUIRE(impl->read(0, out.data(), 4, 1) == RES_OK);
+    CHECK(out == c);
+
+    /* Retrying writes the failed run and the one after it, but not the first one again */
+    fail_write_at = -1;
+    write_count = 0;
+    REQUIRE(impl->ioctl(0, CTRL_SYNC, NULL) == RES_OK);
+    CHECK(write_count == 2);
+    CHECK(flash_has(0, a));
+    CHECK(flash_has(2, b));
+    CHECK(flash_has(4, c));
+
+    ff_diskio_clear_pdrv_wl(0);
+}
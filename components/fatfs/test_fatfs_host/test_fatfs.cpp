@@ -1,5 +1,8 @@
 #include <stdio.h>
 #include <string.h>
+#include <string>
+#include <vector>
+#include <time.h>
 
 #include "ff.h"
 #include "esp_partition.h"
@@ -91,3 +94,348 @@ TEST_CASE("create volume, open file, write and read back data", "[fatfs]")
     free(read);
     free(data);
 }
+
+extern "C" int spi_flash_get_total_erase_cycles(void);
+
+TEST_CASE("appending to a file erases only sectors which need it", "[fatfs]")
+{
+    _spi_flash_init(CONFIG_ESPTOOLPY_FLASHSIZE, CONFIG_WL_SECTOR_SIZE * 16, CONFIG_WL_SECTOR_SIZE, CONFIG_WL_SECTOR_SIZE, "partition_table.bin");
+
+    FRESULT fr_result;
+    BYTE pdrv;
+    FATFS fs;
+    FIL file;
+    UINT bw;
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, "storage");
+
+    wl_handle_t wl_handle;
+    REQUIRE(wl_mount(partition, &wl_handle) == ESP_OK);
+    REQUIRE(ff_diskio_get_drive(&pdrv) == ESP_OK);
+    REQUIRE(ff_diskio_register_wl_partition(pdrv, wl_handle) == ESP_OK);
+
+    char drv[3] = {(char)('0' + pdrv), ':', 0};
+    DWORD part_list[] = {100, 0, 0, 0};
+    BYTE work_area[FF_MAX_SS];
+    REQUIRE(f_fdisk(pdrv, part_list, work_area) == FR_OK);
+    REQUIRE(f_mkfs(drv, FM_ANY, 0, work_area, sizeof(work_area)) == FR_OK);
+    REQUIRE(f_mount(&fs, drv, 0) == FR_OK);
+
+    std::string path = std::string(drv) + "log.txt";
+    fr_result = f_open(&file, path.c_str(), FA_OPEN_ALWAYS | FA_WRITE);
+    REQUIRE(fr_result == FR_OK);
+
+    // Append small records like a logger would, syncing after each one
+    const int records = 200;
+    char record[64];
+    int erases_before = spi_flash_get_total_erase_cycles();
+    for (int i = 0; i < records; i++) {
+        memset(record, 'a' + i % 26, sizeof(record));
+        fr_result = f_write(&file, record, sizeof(record), &bw);
+        REQUIRE(fr_result == FR_OK);
+        REQUIRE(bw == sizeof(record));
+        REQUIRE(f_sync(&file) == FR_OK);
+    }
+    int erases = spi_flash_get_total_erase_cycles() - erases_before;
+    printf("%d appends with f_sync: %d flash sector erases\n", records, erases);
+    // Only the directory entry (file size) needs an erase per sync, appended data doesn't
+    CHECK(erases < records * 3 / 2);
+
+    REQUIRE(f_close(&file) == FR_OK);
+
+    // Read back what was appended
+    REQUIRE(f_open(&file, path.c_str(), FA_READ) == FR_OK);
+    for (int i = 0; i < records; i++) {
+        REQUIRE(f_read(&file, record, sizeof(record), &bw) == FR_OK);
+        REQUIRE(bw == sizeof(record));
+        CHECK(record[0] == 'a' + i % 26);
+        CHECK(record[sizeof(record) - 1] == 'a' + i % 26);
+    }
+    REQUIRE(f_close(&file) == FR_OK);
+
+    REQUIRE(f_mount(0, drv, 0) == FR_OK);
+    ff_diskio_clear_pdrv_wl(wl_handle);
+    ff_diskio_register(pdrv, NULL);
+    REQUIRE(wl_unmount(wl_handle) == ESP_OK);
+}
+
+/* Formats and mounts the "storage" partition on the next free drive */
+struct TestVolume {
+    BYTE pdrv;
+    wl_handle_t wl_handle;
+    FATFS fs;
+    char drv[3];
+
+    TestVolume()
+    {
+        _spi_flash_init(CONFIG_ESPTOOLPY_FLASHSIZE, CONFIG_WL_SECTOR_SIZE * 16, CONFIG_WL_SECTOR_SIZE, CONFIG_WL_SECTOR_SIZE, "partition_table.bin");
+        const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, "storage");
+        REQUIRE(wl_mount(partition, &wl_handle) == ESP_OK);
+        REQUIRE(ff_diskio_get_drive(&pdrv) == ESP_OK);
+        REQUIRE(ff_diskio_register_wl_partition(pdrv, wl_handle) == ESP_OK);
+        drv[0] = '0' + pdrv;
+        drv[1] = ':';
+        drv[2] = 0;
+        DWORD part_list[] = {100, 0, 0, 0};
+        BYTE work_area[FF_MAX_SS];
+        REQUIRE(f_fdisk(pdrv, part_list, work_area) == FR_OK);
+        REQUIRE(f_mkfs(drv, FM_ANY, 0, work_area, sizeof(work_area)) == FR_OK);
+        REQUIRE(f_mount(&fs, drv, 0) == FR_OK);
+    }
+
+    ~TestVolume()
+    {
+        f_mount(0, drv, 0);
+        ff_diskio_clear_pdrv_wl(wl_handle);
+        ff_diskio_register(pdrv, NULL);
+        wl_unmount(wl_handle);
+    }
+
+    std::string path(const char *name)
+    {
+        return std::string(drv) + name;
+    }
+};
+
+static uint32_t file_word(uint32_t offset, uint32_t seed)
+{
+    return offset * 2654435761u + seed;
+}
+
+/* Writes two files in turns, chunk by chunk, so that both are fragmented */
+static void write_interleaved(FIL *files, uint32_t file_size, uint32_t chunk_size)
+{
+    std::vector<uint32_t> chunk(chunk_size / sizeof(uint32_t));
+    for (uint32_t offset = 0; offset < file_size; offset += chunk_size) {
+        for (uint32_t f = 0; f < 2; f++) {
+            for (uint32_t i = 0; i < chunk.size(); i++) {
+                chunk[i] = file_word(offset + i * sizeof(uint32_t), f);
+            }
+            UINT bw;
+            REQUIRE(f_write(&files[f], chunk.data(), chunk_size, &bw) == FR_OK);
+            REQUIRE(bw == chunk_size);
+        }
+    }
+}
+
+TEST_CASE("f_pread and f_pwrite don't move the file pointer", "[fatfs]")
+{
+    TestVolume volume;
+    FIL files[2];
+    REQUIRE(f_open(&files[0], volume.path("a.bin").c_str(), FA_CREATE_ALWAYS | FA_READ | FA_WRITE) == FR_OK);
+    REQUIRE(f_open(&files[1], volume.path("b.bin").c_str(), FA_CREATE_ALWAYS | FA_READ | FA_WRITE) == FR_OK);
+    const uint32_t file_size = 64 * 1024;
+    write_interleaved(files, file_size, 8 * 1024);
+    FIL *file = &files[0];
+
+    REQUIRE(f_lseek(file, 1000) == FR_OK);
+    uint32_t word;
+    UINT br, bw;
+    // Unaligned, crossing sector and fragment boundaries
+    const uint32_t offsets[] = {0, 4, 4092, 8188, 8192, 40000, file_size - 4};
+    for (uint32_t offset : offsets) {
+        REQUIRE(f_pread(file, &word, sizeof(word), offset, &br) == FR_OK);
+        CHECK(br == sizeof(word));
+        CHECK(word == file_word(offset, 0));
+    }
+    std::vector<uint32_t> big(3 * 4096 / sizeof(uint32_t));
+    REQUIRE(f_pread(file, big.data(), big.size() * sizeof(uint32_t), 8192 - 4096, &br) == FR_OK);
+    CHECK(br == big.size() * sizeof(uint32_t));
+    for (uint32_t i = 0; i < big.size(); i++) {
+        CHECK(big[i] == file_word(4096 + i * sizeof(uint32_t), 0));
+    }
+    REQUIRE(f_pread(file, &word, sizeof(word), file_size - 2, &br) == FR_OK);
+    CHECK(br == 2);
+    REQUIRE(f_pread(file, &word, sizeof(word), file_size, &br) == FR_OK);
+    CHECK(br == 0);
+    CHECK(f_tell(file) == 1000);
+
+    word = 0xdeadbeef;
+    REQUIRE(f_pwrite(file, &word, sizeof(word), 8190, &bw) == FR_OK);
+    CHECK(bw == sizeof(word));
+    REQUIRE(f_pwrite(file, &word, sizeof(word), file_size - 2, &bw) == FR_OK);
+    CHECK(bw == 2);
+    CHECK(f_tell(file) == 1000);
+    CHECK(f_size(file) == file_size);
+
+    // Visible through the file pointer, and after reopening
+    uint32_t words[2];
+    REQUIRE(f_lseek(file, 8188) == FR_OK);
+    REQUIRE(f_read(file, words, sizeof(words), &br) == FR_OK);
+    CHECK(words[0] == ((file_word(8188, 0) & 0xffff) | 0xbeef0000));
+    CHECK(words[1] == ((file_word(8192, 0) & 0xffff0000) | 0xdead));
+    REQUIRE(f_close(file) == FR_OK);
+    REQUIRE(f_open(file, volume.path("a.bin").c_str(), FA_READ) == FR_OK);
+    REQUIRE(f_pread(file, words, sizeof(words), 8188, &br) == FR_OK);
+    CHECK(words[0] == ((file_word(8188, 0) & 0xffff) | 0xbeef0000));
+    CHECK(words[1] == ((file_word(8192, 0) & 0xffff0000) | 0xdead));
+    REQUIRE(f_close(&files[0]) == FR_OK);
+    REQUIRE(f_close(&files[1]) == FR_OK);
+}
+
+extern "C" {
+DSTATUS ff_wl_initialize(BYTE pdrv);
+DSTATUS ff_wl_status(BYTE pdrv);
+DRESULT ff_wl_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+DRESULT ff_wl_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+DRESULT ff_wl_ioctl(BYTE pdrv, BYTE cmd, void *buff);
+}
+
+static int s_disk_reads;
+
+static DRESULT counting_wl_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count)
+{
+    s_disk_reads++;
+    return ff_wl_read(pdrv, buff, sector, count);
+}
+
+static const ff_diskio_impl_t counting_wl_impl = {
+    .init = &ff_wl_initialize,
+    .status = &ff_wl_status,
+    .read = &counting_wl_read,
+    .write = &ff_wl_write,
+    .ioctl = &ff_wl_ioctl
+};
+
+TEST_CASE("random reads from a large fragmented file use the cluster link map", "[fatfs][fastseek]")
+{
+    TestVolume volume;
+    ff_diskio_register(volume.pdrv, &counting_wl_impl);
+    FIL files[2];
+    REQUIRE(f_open(&files[0], volume.path("a.bin").c_str(), FA_CREATE_ALWAYS | FA_READ | FA_WRITE) == FR_OK);
+    REQUIRE(f_open(&files[1], volume.path("b.bin").c_str(), FA_CREATE_ALWAYS | FA_READ | FA_WRITE) == FR_OK);
+    const uint32_t file_size = 1536 * 1024;
+    write_interleaved(files, file_size, 32 * 1024);
+    REQUIRE(f_close(&files[1]) == FR_OK);
+    FIL *file = &files[0];
+
+    const int reads = 2000;
+    std::vector<uint32_t> offsets;
+    uint32_t rnd = 1;
+    for (int i = 0; i < reads; i++) {
+        rnd = rnd * 1103515245 + 12345;
+        offsets.push_back((rnd >> 8) % (file_size / sizeof(uint32_t) - 64) * sizeof(uint32_t));
+    }
+    uint32_t data[64];
+    UINT br;
+
+    // Seek and read, following the cluster chain in the FAT
+    ff_diskio_cache_stats_t stats;
+    ff_diskio_reset_cache_stats(volume.pdrv);
+    s_disk_reads = 0;
+    clock_t start = clock();
+    for (uint32_t offset : offsets) {
+        REQUIRE(f_lseek(file, offset) == FR_OK);
+        REQUIRE(f_read(file, data, sizeof(data), &br) == FR_OK);
+        REQUIRE(data[0] == file_word(offset, 0));
+    }
+    clock_t chain_time = clock() - start;
+    // Sector reads, including those served by the sector cache (if enabled)
+    int chain_reads = s_disk_reads;
+    if (ff_diskio_get_cache_stats(volume.pdrv, &stats) == ESP_OK) {
+        chain_reads += stats.hits;
+    }
+
+    DWORD linkmap[128];
+    linkmap[0] = 128;
+    REQUIRE(f_fastseek(file, linkmap) == FR_OK);
+    // 48 fragments, two DWORDs each, plus the size and the terminator
+    CHECK(linkmap[0] == 2 * 48 + 2);
+
+    ff_diskio_reset_cache_stats(volume.pdrv);
+    s_disk_reads = 0;
+    start = clock();
+    for (uint32_t offset : offsets) {
+        REQUIRE(f_pread(file, data, sizeof(data), offset, &br) == FR_OK);
+        REQUIRE(br == sizeof(data));
+        REQUIRE(data[0] == file_word(offset, 0));
+        REQUIRE(data[63] == file_word(offset + 63 * sizeof(uint32_t), 0));
+    }
+    clock_t linkmap_time = clock() - start;
+    int linkmap_reads = s_disk_reads;
+    if (ff_diskio_get_cache_stats(volume.pdrv, &stats) == ESP_OK) {
+        linkmap_reads += stats.hits;
+    }
+
+    printf("%d random reads of %d bytes from a %d kB file in %d fragments:\n", reads, (int)sizeof(data), file_size / 1024, 48);
+    printf("  f_lseek + f_read:      %5d sector reads, %.1f ms\n", chain_reads, chain_time * 1000.0 / CLOCKS_PER_SEC);
+    printf("  link map and f_pread:  %5d sector reads, %.1f ms\n", linkmap_reads, linkmap_time * 1000.0 / CLOCKS_PER_SEC);
+    // Only the data is read, no FAT sectors
+    CHECK(linkmap_reads < reads + reads / 8);
+    CHECK(linkmap_reads < chain_reads);
+
+    // Files can't grow in fast seek mode
+    REQUIRE(f_fastseek(file, NULL) == FR_OK);
+    REQUIRE(f_close(file) == FR_OK);
+}
+
+#if CONFIG_FATFS_SECTOR_CACHE_SIZE > 0
+TEST_CASE("sector cache serves repeated metadata reads and writes back on unmount", "[fatfs][cache]")
+{
+    TestVolume volume;
+    ff_diskio_register(volume.pdrv, &counting_wl_impl);
+    const int n_files = 32;
+    REQUIRE(f_mkdir(volume.path("dir").c_str()) == FR_OK);
+    for (int i = 0; i < n_files; i++) {
+        FIL file;
+        UINT bw;
+        std::string path = volume.path("dir/file") + std::to_string(i) + ".txt";
+        std::string data = "contents of file " + std::to_string(i);
+        REQUIRE(f_open(&file, path.c_str(), FA_CREATE_NEW | FA_WRITE) == FR_OK);
+        REQUIRE(f_write(&file, data.c_str(), data.size(), &bw) == FR_OK);
+        REQUIRE(f_close(&file) == FR_OK);
+    }
+
+    // Start from an empty cache
+    REQUIRE(f_mount(0, volume.drv, 0) == FR_OK);
+    ff_diskio_register(volume.pdrv, &counting_wl_impl);
+    REQUIRE(f_mount(&volume.fs, volume.drv, 1) == FR_OK);
+
+    // Scan the directory and stat every file a few times
+    ff_diskio_reset_cache_stats(volume.pdrv);
+    s_disk_reads = 0;
+    const int scans = 4;
+    for (int scan = 0; scan < scans; scan++) {
+        FF_DIR dir;
+        FILINFO info;
+        int found = 0;
+        REQUIRE(f_opendir(&dir, volume.path("dir").c_str()) == FR_OK);
+        while (f_readdir(&dir, &info) == FR_OK && info.fname[0]) {
+            std::string path = volume.path("dir/") + info.fname;
+            FILINFO file_info;
+            REQUIRE(f_stat(path.c_str(), &file_info) == FR_OK);
+            CHECK(file_info.fsize == info.fsize);
+            found++;
+        }
+        REQUIRE(f_closedir(&dir) == FR_OK);
+        CHECK(found == n_files);
+    }
+    ff_diskio_cache_stats_t stats;
+    REQUIRE(ff_diskio_get_cache_stats(volume.pdrv, &stats) == ESP_OK);
+    printf("%d scans of a directory with %d files: %d sector cache hits, %d misses\n",
+           scans, n_files, (int)stats.hits, (int)stats.misses);
+    CHECK(stats.misses == s_disk_reads);
+    CHECK(stats.hits > stats.misses * 10);
+
+    // Changes which are not synced yet are written back when the drive is unregistered
+    FIL file;
+    UINT bw;
+    REQUIRE(f_open(&file, volume.path("dir/file0.txt").c_str(), FA_WRITE) == FR_OK);
+    REQUIRE(f_write(&file, "CONTENTS", 8, &bw) == FR_OK);
+    REQUIRE(f_close(&file) == FR_OK);
+    REQUIRE(ff_diskio_get_cache_stats(volume.pdrv, &stats) == ESP_OK);
+    CHECK(stats.writebacks > 0);
+    REQUIRE(f_mkdir(volume.path("unsynced").c_str()) == FR_OK);
+    REQUIRE(f_mount(0, volume.drv, 0) == FR_OK);
+    ff_diskio_register(volume.pdrv, &counting_wl_impl);
+    REQUIRE(f_mount(&volume.fs, volume.drv, 1) == FR_OK);
+
+    FILINFO info;
+    CHECK(f_stat(volume.path("unsynced").c_str(), &info) == FR_OK);
+    char buf[32] = {};
+    REQUIRE(f_open(&file, volume.path("dir/file0.txt").c_str(), FA_READ) == FR_OK);
+    REQUIRE(f_read(&file, buf, sizeof(buf) - 1, &bw) == FR_OK);
+    CHECK(std::string(buf) == "CONTENTS of file 0");
+    REQUIRE(f_close(&file) == FR_OK);
+}
+#endif
@@ -270,8 +270,69 @@ static int fresult_to_errno(FRESULT fr)
     return ENOTSUP;
 }
 
+#if FF_USE_FASTSEEK
+/* Initial size of a cluster link map, in DWORDs. Enough for a file in up to 7 fragments. */
+#define LINKMAP_INITIAL_SIZE 16
+
+/**
+ * @brief Switch a file which is accessed at random positions to fast seek mode
+ * The cluster link map is created once, the first time the file is accessed at a
+ * random position. If it can't be created, the file is accessed without it.
+ * Files open for writing are left alone, as the map would have to be rebuilt
+ * every time the file grows.
+ * @param ctx vfs_fat_ctx_t context
+ * @param file file to create the link map for
+ */
+static void file_create_linkmap(vfs_fat_ctx_t* ctx, FIL* file)
+{
+    if (file->cltbl != NULL || f_size(file) == 0 || (file->flag & FA_WRITE)) {
+        return;
+    }
+    _lock_acquire(&ctx->lock);
+    DWORD size = LINKMAP_INITIAL_SIZE;
+    while (file->cltbl == NULL) {
+        DWORD* tbl = ff_memalloc(size * sizeof(DWORD));
+        if (tbl == NULL) {
+            break;
+        }
+        tbl[0] = size;
+        FRESULT res = f_fastseek(file, tbl);
+        if (res != FR_OK) {
+            // on FR_NOT_ENOUGH_CORE, the required size is returned in tbl[0]
+            size = (res == FR_NOT_ENOUGH_CORE && tbl[0] > size) ? tbl[0] : 0;
+            ff_memfree(tbl);
+            if (size == 0) {
+                ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
+                break;
+            }
+        }
+    }
+    _lock_release(&ctx->lock);
+}
+
+/**
+ * @brief Switch a file back to normal mode
+ * FatFs can't grow files in fast seek mode, so this needs to be done before
+ * anything which extends the file.
+ */
+static void file_drop_linkmap(FIL* file)
+{
+    DWORD* tbl = file->cltbl;
+    if (tbl != NULL) {
+        f_fastseek(file, NULL);
+        ff_memfree(tbl);
+    }
+}
+#else
+static inline void file_create_linkmap(vfs_fat_ctx_t* ctx, FIL* file) {}
+static inline void file_drop_linkmap(FIL* file) {}
+#endif // FF_USE_FASTSEEK
+
 static void file_cleanup(vfs_fat_ctx_t* ctx, int fd)
 {
+#if FF_USE_FASTSEEK
+    ff_memfree(ctx->files[fd].cltbl);
+#endif
     memset(&ctx->files[fd], 0, sizeof(FIL));
 }
 
@@ -338,6 +399,9 @@ static ssize_t vfs_fat_write(void* ctx, int fd, const void * data, size_t size)
             return -1;
         }
     }
+    if (f_tell(file) + size > f_size(file)) {
+        file_drop_linkmap(file);
+    }
     unsigned written = 0;
     res = f_write(file, data, size, &written);
     if (res != FR_OK) {
@@ -368,49 +432,53 @@ static ssize_t vfs_fat_read(void* ctx, int fd, void * dst, size_t size)
 
 static ssize_t vfs_fat_pread(void *ctx, int fd, void *dst, size_t size, off_t offset)
 {
-    ssize_t ret = -1;
     vfs_fat_ctx_t *fat_ctx = (vfs_fat_ctx_t *) ctx;
-    _lock_acquire(&fat_ctx->lock);
     FIL *file = &fat_ctx->files[fd];
-    const off_t prev_pos = f_tell(file);
-
-    FRESULT f_res = f_lseek(file, offset);
-    if (f_res != FR_OK) {
-        ESP_LOGD(TAG, "%s: fresult=%d", __func__, f_res);
-        errno = fresult_to_errno(f_res);
-        goto pread_release;
+    if (offset < 0) {
+        errno = EINVAL;
+        return -1;
     }
-
+    file_create_linkmap(fat_ctx, file);
+    // f_pread doesn't move the file pointer, so no lock is needed to restore it
     unsigned read = 0;
-    f_res = f_read(file, dst, size, &read);
-    if (f_res == FR_OK) {
-        ret = read;
-    } else {
-        ESP_LOGD(TAG, "%s: fresult=%d", __func__, f_res);
-        errno = fresult_to_errno(f_res);
-        // No return yet - need to restore previous position
-    }
-
-    f_res = f_lseek(file, prev_pos);
+    FRESULT f_res = f_pread(file, dst, size, offset, &read);
     if (f_res != FR_OK) {
         ESP_LOGD(TAG, "%s: fresult=%d", __func__, f_res);
-        if (ret >= 0) {
-            errno = fresult_to_errno(f_res);
-        } // else f_read failed so errno shouldn't be overwritten
-        ret = -1; // in case the read was successful but the seek wasn't
+        errno = fresult_to_errno(f_res);
+        if (read == 0) {
+            return -1;
+        }
     }
-
-pread_release:
-    _lock_release(&fat_ctx->lock);
-    return ret;
+    return read;
 }
 
 static ssize_t vfs_fat_pwrite(void *ctx, int fd, const void *src, size_t size, off_t offset)
 {
     ssize_t ret = -1;
     vfs_fat_ctx_t *fat_ctx = (vfs_fat_ctx_t *) ctx;
-    _lock_acquire(&fat_ctx->lock);
     FIL *file = &fat_ctx->files[fd];
+    if (offset < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (offset + size <= f_size(file)) {
+        // Writing inside the file doesn't need the file pointer either
+        file_create_linkmap(fat_ctx, file);
+        unsigned wr = 0;
+        FRESULT f_res = f_pwrite(file, src, size, offset, &wr);
+        if (f_res != FR_OK) {
+            ESP_LOGD(TAG, "%s: fresult=%d", __func__, f_res);
+            errno = fresult_to_errno(f_res);
+            if (wr == 0) {
+                return -1;
+            }
+        }
+        return wr;
+    }
+
+    // The file grows: seek, write and seek back
+    _lock_acquire(&fat_ctx->lock);
+    file_drop_linkmap(file);
     const off_t prev_pos = f_tell(file);
 
     FRESULT f_res = f_lseek(file, offset);
@@ -494,6 +562,12 @@ static off_t vfs_fat_lseek(void* ctx, int fd, off_t offset, int mode)
         errno = EINVAL;
         return -1;
     }
+    if (new_pos > f_size(file)) {
+        // f_lseek would clip the position at the end of the file in fast seek mode
+        file_drop_linkmap(file);
+    } else if (new_pos < f_size(file) && new_pos != f_tell(file)) {
+        file_create_linkmap(fat_ctx, file);
+    }
     FRESULT res = f_lseek(file, new_pos);
     if (res != FR_OK) {
         ESP_LOGD(TAG, "%s: fresult=%d", __func__, res);
@@ -20,5 +20,11 @@
 #endif
 
 #ifdef CONFIG_FREERTOS_DEBUG_OCDAWARE
+#if configUSE_PER_CORE_READY_LISTS
+/* pxReadyTasksLists holds a group of configMAX_PRIORITIES lists for each core and
+ * one for unpinned tasks, let OpenOCD walk all of them */
+const int USED DRAM_ATTR uxTopUsedPriority = configMAX_PRIORITIES * (portNUM_PROCESSORS + 1) - 1;
+#else
 const int USED DRAM_ATTR uxTopUsedPriority = configMAX_PRIORITIES - 1;
 #endif
+#endif
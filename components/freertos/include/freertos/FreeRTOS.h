@@ -774,6 +774,10 @@ extern "C" {
 	#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
 #endif
 
+#ifndef configUSE_PER_CORE_READY_LISTS
+	#define configUSE_PER_CORE_READY_LISTS 0
+#endif
+
 #ifndef configAPPLICATION_ALLOCATED_HEAP
 	#define configAPPLICATION_ALLOCATED_HEAP 0
 #endif
@@ -974,6 +978,7 @@ typedef struct xSTATIC_QUEUE
 
 	StaticList_t xDummy3[ 2 ];
 	UBaseType_t uxDummy4[ 3 ];
+	uint8_t ucDummy5;
 
 	#if( ( configSUPPORT_STATIC_ALLOCATION == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
 		uint8_t ucDummy6;
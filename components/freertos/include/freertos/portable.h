@@ -126,9 +126,6 @@ extern "C" {
 #include "mpu_wrappers.h"
 #include "esp_system.h"
 
-#include "hal/cpu_hal.h"
-#include "xt_instr_macros.h"
-
 /*
  * Setup the stack of a new task so it is ready to be placed under the
  * scheduler control.  The registers have to be placed on the stack in
@@ -200,42 +197,12 @@ BaseType_t xPortInterruptedFromISRContext(void);
 	void vPortReleaseTaskMPUSettings( xMPU_SETTINGS *xMPUSettings );
 #endif
 
-/* Multi-core: get current core ID */
-static inline uint32_t IRAM_ATTR xPortGetCoreID(void) {
-    return cpu_hal_get_core_id();
-}
-
 /* Get tick rate per second */
 uint32_t xPortGetTickRateHz(void);
 
-
-static inline bool IRAM_ATTR xPortCanYield(void)
-{
-    uint32_t ps_reg = 0;
-
-    //Get the current value of PS (processor status) register
-    RSR(PS, ps_reg);
-
-    /*
-     * intlevel = (ps_reg & 0xf);
-     * excm  = (ps_reg >> 4) & 0x1;
-     * CINTLEVEL is max(excm * EXCMLEVEL, INTLEVEL), where EXCMLEVEL is 3.
-     * However, just return true, only intlevel is zero.
-     */
-
-    return ((ps_reg & PS_INTLEVEL_MASK) == 0);
-}
-
 #ifdef __cplusplus
 }
 #endif
 
-static inline void uxPortCompareSetExtram(volatile uint32_t *addr, uint32_t compare, uint32_t *set) 
-{
-#if defined(CONFIG_ESP32_SPIRAM_SUPPORT)    
-    compare_and_set_extram(addr, compare, set);
-#endif    
-}
-
 #endif /* PORTABLE_H */
 
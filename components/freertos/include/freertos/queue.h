@@ -114,6 +114,7 @@ typedef void * QueueSetMemberHandle_t;
 #define queueQUEUE_TYPE_COUNTING_SEMAPHORE	( ( uint8_t ) 2U )
 #define queueQUEUE_TYPE_BINARY_SEMAPHORE	( ( uint8_t ) 3U )
 #define queueQUEUE_TYPE_RECURSIVE_MUTEX		( ( uint8_t ) 4U )
+#define queueQUEUE_TYPE_ZERO_COPY			( ( uint8_t ) 5U )
 
 /** @endcond */
 
@@ -1631,6 +1632,144 @@ QueueSetMemberHandle_t xQueueSelectFromSet( QueueSetHandle_t xQueueSet, const Ti
  */
 QueueSetMemberHandle_t xQueueSelectFromSetFromISR( QueueSetHandle_t xQueueSet ) PRIVILEGED_FUNCTION;
 
+/**
+ * Creates a zero copy queue.  A zero copy queue owns a pool of uxQueueLength
+ * fixed size blocks.  Instead of copying items in and out of the queue, a
+ * sender takes a free block from the pool with xQueueSendAcquire(), fills it
+ * in place and posts it with xQueueSendComplete().  The receiver gets the
+ * posted block with pvQueueReceiveInPlace(), reads it in place and gives it
+ * back to the pool with vQueueReturnItem().  Only the block pointers are
+ * copied, so the cost of passing an item does not depend on its size.
+ *
+ * Taking a block from the pool and giving it back each cost a critical
+ * section of the queue in addition to the send and the receive, so a zero copy
+ * queue only pays off for items large enough that copying them in and out
+ * costs more than that.  For small items use xQueueCreate().
+ *
+ * Zero copy queues can be added to a queue set and deleted with vQueueDelete(),
+ * which also frees the pool.  They must not be reset with xQueueReset(), and
+ * the other send and receive functions must not be used on them.
+ *
+ * @param uxQueueLength The number of blocks in the pool, which is also the
+ * maximum number of items that the queue can contain.
+ *
+ * @param uxItemSize The size of each block in bytes.
+ *
+ * @return A handle to the created queue, or NULL if there was not enough
+ * memory to create the queue and its pool.
+ *
+ * Example usage:
+ * @code{c}
+ *  struct AMessage
+ *  {
+ *  char ucMessageID;
+ *  char ucData[ 200 ];
+ *  };
+ *
+ *  QueueHandle_t xQueue = xQueueCreateZeroCopy( 10, sizeof( struct AMessage ) );
+ *
+ *  void vSendingTask( void *pvParameters )
+ *  {
+ *  struct AMessage *pxMessage;
+ *
+ *      if( xQueueSendAcquire( xQueue, ( void ** ) &pxMessage, portMAX_DELAY ) == pdTRUE )
+ *      {
+ *          pxMessage->ucMessageID = 1;
+ *          // ... Fill pxMessage->ucData.
+ *          xQueueSendComplete( xQueue, pxMessage );
+ *      }
+ *  }
+ *
+ *  void vReceivingTask( void *pvParameters )
+ *  {
+ *  struct AMessage *pxMessage;
+ *
+ *      pxMessage = pvQueueReceiveInPlace( xQueue, portMAX_DELAY );
+ *      if( pxMessage != NULL )
+ *      {
+ *          // ... Use the message without copying it.
+ *          vQueueReturnItem( xQueue, pxMessage );
+ *      }
+ *  }
+ * @endcode
+ * \ingroup QueueManagement
+ */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	QueueHandle_t xQueueCreateZeroCopy( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * Takes a free block from the pool of a zero copy queue.  The block must be
+ * passed to xQueueSendComplete() or given back with vQueueReturnItem().
+ *
+ * @param xQueue A queue created with xQueueCreateZeroCopy().
+ *
+ * @param ppvItem Set to the block taken from the pool.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for a block to become free.
+ *
+ * @return pdTRUE if a block was taken, otherwise pdFALSE.
+ */
+BaseType_t xQueueSendAcquire( QueueHandle_t xQueue, void **ppvItem, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * A version of xQueueSendAcquire() that can be used from an ISR.
+ */
+BaseType_t xQueueSendAcquireFromISR( QueueHandle_t xQueue, void **ppvItem ) PRIVILEGED_FUNCTION;
+
+/**
+ * Posts a block taken with xQueueSendAcquire() to the back of a zero copy
+ * queue.  The queue has space for every block of its pool, so this never
+ * blocks.
+ *
+ * @param xQueue A queue created with xQueueCreateZeroCopy().
+ *
+ * @param pvItem The block to post.
+ *
+ * @return pdPASS.
+ */
+BaseType_t xQueueSendComplete( QueueHandle_t xQueue, void *pvItem ) PRIVILEGED_FUNCTION;
+
+/**
+ * A version of xQueueSendComplete() that can be used from an ISR.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if posting the block
+ * unblocked a task with a priority higher than the running task.
+ */
+BaseType_t xQueueSendCompleteFromISR( QueueHandle_t xQueue, void *pvItem, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * Receives a block from a zero copy queue without copying it.  The block
+ * stays owned by the caller until it is given back with vQueueReturnItem().
+ *
+ * @param xQueue A queue created with xQueueCreateZeroCopy().
+ *
+ * @param xTicksToWait The maximum amount of time the task should block
+ * waiting for an item.
+ *
+ * @return The received block, or NULL if the queue stayed empty.
+ */
+void *pvQueueReceiveInPlace( QueueHandle_t xQueue, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * Gives a block back to the pool of a zero copy queue.
+ *
+ * @param xQueue A queue created with xQueueCreateZeroCopy().
+ *
+ * @param pvItem A block returned by pvQueueReceiveInPlace() or taken with
+ * xQueueSendAcquire().
+ */
+void vQueueReturnItem( QueueHandle_t xQueue, void *pvItem ) PRIVILEGED_FUNCTION;
+
+/**
+ * A version of vQueueReturnItem() that can be used from an ISR.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if giving back the block
+ * unblocked a task with a priority higher than the running task.
+ */
+void vQueueReturnItemFromISR( QueueHandle_t xQueue, void *pvItem, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
 /** @cond */
 /* Not public API functions. */
 void vQueueWaitForMessageRestricted( QueueHandle_t xQueue, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
@@ -0,0 +1,174 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * FreeRTOS configuration of the POSIX simulator port. Options are taken from sdkconfig.h like in
+ * the Xtensa port, so that the kernel is built the same way as on the target.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include "sdkconfig.h"
+
+/* enable use of optimized task selection by the scheduler */
+#ifdef CONFIG_FREERTOS_OPTIMIZED_SCHEDULER
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
+#endif
+
+/* keep separate ready lists for the tasks pinned to each core */
+#ifdef CONFIG_FREERTOS_PER_CORE_READY_LISTS
+#define configUSE_PER_CORE_READY_LISTS 1
+#endif
+
+/* Number of simulated cores */
+#ifndef CONFIG_FREERTOS_UNICORE
+#define portNUM_PROCESSORS 2
+#else
+#define portNUM_PROCESSORS 1
+#endif
+
+#define portUSING_MPU_WRAPPERS 0
+#define configUSE_MUTEX 1
+
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS
+#define configTHREAD_LOCAL_STORAGE_DELETE_CALLBACKS 1
+
+/* configASSERT behaviour */
+#include <stdio.h>
+#include <stdlib.h> /* for abort() */
+
+#if defined(CONFIG_FREERTOS_ASSERT_DISABLE)
+#define configASSERT(a) /* assertions disabled */
+#elif defined(CONFIG_FREERTOS_ASSERT_FAIL_PRINT_CONTINUE)
+#define configASSERT(a) if (unlikely(!(a))) {                                     \
+        fprintf(stderr, "%s:%d (%s)- assert failed!\n", __FILE__, __LINE__,  \
+                __FUNCTION__);                                          \
+    }
+#else /* CONFIG_FREERTOS_ASSERT_FAIL_ABORT */
+#define configASSERT(a) if (unlikely(!(a))) {                                     \
+        fprintf(stderr, "%s:%d (%s)- assert failed!\n", __FILE__, __LINE__,  \
+                __FUNCTION__);                                          \
+        abort();                                                        \
+        }
+#endif
+
+#define UNTESTED_FUNCTION()
+
+/*-----------------------------------------------------------
+ * Application specific definitions.
+ *----------------------------------------------------------*/
+
+#define configUSE_PREEMPTION			1
+#define configUSE_IDLE_HOOK				1
+#define configUSE_TICK_HOOK				0
+
+#define configTICK_RATE_HZ				( CONFIG_FREERTOS_HZ )
+
+#define configMAX_PRIORITIES			( 25 )
+
+/* Task code runs on the stack of its host thread, the FreeRTOS stack only holds a pointer to the thread */
+#define configMINIMAL_STACK_SIZE		768
+
+#ifndef configIDLE_TASK_STACK_SIZE
+#define configIDLE_TASK_STACK_SIZE CONFIG_FREERTOS_IDLE_TASK_STACKSIZE
+#endif
+
+#define configMAX_TASK_NAME_LEN			( CONFIG_FREERTOS_MAX_TASK_NAME_LEN )
+
+#ifdef CONFIG_FREERTOS_USE_TRACE_FACILITY
+#define configUSE_TRACE_FACILITY        1       /* Used by uxTaskGetSystemState(), and other trace facility functions */
+#endif
+
+#ifdef CONFIG_FREERTOS_USE_STATS_FORMATTING_FUNCTIONS
+#define configUSE_STATS_FORMATTING_FUNCTIONS    1   /* Used by vTaskList() */
+#endif
+
+#ifdef CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+#define configTASKLIST_INCLUDE_COREID   1
+#endif
+
+#ifdef CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+#define configGENERATE_RUN_TIME_STATS   1       /* Used by vTaskGetRunTimeStats() */
+#endif
+
+#define configUSE_TRACE_FACILITY_2      0
+#define configBENCHMARK					0
+#define configUSE_16_BIT_TICKS			0
+#define configIDLE_SHOULD_YIELD			0
+#define configQUEUE_REGISTRY_SIZE		CONFIG_FREERTOS_QUEUE_REGISTRY_SIZE
+
+#define configUSE_MUTEXES				1
+#define configUSE_RECURSIVE_MUTEXES		1
+#define configUSE_COUNTING_SEMAPHORES	1
+
+/* The stack canary would sit in memory the task code never touches */
+#define configCHECK_FOR_STACK_OVERFLOW	0
+
+/* Co-routine definitions. */
+#define configUSE_CO_ROUTINES 			0
+#define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
+
+/* Set the following definitions to 1 to include the API function, or zero
+   to exclude the API function. */
+
+#define INCLUDE_vTaskPrioritySet			1
+#define INCLUDE_uxTaskPriorityGet			1
+#define INCLUDE_vTaskDelete					1
+#define INCLUDE_vTaskCleanUpResources		0
+#define INCLUDE_vTaskSuspend				1
+#define INCLUDE_vTaskDelayUntil				1
+#define INCLUDE_vTaskDelay					1
+#define INCLUDE_uxTaskGetStackHighWaterMark	1
+#define INCLUDE_pcTaskGetTaskName			1
+#define INCLUDE_xTaskGetIdleTaskHandle      1
+#define INCLUDE_pxTaskGetStackStart			1
+
+#define INCLUDE_xSemaphoreGetMutexHolder    1
+
+/* The tick is the only simulated interrupt */
+#define configKERNEL_INTERRUPT_PRIORITY		1
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY	1
+
+#define configUSE_NEWLIB_REENTRANT		0
+
+#define configSUPPORT_DYNAMIC_ALLOCATION    1
+#define configSUPPORT_STATIC_ALLOCATION CONFIG_FREERTOS_SUPPORT_STATIC_ALLOCATION
+
+/* Ends the host thread of a deleted task */
+extern void vPortCleanUpThread( void *pxTCB );
+#define portCLEAN_UP_TCB( pxTCB )           vPortCleanUpThread( pxTCB )
+
+/* Test FreeRTOS timers (with timer task) and more. */
+/* Some files don't compile if this flag is disabled */
+#define configUSE_TIMERS                    1
+#define configTIMER_TASK_PRIORITY           CONFIG_FREERTOS_TIMER_TASK_PRIORITY
+#define configTIMER_QUEUE_LENGTH            CONFIG_FREERTOS_TIMER_QUEUE_LENGTH
+#define configTIMER_TASK_STACK_DEPTH        CONFIG_FREERTOS_TIMER_TASK_STACK_DEPTH
+
+#define INCLUDE_xTimerPendFunctionCall      1
+#define INCLUDE_eTaskGetState               1
+#define configUSE_QUEUE_SETS                1
+
+#define configUSE_TICKLESS_IDLE             0
+
+#define configENABLE_TASK_SNAPSHOT          1
+
+#if CONFIG_FREERTOS_CHECK_MUTEX_GIVEN_BY_OWNER
+#define configCHECK_MUTEX_GIVEN_BY_OWNER    1
+#else
+#define configCHECK_MUTEX_GIVEN_BY_OWNER    0
+#endif
+
+#endif /* FREERTOS_CONFIG_H */
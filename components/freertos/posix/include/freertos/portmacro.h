@@ -0,0 +1,275 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Port macros of the POSIX simulator port. Tasks run as host threads, see readme_posix.txt.
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sched.h>
+
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+/* newlib defines this for C++, the host C library doesn't */
+#if defined(__cplusplus) && !defined(_Static_assert)
+#define _Static_assert static_assert
+#endif
+
+/*-----------------------------------------------------------
+ * Port specific definitions.
+ *-----------------------------------------------------------
+ */
+
+/* Type definitions. */
+
+#define portCHAR		int8_t
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		int32_t
+#define portSHORT		int16_t
+#define portSTACK_TYPE	uint8_t
+#define portBASE_TYPE	int
+
+typedef portSTACK_TYPE			StackType_t;
+typedef portBASE_TYPE			BaseType_t;
+typedef unsigned portBASE_TYPE	UBaseType_t;
+
+#if( configUSE_16_BIT_TICKS == 1 )
+	typedef uint16_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffff
+#else
+	typedef uint32_t TickType_t;
+	#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
+#endif
+
+/* Host pointers may be 64 bit wide */
+#define portPOINTER_SIZE_TYPE	uintptr_t
+/*-----------------------------------------------------------*/
+
+/* Core the calling thread runs on. Task threads keep it while they are switched in, the tick thread
+   sets it to the core it delivers the tick interrupt to. */
+extern __thread uint32_t port_xCoreID;
+
+static inline uint32_t xPortGetCoreID(void)
+{
+	return port_xCoreID;
+}
+
+/* Interrupts of a simulated core are disabled by taking a lock of that core, which the tick
+   thread also takes to deliver the tick interrupt. Returns the previous state, nonzero if
+   interrupts were already disabled by the calling thread. */
+unsigned portENTER_CRITICAL_NESTED(void);
+void portEXIT_CRITICAL_NESTED(unsigned state);
+
+#define portDISABLE_INTERRUPTS()      portENTER_CRITICAL_NESTED()
+#define portENABLE_INTERRUPTS()       portEXIT_CRITICAL_NESTED(0)
+
+/* "mux" data structure (spinlock), a host atomic holding the core ID of the owner */
+typedef struct {
+	volatile uint32_t owner;
+	volatile uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_FREE_VAL		0xB33FFFFF
+#define portMUX_NO_TIMEOUT      (-1)  /* When passed for 'timeout', spin forever if necessary */
+#define portMUX_TRY_LOCK        0     /* Try to acquire the spinlock a single time only */
+#define portMUX_INITIALIZER_UNLOCKED  {.owner = portMUX_FREE_VAL, .count = 0}
+
+#define portASSERT_IF_IN_ISR()        vPortAssertIfInISR()
+void vPortAssertIfInISR(void);
+
+#define portCRITICAL_NESTING_IN_TCB 0
+
+static inline void __attribute__((always_inline)) vPortCPUInitializeMutex(portMUX_TYPE *mux)
+{
+	mux->owner = portMUX_FREE_VAL;
+	mux->count = 0;
+}
+
+/* 'timeout' counts attempts to take the lock rather than CPU cycles */
+static inline bool __attribute__((always_inline)) vPortCPUAcquireMutexTimeout(portMUX_TYPE *mux, int timeout)
+{
+	uint32_t core_id = xPortGetCoreID();
+	uint32_t expected = portMUX_FREE_VAL;
+
+	if (__atomic_load_n(&mux->owner, __ATOMIC_RELAXED) == core_id) {
+		/* Recursive lock by the same core */
+		mux->count++;
+		return true;
+	}
+	while (!__atomic_compare_exchange_n(&mux->owner, &expected, core_id, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		if (timeout == portMUX_TRY_LOCK || (timeout > 0 && --timeout == 0)) {
+			return false;
+		}
+		expected = portMUX_FREE_VAL;
+		/* The owner may be a thread sharing the host CPU with this one */
+		sched_yield();
+	}
+	mux->count = 1;
+	return true;
+}
+
+static inline void __attribute__((always_inline)) vPortCPUAcquireMutex(portMUX_TYPE *mux)
+{
+	vPortCPUAcquireMutexTimeout(mux, portMUX_NO_TIMEOUT);
+}
+
+static inline void __attribute__((always_inline)) vPortCPUReleaseMutex(portMUX_TYPE *mux)
+{
+	if (--mux->count == 0) {
+		__atomic_store_n(&mux->owner, portMUX_FREE_VAL, __ATOMIC_RELEASE);
+	}
+}
+
+void vPortEnterCritical(portMUX_TYPE *mux);
+void vPortExitCritical(portMUX_TYPE *mux);
+
+/*
+ * Returns true if called from the tick interrupt, the only interrupt of the simulator.
+ */
+BaseType_t xPortInIsrContext(void);
+
+static inline void __attribute__((always_inline)) vPortEnterCriticalCompliance(portMUX_TYPE *mux)
+{
+	if (xPortInIsrContext()) {
+		fprintf(stderr, "%s:%d (%s)- port*_CRITICAL called from ISR context!\n", __FILE__, __LINE__, __FUNCTION__);
+		abort();
+	}
+	vPortEnterCritical(mux);
+}
+
+static inline void __attribute__((always_inline)) vPortExitCriticalCompliance(portMUX_TYPE *mux)
+{
+	if (xPortInIsrContext()) {
+		fprintf(stderr, "%s:%d (%s)- port*_CRITICAL called from ISR context!\n", __FILE__, __LINE__, __FUNCTION__);
+		abort();
+	}
+	vPortExitCritical(mux);
+}
+
+#ifdef CONFIG_FREERTOS_CHECK_PORT_CRITICAL_COMPLIANCE
+#define portENTER_CRITICAL(mux)        vPortEnterCriticalCompliance(mux)
+#define portEXIT_CRITICAL(mux)         vPortExitCriticalCompliance(mux)
+#else
+#define portENTER_CRITICAL(mux)        vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)         vPortExitCritical(mux)
+#endif
+
+#define portENTER_CRITICAL_ISR(mux)    vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)     vPortExitCritical(mux)
+
+#define portENTER_CRITICAL_SAFE(mux)   vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_SAFE(mux)    vPortExitCritical(mux)
+
+/*
+ * Atomically compare *addr to 'compare'. If *addr == compare, *addr is set to *set. *set is updated
+ * with the previous value of *addr.
+ */
+static inline void __attribute__((always_inline)) uxPortCompareSet(volatile uint32_t *addr, uint32_t compare, uint32_t *set)
+{
+	uint32_t expected = compare;
+	__atomic_compare_exchange_n(addr, &expected, *set, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	*set = expected;
+}
+
+static inline void uxPortCompareSetExtram(volatile uint32_t *addr, uint32_t compare, uint32_t *set)
+{
+	uxPortCompareSet(addr, compare, set);
+}
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()            portENTER_CRITICAL_NESTED()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(state)     portEXIT_CRITICAL_NESTED(state)
+
+#define pvPortMallocTcbMem(size)    malloc(size)
+#define pvPortMallocStackMem(size)  malloc(size)
+
+/*-----------------------------------------------------------*/
+
+/* Architecture specifics. */
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT			8
+#define portNOP()					__asm__ volatile ("nop")
+/*-----------------------------------------------------------*/
+
+/* Run time stats are counted in microseconds of host monotonic time */
+uint32_t ulPortGetRunTimeCounterValue(void);
+#define portGET_RUN_TIME_COUNTER_VALUE()  ulPortGetRunTimeCounterValue()
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+
+/* Kernel utilities. */
+void vPortYield( void );
+#define portYIELD()					vPortYield()
+
+/* Yielding from an ISR or within an API call (when interrupts are off) is delayed until interrupts
+   are enabled on the core again, like the cross-core interrupt does on the target. */
+#define portYIELD_FROM_ISR()        vPortYieldOtherCore(xPortGetCoreID())
+#define portYIELD_WITHIN_API()      vPortYieldOtherCore(xPortGetCoreID())
+
+static inline bool xPortCanYield(void)
+{
+	extern __thread int port_xIrqDisabledCore;
+	return port_xIrqDisabledCore < 0 && !xPortInIsrContext();
+}
+
+/* Runs pxHandler as an interrupt of the core. Called from a host thread which isn't a task,
+   to deliver the interrupt of a simulated peripheral (like the esp_timer alarm) in host tests. */
+void vPortSimulateInterrupt(BaseType_t xCoreID, void (*pxHandler)(void *), void *pvArg);
+
+/*-----------------------------------------------------------*/
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+/* The idle task of a simulated core sleeps in the idle hook until there is work for the core */
+void vPortIdleHook( void );
+#define vApplicationIdleHook    vPortIdleHook
+
+/*-----------------------------------------------------------*/
+
+/* Architecture specific optimisations. */
+#if configUSE_PORT_OPTIMISED_TASK_SELECTION == 1
+
+/* Check the configuration. */
+#if( configMAX_PRIORITIES > 32 )
+    #error configUSE_PORT_OPTIMISED_TASK_SELECTION can only be set to 1 when configMAX_PRIORITIES is less than or equal to 32.  It is very rare that a system requires more than 10 to 15 different priorities as tasks that share a priority will time slice.
+#endif
+
+/* Store/clear the ready priorities in a bit map. */
+#define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) |= ( 1UL << ( uxPriority ) )
+#define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities ) ( uxReadyPriorities ) &= ~( 1UL << ( uxPriority ) )
+
+/*-----------------------------------------------------------*/
+
+#define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities ) uxTopPriority = ( 31 - __builtin_clz( ( uxReadyPriorities ) ) )
+
+#endif /* configUSE_PORT_OPTIMISED_TASK_SELECTION */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
@@ -1,4 +1,4 @@
-// Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
 //
 // Licensed under the Apache License, Version 2.0 (the "License");
 // you may not use this file except in compliance with the License.
@@ -11,20 +11,11 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
-#ifndef crc_h
-#define crc_h
 
-#include <stdint.h>
+/*
+ * Newlib location of the byte order macros, used by the esp_netif address types.
+ */
 
-#ifdef __cplusplus
-extern "C" {
-#endif
+#pragma once
 
-uint32_t crc32_le(uint32_t crc, const uint8_t* buf, size_t len);
-
-#ifdef __cplusplus
-}
-#endif
-
-
-#endif /* crc_h */
+#include <endian.h>
@@ -0,0 +1,22 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * FreeRTOS.h includes the newlib header, which the host C library doesn't have. The POSIX port
+ * doesn't use per task reentrancy structures (configUSE_NEWLIB_REENTRANT is 0).
+ */
+
+#pragma once
+
+struct _reent;
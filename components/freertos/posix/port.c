@@ -0,0 +1,410 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * POSIX simulator port, runs the ESP-IDF FreeRTOS SMP kernel on a Linux host.
+ *
+ * Every task is a host thread. A thread only runs task code while its task is switched in on
+ * one of the simulated cores; all other task threads wait on their condition variable, so at
+ * most portNUM_PROCESSORS tasks run at any time. Disabling interrupts on a core takes the
+ * interrupt lock of that core, and the tick thread takes the same lock to deliver the tick
+ * interrupt, so critical sections exclude the tick like on the target. Yields requested while
+ * interrupts are disabled, from the tick or from the other core are pending until the task
+ * switched in on the core enables interrupts again, see readme_posix.txt.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "sdkconfig.h"
+
+/* The task code runs on this stack, not on the FreeRTOS stack of the task */
+#define PORT_THREAD_STACK_SIZE      (256 * 1024)
+
+typedef struct {
+	pthread_t thread;
+	TaskFunction_t code;
+	void *params;
+	pthread_cond_t cond;
+	int core;           /* core the task was switched in on, -1 while the thread waits for that */
+	bool deleted;
+} port_thread_t;
+
+typedef struct {
+	pthread_mutex_t irq_lock;       /* held while interrupts are disabled on the core */
+	bool yield_pending;             /* switch context once interrupts are enabled */
+	pthread_cond_t idle_cond;       /* idle task of the core waits here for work */
+} port_core_t;
+
+__thread uint32_t port_xCoreID = 0;
+__thread int port_xIrqDisabledCore = -1;   /* core whose interrupts the calling thread disabled */
+
+BaseType_t port_uxCriticalNesting[portNUM_PROCESSORS] = {0};
+BaseType_t port_uxOldInterruptState[portNUM_PROCESSORS] = {0};
+
+static __thread port_thread_t *s_self;      /* NULL in threads that aren't tasks */
+static __thread bool s_in_isr;
+
+static port_core_t s_cores[portNUM_PROCESSORS];
+static pthread_once_t s_cores_init = PTHREAD_ONCE_INIT;
+
+/* Protects the hand over of cores between task threads */
+static pthread_mutex_t s_sched_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_end_cond = PTHREAD_COND_INITIALIZER;
+static bool s_scheduler_running;
+
+static void prvInitCores(void)
+{
+	for (int i = 0; i < portNUM_PROCESSORS; i++) {
+		pthread_mutex_init(&s_cores[i].irq_lock, NULL);
+		pthread_cond_init(&s_cores[i].idle_cond, NULL);
+	}
+}
+
+static inline bool prvYieldPending(uint32_t core_id)
+{
+	return __atomic_load_n(&s_cores[core_id].yield_pending, __ATOMIC_ACQUIRE);
+}
+
+/* pxTopOfStack, the first member of the TCB, points at the thread pointer stored by pxPortInitialiseStack() */
+static inline port_thread_t *prvGetThread(TaskHandle_t task)
+{
+	return **(port_thread_t ***)task;
+}
+
+/* Waits until the task of the calling thread is switched in, s_sched_lock must be held and is released */
+static void prvWaitForCore(port_thread_t *self)
+{
+	while (self->core < 0 && !self->deleted) {
+		pthread_cond_wait(&self->cond, &s_sched_lock);
+	}
+	if (self->deleted) {
+		pthread_mutex_unlock(&s_sched_lock);
+		pthread_cond_destroy(&self->cond);
+		free(self);
+		pthread_exit(NULL);
+	}
+	port_xCoreID = self->core;
+	self->core = -1;
+	pthread_mutex_unlock(&s_sched_lock);
+}
+
+static void *prvThreadEntry(void *arg)
+{
+	port_thread_t *self = (port_thread_t *)arg;
+
+	s_self = self;
+	pthread_mutex_lock(&s_sched_lock);
+	prvWaitForCore(self);
+
+	self->code(self->params);
+
+	//FreeRTOS tasks should not return. Log the task name and abort.
+	fprintf(stderr, "FreeRTOS Task \"%s\" should not return, Aborting now!\n", pcTaskGetTaskName(NULL));
+	abort();
+	return NULL;
+}
+
+/*
+ * Stack initialization. Creates the thread of the task, which waits until the task is switched in.
+ */
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+	port_thread_t **sp;
+	port_thread_t *thread;
+	pthread_attr_t attr;
+
+	pthread_once(&s_cores_init, prvInitCores);
+
+	thread = calloc(1, sizeof(port_thread_t));
+	configASSERT(thread != NULL);
+	thread->code = pxCode;
+	thread->params = pvParameters;
+	thread->core = -1;
+	pthread_cond_init(&thread->cond, NULL);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pthread_attr_setstacksize(&attr, PORT_THREAD_STACK_SIZE);
+	int err = pthread_create(&thread->thread, &attr, prvThreadEntry, thread);
+	configASSERT(err == 0);
+	pthread_attr_destroy(&attr);
+
+	sp = (port_thread_t **)(((uintptr_t)(pxTopOfStack + 1) - sizeof(port_thread_t *)) & ~(uintptr_t)portBYTE_ALIGNMENT_MASK);
+	*sp = thread;
+	return (StackType_t *)sp;
+}
+
+void vPortCleanUpThread( void *pxTCB )
+{
+	port_thread_t *thread = prvGetThread((TaskHandle_t)pxTCB);
+
+	pthread_mutex_lock(&s_sched_lock);
+	thread->deleted = true;
+	pthread_cond_signal(&thread->cond);
+	pthread_mutex_unlock(&s_sched_lock);
+}
+
+/*-----------------------------------------------------------*/
+
+unsigned portENTER_CRITICAL_NESTED(void)
+{
+	uint32_t core_id = xPortGetCoreID();
+
+	if (port_xIrqDisabledCore == (int)core_id) {
+		return 1;
+	}
+	pthread_once(&s_cores_init, prvInitCores);
+	pthread_mutex_lock(&s_cores[core_id].irq_lock);
+	port_xIrqDisabledCore = core_id;
+	return 0;
+}
+
+static void prvEnableInterrupts(void)
+{
+	int core_id = port_xIrqDisabledCore;
+
+	if (core_id >= 0) {
+		port_xIrqDisabledCore = -1;
+		pthread_mutex_unlock(&s_cores[core_id].irq_lock);
+	}
+}
+
+void portEXIT_CRITICAL_NESTED(unsigned state)
+{
+	if (state == 0) {
+		prvEnableInterrupts();
+		if (s_self != NULL && prvYieldPending(xPortGetCoreID())) {
+			vPortYield();
+		}
+	}
+}
+
+/* Hands the core over to the thread of the task switched in, and waits to be switched in again */
+static void prvSwitchThread(port_thread_t *next, uint32_t core_id)
+{
+	pthread_mutex_lock(&s_sched_lock);
+	next->core = core_id;
+	pthread_cond_signal(&next->cond);
+	prvWaitForCore(s_self);
+}
+
+void vPortYield( void )
+{
+	if (s_self == NULL || port_xIrqDisabledCore >= 0) {
+		/* Not a task, or interrupts are disabled: switch once they are enabled again */
+		vPortYieldOtherCore(xPortGetCoreID());
+		return;
+	}
+
+	do {
+		uint32_t core_id = xPortGetCoreID();
+
+		portENTER_CRITICAL_NESTED();
+		__atomic_store_n(&s_cores[core_id].yield_pending, false, __ATOMIC_RELEASE);
+		vTaskSwitchContext();
+		port_thread_t *next = prvGetThread(xTaskGetCurrentTaskHandleForCPU(core_id));
+		prvEnableInterrupts();
+
+		if (next != s_self) {
+			prvSwitchThread(next, core_id);
+		}
+	} while (prvYieldPending(xPortGetCoreID()));
+}
+
+void vPortYieldOtherCore( BaseType_t coreid )
+{
+	port_core_t *core = &s_cores[coreid];
+
+	pthread_mutex_lock(&s_sched_lock);
+	__atomic_store_n(&core->yield_pending, true, __ATOMIC_RELEASE);
+	pthread_cond_signal(&core->idle_cond);
+	pthread_mutex_unlock(&s_sched_lock);
+
+	if (coreid == (BaseType_t)xPortGetCoreID() && s_self != NULL && !s_in_isr && port_xIrqDisabledCore < 0) {
+		vPortYield();
+	}
+}
+
+void vPortIdleHook( void )
+{
+	uint32_t core_id = xPortGetCoreID();
+	port_core_t *core = &s_cores[core_id];
+	struct timespec timeout;
+
+	/* Sleep for at most a tick, the tick thread wakes the core up if a task is unblocked */
+	clock_gettime(CLOCK_REALTIME, &timeout);
+	timeout.tv_nsec += 1000000000L / configTICK_RATE_HZ;
+	if (timeout.tv_nsec >= 1000000000L) {
+		timeout.tv_sec++;
+		timeout.tv_nsec -= 1000000000L;
+	}
+	pthread_mutex_lock(&s_sched_lock);
+	if (!prvYieldPending(core_id)) {
+		pthread_cond_timedwait(&core->idle_cond, &s_sched_lock, &timeout);
+	}
+	pthread_mutex_unlock(&s_sched_lock);
+
+	if (prvYieldPending(core_id)) {
+		vPortYield();
+	}
+}
+
+/*-----------------------------------------------------------*/
+
+void vPortSimulateInterrupt(BaseType_t xCoreID, void (*pxHandler)(void *), void *pvArg)
+{
+	configASSERT(s_self == NULL);
+	s_in_isr = true;
+	port_xCoreID = xCoreID;
+	unsigned state = portENTER_CRITICAL_NESTED();
+	pxHandler(pvArg);
+	portEXIT_CRITICAL_NESTED(state);
+	s_in_isr = false;
+}
+
+static void prvTickInterrupt(void *arg)
+{
+	if (xTaskIncrementTick() != pdFALSE) {
+		portYIELD_FROM_ISR();
+	}
+}
+
+static void *prvTickThread(void *arg)
+{
+	struct timespec next;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (__atomic_load_n(&s_scheduler_running, __ATOMIC_ACQUIRE)) {
+		next.tv_nsec += 1000000000L / configTICK_RATE_HZ;
+		if (next.tv_nsec >= 1000000000L) {
+			next.tv_sec++;
+			next.tv_nsec -= 1000000000L;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+		/* The tick interrupt fires on every core, like the per-core timers of the target */
+		for (int i = 0; i < portNUM_PROCESSORS; i++) {
+			vPortSimulateInterrupt(i, prvTickInterrupt, NULL);
+		}
+	}
+	return NULL;
+}
+
+BaseType_t xPortStartScheduler( void )
+{
+	pthread_t tick_thread;
+
+	/* vTaskStartScheduler() disabled interrupts, the tasks start with interrupts enabled */
+	prvEnableInterrupts();
+
+	pthread_mutex_lock(&s_sched_lock);
+	__atomic_store_n(&s_scheduler_running, true, __ATOMIC_RELEASE);
+	for (int i = 0; i < portNUM_PROCESSORS; i++) {
+		port_thread_t *thread = prvGetThread(xTaskGetCurrentTaskHandleForCPU(i));
+		thread->core = i;
+		pthread_cond_signal(&thread->cond);
+	}
+	int err = pthread_create(&tick_thread, NULL, prvTickThread, NULL);
+	configASSERT(err == 0);
+	pthread_detach(tick_thread);
+
+	/* The calling thread isn't a task, it only waits for vTaskEndScheduler() */
+	while (s_scheduler_running) {
+		pthread_cond_wait(&s_end_cond, &s_sched_lock);
+	}
+	pthread_mutex_unlock(&s_sched_lock);
+	return pdTRUE;
+}
+
+void vPortEndScheduler( void )
+{
+	pthread_mutex_lock(&s_sched_lock);
+	__atomic_store_n(&s_scheduler_running, false, __ATOMIC_RELEASE);
+	pthread_cond_signal(&s_end_cond);
+	pthread_mutex_unlock(&s_sched_lock);
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortInIsrContext(void)
+{
+	return s_in_isr;
+}
+
+BaseType_t xPortInterruptedFromISRContext(void)
+{
+	return s_in_isr;
+}
+
+void vPortAssertIfInISR(void)
+{
+	configASSERT(xPortInIsrContext());
+}
+
+void vPortSetStackWatchpoint( void* pxStackStart )
+{
+	/* Task code doesn't run on the FreeRTOS stack, there is nothing to watch */
+}
+
+uint32_t xPortGetTickRateHz(void)
+{
+	return (uint32_t)configTICK_RATE_HZ;
+}
+
+uint32_t ulPortGetRunTimeCounterValue(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)(now.tv_sec * 1000000ULL + now.tv_nsec / 1000);
+}
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+	BaseType_t oldInterruptLevel = portENTER_CRITICAL_NESTED();
+	vPortCPUAcquireMutex( mux );
+	BaseType_t coreID = xPortGetCoreID();
+	BaseType_t newNesting = port_uxCriticalNesting[coreID] + 1;
+	port_uxCriticalNesting[coreID] = newNesting;
+
+	if( newNesting == 1 )
+	{
+		//This is the first time we get called. Save original interrupt level.
+		port_uxOldInterruptState[coreID] = oldInterruptLevel;
+	}
+}
+
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+	vPortCPUReleaseMutex( mux );
+	BaseType_t coreID = xPortGetCoreID();
+	BaseType_t nesting =  port_uxCriticalNesting[coreID];
+
+	if(nesting > 0U)
+	{
+		nesting--;
+		port_uxCriticalNesting[coreID] = nesting;
+
+		if( nesting == 0U )
+		{
+			portEXIT_CRITICAL_NESTED(port_uxOldInterruptState[coreID]);
+		}
+	}
+}
@@ -0,0 +1,21 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/* This header holds the macros for porting which should only be used inside FreeRTOS */
+
+#pragma once
+
+//All of the host memory can hold TCBs and stacks
+#define portVALID_TCB_MEM(ptr) ((ptr) != NULL)
+#define portVALID_STACK_MEM(ptr) ((ptr) != NULL)
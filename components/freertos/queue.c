@@ -150,6 +150,7 @@ typedef struct QueueDefinition
 	volatile UBaseType_t uxMessagesWaiting;/*< The number of items currently in the queue. */
 	UBaseType_t uxLength;			/*< The length of the queue defined as the number of items it will hold, not the number of bytes. */
 	UBaseType_t uxItemSize;			/*< The size of each items that the queue will hold. */
+	uint8_t ucZeroCopy;				/*< Set to pdTRUE if the queue was created with xQueueCreateZeroCopy(), in which case its pool follows the structure. */
 
 	#if( ( configSUPPORT_STATIC_ALLOCATION == 1 ) && ( configSUPPORT_DYNAMIC_ALLOCATION == 1 ) )
 		uint8_t ucStaticallyAllocated;	/*< Set to pdTRUE if the memory used by the queue was statically allocated to ensure no attempt is made to free the memory. */
@@ -438,6 +439,7 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength, const UBaseT
 	defined. */
 	pxNewQueue->uxLength = uxQueueLength;
 	pxNewQueue->uxItemSize = uxItemSize;
+	pxNewQueue->ucZeroCopy = pdFALSE;
 	( void ) xQueueGenericReset( pxNewQueue, pdTRUE );
 
 	#if ( configUSE_TRACE_FACILITY == 1 )
@@ -2618,3 +2620,290 @@ Queue_t * const pxQueue = ( Queue_t * ) xQueue;
 
 
 
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+	/* A zero copy queue is a single allocation holding the queue of filled
+	blocks, the pool directly after it, the pointer storage of the queue and
+	finally the blocks themselves.  Only block pointers pass through the queue.
+	The free blocks are kept in a list linked through their first word, which
+	is protected by the critical section of the queue, so taking and giving
+	back a block costs no more than a critical section. */
+	typedef struct ZeroCopyPool
+	{
+		List_t xTasksWaitingForBlock;	/*< List of tasks that are blocked waiting for a free block.  Stored in priority order. */
+		void *pvFreeList;				/*< Points to the first free block, or NULL if all blocks are in use. */
+		int8_t *pcBlocks;				/*< Points to the first block. */
+		int8_t *pcBlocksEnd;			/*< Points to the byte after the last block. */
+	} ZeroCopyPool_t;
+
+	static ZeroCopyPool_t *prvGetZeroCopyPool( Queue_t * const pxQueue )
+	{
+		configASSERT( pxQueue );
+		configASSERT( pxQueue->ucZeroCopy == pdTRUE );
+
+		return ( ZeroCopyPool_t * ) ( pxQueue + 1 );
+	}
+
+	static void prvAssertIsZeroCopyBlock( ZeroCopyPool_t * const pxPool, void *pvItem )
+	{
+		configASSERT( ( ( int8_t * ) pvItem >= pxPool->pcBlocks ) && ( ( int8_t * ) pvItem < pxPool->pcBlocksEnd ) );
+
+		/* Remove compiler warnings should configASSERT() not be defined. */
+		( void ) pxPool;
+		( void ) pvItem;
+	}
+
+	/* Must be called from within the critical section of the queue. */
+	static void *prvTakeFreeBlock( ZeroCopyPool_t * const pxPool )
+	{
+	void *pvBlock = pxPool->pvFreeList;
+
+		if( pvBlock != NULL )
+		{
+			pxPool->pvFreeList = *( void ** ) pvBlock;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return pvBlock;
+	}
+
+	/* Must be called from within the critical section of the queue.  Returns
+	pdTRUE if a task waiting for a block was unblocked that has a priority
+	higher than the calling task. */
+	static BaseType_t prvGiveFreeBlock( ZeroCopyPool_t * const pxPool, void *pvBlock )
+	{
+	BaseType_t xReturn = pdFALSE;
+
+		*( void ** ) pvBlock = pxPool->pvFreeList;
+		pxPool->pvFreeList = pvBlock;
+
+		if( listLIST_IS_EMPTY( &( pxPool->xTasksWaitingForBlock ) ) == pdFALSE )
+		{
+			xReturn = xTaskRemoveFromEventList( &( pxPool->xTasksWaitingForBlock ) );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return xReturn;
+	}
+
+	QueueHandle_t xQueueCreateZeroCopy( const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize )
+	{
+	Queue_t *pxNewQueue;
+	ZeroCopyPool_t *pxPool;
+	size_t xBlockSize, xBlocksOffset;
+	UBaseType_t x;
+
+		configASSERT( uxQueueLength > ( UBaseType_t ) 0 );
+		configASSERT( uxItemSize > ( UBaseType_t ) 0 );
+
+		/* Every block is aligned so that it can hold any structure, and can
+		hold the link to the next free block. */
+		xBlockSize = ( ( size_t ) uxItemSize > sizeof( void * ) ) ? ( size_t ) uxItemSize : sizeof( void * );
+		xBlockSize = ( xBlockSize + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+		xBlocksOffset = ( sizeof( Queue_t ) + sizeof( ZeroCopyPool_t ) + ( ( size_t ) uxQueueLength * sizeof( void * ) ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+		pxNewQueue = ( Queue_t * ) pvPortMalloc( xBlocksOffset + ( ( size_t ) uxQueueLength * xBlockSize ) );
+
+		if( pxNewQueue != NULL )
+		{
+			pxPool = ( ZeroCopyPool_t * ) ( pxNewQueue + 1 );
+
+			#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+			{
+				/* Deleting the queue frees the pool along with it. */
+				pxNewQueue->ucStaticallyAllocated = pdFALSE;
+			}
+			#endif /* configSUPPORT_STATIC_ALLOCATION */
+
+			prvInitialiseNewQueue( uxQueueLength, sizeof( void * ), ( uint8_t * ) ( pxPool + 1 ), queueQUEUE_TYPE_ZERO_COPY, pxNewQueue );
+			pxNewQueue->ucZeroCopy = pdTRUE;
+
+			vListInitialise( &( pxPool->xTasksWaitingForBlock ) );
+			pxPool->pcBlocks = ( int8_t * ) pxNewQueue + xBlocksOffset;
+			pxPool->pcBlocksEnd = pxPool->pcBlocks + ( ( size_t ) uxQueueLength * xBlockSize );
+
+			/* All blocks start out free, linked in address order. */
+			pxPool->pvFreeList = NULL;
+			for( x = uxQueueLength; x > ( UBaseType_t ) 0; x-- )
+			{
+				( void ) prvGiveFreeBlock( pxPool, pxPool->pcBlocks + ( ( size_t ) ( x - 1 ) * xBlockSize ) );
+			}
+		}
+
+		return pxNewQueue;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xQueueSendAcquire( QueueHandle_t xQueue, void **ppvItem, TickType_t xTicksToWait )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+	ZeroCopyPool_t * const pxPool = prvGetZeroCopyPool( pxQueue );
+	BaseType_t xEntryTimeSet = pdFALSE;
+	TimeOut_t xTimeOut;
+
+		configASSERT( ppvItem );
+		#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+		{
+			configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+		}
+		#endif
+
+		for( ;; )
+		{
+			taskENTER_CRITICAL(&pxQueue->mux);
+
+			*ppvItem = prvTakeFreeBlock( pxPool );
+			if( *ppvItem != NULL )
+			{
+				taskEXIT_CRITICAL(&pxQueue->mux);
+				return pdTRUE;
+			}
+			else if( xTicksToWait == ( TickType_t ) 0 )
+			{
+				/* No block is free and no block time is specified (or the
+				block time has expired) so leave now. */
+				taskEXIT_CRITICAL(&pxQueue->mux);
+				return pdFALSE;
+			}
+			else if( xEntryTimeSet == pdFALSE )
+			{
+				vTaskSetTimeOutState( &xTimeOut );
+				xEntryTimeSet = pdTRUE;
+			}
+			else if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+			{
+				taskEXIT_CRITICAL(&pxQueue->mux);
+				return pdFALSE;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			/* Giving back a block takes the same critical section, so the
+			task can not miss being unblocked. */
+			vTaskPlaceOnEventList( &( pxPool->xTasksWaitingForBlock ), xTicksToWait );
+			taskEXIT_CRITICAL(&pxQueue->mux);
+			portYIELD_WITHIN_API();
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xQueueSendAcquireFromISR( QueueHandle_t xQueue, void **ppvItem )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+	ZeroCopyPool_t * const pxPool = prvGetZeroCopyPool( pxQueue );
+	UBaseType_t uxSavedInterruptStatus;
+
+		configASSERT( ppvItem );
+
+		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+		{
+			taskENTER_CRITICAL_ISR(&pxQueue->mux);
+			*ppvItem = prvTakeFreeBlock( pxPool );
+			taskEXIT_CRITICAL_ISR(&pxQueue->mux);
+		}
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+
+		return ( *ppvItem != NULL ) ? pdTRUE : pdFALSE;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xQueueSendComplete( QueueHandle_t xQueue, void *pvItem )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+	BaseType_t xReturn;
+
+		prvAssertIsZeroCopyBlock( prvGetZeroCopyPool( pxQueue ), pvItem );
+
+		/* There is a slot for every block, so this never has to wait. */
+		xReturn = xQueueGenericSend( pxQueue, &pvItem, ( TickType_t ) 0, queueSEND_TO_BACK );
+		configASSERT( xReturn == pdPASS );
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t xQueueSendCompleteFromISR( QueueHandle_t xQueue, void *pvItem, BaseType_t * const pxHigherPriorityTaskWoken )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+	BaseType_t xReturn;
+
+		prvAssertIsZeroCopyBlock( prvGetZeroCopyPool( pxQueue ), pvItem );
+
+		xReturn = xQueueGenericSendFromISR( pxQueue, &pvItem, pxHigherPriorityTaskWoken, queueSEND_TO_BACK );
+		configASSERT( xReturn == pdPASS );
+
+		return xReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+	void *pvQueueReceiveInPlace( QueueHandle_t xQueue, TickType_t xTicksToWait )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+	void *pvItem;
+
+		( void ) prvGetZeroCopyPool( pxQueue );
+
+		if( xQueueGenericReceive( pxQueue, &pvItem, xTicksToWait, pdFALSE ) != pdPASS )
+		{
+			pvItem = NULL;
+		}
+
+		return pvItem;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vQueueReturnItem( QueueHandle_t xQueue, void *pvItem )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+	ZeroCopyPool_t * const pxPool = prvGetZeroCopyPool( pxQueue );
+
+		prvAssertIsZeroCopyBlock( pxPool, pvItem );
+
+		taskENTER_CRITICAL(&pxQueue->mux);
+		if( prvGiveFreeBlock( pxPool, pvItem ) != pdFALSE )
+		{
+			queueYIELD_IF_USING_PREEMPTION();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+		taskEXIT_CRITICAL(&pxQueue->mux);
+	}
+	/*-----------------------------------------------------------*/
+
+	void vQueueReturnItemFromISR( QueueHandle_t xQueue, void *pvItem, BaseType_t * const pxHigherPriorityTaskWoken )
+	{
+	Queue_t * const pxQueue = ( Queue_t * ) xQueue;
+	ZeroCopyPool_t * const pxPool = prvGetZeroCopyPool( pxQueue );
+	UBaseType_t uxSavedInterruptStatus;
+
+		prvAssertIsZeroCopyBlock( pxPool, pvItem );
+
+		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+		{
+			taskENTER_CRITICAL_ISR(&pxQueue->mux);
+			if( ( prvGiveFreeBlock( pxPool, pvItem ) != pdFALSE ) && ( pxHigherPriorityTaskWoken != NULL ) )
+			{
+				*pxHigherPriorityTaskWoken = pdTRUE;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+			taskEXIT_CRITICAL_ISR(&pxQueue->mux);
+		}
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+	}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
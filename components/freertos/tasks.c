@@ -76,7 +76,6 @@
 all the API functions to use the MPU wrappers.  That should only be done when
 task.h is included from an application file. */
 #define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
-#include "esp_newlib.h"
 #include "esp_compiler.h"
 
 /* FreeRTOS includes. */
@@ -88,6 +87,10 @@ task.h is included from an application file. */
 #include "portmacro_priv.h"
 #include "semphr.h"
 
+#if ( configUSE_NEWLIB_REENTRANT == 1 )
+#include "esp_newlib.h"
+#endif
+
 /* Lint e961 and e750 are suppressed as a MISRA exception justified because the
 MPU ports require MPU_WRAPPERS_INCLUDED_FROM_API_FILE to be defined for the
 header files above, but not in this file, in order to generate the correct
@@ -111,6 +114,32 @@ functions but without including stdio.h here. */
 	#endif /* INCLUDE_vTaskSuspend */
 #endif /* configUSE_TICKLESS_IDLE */
 
+#if ( configUSE_PER_CORE_READY_LISTS == 1 )
+	#if ( portNUM_PROCESSORS == 1 ) || ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+		#error configUSE_PER_CORE_READY_LISTS is only supported on multicore targets without configUSE_PORT_OPTIMISED_TASK_SELECTION
+	#endif
+	#if ( configMAX_PRIORITIES > 32 )
+		#error configUSE_PER_CORE_READY_LISTS can only be set to 1 when configMAX_PRIORITIES is less than or equal to 32
+	#endif
+#endif /* configUSE_PER_CORE_READY_LISTS */
+
+/*
+ * The ready lists are kept in groups of configMAX_PRIORITIES lists.  With
+ * configUSE_PER_CORE_READY_LISTS there is one group for the tasks pinned to
+ * each core and one for the tasks without affinity, so that a core never has to
+ * skip over tasks it cannot run.  Otherwise there is a single group.
+ */
+#if ( configUSE_PER_CORE_READY_LISTS == 1 )
+	#define taskREADY_LIST_GROUPS				( portNUM_PROCESSORS + 1 )
+	#define taskREADY_LIST_GROUP( xCoreID )		( ( ( xCoreID ) == tskNO_AFFINITY ) ? portNUM_PROCESSORS : ( xCoreID ) )
+#else
+	#define taskREADY_LIST_GROUPS				1
+	#define taskREADY_LIST_GROUP( xCoreID )		0
+#endif /* configUSE_PER_CORE_READY_LISTS */
+
+#define taskREADY_LIST_IN_GROUP( uxGroup, uxPriority )	( &( pxReadyTasksLists[ ( uxGroup ) * configMAX_PRIORITIES + ( uxPriority ) ] ) )
+#define taskREADY_LIST( xCoreID, uxPriority )			taskREADY_LIST_IN_GROUP( taskREADY_LIST_GROUP( xCoreID ), ( uxPriority ) )
+
 /*
  * Defines the size, in bytes, of the stack allocated to the idle task.
  */
@@ -255,7 +284,7 @@ static variables must be declared volatile. */
 PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB[ portNUM_PROCESSORS ] = { NULL };
 
 /* Lists for ready and blocked tasks. --------------------*/
-PRIVILEGED_DATA static List_t pxReadyTasksLists[ configMAX_PRIORITIES ];/*< Prioritised ready tasks. */
+PRIVILEGED_DATA static List_t pxReadyTasksLists[ taskREADY_LIST_GROUPS * configMAX_PRIORITIES ];/*< Prioritised ready tasks, see taskREADY_LIST(). */
 PRIVILEGED_DATA static List_t xDelayedTaskList1;						/*< Delayed tasks. */
 PRIVILEGED_DATA static List_t xDelayedTaskList2;						/*< Delayed tasks (two lists are used - one for delays that have overflowed the current tick count. */
 PRIVILEGED_DATA static List_t * volatile pxDelayedTaskList;				/*< Points to the delayed task list currently being used. */
@@ -284,7 +313,12 @@ PRIVILEGED_DATA static List_t xPendingReadyList[ portNUM_PROCESSORS ];						/*<
 /* Other file private variables. --------------------------------*/
 PRIVILEGED_DATA static volatile UBaseType_t uxCurrentNumberOfTasks 	= ( UBaseType_t ) 0U;
 PRIVILEGED_DATA static volatile TickType_t xTickCount 				= ( TickType_t ) 0U;
-PRIVILEGED_DATA static volatile UBaseType_t uxTopReadyPriority 		= tskIDLE_PRIORITY;
+#if ( configUSE_PER_CORE_READY_LISTS == 1 )
+	PRIVILEGED_DATA static volatile UBaseType_t uxReadyPriorities[ taskREADY_LIST_GROUPS ] = { 0 };	/*< Bit n is set if the ready list of priority n of the group may be non empty. */
+	PRIVILEGED_DATA static BaseType_t xLastSelectedUnpinned[ portNUM_PROCESSORS ] = { pdFALSE };	/*< Alternates between pinned and unpinned tasks of equal priority. */
+#else
+	PRIVILEGED_DATA static volatile UBaseType_t uxTopReadyPriority 		= tskIDLE_PRIORITY;
+#endif
 PRIVILEGED_DATA static volatile BaseType_t xSchedulerRunning 		= pdFALSE;
 PRIVILEGED_DATA static volatile UBaseType_t uxPendedTicks 			= ( UBaseType_t ) 0U;
 PRIVILEGED_DATA static volatile BaseType_t xYieldPending[portNUM_PROCESSORS] 		= {pdFALSE};
@@ -417,6 +451,28 @@ PRIVILEGED_DATA static volatile BaseType_t xSwitchingContext[ portNUM_PROCESSORS
 
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_PER_CORE_READY_LISTS == 1 )
+
+	/* Each group of ready lists has its own bitmap of ready priorities.  Bits
+	are set when a task is added to a list and only cleared by the scheduler
+	when it finds the list empty, so the places that remove tasks from ready
+	lists don't need to know which group the task is in. */
+	#define taskRECORD_READY_TCB( pxTCB )	uxReadyPriorities[ taskREADY_LIST_GROUP( ( pxTCB )->xCoreID ) ] |= ( 1UL << ( pxTCB )->uxPriority )
+
+	/* Number of ready tasks of the given priority that can run on the core. */
+	#define taskREADY_TASKS_FOR_CORE( xCoreID, uxPriority )												\
+		( listCURRENT_LIST_LENGTH( taskREADY_LIST( ( xCoreID ), ( uxPriority ) ) ) +					\
+		  listCURRENT_LIST_LENGTH( taskREADY_LIST( tskNO_AFFINITY, ( uxPriority ) ) ) )
+
+#else
+
+	#define taskRECORD_READY_TCB( pxTCB )	taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority )
+	#define taskREADY_TASKS_FOR_CORE( xCoreID, uxPriority )	listCURRENT_LIST_LENGTH( taskREADY_LIST( ( xCoreID ), ( uxPriority ) ) )
+
+#endif /* configUSE_PER_CORE_READY_LISTS */
+
+/*-----------------------------------------------------------*/
+
 /* pxDelayedTaskList and pxOverflowDelayedTaskList are switched when the tick
 count overflows. */
 #define taskSWITCH_DELAYED_LISTS()																	\
@@ -441,8 +497,8 @@ count overflows. */
  */
 #define prvAddTaskToReadyList( pxTCB )																\
 	traceMOVED_TASK_TO_READY_STATE( pxTCB );														\
-	taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );												\
-	vListInsertEnd( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xGenericListItem ) )
+	taskRECORD_READY_TCB( pxTCB );																	\
+	vListInsertEnd( taskREADY_LIST( ( pxTCB )->xCoreID, ( pxTCB )->uxPriority ), &( ( pxTCB )->xGenericListItem ) )
 /*
  * Place the task represented by pxTCB which has been in a ready list before
  * into the appropriate ready list for the task.
@@ -450,8 +506,8 @@ count overflows. */
  */
 #define prvReaddTaskToReadyList( pxTCB )                                                               \
    traceREADDED_TASK_TO_READY_STATE( pxTCB );                                                      \
-   taskRECORD_READY_PRIORITY( ( pxTCB )->uxPriority );                                             \
-   vListInsertEnd( &( pxReadyTasksLists[ ( pxTCB )->uxPriority ] ), &( ( pxTCB )->xGenericListItem ) )
+   taskRECORD_READY_TCB( pxTCB );                                                                  \
+   vListInsertEnd( taskREADY_LIST( ( pxTCB )->xCoreID, ( pxTCB )->uxPriority ), &( ( pxTCB )->xGenericListItem ) )
 /*-----------------------------------------------------------*/
 
 #define tskCAN_RUN_HERE( cpuid ) ( cpuid==xPortGetCoreID() || cpuid==tskNO_AFFINITY )
@@ -1730,7 +1786,7 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB, TaskFunction_t pxTaskCode
 				nothing more than change it's priority variable. However, if
 				the task is in a ready list it needs to be removed and placed
 				in the list appropriate to its new priority. */
-				if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ uxPriorityUsedOnEntry ] ), &( pxTCB->xGenericListItem ) ) != pdFALSE )
+				if( listIS_CONTAINED_WITHIN( taskREADY_LIST( pxTCB->xCoreID, uxPriorityUsedOnEntry ), &( pxTCB->xGenericListItem ) ) != pdFALSE )
 				{
 					/* The task is currently in its ready list - remove before adding
 					it to it's new ready list.  As we are in a critical section we
@@ -2151,15 +2207,18 @@ void vTaskSuspendAll( void )
 
 	static BaseType_t xHaveReadyTasks( void )
 	{
-		for (int i = tskIDLE_PRIORITY + 1; i < configMAX_PRIORITIES; ++i)
+		for (int g = 0; g < taskREADY_LIST_GROUPS; ++g)
 		{
-			if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ i ] ) ) > 0 )
-			{
-				return pdTRUE;
-			}
-			else
+			for (int i = tskIDLE_PRIORITY + 1; i < configMAX_PRIORITIES; ++i)
 			{
-				mtCOVERAGE_TEST_MARKER();
+				if( listCURRENT_LIST_LENGTH( taskREADY_LIST_IN_GROUP( g, i ) ) > 0 )
+				{
+					return pdTRUE;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
 			}
 		}
 		return pdFALSE;
@@ -2167,6 +2226,17 @@ void vTaskSuspendAll( void )
 
 #endif // portNUM_PROCESSORS > 1
 
+	static UBaseType_t prvReadyTasksAtIdlePriority( void )
+	{
+	UBaseType_t uxCount = 0;
+
+		for (int g = 0; g < taskREADY_LIST_GROUPS; ++g)
+		{
+			uxCount += listCURRENT_LIST_LENGTH( taskREADY_LIST_IN_GROUP( g, tskIDLE_PRIORITY ) );
+		}
+		return uxCount;
+	}
+
 	static TickType_t prvGetExpectedIdleTime( void )
 	{
 	TickType_t xReturn;
@@ -2188,7 +2258,7 @@ void vTaskSuspendAll( void )
 			xReturn = 0;
 		}
 #endif // portNUM_PROCESSORS > 1
-		else if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > portNUM_PROCESSORS )
+		else if( prvReadyTasksAtIdlePriority() > portNUM_PROCESSORS )
 		{
 			/* There are other idle priority tasks in the ready state.  If
 			time slicing is used then the very next tick interrupt must be
@@ -2339,7 +2409,7 @@ UBaseType_t uxTaskGetNumberOfTasks( void )
 
 	UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime )
 	{
-	UBaseType_t uxTask = 0, uxQueue = configMAX_PRIORITIES;
+	UBaseType_t uxTask = 0, uxQueue = taskREADY_LIST_GROUPS * configMAX_PRIORITIES;
 
 		taskENTER_CRITICAL(&xTaskQueueMutex);
 		{
@@ -2593,7 +2663,7 @@ BaseType_t xSwitchRequired = pdFALSE;
 		writer has not explicitly turned time slicing off. */
 		#if ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) )
 		{
-			if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ pxCurrentTCB[ xPortGetCoreID() ]->uxPriority ] ) ) > ( UBaseType_t ) 1 )
+			if( taskREADY_TASKS_FOR_CORE( xPortGetCoreID(), pxCurrentTCB[ xPortGetCoreID() ]->uxPriority ) > ( UBaseType_t ) 1 )
 			{
 				xSwitchRequired = pdTRUE;
 			}
@@ -2718,6 +2788,112 @@ BaseType_t xSwitchRequired = pdFALSE;
 #endif /* configUSE_APPLICATION_TASK_TAG */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_PER_CORE_READY_LISTS == 1 )
+
+	/* Returns the item listGET_OWNER_OF_NEXT_ENTRY() would pick from pxList,
+	skipping a task that is running on another core, without moving the list
+	index.  Returns NULL if all tasks of the list are running elsewhere. */
+	static ListItem_t *prvNextReadyItemForCore( List_t * const pxList, const BaseType_t xCoreID )
+	{
+	ListItem_t *pxItem = pxList->pxIndex;
+	UBaseType_t uxLeft = listCURRENT_LIST_LENGTH( pxList );
+
+		while( uxLeft-- > 0 )
+		{
+			pxItem = pxItem->pxNext;
+			if( ( void * ) pxItem == ( void * ) &( pxList->xListEnd ) )
+			{
+				pxItem = pxItem->pxNext;
+			}
+
+			BaseType_t xRunningElsewhere = pdFALSE;
+			for( BaseType_t i = 0; i < portNUM_PROCESSORS; i++ )
+			{
+				if( i != xCoreID && pxCurrentTCB[ i ] == listGET_LIST_ITEM_OWNER( pxItem ) )
+				{
+					xRunningElsewhere = pdTRUE;
+				}
+			}
+			if( xRunningElsewhere == pdFALSE )
+			{
+				return pxItem;
+			}
+		}
+		return NULL;
+	}
+
+	/* Makes the highest priority task that can run on xCoreID the current
+	task of the core.  Only the lists pinned to the core and the unpinned lists
+	are looked at, and only tasks running on the other cores are skipped, so
+	the time taken doesn't depend on the number of tasks.  Tasks of equal
+	priority are picked round robin within each list, alternating between the
+	pinned and the unpinned list.  Must be called with xTaskQueueMutex held. */
+	static void prvSelectHighestPriorityTaskForCore( const BaseType_t xCoreID )
+	{
+	UBaseType_t uxPinned = uxReadyPriorities[ xCoreID ];
+	UBaseType_t uxUnpinned = uxReadyPriorities[ taskREADY_LIST_GROUP( tskNO_AFFINITY ) ];
+
+		for( ;; )
+		{
+			/* The idle task of the core is always ready. */
+			configASSERT( ( uxPinned | uxUnpinned ) != 0 );
+
+			const UBaseType_t uxTopPriority = 31 - __builtin_clz( uxPinned | uxUnpinned );
+			const UBaseType_t uxBit = 1UL << uxTopPriority;
+			List_t * const pxPinnedList = taskREADY_LIST( xCoreID, uxTopPriority );
+			List_t * const pxUnpinnedList = taskREADY_LIST( tskNO_AFFINITY, uxTopPriority );
+			ListItem_t *pxPinnedItem = NULL, *pxUnpinnedItem = NULL;
+
+			if( ( uxPinned & uxBit ) != 0 )
+			{
+				if( listLIST_IS_EMPTY( pxPinnedList ) )
+				{
+					uxReadyPriorities[ xCoreID ] &= ~uxBit;
+				}
+				else
+				{
+					pxPinnedItem = prvNextReadyItemForCore( pxPinnedList, xCoreID );
+				}
+			}
+			if( ( uxUnpinned & uxBit ) != 0 )
+			{
+				if( listLIST_IS_EMPTY( pxUnpinnedList ) )
+				{
+					uxReadyPriorities[ taskREADY_LIST_GROUP( tskNO_AFFINITY ) ] &= ~uxBit;
+				}
+				else
+				{
+					pxUnpinnedItem = prvNextReadyItemForCore( pxUnpinnedList, xCoreID );
+				}
+			}
+			uxPinned &= ~uxBit;
+			uxUnpinned &= ~uxBit;
+
+			if( pxPinnedItem != NULL && ( pxUnpinnedItem == NULL || xLastSelectedUnpinned[ xCoreID ] != pdFALSE ) )
+			{
+				pxPinnedList->pxIndex = pxPinnedItem;
+				pxCurrentTCB[ xCoreID ] = listGET_LIST_ITEM_OWNER( pxPinnedItem );
+				xLastSelectedUnpinned[ xCoreID ] = pdFALSE;
+				return;
+			}
+			else if( pxUnpinnedItem != NULL )
+			{
+				pxUnpinnedList->pxIndex = pxUnpinnedItem;
+				pxCurrentTCB[ xCoreID ] = listGET_LIST_ITEM_OWNER( pxUnpinnedItem );
+				xLastSelectedUnpinned[ xCoreID ] = pdTRUE;
+				return;
+			}
+			else
+			{
+				/* Nothing at this priority can run here, try the next lower one. */
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+	}
+
+#endif /* configUSE_PER_CORE_READY_LISTS */
+/*-----------------------------------------------------------*/
+
 void vTaskSwitchContext( void )
 {
 	//Theoretically, this is only called from either the tick interrupt or the crosscore interrupt, so disabling
@@ -2778,7 +2954,9 @@ void vTaskSwitchContext( void )
 		*/
 		vPortCPUAcquireMutex( &xTaskQueueMutex );
 
-#if !configUSE_PORT_OPTIMISED_TASK_SELECTION
+#if ( configUSE_PER_CORE_READY_LISTS == 1 )
+		prvSelectHighestPriorityTaskForCore( xPortGetCoreID() );
+#elif !configUSE_PORT_OPTIMISED_TASK_SELECTION
 		unsigned portBASE_TYPE foundNonExecutingWaiter = pdFALSE, ableToSchedule = pdFALSE, resetListHead;
 		unsigned portBASE_TYPE holdTop=pdFALSE;
 		tskTCB * pxTCB;
@@ -2866,10 +3044,8 @@ void vTaskSwitchContext( void )
 
 #else 
 		//For Unicore targets we can keep the current FreeRTOS O(1)
-		//Scheduler. I hope to optimize better the scheduler for 
-		//Multicore settings -- This will involve to create a per
-		//affinity ready task list which will impact hugely on 
-		//tasks module
+		//Scheduler. Multicore targets get the same with
+		//configUSE_PER_CORE_READY_LISTS, see above.
 		taskSELECT_HIGHEST_PRIORITY_TASK();
 #endif
 		traceTASK_SWITCHED_IN();
@@ -3362,7 +3538,7 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 			the list, and an occasional incorrect value will not matter.  If
 			the ready list at the idle priority contains more than one task
 			then a task other than the idle task is ready to execute. */
-			if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) 1 )
+			if( taskREADY_TASKS_FOR_CORE( xPortGetCoreID(), tskIDLE_PRIORITY ) > ( UBaseType_t ) 1 )
 			{
 				taskYIELD();
 			}
@@ -3572,7 +3748,7 @@ static void prvInitialiseTaskLists( void )
 {
 UBaseType_t uxPriority;
 
-	for( uxPriority = ( UBaseType_t ) 0U; uxPriority < ( UBaseType_t ) configMAX_PRIORITIES; uxPriority++ )
+	for( uxPriority = ( UBaseType_t ) 0U; uxPriority < ( UBaseType_t ) ( taskREADY_LIST_GROUPS * configMAX_PRIORITIES ); uxPriority++ )
 	{
 		vListInitialise( &( pxReadyTasksLists[ uxPriority ] ) );
 	}
@@ -4049,7 +4225,7 @@ TCB_t *pxTCB;
 
 				/* If the task being modified is in the ready state it will need to
 				be moved into a new list. */
-				if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), &( pxTCB->xGenericListItem ) ) != pdFALSE )
+				if( listIS_CONTAINED_WITHIN( taskREADY_LIST( pxTCB->xCoreID, pxTCB->uxPriority ), &( pxTCB->xGenericListItem ) ) != pdFALSE )
 				{
 					if( uxListRemove( &( pxTCB->xGenericListItem ) ) == ( UBaseType_t ) 0 )
 					{
@@ -5099,7 +5275,7 @@ TickType_t uxReturn;
 		*pxTcbSz = sizeof(TCB_t);
 		/* Fill in an TaskStatus_t structure with information on each
 		task in the Ready state. */
-		i = configMAX_PRIORITIES;
+		i = taskREADY_LIST_GROUPS * configMAX_PRIORITIES;
 		do
 		{
 			i--;
@@ -62,4 +62,59 @@ TEST_CASE("scheduling time test", "[freertos]")
     BaseType_t result = xSemaphoreTake(context.end_sema, portMAX_DELAY);    
     TEST_ASSERT_EQUAL_HEX32(pdTRUE, result);
     TEST_PERFORMANCE_LESS_THAN(SCHEDULING_TIME , "scheduling time %d cycles" ,context.cycles_to_sched);
-}
\ No newline at end of file
+}
+
+#if !CONFIG_FREERTOS_UNICORE
+
+#define PINNED_TASKS    16
+
+static SemaphoreHandle_t pinned_done;
+
+/* Stays ready on core 0 at the priority of the test tasks on core 1, until test_task_2 is done */
+static void test_pinned_task(void *arg)
+{
+    volatile test_context_t *context = (volatile test_context_t *)arg;
+
+    while (context->cycles_to_sched == 0) {
+    }
+    xSemaphoreGive(pinned_done);
+    vTaskDelete(NULL);
+}
+
+static uint32_t measure_scheduling_time(int pinned_tasks)
+{
+    test_context_t context = { 0 };
+
+    context.end_sema = xSemaphoreCreateBinary();
+    TEST_ASSERT(context.end_sema != NULL);
+    pinned_done = xSemaphoreCreateCounting(PINNED_TASKS, 0);
+    TEST_ASSERT(pinned_done != NULL);
+
+    for (int i = 0; i < pinned_tasks; i++) {
+        xTaskCreatePinnedToCore(test_pinned_task, "pinned", 2048, &context, UNITY_FREERTOS_PRIORITY + 1, NULL, 0);
+    }
+    xTaskCreatePinnedToCore(test_task_1, "test1" , 4096, &context, UNITY_FREERTOS_PRIORITY + 1, &context.t1_handle, 1);
+    xTaskCreatePinnedToCore(test_task_2, "test2" , 4096, &context, UNITY_FREERTOS_PRIORITY + 1, NULL, 1);
+
+    TEST_ASSERT_EQUAL_HEX32(pdTRUE, xSemaphoreTake(context.end_sema, portMAX_DELAY));
+    for (int i = 0; i < pinned_tasks; i++) {
+        xSemaphoreTake(pinned_done, portMAX_DELAY);
+    }
+    vSemaphoreDelete(pinned_done);
+    vSemaphoreDelete(context.end_sema);
+    return context.cycles_to_sched;
+}
+
+TEST_CASE("scheduling time with tasks pinned to the other core", "[freertos]")
+{
+    uint32_t alone = measure_scheduling_time(0);
+    uint32_t with_pinned = measure_scheduling_time(PINNED_TASKS);
+
+    printf("scheduling time %d cycles, %d cycles with %d ready tasks of equal priority pinned to the other core\n",
+           alone, with_pinned, PINNED_TASKS);
+#if CONFIG_FREERTOS_PER_CORE_READY_LISTS
+    TEST_PERFORMANCE_LESS_THAN(SCHEDULING_TIME , "scheduling time with tasks pinned to the other core %d cycles", with_pinned);
+#endif
+}
+
+#endif // !CONFIG_FREERTOS_UNICORE
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "unity.h"
+
+/*
+ * Zero copy queue tests. Blocks taken from the pool of the queue are filled in
+ * place, posted and received without copying, then returned to the pool.
+ */
+#define QUEUE_LEN               4
+#define ITEM_SIZE               61
+
+TEST_CASE("Zero copy queue passes blocks in order", "[freertos]")
+{
+    QueueHandle_t queue = xQueueCreateZeroCopy(QUEUE_LEN, ITEM_SIZE);
+    TEST_ASSERT_NOT_NULL(queue);
+
+    for (int round = 0; round < 3; round++) {
+        //Take all blocks of the pool, they must be distinct and aligned
+        uint8_t *blocks[QUEUE_LEN];
+        for (int i = 0; i < QUEUE_LEN; i++) {
+            TEST_ASSERT_EQUAL(pdTRUE, xQueueSendAcquire(queue, (void **)&blocks[i], 0));
+            TEST_ASSERT_EQUAL(0, (uint32_t)blocks[i] % portBYTE_ALIGNMENT);
+            for (int j = 0; j < i; j++) {
+                TEST_ASSERT_NOT_EQUAL(blocks[j], blocks[i]);
+            }
+            memset(blocks[i], round * QUEUE_LEN + i, ITEM_SIZE);
+        }
+        void *extra;
+        TEST_ASSERT_EQUAL(pdFALSE, xQueueSendAcquire(queue, &extra, 0));
+
+        for (int i = 0; i < QUEUE_LEN; i++) {
+            TEST_ASSERT_EQUAL(pdPASS, xQueueSendComplete(queue, blocks[i]));
+        }
+        TEST_ASSERT_EQUAL(QUEUE_LEN, uxQueueMessagesWaiting(queue));
+
+        //Received blocks are the posted ones, in order and with their contents
+        for (int i = 0; i < QUEUE_LEN; i++) {
+            uint8_t *item = pvQueueReceiveInPlace(queue, 0);
+            TEST_ASSERT_EQUAL_PTR(blocks[i], item);
+            TEST_ASSERT_EACH_EQUAL_UINT8(round * QUEUE_LEN + i, item, ITEM_SIZE);
+            vQueueReturnItem(queue, item);
+        }
+        TEST_ASSERT_NULL(pvQueueReceiveInPlace(queue, 0));
+    }
+    vQueueDelete(queue);
+}
+
+static void return_blocks_task(void *arg)
+{
+    QueueHandle_t queue = (QueueHandle_t)arg;
+    for (int i = 0; i < QUEUE_LEN * 10; i++) {
+        void *item = pvQueueReceiveInPlace(queue, portMAX_DELAY);
+        vQueueReturnItem(queue, item);
+    }
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("Zero copy queue sender blocks until a block is returned", "[freertos]")
+{
+    QueueHandle_t queue = xQueueCreateZeroCopy(QUEUE_LEN, ITEM_SIZE);
+    TEST_ASSERT_NOT_NULL(queue);
+
+    //Send more items than there are blocks while the other core returns them
+    xTaskCreatePinnedToCore(return_blocks_task, "ret", 2048, queue, UNITY_FREERTOS_PRIORITY - 1, NULL, portNUM_PROCESSORS - 1);
+    for (int i = 0; i < QUEUE_LEN * 10; i++) {
+        void *item;
+        TEST_ASSERT_EQUAL(pdTRUE, xQueueSendAcquire(queue, &item, 100));
+        TEST_ASSERT_EQUAL(pdPASS, xQueueSendComplete(queue, item));
+    }
+    vTaskDelay(10);
+    TEST_ASSERT_EQUAL(0, uxQueueMessagesWaiting(queue));
+    vQueueDelete(queue);
+}
+
+TEST_CASE("Zero copy queue sender times out while the pool is empty", "[freertos]")
+{
+    QueueHandle_t queue = xQueueCreateZeroCopy(1, ITEM_SIZE);
+    TEST_ASSERT_NOT_NULL(queue);
+
+    void *item, *extra;
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueSendAcquire(queue, &item, 0));
+    TickType_t start = xTaskGetTickCount();
+    TEST_ASSERT_EQUAL(pdFALSE, xQueueSendAcquire(queue, &extra, 10));
+    TEST_ASSERT_GREATER_OR_EQUAL(10, xTaskGetTickCount() - start);
+
+    //A returned block can be taken again
+    vQueueReturnItem(queue, item);
+    TEST_ASSERT_EQUAL(pdTRUE, xQueueSendAcquire(queue, &extra, 0));
+    TEST_ASSERT_EQUAL_PTR(item, extra);
+    vQueueReturnItem(queue, extra);
+    vQueueDelete(queue);
+}
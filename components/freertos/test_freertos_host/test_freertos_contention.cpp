@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "catch.hpp"
+
+static double time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+struct queue_context {
+    QueueHandle_t queue;
+    uint32_t items;
+    uint32_t sum;
+    SemaphoreHandle_t done;
+};
+
+static void queue_producer(void *arg)
+{
+    queue_context *ctx = (queue_context *) arg;
+    for (uint32_t i = 0; i < ctx->items; i++) {
+        xQueueSend(ctx->queue, &i, portMAX_DELAY);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void queue_consumer(void *arg)
+{
+    queue_context *ctx = (queue_context *) arg;
+    uint32_t item;
+    for (uint32_t i = 0; i < ctx->items; i++) {
+        xQueueReceive(ctx->queue, &item, portMAX_DELAY);
+        ctx->sum += item;
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("queue throughput between tasks", "[freertos_port][timing]")
+{
+    for (int consumer_core = 0; consumer_core < portNUM_PROCESSORS; consumer_core++) {
+        queue_context ctx = { xQueueCreate(16, sizeof(uint32_t)), 100000, 0, xSemaphoreCreateCounting(2, 0) };
+        double start = time_s();
+        REQUIRE(xTaskCreatePinnedToCore(queue_consumer, "consumer", 2048, &ctx, 6, NULL, consumer_core) == pdPASS);
+        REQUIRE(xTaskCreatePinnedToCore(queue_producer, "producer", 2048, &ctx, 6, NULL, 0) == pdPASS);
+        REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+        REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+        double seconds = time_s() - start;
+        CHECK(ctx.sum == (uint32_t)((uint64_t) ctx.items * (ctx.items - 1) / 2));
+        printf("queue, producer on core 0, consumer on core %d: %.0f items/s\n", consumer_core, ctx.items / seconds);
+        vQueueDelete(ctx.queue);
+        vSemaphoreDelete(ctx.done);
+    }
+}
+
+#define MAX_MESSAGE_SIZE    16384
+
+/* Both kinds of queue fill each message on the sending side and read it on the receiving side */
+struct message_context {
+    QueueHandle_t queue;
+    size_t size;
+    uint32_t messages;
+    uint32_t sum;
+    SemaphoreHandle_t done;
+};
+
+static void copy_producer(void *arg)
+{
+    message_context *ctx = (message_context *) arg;
+    std::vector<uint8_t> message(ctx->size);
+    for (uint32_t i = 0; i < ctx->messages; i++) {
+        memset(message.data(), (uint8_t) i, ctx->size);
+        xQueueSend(ctx->queue, message.data(), portMAX_DELAY);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void copy_consumer(void *arg)
+{
+    message_context *ctx = (message_context *) arg;
+    std::vector<uint8_t> message(ctx->size);
+    for (uint32_t i = 0; i < ctx->messages; i++) {
+        xQueueReceive(ctx->queue, message.data(), portMAX_DELAY);
+        ctx->sum += message[0] + message[ctx->size - 1];
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void zero_copy_producer(void *arg)
+{
+    message_context *ctx = (message_context *) arg;
+    for (uint32_t i = 0; i < ctx->messages; i++) {
+        void *message;
+        xQueueSendAcquire(ctx->queue, &message, portMAX_DELAY);
+        memset(message, (uint8_t) i, ctx->size);
+        xQueueSendComplete(ctx->queue, message);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void zero_copy_consumer(void *arg)
+{
+    message_context *ctx = (message_context *) arg;
+    for (uint32_t i = 0; i < ctx->messages; i++) {
+        uint8_t *message = (uint8_t *) pvQueueReceiveInPlace(ctx->queue, portMAX_DELAY);
+        ctx->sum += message[0] + message[ctx->size - 1];
+        vQueueReturnItem(ctx->queue, message);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+/* Passes messages of the given size from core 0 to the last core, returns messages per second */
+static double run_messages(bool zero_copy, size_t size)
+{
+    message_context ctx = { zero_copy ? xQueueCreateZeroCopy(16, size) : xQueueCreate(16, size), size, 50000, 0,
+                            xSemaphoreCreateCounting(2, 0) };
+    REQUIRE(ctx.queue != NULL);
+    double start = time_s();
+    REQUIRE(xTaskCreatePinnedToCore(zero_copy ? zero_copy_consumer : copy_consumer, "consumer", 2048, &ctx, 6, NULL,
+                                    portNUM_PROCESSORS - 1) == pdPASS);
+    REQUIRE(xTaskCreatePinnedToCore(zero_copy ? zero_copy_producer : copy_producer, "producer", 2048, &ctx, 6, NULL,
+                                    0) == pdPASS);
+    REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+    REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+    double seconds = time_s() - start;
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < ctx.messages; i++) {
+        expected += 2 * (uint8_t) i;
+    }
+    CHECK(ctx.sum == expected);
+    vQueueDelete(ctx.queue);
+    vSemaphoreDelete(ctx.done);
+    return ctx.messages / seconds;
+}
+
+/* Fills and drains the queue from a single task, so that no task switches hide the cost of passing a message */
+static double run_messages_single_task(bool zero_copy, size_t size)
+{
+    const uint32_t length = 16, rounds = 20000;
+    QueueHandle_t queue = zero_copy ? xQueueCreateZeroCopy(length, size) : xQueueCreate(length, size);
+    REQUIRE(queue != NULL);
+    std::vector<uint8_t> message(size);
+    uint32_t sum = 0;
+    double start = time_s();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t i = 0; i < length; i++) {
+            if (zero_copy) {
+                void *block;
+                xQueueSendAcquire(queue, &block, 0);
+                memset(block, (uint8_t) i, size);
+                xQueueSendComplete(queue, block);
+            } else {
+                memset(message.data(), (uint8_t) i, size);
+                xQueueSend(queue, message.data(), 0);
+            }
+        }
+        for (uint32_t i = 0; i < length; i++) {
+            if (zero_copy) {
+                uint8_t *block = (uint8_t *) pvQueueReceiveInPlace(queue, 0);
+                sum += block[size - 1];
+                vQueueReturnItem(queue, block);
+            } else {
+                xQueueReceive(queue, message.data(), 0);
+                sum += message[size - 1];
+            }
+        }
+    }
+    double seconds = time_s() - start;
+    CHECK(sum == rounds * length * (length - 1) / 2);
+    vQueueDelete(queue);
+    return rounds * length / seconds;
+}
+
+TEST_CASE("copying and zero copy queue throughput against message size", "[freertos_port][timing]")
+{
+    for (size_t size = 4; size <= MAX_MESSAGE_SIZE; size *= 4) {
+        printf("%5zu byte messages: copy %.0f msg/s, zero copy %.0f msg/s\n", size,
+               run_messages(false, size), run_messages(true, size));
+    }
+    for (size_t size = 4; size <= MAX_MESSAGE_SIZE; size *= 4) {
+        printf("%5zu byte messages in one task: copy %.0f msg/s, zero copy %.0f msg/s\n", size,
+               run_messages_single_task(false, size), run_messages_single_task(true, size));
+    }
+}
+
+struct lock_context {
+    SemaphoreHandle_t mutex;
+    portMUX_TYPE mux;
+    volatile int counter;
+    int iterations;
+    SemaphoreHandle_t done;
+};
+
+static void take_mutex(void *arg)
+{
+    lock_context *ctx = (lock_context *) arg;
+    for (int i = 0; i < ctx->iterations; i++) {
+        xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+        ctx->counter = ctx->counter + 1;
+        xSemaphoreGive(ctx->mutex);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+static void take_spinlock(void *arg)
+{
+    lock_context *ctx = (lock_context *) arg;
+    for (int i = 0; i < ctx->iterations; i++) {
+        portENTER_CRITICAL(&ctx->mux);
+        ctx->counter = ctx->counter + 1;
+        portEXIT_CRITICAL(&ctx->mux);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+/* Runs the same number of lock takers on each core, returns lock operations per second */
+static double run_lock_takers(TaskFunction_t taker, int tasks_per_core)
+{
+    lock_context ctx = { xSemaphoreCreateMutex(), portMUX_INITIALIZER_UNLOCKED, 0, 20000, xSemaphoreCreateCounting(16, 0) };
+    const int tasks = tasks_per_core * portNUM_PROCESSORS;
+    double start = time_s();
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        for (int i = 0; i < tasks_per_core; i++) {
+            REQUIRE(xTaskCreatePinnedToCore(taker, "taker", 2048, &ctx, 6, NULL, core) == pdPASS);
+        }
+    }
+    for (int i = 0; i < tasks; i++) {
+        REQUIRE(xSemaphoreTake(ctx.done, 60000) == pdTRUE);
+    }
+    double seconds = time_s() - start;
+    CHECK(ctx.counter == tasks * ctx.iterations);
+    vSemaphoreDelete(ctx.mutex);
+    vSemaphoreDelete(ctx.done);
+    return tasks * ctx.iterations / seconds;
+}
+
+TEST_CASE("mutex and spinlock contention", "[freertos_port][timing]")
+{
+    for (int tasks_per_core = 1; tasks_per_core <= 4; tasks_per_core *= 2) {
+        printf("%d tasks per core: mutex %.0f ops/s, critical section %.0f ops/s\n", tasks_per_core,
+               run_lock_takers(take_mutex, tasks_per_core), run_lock_takers(take_spinlock, tasks_per_core));
+    }
+}
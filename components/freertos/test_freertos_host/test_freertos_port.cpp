@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "catch.hpp"
+
+static uint64_t time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static int count_threads(void)
+{
+    FILE *f = fopen("/proc/self/status", "r");
+    REQUIRE(f != NULL);
+    char line[128];
+    int threads = -1;
+    while (fgets(line, sizeof(line), f)) {
+        sscanf(line, "Threads: %d", &threads);
+    }
+    fclose(f);
+    return threads;
+}
+
+struct core_report {
+    SemaphoreHandle_t done;
+    volatile uint32_t core;
+};
+
+static void report_core(void *arg)
+{
+    core_report *report = (core_report *) arg;
+    report->core = xPortGetCoreID();
+    xSemaphoreGive(report->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("pinned tasks run on their simulated core", "[freertos_port]")
+{
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        core_report report = { xSemaphoreCreateBinary(), 0xff };
+        REQUIRE(xTaskCreatePinnedToCore(report_core, "core", 2048, &report, 6, NULL, core) == pdPASS);
+        REQUIRE(xSemaphoreTake(report.done, 100) == pdTRUE);
+        CHECK(report.core == core);
+        vSemaphoreDelete(report.done);
+    }
+}
+
+TEST_CASE("tick count advances at the tick rate", "[freertos_port]")
+{
+    TickType_t start_tick = xTaskGetTickCount();
+    uint64_t start = time_us();
+    vTaskDelay(200);
+    uint64_t elapsed_ms = (time_us() - start) / 1000;
+    CHECK(xTaskGetTickCount() - start_tick >= 200);
+    CHECK(elapsed_ms >= 200 * portTICK_PERIOD_MS - 10);
+    CHECK(elapsed_ms < 1000 * portTICK_PERIOD_MS);
+}
+
+struct wake_context {
+    SemaphoreHandle_t sem;
+    volatile int woken;
+};
+
+static void wait_for_semaphore(void *arg)
+{
+    wake_context *ctx = (wake_context *) arg;
+    while (true) {
+        xSemaphoreTake(ctx->sem, portMAX_DELAY);
+        ctx->woken++;
+    }
+}
+
+TEST_CASE("unblocked higher priority task preempts the giving task", "[freertos_port]")
+{
+    wake_context ctx = { xSemaphoreCreateBinary(), 0 };
+    TaskHandle_t task;
+    REQUIRE(xTaskCreatePinnedToCore(wait_for_semaphore, "wait", 2048, &ctx, 7, &task, xPortGetCoreID()) == pdPASS);
+    for (int i = 0; i < 100; i++) {
+        xSemaphoreGive(ctx.sem);
+        REQUIRE(ctx.woken == i + 1);
+    }
+
+    /* A suspended scheduler delays the switch until it is resumed */
+    vTaskSuspendAll();
+    xSemaphoreGive(ctx.sem);
+    CHECK(ctx.woken == 100);
+    xTaskResumeAll();
+    CHECK(ctx.woken == 101);
+
+    vTaskDelete(task);
+    vSemaphoreDelete(ctx.sem);
+}
+
+struct counter_context {
+    portMUX_TYPE mux;
+    volatile int counter;
+    int increments;
+    SemaphoreHandle_t done;
+};
+
+static void increment_in_critical_section(void *arg)
+{
+    counter_context *ctx = (counter_context *) arg;
+    for (int i = 0; i < ctx->increments; i++) {
+        portENTER_CRITICAL(&ctx->mux);
+        ctx->counter = ctx->counter + 1;
+        portEXIT_CRITICAL(&ctx->mux);
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("critical sections exclude the tasks on all cores", "[freertos_port]")
+{
+    const int tasks_per_core = 2;
+    counter_context ctx = { portMUX_INITIALIZER_UNLOCKED, 0, 100000, xSemaphoreCreateCounting(16, 0) };
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        for (int i = 0; i < tasks_per_core; i++) {
+            REQUIRE(xTaskCreatePinnedToCore(increment_in_critical_section, "inc", 2048, &ctx, 6, NULL, core) == pdPASS);
+        }
+    }
+    for (int i = 0; i < tasks_per_core * portNUM_PROCESSORS; i++) {
+        REQUIRE(xSemaphoreTake(ctx.done, 10000) == pdTRUE);
+    }
+    CHECK(ctx.counter == tasks_per_core * portNUM_PROCESSORS * ctx.increments);
+    vSemaphoreDelete(ctx.done);
+}
+
+static void signal_and_exit(void *arg)
+{
+    xSemaphoreGive((SemaphoreHandle_t) arg);
+    vTaskDelete(NULL);
+}
+
+TEST_CASE("deleted tasks end their threads", "[freertos_port]")
+{
+    /* Let the idle tasks free the tasks of earlier tests */
+    vTaskDelay(50);
+    UBaseType_t tasks = uxTaskGetNumberOfTasks();
+    int threads = count_threads();
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(50, 0);
+    for (int i = 0; i < 50; i++) {
+        REQUIRE(xTaskCreatePinnedToCore(signal_and_exit, "exit", 2048, done, 4, NULL, i % portNUM_PROCESSORS) == pdPASS);
+    }
+    for (int i = 0; i < 50; i++) {
+        REQUIRE(xSemaphoreTake(done, 1000) == pdTRUE);
+    }
+
+    /* The idle tasks free the deleted tasks */
+    for (int i = 0; i < 100 && (uxTaskGetNumberOfTasks() != tasks || count_threads() > threads); i++) {
+        vTaskDelay(10);
+    }
+    CHECK(uxTaskGetNumberOfTasks() == tasks);
+    CHECK(count_threads() <= threads);
+    vSemaphoreDelete(done);
+}
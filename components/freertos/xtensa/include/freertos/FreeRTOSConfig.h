@@ -77,6 +77,11 @@
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
 #endif
 
+/* keep separate ready lists for the tasks pinned to each core */
+#ifdef CONFIG_FREERTOS_PER_CORE_READY_LISTS
+#define configUSE_PER_CORE_READY_LISTS 1
+#endif
+
 /* ESP31 and ESP32 are dualcore processors. */
 #ifndef CONFIG_FREERTOS_UNICORE
 #define portNUM_PROCESSORS 2
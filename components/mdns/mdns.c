@@ -1028,6 +1028,103 @@ static void _mdns_dispatch_tx_packet(mdns_tx_packet_t * p)
     _mdns_udp_pcb_write(p->tcpip_if, p->ip_protocol, &p->dst, p->port, packet, index);
 }
 
+/**
+ * @brief  Allocate memory that is needed only until the current action finishes
+ *
+ * Falls back to the heap when the packet arena is full
+ */
+static void * _mdns_arena_alloc(size_t size)
+{
+    size_t aligned = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    if (_mdns_server->packet_arena.used + aligned > sizeof(_mdns_server->packet_arena.buf)) {
+        return malloc(size);
+    }
+    void * ptr = (uint8_t *)_mdns_server->packet_arena.buf + _mdns_server->packet_arena.used;
+    _mdns_server->packet_arena.used += aligned;
+    return ptr;
+}
+
+/**
+ * @brief  Duplicate string into the packet arena
+ */
+static char * _mdns_arena_strdup(const char * str)
+{
+    size_t len = strlen(str) + 1;
+    char * ret = (char *)_mdns_arena_alloc(len);
+    if (ret) {
+        memcpy(ret, str, len);
+    }
+    return ret;
+}
+
+/**
+ * @brief  Free memory from _mdns_arena_alloc (only the heap fallback is actually released)
+ */
+static void _mdns_arena_free(void * ptr)
+{
+    uint8_t * arena = (uint8_t *)_mdns_server->packet_arena.buf;
+    if ((uint8_t *)ptr < arena || (uint8_t *)ptr >= arena + sizeof(_mdns_server->packet_arena.buf)) {
+        free(ptr);
+    }
+}
+
+/**
+ * @brief  Link the preallocated packets and answers into their free lists
+ */
+static void _mdns_init_pools(void)
+{
+    size_t i;
+    _mdns_server->packet_arena.used = 0;
+    _mdns_server->tx_packet_free = NULL;
+    for (i = 0; i < MDNS_TX_PACKET_POOL_LEN; i++) {
+        _mdns_server->tx_packet_pool[i].next = _mdns_server->tx_packet_free;
+        _mdns_server->tx_packet_free = &_mdns_server->tx_packet_pool[i];
+    }
+    _mdns_server->answer_free = NULL;
+    for (i = 0; i < MDNS_ANSWER_POOL_LEN; i++) {
+        _mdns_server->answer_pool[i].next = _mdns_server->answer_free;
+        _mdns_server->answer_free = &_mdns_server->answer_pool[i];
+    }
+}
+
+/**
+ * @brief  Take an answer from the pool or the heap if the pool is empty
+ */
+static mdns_out_answer_t * _mdns_new_answer(void)
+{
+    mdns_out_answer_t * a = _mdns_server->answer_free;
+    if (a) {
+        _mdns_server->answer_free = a->next;
+        return a;
+    }
+    return (mdns_out_answer_t *)malloc(sizeof(mdns_out_answer_t));
+}
+
+/**
+ * @brief  Return answer to the pool or the heap
+ */
+static void _mdns_free_answer(mdns_out_answer_t * answer)
+{
+    if (answer >= _mdns_server->answer_pool && answer < _mdns_server->answer_pool + MDNS_ANSWER_POOL_LEN) {
+        answer->next = _mdns_server->answer_free;
+        _mdns_server->answer_free = answer;
+    } else {
+        free(answer);
+    }
+}
+
+/**
+ * @brief  Free all answers in the list
+ */
+static void _mdns_free_answers(mdns_out_answer_t * answers)
+{
+    while (answers) {
+        mdns_out_answer_t * a = answers;
+        answers = answers->next;
+        _mdns_free_answer(a);
+    }
+}
+
 /**
  * @brief  frees a packet
  *
@@ -1039,10 +1136,15 @@ static void _mdns_free_tx_packet(mdns_tx_packet_t * packet)
         return;
     }
     queueFree(mdns_out_question_t, packet->questions);
-    queueFree(mdns_out_answer_t, packet->answers);
-    queueFree(mdns_out_answer_t, packet->servers);
-    queueFree(mdns_out_answer_t, packet->additional);
-    free(packet);
+    _mdns_free_answers(packet->answers);
+    _mdns_free_answers(packet->servers);
+    _mdns_free_answers(packet->additional);
+    if (packet >= _mdns_server->tx_packet_pool && packet < _mdns_server->tx_packet_pool + MDNS_TX_PACKET_POOL_LEN) {
+        packet->next = _mdns_server->tx_packet_free;
+        _mdns_server->tx_packet_free = packet;
+    } else {
+        free(packet);
+    }
 }
 
 /**
@@ -1145,13 +1247,13 @@ static void _mdns_remove_scheduled_answer(mdns_if_t tcpip_if, mdns_ip_protocol_t
             mdns_out_answer_t * a = q->answers;
             if (a->type == type && a->service == service->service) {
                 q->answers = q->answers->next;
-                free(a);
+                _mdns_free_answer(a);
             } else {
                 while (a->next) {
                     if (a->next->type == type && a->next->service == service->service) {
                         mdns_out_answer_t * b = a->next;
                         a->next = b->next;
-                        free(b);
+                        _mdns_free_answer(b);
                         break;
                     }
                     a = a->next;
@@ -1177,14 +1279,14 @@ static void _mdns_dealloc_answer(mdns_out_answer_t ** destination, uint16_t type
     }
     if (d->type == type && d->service == service->service) {
         *destination = d->next;
-        free(d);
+        _mdns_free_answer(d);
         return;
     }
     while (d->next) {
         mdns_out_answer_t * a = d->next;
         if (a->type == type && a->service == service->service) {
             d->next = a->next;
-            free(a);
+            _mdns_free_answer(a);
             return;
         }
         d = d->next;
@@ -1204,7 +1306,7 @@ static bool _mdns_alloc_answer(mdns_out_answer_t ** destination, uint16_t type,
         d = d->next;
     }
 
-    mdns_out_answer_t * a = (mdns_out_answer_t *)malloc(sizeof(mdns_out_answer_t));
+    mdns_out_answer_t * a = _mdns_new_answer();
     if (!a) {
         HOOK_MALLOC_FAILED;
         return false;
@@ -1224,10 +1326,15 @@ static bool _mdns_alloc_answer(mdns_out_answer_t ** destination, uint16_t type,
  */
 static mdns_tx_packet_t * _mdns_alloc_packet_default(mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
 {
-    mdns_tx_packet_t * packet = (mdns_tx_packet_t*)malloc(sizeof(mdns_tx_packet_t));
-    if (!packet) {
-        HOOK_MALLOC_FAILED;
-        return NULL;
+    mdns_tx_packet_t * packet = _mdns_server->tx_packet_free;
+    if (packet) {
+        _mdns_server->tx_packet_free = packet->next;
+    } else {
+        packet = (mdns_tx_packet_t*)malloc(sizeof(mdns_tx_packet_t));
+        if (!packet) {
+            HOOK_MALLOC_FAILED;
+            return NULL;
+        }
     }
     memset((uint8_t*)packet, 0, sizeof(mdns_tx_packet_t));
     packet->tcpip_if = tcpip_if;
@@ -1943,14 +2050,14 @@ static void _mdns_dealloc_scheduled_service_answers(mdns_out_answer_t ** destina
     }
     while (d && d->service == service) {
         *destination = d->next;
-        free(d);
+        _mdns_free_answer(d);
         d = *destination;
     }
     while (d && d->next) {
         mdns_out_answer_t * a = d->next;
         if (a->service == service) {
             d->next = a->next;
-            free(a);
+            _mdns_free_answer(a);
         } else {
             d = d->next;
         }
@@ -2431,6 +2538,30 @@ static bool _mdns_question_matches(mdns_parsed_question_t * question, uint16_t t
     return false;
 }
 
+/**
+ * @brief  Allocate empty question in the packet arena
+ */
+static mdns_parsed_question_t * _mdns_alloc_parsed_question(void)
+{
+    mdns_parsed_question_t * q = (mdns_parsed_question_t *)_mdns_arena_alloc(sizeof(mdns_parsed_question_t));
+    if (q) {
+        memset(q, 0, sizeof(mdns_parsed_question_t));
+    }
+    return q;
+}
+
+/**
+ * @brief  Free question allocated with _mdns_alloc_parsed_question
+ */
+static void _mdns_free_parsed_question(mdns_parsed_question_t * q)
+{
+    _mdns_arena_free(q->host);
+    _mdns_arena_free(q->service);
+    _mdns_arena_free(q->proto);
+    _mdns_arena_free(q->domain);
+    _mdns_arena_free(q);
+}
+
 /**
  * @brief  Removes saved question from parsed data
  */
@@ -2440,11 +2571,7 @@ static void _mdns_remove_parsed_question(mdns_parsed_packet_t * parsed_packet, u
 
     if (_mdns_question_matches(q, type, service)) {
         parsed_packet->questions = q->next;
-        free(q->host);
-        free(q->service);
-        free(q->proto);
-        free(q->domain);
-        free(q);
+        _mdns_free_parsed_question(q);
         return;
     }
 
@@ -2452,11 +2579,7 @@ static void _mdns_remove_parsed_question(mdns_parsed_packet_t * parsed_packet, u
         mdns_parsed_question_t * p = q->next;
         if (_mdns_question_matches(p, type, service)) {
             q->next = p->next;
-            free(p->host);
-            free(p->service);
-            free(p->proto);
-            free(p->domain);
-            free(p);
+            _mdns_free_parsed_question(p);
             return;
         }
         q = q->next;
@@ -2589,12 +2712,12 @@ handle_error :
 }
 
 /**
- * @brief  Duplicate string or return error
+ * @brief  Duplicate string into the packet arena or return error
  */
 static esp_err_t _mdns_strdup_check(char ** out, char * in)
 {
     if (in && in[0]) {
-        *out = strdup(in);
+        *out = _mdns_arena_strdup(in);
         if (!*out) {
             return ESP_FAIL;
         }
@@ -2604,6 +2727,308 @@ static esp_err_t _mdns_strdup_check(char ** out, char * in)
     return ESP_OK;
 }
 
+/**
+ * @brief  Remove cached records that match the filter, or all of them if filter is NULL
+ */
+static void _mdns_cache_remove(bool (*filter)(mdns_cached_record_t * r, void * arg), void * arg)
+{
+    mdns_cached_record_t * r = _mdns_server->cache;
+    mdns_cached_record_t * p = NULL;
+    while (r) {
+        if (!filter || filter(r, arg)) {
+            mdns_cached_record_t * d = r;
+            r = r->next;
+            if (p) {
+                p->next = r;
+            } else {
+                _mdns_server->cache = r;
+            }
+            free(d);
+            _mdns_server->cache_len--;
+        } else {
+            p = r;
+            r = r->next;
+        }
+    }
+}
+
+static bool _mdns_cache_is_expired(mdns_cached_record_t * r, void * now)
+{
+    return (int32_t)(r->expires_at - *(uint32_t *)now) <= 0;
+}
+
+static bool _mdns_cache_is_on_pcb(mdns_cached_record_t * r, void * pcb)
+{
+    return r->tcpip_if == ((mdns_cached_record_t *)pcb)->tcpip_if && r->ip_protocol == ((mdns_cached_record_t *)pcb)->ip_protocol;
+}
+
+/**
+ * @brief  Forget records received on the interface (it went down, the peers may have changed)
+ */
+static void _mdns_cache_flush_pcb(mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
+{
+    mdns_cached_record_t pcb;
+    pcb.tcpip_if = tcpip_if;
+    pcb.ip_protocol = ip_protocol;
+    _mdns_cache_remove(_mdns_cache_is_on_pcb, &pcb);
+}
+
+/**
+ * @brief  Check if cached record holds the same resource record as the received one
+ *
+ * PTR, A and AAAA records are shared (many per name), SRV and TXT records are unique per name
+ */
+static bool _mdns_cache_record_matches(mdns_cached_record_t * r, void * arg)
+{
+    mdns_cached_record_t * record = (mdns_cached_record_t *)arg;
+    if (r->type != record->type || r->tcpip_if != record->tcpip_if || r->ip_protocol != record->ip_protocol
+        || strcasecmp(r->host, record->host) || strcasecmp(r->service, record->service) || strcasecmp(r->proto, record->proto)) {
+        return false;
+    }
+    if (r->type == MDNS_TYPE_PTR) {
+        return !strcasecmp(r->target, record->target);
+    } else if (r->type == MDNS_TYPE_A) {
+        return r->addr.u_addr.ip4.addr == record->addr.u_addr.ip4.addr;
+    } else if (r->type == MDNS_TYPE_AAAA) {
+        return !memcmp(r->addr.u_addr.ip6.addr, record->addr.u_addr.ip6.addr, MDNS_ANSWER_AAAA_SIZE);
+    }
+    return true;
+}
+
+/**
+ * @brief  Check if unique record changed its data
+ */
+static bool _mdns_cache_record_data_equal(mdns_cached_record_t * r, mdns_cached_record_t * record)
+{
+    if (r->type == MDNS_TYPE_SRV) {
+        return r->port == record->port && !strcasecmp(r->target, record->target);
+    } else if (r->type == MDNS_TYPE_TXT) {
+        return r->txt_len == record->txt_len && !memcmp(r->txt, record->txt, r->txt_len);
+    }
+    return true;
+}
+
+/**
+ * @brief  Check if cached record is of the same name and type as the received one, which has
+ *         its cache-flush bit set, and was received more than a second earlier
+ *
+ * Records received within the last second belong to the same announcement (RFC 6762, 10.2).
+ * A cached copy of the received record itself is kept, its TTL is refreshed instead.
+ */
+static bool _mdns_cache_record_is_flushed(mdns_cached_record_t * r, void * arg)
+{
+    mdns_cached_record_t * record = (mdns_cached_record_t *)arg;
+    uint32_t now = record->expires_at - record->ttl;
+    if (r->type != record->type || r->tcpip_if != record->tcpip_if || r->ip_protocol != record->ip_protocol
+        || strcasecmp(r->host, record->host) || strcasecmp(r->service, record->service) || strcasecmp(r->proto, record->proto)) {
+        return false;
+    }
+    if ((int32_t)(now - (r->expires_at - r->ttl)) <= MDNS_CACHE_FLUSH_DELAY_MS) {
+        return false;
+    }
+    return !_mdns_cache_record_matches(r, record) || !_mdns_cache_record_data_equal(r, record);
+}
+
+/**
+ * @brief  Copy record with its names and data into one allocation
+ */
+static mdns_cached_record_t * _mdns_cache_record_dup(mdns_cached_record_t * record)
+{
+    size_t host_len = strlen(record->host) + 1;
+    size_t service_len = strlen(record->service) + 1;
+    size_t proto_len = strlen(record->proto) + 1;
+    size_t target_len = record->target ? strlen(record->target) + 1 : 0;
+    mdns_cached_record_t * r = (mdns_cached_record_t *)malloc(sizeof(mdns_cached_record_t) + host_len + service_len + proto_len + target_len + record->txt_len);
+    if (!r) {
+        HOOK_MALLOC_FAILED;
+        return NULL;
+    }
+    memcpy(r, record, sizeof(mdns_cached_record_t));
+    char * str = (char *)(r + 1);
+    r->host = memcpy(str, record->host, host_len);
+    str += host_len;
+    r->service = memcpy(str, record->service, service_len);
+    str += service_len;
+    r->proto = memcpy(str, record->proto, proto_len);
+    str += proto_len;
+    if (record->target) {
+        r->target = memcpy(str, record->target, target_len);
+        str += target_len;
+    }
+    if (record->txt_len) {
+        r->txt = memcpy(str, record->txt, record->txt_len);
+    }
+    r->next = NULL;
+    return r;
+}
+
+/**
+ * @brief  Called from parser to remember record of other host
+ *
+ * A record with TTL of zero (goodbye) removes the cached one.
+ * A record with the cache-flush bit set replaces the cached records of its name and type.
+ * If the cache is full, the record closest to expiring is dropped.
+ */
+static void _mdns_cache_add(const uint8_t * data, const uint8_t * data_ptr, uint16_t data_len, mdns_name_t * name, uint16_t type, uint32_t ttl, bool flush, mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
+{
+    static mdns_name_t target;
+    mdns_cached_record_t record;
+
+    if (!MDNS_CACHE_SIZE || name->sub || name->invalid || strcasecmp(name->domain, MDNS_DEFAULT_DOMAIN)) {
+        return;
+    }
+    memset(&record, 0, sizeof(mdns_cached_record_t));
+    record.type = type;
+    record.tcpip_if = tcpip_if;
+    record.ip_protocol = ip_protocol;
+    record.host = name->host;
+    record.service = name->service;
+    record.proto = name->proto;
+
+    if (type == MDNS_TYPE_PTR) {
+        if (!_mdns_parse_fqdn(data, data_ptr, &target) || target.invalid || _str_null_or_empty(target.host)) {
+            return;
+        }
+        record.target = target.host;
+    } else if (type == MDNS_TYPE_SRV) {
+        if (data_len <= MDNS_SRV_FQDN_OFFSET || !_mdns_parse_fqdn(data, data_ptr + MDNS_SRV_FQDN_OFFSET, &target) || target.invalid) {
+            return;
+        }
+        record.target = target.host;
+        record.port = _mdns_read_u16(data_ptr, MDNS_SRV_PORT_OFFSET);
+    } else if (type == MDNS_TYPE_TXT) {
+        record.txt = data_ptr;
+        record.txt_len = data_len;
+    } else if (type == MDNS_TYPE_A && data_len == 4) {
+        record.addr.type = IPADDR_TYPE_V4;
+        memcpy(&record.addr.u_addr.ip4.addr, data_ptr, 4);
+    } else if (type == MDNS_TYPE_AAAA && data_len == MDNS_ANSWER_AAAA_SIZE) {
+        record.addr.type = IPADDR_TYPE_V6;
+        memcpy(record.addr.u_addr.ip6.addr, data_ptr, MDNS_ANSWER_AAAA_SIZE);
+    } else {
+        return;
+    }
+
+    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    record.ttl = MIN(ttl, MDNS_CACHE_MAX_TTL) * 1000;
+    record.expires_at = now + record.ttl;
+
+    if (flush && ttl) {
+        _mdns_cache_remove(_mdns_cache_record_is_flushed, &record);
+    }
+    mdns_cached_record_t * r = _mdns_server->cache;
+    while (r && !_mdns_cache_record_matches(r, &record)) {
+        r = r->next;
+    }
+    if (r) {
+        if (ttl && _mdns_cache_record_data_equal(r, &record)) {
+            r->ttl = record.ttl;
+            r->expires_at = record.expires_at;
+            return;
+        }
+        _mdns_cache_remove(_mdns_cache_record_matches, &record);
+    }
+    if (!ttl) {
+        return;
+    }
+
+    _mdns_cache_remove(_mdns_cache_is_expired, &now);
+    if (_mdns_server->cache_len >= MDNS_CACHE_SIZE) {
+        mdns_cached_record_t * oldest = _mdns_server->cache;
+        for (r = _mdns_server->cache; r; r = r->next) {
+            if ((int32_t)(r->expires_at - oldest->expires_at) < 0) {
+                oldest = r;
+            }
+        }
+        _mdns_cache_remove(_mdns_cache_record_matches, oldest);
+    }
+    r = _mdns_cache_record_dup(&record);
+    if (!r) {
+        return;
+    }
+    r->next = _mdns_server->cache;
+    _mdns_server->cache = r;
+    _mdns_server->cache_len++;
+}
+
+/**
+ * @brief  Add cached records matching the search to its results
+ *
+ * Only records with more than half of their TTL remaining are used for PTR searches,
+ * as those are sent out as known answers when the search is transmitted (RFC 6762, 7.1).
+ *
+ * @return true if the search is complete without querying the network
+ */
+static bool _mdns_cache_search(mdns_search_once_t * search)
+{
+    static const uint16_t types[] = { MDNS_TYPE_PTR, MDNS_TYPE_SRV, MDNS_TYPE_TXT, MDNS_TYPE_A, MDNS_TYPE_AAAA };
+    static mdns_name_t name;
+    mdns_cached_record_t * r;
+    size_t i;
+
+    if (!_mdns_server->cache) {
+        return false;
+    }
+    uint32_t now = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    _mdns_cache_remove(_mdns_cache_is_expired, &now);
+
+    // answers for the instances (SRV, TXT) and hosts (A, AAAA) are linked to PTR results, so go type by type
+    for (i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        for (r = _mdns_server->cache; r; r = r->next) {
+            if (r->type != types[i]) {
+                continue;
+            }
+            if (search->type == MDNS_TYPE_PTR && (r->expires_at - now) < r->ttl / 2) {
+                continue;
+            }
+            strlcpy(name.host, r->host, MDNS_NAME_BUF_LEN);
+            strlcpy(name.service, r->service, MDNS_NAME_BUF_LEN);
+            strlcpy(name.proto, r->proto, MDNS_NAME_BUF_LEN);
+            if (_mdns_search_find_from(search, &name, r->type, r->tcpip_if, r->ip_protocol) != search) {
+                continue;
+            }
+            if (r->type == MDNS_TYPE_PTR) {
+                _mdns_search_result_add_ptr(search, r->target, r->tcpip_if, r->ip_protocol);
+            } else if (r->type == MDNS_TYPE_SRV) {
+                if (search->type == MDNS_TYPE_PTR) {
+                    mdns_result_t * result = _mdns_search_result_add_ptr(search, r->host, r->tcpip_if, r->ip_protocol);
+                    if (result && !result->hostname) {
+                        result->port = r->port;
+                        result->hostname = strdup(r->target);
+                    }
+                } else {
+                    _mdns_search_result_add_srv(search, r->target, r->port, r->tcpip_if, r->ip_protocol);
+                }
+            } else if (r->type == MDNS_TYPE_TXT) {
+                mdns_txt_item_t * txt = NULL;
+                size_t txt_count = 0;
+                if (search->type == MDNS_TYPE_PTR) {
+                    mdns_result_t * result = _mdns_search_result_add_ptr(search, r->host, r->tcpip_if, r->ip_protocol);
+                    if (result && !result->txt) {
+                        _mdns_result_txt_create(r->txt, r->txt_len, &txt, &txt_count);
+                        if (txt_count) {
+                            result->txt = txt;
+                            result->txt_count = txt_count;
+                        }
+                    }
+                } else {
+                    _mdns_result_txt_create(r->txt, r->txt_len, &txt, &txt_count);
+                    if (txt_count) {
+                        _mdns_search_result_add_txt(search, txt, txt_count, r->tcpip_if, r->ip_protocol);
+                    }
+                }
+            } else {
+                _mdns_search_result_add_ip(search, r->host, &r->addr, r->tcpip_if, r->ip_protocol);
+            }
+        }
+    }
+
+    if (search->max_results && search->num_results >= search->max_results) {
+        return true;
+    }
+    return search->result && search->type != MDNS_TYPE_PTR && search->type != MDNS_TYPE_ANY;
+}
+
 /**
  * @brief  main packet parser
  *
@@ -2629,7 +3054,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
     mdns_debug_packet(data, len);
 #endif
 
-    mdns_parsed_packet_t * parsed_packet = (mdns_parsed_packet_t *)malloc(sizeof(mdns_parsed_packet_t));
+    mdns_parsed_packet_t * parsed_packet = (mdns_parsed_packet_t *)_mdns_arena_alloc(sizeof(mdns_parsed_packet_t));
     if (!parsed_packet) {
         HOOK_MALLOC_FAILED;
         return;
@@ -2647,13 +3072,13 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
     header.additional = _mdns_read_u16(data, MDNS_HEAD_ADDITIONAL_OFFSET);
 
     if (header.flags.value == MDNS_FLAGS_AUTHORITATIVE && packet->src_port != MDNS_SERVICE_PORT) {
-        free(parsed_packet);
+        _mdns_arena_free(parsed_packet);
         return;
     }
 
     //if we have not set the hostname, we can not answer questions
     if (header.questions && _str_null_or_empty(_mdns_server->hostname)) {
-        free(parsed_packet);
+        _mdns_arena_free(parsed_packet);
         return;
     }
 
@@ -2692,7 +3117,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                 parsed_packet->discovery = true;
                 mdns_srv_item_t * a = _mdns_server->services;
                 while (a) {
-                    mdns_parsed_question_t * question = (mdns_parsed_question_t *)calloc(1, sizeof(mdns_parsed_question_t));
+                    mdns_parsed_question_t * question = _mdns_alloc_parsed_question();
                     if (!question) {
                         HOOK_MALLOC_FAILED;
                         goto clear_rx_packet;
@@ -2703,9 +3128,9 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                     question->unicast = unicast;
                     question->type = MDNS_TYPE_SDPTR;
                     question->host = NULL;
-                    question->service = strdup(a->service->service);
-                    question->proto = strdup(a->service->proto);
-                    question->domain = strdup(MDNS_DEFAULT_DOMAIN);
+                    question->service = _mdns_arena_strdup(a->service->service);
+                    question->proto = _mdns_arena_strdup(a->service->proto);
+                    question->domain = _mdns_arena_strdup(MDNS_DEFAULT_DOMAIN);
                     if (!question->service || !question->proto || !question->domain) {
                         goto clear_rx_packet;
                     }
@@ -2720,7 +3145,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                 parsed_packet->probe = true;
             }
 
-            mdns_parsed_question_t * question = (mdns_parsed_question_t *)calloc(1, sizeof(mdns_parsed_question_t));
+            mdns_parsed_question_t * question = _mdns_alloc_parsed_question();
             if (!question) {
                 HOOK_MALLOC_FAILED;
                 goto clear_rx_packet;
@@ -2756,6 +3181,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
             uint32_t ttl = _mdns_read_u32(content, MDNS_TTL_OFFSET);
             uint16_t data_len = _mdns_read_u16(content, MDNS_LEN_OFFSET);
             const uint8_t * data_ptr = content + MDNS_DATA_OFFSET;
+            bool cache_flush = mdns_class & 0x8000;
             mdns_class &= 0x7FFF;
 
             content = data_ptr + data_len;
@@ -2792,6 +3218,7 @@ void mdns_parse_packet(mdns_rx_packet_t * packet)
                     //skip this record
                     continue;
                 }
+                _mdns_cache_add(data, data_ptr, data_len, name, type, ttl, cache_flush, packet->tcpip_if, packet->ip_protocol);
                 search_result = _mdns_search_find_from(_mdns_server->search_once, name, type, packet->tcpip_if, packet->ip_protocol);
             }
 
@@ -3069,13 +3496,9 @@ clear_rx_packet:
     while (parsed_packet->questions) {
         mdns_parsed_question_t * question = parsed_packet->questions;
         parsed_packet->questions = parsed_packet->questions->next;
-        free(question->host);
-        free(question->service);
-        free(question->proto);
-        free(question->domain);
-        free(question);
+        _mdns_free_parsed_question(question);
     }
-    free(parsed_packet);
+    _mdns_arena_free(parsed_packet);
 }
 
 /**
@@ -3098,6 +3521,7 @@ void _mdns_disable_pcb(mdns_if_t tcpip_if, mdns_ip_protocol_t ip_protocol)
 {
     if (_mdns_server->interfaces[tcpip_if].pcbs[ip_protocol].pcb) {
         _mdns_clear_pcb_tx_queue_head(tcpip_if, ip_protocol);
+        _mdns_cache_flush_pcb(tcpip_if, ip_protocol);
         _mdns_pcb_deinit(tcpip_if, ip_protocol);
         mdns_if_t other_if = _mdns_get_other_if (tcpip_if);
         if (other_if != MDNS_IF_MAX && _mdns_server->interfaces[other_if].pcbs[ip_protocol].state == PCB_DUP) {
@@ -3271,12 +3695,15 @@ static void _mdns_search_finish(mdns_search_once_t * search)
 }
 
 /**
- * @brief  Add new search to the search chain
+ * @brief  Add new search to the search chain, or finish it right away if the cache has the answers
  */
 static void _mdns_search_add(mdns_search_once_t * search)
 {
     search->next = _mdns_server->search_once;
     _mdns_server->search_once = search;
+    if (_mdns_cache_search(search)) {
+        _mdns_search_finish(search);
+    }
 }
 
 /**
@@ -3611,7 +4038,7 @@ static mdns_tx_packet_t * _mdns_create_search_packet(mdns_search_once_t * search
                 r = r->next;
                 continue;
             }
-            mdns_out_answer_t * a = (mdns_out_answer_t *)malloc(sizeof(mdns_out_answer_t));
+            mdns_out_answer_t * a = _mdns_new_answer();
             if (!a) {
                 HOOK_MALLOC_FAILED;
                 _mdns_free_tx_packet(packet);
@@ -3973,6 +4400,7 @@ static void _mdns_execute_action(mdns_action_t * action)
         break;
     }
     free(action);
+    _mdns_server->packet_arena.used = 0;
 }
 
 /**
@@ -4234,6 +4662,7 @@ esp_err_t mdns_init(void)
         return ESP_ERR_NO_MEM;
     }
     memset((uint8_t*)_mdns_server, 0, sizeof(mdns_server_t));
+    _mdns_init_pools();
     // zero-out local copy of netifs to initiate a fresh search by interface key whenever a netif ptr is needed
     memset(s_esp_netifs, 0, sizeof(s_esp_netifs));
 
@@ -4331,6 +4760,7 @@ void mdns_free(void)
         vQueueDelete(_mdns_server->action_queue);
     }
     _mdns_clear_tx_queue_head();
+    _mdns_cache_remove(NULL, NULL);
     while (_mdns_server->search_once) {
         mdns_search_once_t * h = _mdns_server->search_once;
         _mdns_server->search_once = h->next;
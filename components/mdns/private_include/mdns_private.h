@@ -72,6 +72,9 @@
 #define MDNS_NAME_MAX_LEN           64                      // Maximum string length of hostname, instance, service and proto
 #define MDNS_NAME_BUF_LEN           (MDNS_NAME_MAX_LEN+1)   // Maximum char buffer size to hold hostname, instance, service or proto
 #define MDNS_MAX_PACKET_SIZE        1460                    // Maximum size of mDNS  outgoing packet
+#define MDNS_PACKET_ARENA_SIZE      (512 + MDNS_MAX_SERVICES * 64)  // Scratch memory for parsing one received packet (service discovery adds a question per service)
+#define MDNS_TX_PACKET_POOL_LEN     8                       // Outgoing packets preallocated with the server
+#define MDNS_ANSWER_POOL_LEN        (16 + MDNS_MAX_SERVICES * 2)    // Outgoing answers preallocated with the server
 
 #define MDNS_HEAD_LEN               12
 #define MDNS_HEAD_ID_OFFSET         0
@@ -93,6 +96,9 @@
 #define MDNS_SRV_FQDN_OFFSET        6
 
 #define MDNS_TIMER_PERIOD_US        (CONFIG_MDNS_TIMER_PERIOD_MS*1000)
+#define MDNS_CACHE_SIZE             CONFIG_MDNS_CACHE_SIZE  // Maximum records received from other hosts kept until their TTL expires
+#define MDNS_CACHE_MAX_TTL          86400                   // Longer TTLs are shortened to this when cached (in seconds)
+#define MDNS_CACHE_FLUSH_DELAY_MS   1000                    // Records received this recently are kept by a cache-flush record
 
 #define MDNS_SERVICE_LOCK()     xSemaphoreTake(_mdns_service_semaphore, portMAX_DELAY)
 #define MDNS_SERVICE_UNLOCK()   xSemaphoreGive(_mdns_service_semaphore)
@@ -323,6 +329,23 @@ typedef enum {
     SEARCH_MAX
 } mdns_search_once_state_t;
 
+typedef struct mdns_cached_record_s {
+    struct mdns_cached_record_s * next;
+    uint32_t expires_at;                    // in ms
+    uint32_t ttl;                           // in ms
+    uint16_t type;
+    uint16_t port;                          // SRV
+    mdns_if_t tcpip_if;
+    mdns_ip_protocol_t ip_protocol;
+    const char * host;                      // record name: instance for SRV/TXT, host name for A/AAAA, empty for PTR
+    const char * service;
+    const char * proto;
+    const char * target;                    // PTR instance or SRV host name
+    const uint8_t * txt;                    // TXT rdata
+    uint16_t txt_len;
+    esp_ip_addr_t addr;                     // A/AAAA
+} mdns_cached_record_t;
+
 typedef struct mdns_search_once_s {
     struct mdns_search_once_s * next;
 
@@ -352,6 +375,16 @@ typedef struct mdns_server_s {
     mdns_tx_packet_t * tx_queue_head;
     mdns_search_once_t * search_once;
     esp_timer_handle_t timer_handle;
+    mdns_cached_record_t * cache;
+    size_t cache_len;
+    struct {
+        void * buf[MDNS_PACKET_ARENA_SIZE / sizeof(void *)];
+        size_t used;
+    } packet_arena;                                         // bump allocated, reset after each action
+    mdns_tx_packet_t tx_packet_pool[MDNS_TX_PACKET_POOL_LEN];
+    mdns_tx_packet_t * tx_packet_free;
+    mdns_out_answer_t answer_pool[MDNS_ANSWER_POOL_LEN];
+    mdns_out_answer_t * answer_free;
 } mdns_server_t;
 
 typedef struct {
@@ -20,6 +20,8 @@
 // Not to include
 #define ESP_MDNS_NETWORKING_H_
 #define _TCPIP_ADAPTER_H_
+#define _ESP_NETIF_H_
+#define _ESP_TASK_H_
 
 
 #ifdef USE_BSD_STRING
@@ -34,6 +36,14 @@
 #include <sys/time.h>
 
 #define CONFIG_MDNS_MAX_SERVICES    25
+#define CONFIG_MDNS_TASK_PRIORITY   1
+#define CONFIG_MDNS_TASK_AFFINITY   0
+#define CONFIG_MDNS_SERVICE_ADD_TIMEOUT_MS  10
+#define CONFIG_MDNS_TIMER_PERIOD_MS         100
+#define CONFIG_MDNS_CACHE_SIZE              32
+
+#define ESP_TASK_PRIO_MAX           25
+#define ESP_TASKD_EVENT_PRIO        5
 
 #define ERR_OK                      0
 #define ESP_OK                      0
@@ -56,6 +66,8 @@
 
 #define portMAX_DELAY               0xFFFFFFFF
 #define portTICK_PERIOD_MS          1
+#define portTICK_RATE_MS            portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms)           (ms)
 #define ESP_LOGD(a,b)
 
 #define xSemaphoreTake(s,d)
@@ -71,10 +83,11 @@
 #define vTaskDelay(m)               usleep((m)*0)
 #define pbuf_free(p)                free(p)
 #define esp_random()                (rand()%UINT32_MAX)
-#define tcpip_adapter_get_ip_info(i,d)          true
-#define tcpip_adapter_dhcpc_get_status(a, b)    TCPIP_ADAPTER_DHCP_STARTED
-#define tcpip_adapter_get_ip6_linklocal(i,d)    (ESP_OK)
-#define tcpip_adapter_get_hostname(i, n)        *(n) = "esp32-0123456789AB"
+#define esp_netif_get_ip_info(i,d)              true
+#define esp_netif_dhcpc_get_status(a, b)        ESP_NETIF_DHCP_STARTED
+#define esp_netif_get_ip6_linklocal(i,d)        (ESP_OK)
+#define esp_netif_get_hostname(i, n)            *(n) = "esp32-0123456789AB"
+#define esp_netif_get_handle_from_ifkey(k)      NULL
 
 #define IP4_ADDR(ipaddr, a,b,c,d) \
         (ipaddr)->addr = ((uint32_t)((d) & 0xff) << 24) | \
@@ -158,25 +171,27 @@ typedef enum {
 
 /* status of DHCP client or DHCP server */
 typedef enum {
-    TCPIP_ADAPTER_DHCP_INIT = 0,    /**< DHCP client/server in initial state */
-    TCPIP_ADAPTER_DHCP_STARTED,     /**< DHCP client/server already been started */
-    TCPIP_ADAPTER_DHCP_STOPPED,     /**< DHCP client/server already been stopped */
-    TCPIP_ADAPTER_DHCP_STATUS_MAX
-} tcpip_adapter_dhcp_status_t;
+    ESP_NETIF_DHCP_INIT = 0,    /**< DHCP client/server in initial state */
+    ESP_NETIF_DHCP_STARTED,     /**< DHCP client/server already been started */
+    ESP_NETIF_DHCP_STOPPED,     /**< DHCP client/server already been stopped */
+    ESP_NETIF_DHCP_STATUS_MAX
+} esp_netif_dhcp_status_t;
 
 struct udp_pcb {
     uint8_t dummy;
 };
 
-struct ip4_addr {
+struct esp_ip4_addr {
   uint32_t addr;
 };
-typedef struct ip4_addr ip4_addr_t;
+typedef struct esp_ip4_addr esp_ip4_addr_t;
+typedef struct esp_ip4_addr ip4_addr_t;
 
-struct ip6_addr {
+struct esp_ip6_addr {
   uint32_t addr[4];
 };
-typedef struct ip6_addr ip6_addr_t;
+typedef struct esp_ip6_addr esp_ip6_addr_t;
+typedef struct esp_ip6_addr ip6_addr_t;
 
 typedef struct _ip_addr {
   union {
@@ -185,27 +200,24 @@ typedef struct _ip_addr {
   } u_addr;
   uint8_t type;
 } ip_addr_t;
+typedef struct _ip_addr esp_ip_addr_t;
 
 typedef struct {
-    ip4_addr_t ip;
-    ip4_addr_t netmask;
-    ip4_addr_t gw;
-} tcpip_adapter_ip_info_t;
+    esp_ip4_addr_t ip;
+    esp_ip4_addr_t netmask;
+    esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
 
-typedef enum {
-    TCPIP_ADAPTER_IF_STA = 0,     /**< ESP32 station interface */
-    TCPIP_ADAPTER_IF_AP,          /**< ESP32 soft-AP interface */
-    TCPIP_ADAPTER_IF_ETH,         /**< ESP32 ethernet interface */
-    TCPIP_ADAPTER_IF_MAX
-} tcpip_adapter_if_t;
+typedef struct esp_netif_obj esp_netif_t;
 
 typedef struct {
-    ip6_addr_t ip;
-} tcpip_adapter_ip6_info_t;
+    esp_ip6_addr_t ip;
+} esp_netif_ip6_info_t;
 
 typedef struct {
-    tcpip_adapter_if_t if_index;        /*!< Interface for which the event is received */
-    tcpip_adapter_ip6_info_t ip6_info;  /*!< IPv6 address of the interface */
+    int if_index;                       /*!< Interface index for which the event is received */
+    esp_netif_t *esp_netif;             /*!< Pointer to corresponding esp-netif object */
+    esp_netif_ip6_info_t ip6_info;      /*!< IPv6 address of the interface */
 } ip_event_got_ip6_t;
 
 typedef void* system_event_t;
@@ -47,12 +47,15 @@ esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args,
     return ESP_OK;
 }
 
+// Added to the tick count, so that tests can let time pass
+uint32_t  g_tick_offset_ms = 0;
+
 uint32_t xTaskGetTickCount(void)
 {
     struct timeval tv;
     struct timezone tz;
     if (gettimeofday(&tv, &tz) == 0) {
-        return (tv.tv_sec * 1000) + (tv.tv_usec / 1000);
+        return (tv.tv_sec * 1000) + (tv.tv_usec / 1000) + g_tick_offset_ms;
     }
     return 0;
 }
@@ -99,3 +102,30 @@ void ForceTaskDelete(void)
 {
     g_queue_send_shall_fail = 1;
 }
+
+/// Allocation counters (mdns.c is built with its allocations redirected here)
+extern size_t g_mdns_allocs;
+
+void * mdns_test_malloc(size_t size)
+{
+    g_mdns_allocs++;
+    return malloc(size);
+}
+
+void * mdns_test_calloc(size_t nmemb, size_t size)
+{
+    g_mdns_allocs++;
+    return calloc(nmemb, size);
+}
+
+char * mdns_test_strdup(const char * s)
+{
+    g_mdns_allocs++;
+    return strdup(s);
+}
+
+char * mdns_test_strndup(const char * s, size_t n)
+{
+    g_mdns_allocs++;
+    return strndup(s, n);
+}
@@ -50,4 +50,20 @@ mdns_search_once_t * mdns_test_search_init(const char * name, const char * servi
 mdns_srv_item_t * mdns_test_mdns_get_service_item(const char * service, const char * proto)
 {
     return mdns_test_static_mdns_get_service_item(service, proto);
-}
\ No newline at end of file
+}
+
+//
+// Count heap allocations of mdns.c, reported by the benchmark mode of the test
+size_t g_mdns_allocs;
+
+void * mdns_test_malloc(size_t size);
+void * mdns_test_calloc(size_t nmemb, size_t size);
+char * mdns_test_strdup(const char * s);
+char * mdns_test_strndup(const char * s, size_t n);
+
+#undef strdup
+#undef strndup
+#define malloc(size)        mdns_test_malloc(size)
+#define calloc(nmemb, size) mdns_test_calloc(nmemb, size)
+#define strdup(s)           mdns_test_strdup(s)
+#define strndup(s, n)       mdns_test_strndup(s, n)
@@ -17,6 +17,7 @@
 #include <unistd.h>
 #include <signal.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "mdns.h"
 #include "mdns_private.h"
@@ -108,6 +109,212 @@ static void mdns_test_query_free(void)
 //
 void mdns_parse_packet(mdns_rx_packet_t * packet);
 
+#ifdef INSTR_IS_OFF
+extern mdns_server_t * _mdns_server;
+extern size_t g_mdns_allocs;
+
+//
+// Pass the packet through the service task actions, as if it was received and answered on a running interface
+static void mdns_test_handle_packet(uint8_t * data, size_t len)
+{
+    mdns_action_t * a = (mdns_action_t *)malloc(sizeof(mdns_action_t));
+    mdns_rx_packet_t * packet = (mdns_rx_packet_t *)calloc(1, sizeof(mdns_rx_packet_t));
+    struct pbuf * pb = (struct pbuf *)calloc(1, sizeof(struct pbuf));
+    if (!a || !packet || !pb) {
+        abort();
+    }
+    pb->payload = data;
+    pb->len = len;
+    packet->pb = pb;
+    packet->src_port = MDNS_SERVICE_PORT;
+    packet->multicast = 1;
+    a->type = ACTION_RX_HANDLE;
+    a->data.rx_handle.packet = packet;
+    mdns_test_execute_action(a);
+
+    // transmit whatever the scheduler would have sent
+    while (_mdns_server->tx_queue_head) {
+        a = (mdns_action_t *)malloc(sizeof(mdns_action_t));
+        if (!a) {
+            abort();
+        }
+        a->type = ACTION_TX_HANDLE;
+        a->data.tx_handle.packet = _mdns_server->tx_queue_head;
+        _mdns_server->tx_queue_head->queued = true;
+        mdns_test_execute_action(a);
+    }
+}
+
+//
+// Benchmark mode: parse and answer the given packets repeatedly, report allocations and packets per second
+static int mdns_test_bench(int rounds, int count, char ** files)
+{
+    static uint8_t bufs[64][1460];
+    size_t lens[64];
+    int i, r;
+    struct timeval start, end;
+
+    if (count > 64) {
+        count = 64;
+    }
+    for (i=0; i<count; i++) {
+        FILE * file = fopen(files[i], "r");
+        if (!file) {
+            printf("Cannot open %s\n", files[i]);
+            return 1;
+        }
+        lens[i] = fread(bufs[i], 1, 1460, file);
+        fclose(file);
+    }
+    _mdns_server->interfaces[MDNS_IF_STA].pcbs[MDNS_IP_PROTOCOL_V4].state = PCB_RUNNING;
+    mdns_test_query("_afpovertcp", "_tcp");
+
+    g_mdns_allocs = 0;
+    gettimeofday(&start, NULL);
+    for (r=0; r<rounds; r++) {
+        for (i=0; i<count; i++) {
+            mdns_test_handle_packet(bufs[i], lens[i]);
+        }
+    }
+    gettimeofday(&end, NULL);
+
+    double secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+    size_t packets = (size_t)rounds * count;
+    printf("packets: %zu, allocations: %zu (%.2f per packet), %.0f packets/s\n",
+           packets, g_mdns_allocs, (double)g_mdns_allocs / packets, packets / secs);
+    _mdns_server->interfaces[MDNS_IF_STA].pcbs[MDNS_IP_PROTOCOL_V4].state = PCB_OFF;
+    return 0;
+}
+
+//
+// Cache mode: pass crafted responses of other hosts through the parser and check the record cache
+extern uint32_t g_tick_offset_ms;
+
+#define CACHE_CHECK(cond) do { if (!(cond)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static void mdns_test_put_u16(uint8_t * p, uint16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value;
+}
+
+static size_t mdns_test_put_name(uint8_t * p, const char * name)
+{
+    size_t len = 0;
+    while (*name) {
+        const char * dot = strchr(name, '.');
+        size_t label = dot ? (size_t)(dot - name) : strlen(name);
+        p[len++] = label;
+        memcpy(p + len, name, label);
+        len += label;
+        name += label + (dot ? 1 : 0);
+    }
+    p[len++] = 0;
+    return len;
+}
+
+//
+// Receive an authoritative response with a single A record
+static void mdns_test_receive_a(const char * name, uint8_t last_octet, uint32_t ttl, bool flush)
+{
+    uint8_t * buf = (uint8_t *)calloc(1, 128);
+    if (!buf) {
+        abort();
+    }
+    size_t len = MDNS_HEAD_LEN;
+    mdns_test_put_u16(buf + MDNS_HEAD_FLAGS_OFFSET, MDNS_FLAGS_AUTHORITATIVE);
+    mdns_test_put_u16(buf + MDNS_HEAD_ANSWERS_OFFSET, 1);
+    len += mdns_test_put_name(buf + len, name);
+    mdns_test_put_u16(buf + len + MDNS_TYPE_OFFSET, MDNS_TYPE_A);
+    mdns_test_put_u16(buf + len + MDNS_CLASS_OFFSET, flush ? MDNS_CLASS_IN_FLUSH_CACHE : MDNS_CLASS_IN);
+    mdns_test_put_u16(buf + len + MDNS_TTL_OFFSET, ttl >> 16);
+    mdns_test_put_u16(buf + len + MDNS_TTL_OFFSET + 2, ttl);
+    mdns_test_put_u16(buf + len + MDNS_LEN_OFFSET, 4);
+    len += MDNS_DATA_OFFSET;
+    uint8_t addr[4] = { 192, 168, 0, last_octet };
+    memcpy(buf + len, addr, 4);
+    len += 4;
+    mdns_test_handle_packet(buf, len);
+    free(buf);
+}
+
+//
+// Count cached A records of the host, and return the last octet of one of them
+static int mdns_test_cached_a(const char * host, uint8_t * last_octet)
+{
+    int count = 0;
+    for (mdns_cached_record_t * r = _mdns_server->cache; r; r = r->next) {
+        if (r->type == MDNS_TYPE_A && !strcmp(r->host, host)) {
+            if (last_octet) {
+                *last_octet = ((uint8_t *)&r->addr.u_addr.ip4.addr)[3];
+            }
+            count++;
+        }
+    }
+    return count;
+}
+
+static int mdns_test_cache(void)
+{
+    int failures = 0;
+    uint8_t octet = 0;
+
+    _mdns_server->interfaces[MDNS_IF_STA].pcbs[MDNS_IP_PROTOCOL_V4].state = PCB_RUNNING;
+
+    // insert, refresh and add a second address of a host
+    mdns_test_receive_a("peer.local", 1, 120, false);
+    CACHE_CHECK(_mdns_server->cache_len == 1);
+    CACHE_CHECK(mdns_test_cached_a("peer", &octet) == 1 && octet == 1);
+    mdns_test_receive_a("peer.local", 1, 120, false);
+    CACHE_CHECK(_mdns_server->cache_len == 1);
+    mdns_test_receive_a("peer.local", 2, 120, false);
+    CACHE_CHECK(mdns_test_cached_a("peer", NULL) == 2);
+    mdns_test_receive_a("other.local", 9, 120, false);
+    CACHE_CHECK(_mdns_server->cache_len == 3);
+
+    // a cache-flush record keeps the records received within the last second
+    mdns_test_receive_a("peer.local", 3, 120, true);
+    CACHE_CHECK(mdns_test_cached_a("peer", NULL) == 3);
+
+    // and replaces the older ones of its name and type only
+    g_tick_offset_ms += 2000;
+    mdns_test_receive_a("peer.local", 4, 120, true);
+    CACHE_CHECK(mdns_test_cached_a("peer", &octet) == 1 && octet == 4);
+    CACHE_CHECK(mdns_test_cached_a("other", NULL) == 1);
+
+    // a repeated cache-flush record refreshes the cached copy
+    g_tick_offset_ms += 2000;
+    mdns_test_receive_a("peer.local", 4, 120, true);
+    CACHE_CHECK(mdns_test_cached_a("peer", &octet) == 1 && octet == 4);
+
+    // goodbye removes the record
+    mdns_test_receive_a("other.local", 9, 0, false);
+    CACHE_CHECK(mdns_test_cached_a("other", NULL) == 0);
+
+    // expired records are dropped when a new record is added
+    mdns_test_receive_a("short.local", 5, 1, false);
+    CACHE_CHECK(mdns_test_cached_a("short", NULL) == 1);
+    g_tick_offset_ms += 1500;
+    mdns_test_receive_a("other.local", 9, 120, false);
+    CACHE_CHECK(mdns_test_cached_a("short", NULL) == 0);
+    CACHE_CHECK(_mdns_server->cache_len == 2);
+
+    // when full, the record closest to expiring is dropped
+    char name[16];
+    for (int i = 0; i < MDNS_CACHE_SIZE; i++) {
+        sprintf(name, "host%d.local", i);
+        mdns_test_receive_a(name, i, 600 + i, false);
+    }
+    CACHE_CHECK(_mdns_server->cache_len == MDNS_CACHE_SIZE);
+    CACHE_CHECK(mdns_test_cached_a("host0", NULL) == 1);
+    CACHE_CHECK(mdns_test_cached_a("peer", NULL) == 0 && mdns_test_cached_a("other", NULL) == 0);
+
+    _mdns_server->interfaces[MDNS_IF_STA].pcbs[MDNS_IP_PROTOCOL_V4].state = PCB_OFF;
+    printf("cache: %s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
+#endif
+
 //
 // Test starts here
 //
@@ -194,9 +401,25 @@ int main(int argc, char** argv)
     size_t len = 1460;
     memset(buf, 0, 1460);
 
-    if (argc != 2)
+    if (argc > 3 && strcmp(argv[1], "-b") == 0)
+    {
+        int ret = mdns_test_bench(atoi(argv[2]), argc - 3, argv + 3);
+        ForceTaskDelete();
+        mdns_free();
+        return ret;
+    }
+    else if (argc == 2 && strcmp(argv[1], "-c") == 0)
+    {
+        int ret = mdns_test_cache();
+        ForceTaskDelete();
+        mdns_free();
+        return ret;
+    }
+    else if (argc != 2)
     {
         printf("Non-instrumentation mode: please supply a file name created by AFL to reproduce crash\n");
+        printf("                          or -b <rounds> <files> to benchmark the parser\n");
+        printf("                          or -c to test the record cache\n");
         return 1;
     }
     else
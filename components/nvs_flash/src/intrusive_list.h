@@ -14,6 +14,7 @@
 #ifndef intrusive_list_h
 #define intrusive_list_h
 
+#include <cstddef>
 #include <cassert>
 #include <unordered_map>
 
@@ -24,15 +24,14 @@
 #include "nvs_encr.hpp"
 #endif
 
-#ifdef ESP_PLATFORM
-#include <esp32/rom/crc.h>
+#include "esp_crc.h"
 
+#ifdef ESP_PLATFORM
 // Uncomment this line to force output from this module
 // #define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
 #include "esp_log.h"
 static const char* TAG = "nvs";
 #else
-#include "crc.h"
 #define ESP_LOGD(...)
 #endif
 
@@ -555,8 +554,8 @@ extern "C" esp_err_t nvs_flash_generate_keys(const esp_partition_t* partition, n
         return err;
     }
 
-    uint32_t crc_calc = crc32_le(0xffffffff, cfg->eky, NVS_KEY_SIZE);
-    crc_calc = crc32_le(crc_calc, cfg->tky, NVS_KEY_SIZE);
+    uint32_t crc_calc = esp_crc32_le(0xffffffff, cfg->eky, NVS_KEY_SIZE);
+    crc_calc = esp_crc32_le(crc_calc, cfg->tky, NVS_KEY_SIZE);
 
     uint8_t crc_wr[16];
     memset(crc_wr, 0xff, sizeof(crc_wr));
@@ -624,8 +623,8 @@ extern "C" esp_err_t nvs_flash_read_security_cfg(const esp_partition_t* partitio
         return err;
     }
 
-    crc_calc = crc32_le(0xffffffff, cfg->eky, NVS_KEY_SIZE);
-    crc_calc = crc32_le(crc_calc, cfg->tky, NVS_KEY_SIZE);
+    crc_calc = esp_crc32_le(0xffffffff, cfg->eky, NVS_KEY_SIZE);
+    crc_calc = esp_crc32_le(crc_calc, cfg->tky, NVS_KEY_SIZE);
 
     if(crc_calc != crc_read) {
         if(!check_if_initialized(cfg->eky, cfg->tky, crc_read)) {
@@ -12,11 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include "nvs_page.hpp"
-#if defined(ESP_PLATFORM)
-#include <esp32/rom/crc.h>
-#else
-#include "crc.h"
-#endif
+#include "esp_crc.h"
 #include <cstdio>
 #include <cstring>
 
@@ -27,9 +23,9 @@ namespace nvs
 
 uint32_t Page::Header::calculateCrc32()
 {
-    return crc32_le(0xffffffff,
-                    reinterpret_cast<uint8_t*>(this) + offsetof(Header, mSeqNumber),
-                    offsetof(Header, mCrc32) - offsetof(Header, mSeqNumber));
+    return esp_crc32_le(0xffffffff,
+                        reinterpret_cast<uint8_t*>(this) + offsetof(Header, mSeqNumber),
+                        offsetof(Header, mCrc32) - offsetof(Header, mSeqNumber));
 }
 
 esp_err_t Page::load(uint32_t sectorNumber)
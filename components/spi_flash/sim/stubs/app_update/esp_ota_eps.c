@@ -11,3 +11,51 @@ const esp_partition_t* esp_ota_get_running_partition(void)
 
     return partition;
 }
+
+// Minimal OTA writer: writes the image sequentially, no validation beyond the magic byte
+static const esp_partition_t* s_ota_partition;
+static size_t s_ota_wrote_size;
+
+esp_err_t esp_ota_begin(const esp_partition_t* partition, size_t image_size, esp_ota_handle_t* out_handle)
+{
+    if (partition == NULL || out_handle == NULL || s_ota_partition != NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (partition == esp_ota_get_running_partition()) {
+        return ESP_ERR_OTA_PARTITION_CONFLICT;
+    }
+    size_t erase_size = (image_size == 0 || image_size == OTA_SIZE_UNKNOWN) ? partition->size :
+                        (image_size + SPI_FLASH_SEC_SIZE - 1) & ~(SPI_FLASH_SEC_SIZE - 1);
+    esp_err_t err = esp_partition_erase_range(partition, 0, erase_size);
+    if (err != ESP_OK) {
+        return err;
+    }
+    s_ota_partition = partition;
+    s_ota_wrote_size = 0;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void* data, size_t size)
+{
+    if (handle != 1 || s_ota_partition == NULL || data == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_ota_wrote_size == 0 && size > 0 && *(const uint8_t*)data != ESP_IMAGE_HEADER_MAGIC) {
+        return ESP_ERR_OTA_VALIDATE_FAILED;
+    }
+    esp_err_t err = esp_partition_write(s_ota_partition, s_ota_wrote_size, data, size);
+    if (err == ESP_OK) {
+        s_ota_wrote_size += size;
+    }
+    return err;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    if (handle != 1 || s_ota_partition == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_ota_partition = NULL;
+    return s_ota_wrote_size > 0 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
@@ -32,6 +32,7 @@ typedef int (*trans_func)(esp_transport_handle_t t);
 typedef int (*poll_func)(esp_transport_handle_t t, int timeout_ms);
 typedef int (*connect_async_func)(esp_transport_handle_t t, const char *host, int port, int timeout_ms);
 typedef esp_transport_handle_t (*payload_transfer_func)(esp_transport_handle_t);
+typedef int (*get_socket_func)(esp_transport_handle_t t);
 
 typedef struct esp_tls_last_error* esp_tls_error_handle_t;
 
@@ -66,6 +67,21 @@ esp_err_t esp_transport_list_destroy(esp_transport_list_handle_t list);
  */
 esp_err_t esp_transport_list_add(esp_transport_list_handle_t list, esp_transport_handle_t t, const char *scheme);
 
+/**
+ * @brief      Remove a transport from the list without destroying it.
+ *             The caller becomes the owner of the transport and must free it with `esp_transport_destroy`.
+ *             The transport no longer reports errors to the error tracker of the list.
+ *
+ * @param[in]  list  The list
+ * @param[in]  t     The Transport
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_ERR_INVALID_ARG
+ *     - ESP_ERR_NOT_FOUND if the transport is not in the list
+ */
+esp_err_t esp_transport_list_remove(esp_transport_list_handle_t list, esp_transport_handle_t t);
+
 /**
  * @brief      This function will remove all transport from the list,
  *             invoke esp_transport_destroy of every transport have added this the list
@@ -300,6 +316,30 @@ esp_err_t esp_transport_set_async_connect_func(esp_transport_handle_t t, connect
  */
 esp_err_t esp_transport_set_parent_transport_func(esp_transport_handle_t t, payload_transfer_func _parent_transport);
 
+/**
+ * @brief      Set the function returning the socket descriptor of the transport
+ *
+ * @param[in]  t                    The transport handle
+ * @param[in]  _get_socket          The socket getter pointer
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t esp_transport_set_get_socket_func(esp_transport_handle_t t, get_socket_func _get_socket);
+
+/**
+ * @brief      Get the socket descriptor of a connected transport,
+ *             e.g. to wait for several transports at once with select()
+ *
+ * @param[in]  t        The transport handle
+ *
+ * @return
+ *     - socket descriptor
+ *     - (-1) if the transport is not connected or does not provide its socket
+ */
+int esp_transport_get_socket(esp_transport_handle_t t);
+
 /**
  * @brief      Returns esp_tls error handle.
  *             Warning: The returned pointer is valid only as long as esp_transport_handle_t exists. Once transport
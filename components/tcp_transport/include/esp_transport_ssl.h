@@ -146,6 +146,28 @@ void esp_transport_ssl_skip_common_name_check(esp_transport_handle_t t);
  */
 void esp_transport_ssl_set_psk_key_hint(esp_transport_handle_t t, const psk_hint_key_t* psk_hint_key);
 
+/**
+ * @brief      Set the TLS session which the next connection tries to resume.
+ *             Note that, this function stores the pointer to the session, rather than making a copy.
+ *             So the session must remain valid until the connection is established
+ *
+ * @param      t        ssl transport
+ * @param[in]  session  The session from `esp_transport_ssl_get_client_session` of an earlier connection
+ *                      to the same server, NULL for a full handshake
+ */
+void esp_transport_ssl_set_client_session(esp_transport_handle_t t, esp_tls_client_session_t *session);
+
+/**
+ * @brief      Get a copy of the TLS session of the connection, to resume it on a later connection
+ *
+ * @param      t     ssl transport
+ *
+ * @return
+ *     - The session, to be freed with `esp_tls_free_client_session`
+ *     - NULL if the transport is not connected or the TLS stack does not support it
+ */
+esp_tls_client_session_t *esp_transport_ssl_get_client_session(esp_transport_handle_t t);
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,7 @@ struct esp_transport_item_t {
     trans_func      _destroy;       /*!< Destroy and free transport */
     connect_async_func _connect_async;      /*!< non-blocking connect function of this transport */
     payload_transfer_func  _parent_transfer;        /*!< Function returning underlying transport layer */
+    get_socket_func _get_socket;                    /*!< Function returning the socket descriptor of this transport */
     esp_tls_error_handle_t     error_handle;            /*!< Pointer to esp-tls error handle */
 
     STAILQ_ENTRY(esp_transport_item_t) next;
@@ -93,6 +94,23 @@ esp_err_t esp_transport_list_add(esp_transport_list_handle_t h, esp_transport_ha
     return ESP_OK;
 }
 
+esp_err_t esp_transport_list_remove(esp_transport_list_handle_t h, esp_transport_handle_t t)
+{
+    if (h == NULL || t == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_transport_handle_t item;
+    STAILQ_FOREACH(item, &h->list, next) {
+        if (item == t) {
+            STAILQ_REMOVE(&h->list, t, esp_transport_item_t, next);
+            // The error tracker belongs to the list, the detached transport must not refer to it anymore
+            t->error_handle = NULL;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
 esp_transport_handle_t esp_transport_list_get_transport(esp_transport_list_handle_t h, const char *scheme)
 {
     if (!h) {
@@ -254,6 +272,7 @@ esp_err_t esp_transport_set_func(esp_transport_handle_t t,
     t->_destroy = _destroy;
     t->_connect_async = NULL;
     t->_parent_transfer = esp_transport_get_default_parent;
+    t->_get_socket = NULL;
     return ESP_OK;
 }
 
@@ -292,6 +311,23 @@ esp_err_t esp_transport_set_parent_transport_func(esp_transport_handle_t t, payl
     return ESP_OK;
 }
 
+esp_err_t esp_transport_set_get_socket_func(esp_transport_handle_t t, get_socket_func _get_socket)
+{
+    if (t == NULL) {
+        return ESP_FAIL;
+    }
+    t->_get_socket = _get_socket;
+    return ESP_OK;
+}
+
+int esp_transport_get_socket(esp_transport_handle_t t)
+{
+    if (t && t->_get_socket) {
+        return t->_get_socket(t);
+    }
+    return -1;
+}
+
 esp_tls_error_handle_t esp_transport_get_error_handle(esp_transport_handle_t t)
 {
     if (t) {
@@ -302,7 +338,7 @@ esp_tls_error_handle_t esp_transport_get_error_handle(esp_transport_handle_t t)
 
 void esp_transport_set_errors(esp_transport_handle_t t, const esp_tls_error_handle_t error_handle)
 {
-    if (t)  {
+    if (t && t->error_handle)  {
         memcpy(t->error_handle, error_handle, sizeof(esp_tls_last_error_t));
     }
 }
\ No newline at end of file
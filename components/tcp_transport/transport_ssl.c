@@ -176,6 +176,15 @@ static int ssl_close(esp_transport_handle_t t)
     return ret;
 }
 
+static int ssl_get_socket(esp_transport_handle_t t)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    if (ssl->ssl_initialized && ssl->tls) {
+        return ssl->tls->sockfd;
+    }
+    return -1;
+}
+
 static int ssl_destroy(esp_transport_handle_t t)
 {
     transport_ssl_t *ssl = esp_transport_get_context_data(t);
@@ -279,6 +288,23 @@ void esp_transport_ssl_skip_common_name_check(esp_transport_handle_t t)
     }
 }
 
+void esp_transport_ssl_set_client_session(esp_transport_handle_t t, esp_tls_client_session_t *session)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    if (t && ssl) {
+        ssl->cfg.client_session = session;
+    }
+}
+
+esp_tls_client_session_t *esp_transport_ssl_get_client_session(esp_transport_handle_t t)
+{
+    transport_ssl_t *ssl = esp_transport_get_context_data(t);
+    if (t && ssl && ssl->ssl_initialized && ssl->tls) {
+        return esp_tls_get_client_session(ssl->tls);
+    }
+    return NULL;
+}
+
 esp_transport_handle_t esp_transport_ssl_init(void)
 {
     esp_transport_handle_t t = esp_transport_init();
@@ -287,6 +313,7 @@ esp_transport_handle_t esp_transport_ssl_init(void)
     esp_transport_set_context_data(t, ssl);
     esp_transport_set_func(t, ssl_connect, ssl_read, ssl_write, ssl_close, ssl_poll_read, ssl_poll_write, ssl_destroy);
     esp_transport_set_async_connect_func(t, ssl_connect_async);
+    esp_transport_set_get_socket_func(t, ssl_get_socket);
     return t;
 }
 
@@ -170,6 +170,12 @@ static int tcp_close(esp_transport_handle_t t)
     return ret;
 }
 
+static int tcp_get_socket(esp_transport_handle_t t)
+{
+    transport_tcp_t *tcp = esp_transport_get_context_data(t);
+    return tcp->sock;
+}
+
 static esp_err_t tcp_destroy(esp_transport_handle_t t)
 {
     transport_tcp_t *tcp = esp_transport_get_context_data(t);
@@ -186,6 +192,7 @@ esp_transport_handle_t esp_transport_tcp_init(void)
     tcp->sock = -1;
     esp_transport_set_func(t, tcp_connect, tcp_read, tcp_write, tcp_close, tcp_poll_read, tcp_poll_write, tcp_destroy);
     esp_transport_set_context_data(t, tcp);
+    esp_transport_set_get_socket_func(t, tcp_get_socket);
 
     return t;
 }
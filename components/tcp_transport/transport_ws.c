@@ -62,6 +62,12 @@ static esp_transport_handle_t ws_get_payload_transport_handle(esp_transport_hand
     return ws->parent;
 }
 
+static int ws_get_socket(esp_transport_handle_t t)
+{
+    transport_ws_t *ws = esp_transport_get_context_data(t);
+    return esp_transport_get_socket(ws->parent);
+}
+
 static char *trimwhitespace(const char *str)
 {
     char *end;
@@ -471,6 +477,7 @@ esp_transport_handle_t esp_transport_ws_init(esp_transport_handle_t parent_handl
     esp_transport_set_func(t, ws_connect, ws_read, ws_write, ws_close, ws_poll_read, ws_poll_write, ws_destroy);
     // webocket underlying transfer is the payload transfer handle
     esp_transport_set_parent_transport_func(t, ws_get_payload_transport_handle);
+    esp_transport_set_get_socket_func(t, ws_get_socket);
 
     esp_transport_set_context_data(t, ws);
     return t;
@@ -4,6 +4,7 @@
 #define CONFIG_LOG_DEFAULT_LEVEL 3
 #define CONFIG_PARTITION_TABLE_OFFSET 0x8000
 #define CONFIG_ESPTOOLPY_FLASHSIZE "8MB"
+#define CONFIG_ESP_CRC_SLICE_BY_8 1
 //currently use the legacy implementation, since the stubs for new HAL are not done yet
 #define CONFIG_SPI_FLASH_USE_LEGACY_IMPL 1
 
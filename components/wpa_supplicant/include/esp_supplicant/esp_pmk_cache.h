@@ -0,0 +1,41 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __ESP_PMK_CACHE_H__
+#define __ESP_PMK_CACHE_H__
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+  * @brief     Remove all station PMKs cached in NVS
+  *
+  * With CONFIG_WPA_PMK_CACHE the station stores the PMKs it derives from
+  * WPA-PSK passphrases in the "wpa_pmk" NVS namespace. esp_wifi_restore()
+  * removes them as well.
+  *
+  * @return
+  *          - ESP_OK : succeed, or the cache is disabled
+  *          - others : failed to open or erase the NVS namespace
+  */
+esp_err_t esp_pmk_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ESP_PMK_CACHE_H__ */
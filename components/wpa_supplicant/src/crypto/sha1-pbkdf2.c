@@ -15,78 +15,83 @@
 #include "utils/includes.h"
 #include "utils/common.h"
 #include "sha1.h"
+#include "sha1_i.h"
 #include "md5.h"
 #include "crypto.h"
 
-#ifdef USE_MBEDTLS_CRYPTO
-#include "mbedtls/pkcs5.h"
-
-/**
- * pbkdf2_sha1 - SHA1-based key derivation function (PBKDF2) for IEEE 802.11i
- * @passphrase: ASCII passphrase
- * @ssid: SSID
- * @ssid_len: SSID length in bytes
- * @iterations: Number of iterations to run
- * @buf: Buffer for the generated key
- * @buflen: Length of the buffer in bytes
- * Returns: 0 on success, -1 of failure
- *
- * This function is used to derive PSK for WPA-PSK. For this protocol,
- * iterations is set to 4096 and buflen to 32. This function is described in
- * IEEE Std 802.11-2004, Clause H.4. The main construction is from PKCS#5 v2.0.
+/*
+ * The PRF of PBKDF2 is HMAC-SHA1 keyed with the passphrase. The SHA1 states
+ * after the key XOR ipad and key XOR opad blocks are the same for every HMAC
+ * invocation, so they are computed once per derivation. Every U2..Uc
+ * iteration then only hashes a 20 byte message on top of each state, which
+ * fits a single pre-padded block, i.e. two SHA1 transforms per iteration.
  */
-int
-pbkdf2_sha1(const char *passphrase, const char *ssid, size_t ssid_len,
-		int iterations, u8 *buf, size_t buflen)
-{
+struct pbkdf2_sha1_key {
+	u32 istate[5];
+	u32 ostate[5];
+};
 
-    mbedtls_md_context_t sha1_ctx;
-    const mbedtls_md_info_t *info_sha1;
-    int ret;
+/* Length in bits of a 20 byte message hashed after one 64 byte key block */
+#define PBKDF2_SHA1_HMAC_BITS ((64 + SHA1_MAC_LEN) * 8)
 
-    mbedtls_md_init( &sha1_ctx );
-
-    info_sha1 = mbedtls_md_info_from_type( MBEDTLS_MD_SHA1 );
-    if (info_sha1 == NULL) {
-        ret = -1;
-        goto exit;
-    }
-
-    if ((ret = mbedtls_md_setup( &sha1_ctx, info_sha1, 1 ) ) != 0) {
-        ret = -1;
-        goto exit;
-    }
+static int
+pbkdf2_sha1_key_init(const char *passphrase, struct pbkdf2_sha1_key *key)
+{
+	unsigned char k_pad[64];
+	unsigned char tk[SHA1_MAC_LEN];
+	const u8 *k = (const u8 *) passphrase;
+	size_t k_len = os_strlen(passphrase);
+	struct SHA1Context ctx;
+	size_t i;
+
+	/* if key is longer than 64 bytes reset it to key = SHA1(key) */
+	if (k_len > 64) {
+		if (sha1_vector(1, &k, &k_len, tk))
+			return -1;
+		k = tk;
+		k_len = SHA1_MAC_LEN;
+	}
 
-    ret = mbedtls_pkcs5_pbkdf2_hmac( &sha1_ctx, (const unsigned char*) passphrase, os_strlen(passphrase) , (const unsigned char*) ssid,
-            ssid_len, iterations, 32, buf );
-    if (ret != 0) {
-        ret = -1;
-        goto exit;
-    }
+	os_memset(k_pad, 0, sizeof(k_pad));
+	os_memcpy(k_pad, k, k_len);
+	for (i = 0; i < 64; i++)
+		k_pad[i] ^= 0x36;
+	SHA1Init(&ctx);
+	SHA1Transform(ctx.state, k_pad);
+	os_memcpy(key->istate, ctx.state, sizeof(key->istate));
+
+	/* k_pad now holds key XOR ipad, 0x36 ^ 0x5c turns it into key XOR opad */
+	for (i = 0; i < 64; i++)
+		k_pad[i] ^= 0x36 ^ 0x5c;
+	SHA1Init(&ctx);
+	SHA1Transform(ctx.state, k_pad);
+	os_memcpy(key->ostate, ctx.state, sizeof(key->ostate));
+
+	os_memset(k_pad, 0, sizeof(k_pad));
+	os_memset(tk, 0, sizeof(tk));
+	os_memset(&ctx, 0, sizeof(ctx));
+	return 0;
+}
 
-exit:
-    mbedtls_md_free( &sha1_ctx );
+static void
+pbkdf2_sha1_put_state(u8 *out, const u32 state[5])
+{
+	int i;
 
-    return ret;
+	for (i = 0; i < 5; i++)
+		WPA_PUT_BE32(out + 4 * i, state[i]);
 }
-#else
 
 static int 
-pbkdf2_sha1_f(const char *passphrase, const char *ssid,
+pbkdf2_sha1_f(const struct pbkdf2_sha1_key *key, const char *ssid,
         size_t ssid_len, int iterations, unsigned int count,
         u8 *digest)
 {
-	unsigned char tmp[SHA1_MAC_LEN], tmp2[SHA1_MAC_LEN];
-	int i, j;
+	unsigned char block[64];
 	unsigned char count_buf[4];
-	const u8 *addr[2];
-	size_t len[2];
-	size_t passphrase_len = os_strlen(passphrase);
-
-	addr[0] = (u8 *) ssid;
-	len[0] = ssid_len;
-	addr[1] = count_buf;
-	len[1] = 4;
+	struct SHA1Context ctx;
+	u32 state[5];
+	int i, j;
 
 	/* F(P, S, c, i) = U1 xor U2 xor ... Uc
 	 * U1 = PRF(P, S || i)
@@ -94,24 +99,45 @@ pbkdf2_sha1_f(const char *passphrase, const char *ssid,
 	 * Uc = PRF(P, Uc-1)
 	 */
 
-	count_buf[0] = (count >> 24) & 0xff;
-	count_buf[1] = (count >> 16) & 0xff;
-	count_buf[2] = (count >> 8) & 0xff;
-	count_buf[3] = count & 0xff;
-	if (hmac_sha1_vector((u8 *) passphrase, passphrase_len, 2, addr, len,
-			     tmp))
-		return -1;
-	os_memcpy(digest, tmp, SHA1_MAC_LEN);
+	WPA_PUT_BE32(count_buf, count);
+
+	/* U1 hashes the variable length salt with the generic update path */
+	os_memcpy(ctx.state, key->istate, sizeof(ctx.state));
+	ctx.count[0] = 64 * 8;
+	ctx.count[1] = 0;
+	SHA1Update(&ctx, ssid, ssid_len);
+	SHA1Update(&ctx, count_buf, sizeof(count_buf));
+	SHA1Final(block, &ctx);
+
+	os_memcpy(ctx.state, key->ostate, sizeof(ctx.state));
+	ctx.count[0] = 64 * 8;
+	ctx.count[1] = 0;
+	SHA1Update(&ctx, block, SHA1_MAC_LEN);
+	SHA1Final(block, &ctx);
+	os_memcpy(digest, block, SHA1_MAC_LEN);
+
+	/* block holds Uk-1 followed by the SHA1 padding for a 20 byte message,
+	 * the inner and the outer hash of the HMAC share the same padding */
+	os_memset(block + SHA1_MAC_LEN, 0, sizeof(block) - SHA1_MAC_LEN);
+	block[SHA1_MAC_LEN] = 0x80;
+	WPA_PUT_BE32(block + 60, PBKDF2_SHA1_HMAC_BITS);
 
 	for (i = 1; i < iterations; i++) {
-		if (hmac_sha1((u8 *) passphrase, passphrase_len, tmp,
-			      SHA1_MAC_LEN, tmp2))
-			return -1;
-		os_memcpy(tmp, tmp2, SHA1_MAC_LEN);
+		os_memcpy(state, key->istate, sizeof(state));
+		SHA1Transform(state, block);
+		pbkdf2_sha1_put_state(block, state);
+
+		os_memcpy(state, key->ostate, sizeof(state));
+		SHA1Transform(state, block);
+		pbkdf2_sha1_put_state(block, state);
+
 		for (j = 0; j < SHA1_MAC_LEN; j++)
-			digest[j] ^= tmp2[j];
+			digest[j] ^= block[j];
 	}
 
+	os_memset(block, 0, sizeof(block));
+	os_memset(state, 0, sizeof(state));
+	os_memset(&ctx, 0, sizeof(ctx));
 	return 0;
 }
 
@@ -138,18 +164,25 @@ pbkdf2_sha1(const char *passphrase, const char *ssid, size_t ssid_len,
 	unsigned char *pos = buf;
 	size_t left = buflen, plen;
 	unsigned char digest[SHA1_MAC_LEN];
+	struct pbkdf2_sha1_key key;
+
+	if (pbkdf2_sha1_key_init(passphrase, &key))
+		return -1;
 
 	while (left > 0) {
 		count++;
-		if (pbkdf2_sha1_f(passphrase, ssid, ssid_len, iterations,
-				  count, digest))
+		if (pbkdf2_sha1_f(&key, ssid, ssid_len, iterations,
+				  count, digest)) {
+			os_memset(&key, 0, sizeof(key));
 			return -1;
+		}
 		plen = left > SHA1_MAC_LEN ? SHA1_MAC_LEN : left;
 		os_memcpy(pos, digest, plen);
 		pos += plen;
 		left -= plen;
 	}
 
+	os_memset(&key, 0, sizeof(key));
+	os_memset(digest, 0, sizeof(digest));
 	return 0;
 }
-#endif
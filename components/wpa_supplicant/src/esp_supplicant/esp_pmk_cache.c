@@ -0,0 +1,160 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "common/defs.h"
+#include "common/wpa_common.h"
+#include "crypto/crypto.h"
+#include "crypto/sha256.h"
+#include "esp_supplicant/esp_pmk_cache_i.h"
+#include "nvs.h"
+
+#ifdef CONFIG_WPA_PMK_CACHE
+
+#define PMK_CACHE_NAMESPACE "wpa_pmk"
+#define PMK_CACHE_SSID_LEN  32
+
+/* A cache entry, stored as one NVS blob per slot */
+struct pmk_cache_entry {
+    u32 generation;                 /* Higher means more recently used */
+    u8 ssid_len;
+    u8 ssid[PMK_CACHE_SSID_LEN];
+    u8 key_hash[SHA256_MAC_LEN];    /* SHA256(SSID || passphrase) */
+    u8 pmk[PMK_LEN];
+};
+
+static void pmk_cache_slot_key(char *key, size_t size, int slot)
+{
+    os_snprintf(key, size, "pmk%d", slot);
+}
+
+esp_err_t esp_pmk_cache_clear(void)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(PMK_CACHE_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_erase_all(handle);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t __real_esp_wifi_restore(void);
+
+/* esp_wifi_restore() is in the WiFi library, the linker wraps it (see CMakeLists.txt and
+   component.mk) so that restoring the default WiFi settings drops the cached PMKs too */
+esp_err_t __wrap_esp_wifi_restore(void)
+{
+    esp_err_t err = __real_esp_wifi_restore();
+
+    if (err == ESP_OK && esp_pmk_cache_clear() != ESP_OK) {
+        wpa_printf(MSG_WARNING, "Failed to clear the PMK cache");
+    }
+    return err;
+}
+
+int esp_pmk_cache_derive(const char *passphrase, const u8 *ssid, size_t ssid_len, u8 *pmk, size_t pmk_len)
+{
+    struct pmk_cache_entry entry;
+    u8 key_hash[SHA256_MAC_LEN];
+    const u8 *addr[2] = { ssid, (const u8 *)passphrase };
+    size_t len[2] = { ssid_len, os_strlen(passphrase) };
+    u32 newest = 0, oldest = UINT32_MAX;
+    int hit = -1, victim = 0, empty = -1;
+    nvs_handle_t handle;
+    char key[8];
+    size_t size;
+    int ret = 0;
+
+    if (ssid_len > PMK_CACHE_SSID_LEN || pmk_len != PMK_LEN ||
+        nvs_open(PMK_CACHE_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return pbkdf2_sha1(passphrase, (const char *)ssid, ssid_len, PMK_CACHE_PSK_ITERATIONS, pmk, pmk_len);
+    }
+
+    if (sha256_vector(2, addr, len, key_hash)) {
+        nvs_close(handle);
+        return -1;
+    }
+
+    for (int slot = 0; slot < CONFIG_WPA_PMK_CACHE_SIZE; slot++) {
+        pmk_cache_slot_key(key, sizeof(key), slot);
+        size = sizeof(entry);
+        if (nvs_get_blob(handle, key, &entry, &size) != ESP_OK || size != sizeof(entry)) {
+            if (empty < 0) {
+                empty = slot;
+            }
+            continue;
+        }
+        if (entry.generation > newest) {
+            newest = entry.generation;
+        }
+        if (hit < 0 && entry.ssid_len == ssid_len && os_memcmp(entry.ssid, ssid, ssid_len) == 0 &&
+            os_memcmp(entry.key_hash, key_hash, sizeof(key_hash)) == 0) {
+            hit = slot;
+            os_memcpy(pmk, entry.pmk, PMK_LEN);
+        } else if (entry.generation < oldest) {
+            oldest = entry.generation;
+            victim = slot;
+        }
+    }
+
+    if (hit >= 0) {
+        /* Only rewrite the entry if another one was used more recently, so that
+           reconnecting to the same network does not write to flash */
+        pmk_cache_slot_key(key, sizeof(key), hit);
+        size = sizeof(entry);
+        if (nvs_get_blob(handle, key, &entry, &size) == ESP_OK && entry.generation != newest) {
+            entry.generation = newest + 1;
+            if (nvs_set_blob(handle, key, &entry, sizeof(entry)) == ESP_OK) {
+                nvs_commit(handle);
+            }
+        }
+        wpa_printf(MSG_DEBUG, "PMK cache hit for SSID '%s'", wpa_ssid_txt(ssid, ssid_len));
+    } else {
+        ret = pbkdf2_sha1(passphrase, (const char *)ssid, ssid_len, PMK_CACHE_PSK_ITERATIONS, pmk, pmk_len);
+        if (ret == 0) {
+            os_memset(&entry, 0, sizeof(entry));
+            entry.generation = newest + 1;
+            entry.ssid_len = ssid_len;
+            os_memcpy(entry.ssid, ssid, ssid_len);
+            os_memcpy(entry.key_hash, key_hash, sizeof(key_hash));
+            os_memcpy(entry.pmk, pmk, PMK_LEN);
+            pmk_cache_slot_key(key, sizeof(key), empty >= 0 ? empty : victim);
+            if (nvs_set_blob(handle, key, &entry, sizeof(entry)) == ESP_OK) {
+                nvs_commit(handle);
+            }
+        }
+    }
+
+    os_memset(&entry, 0, sizeof(entry));
+    os_memset(key_hash, 0, sizeof(key_hash));
+    nvs_close(handle);
+    return ret;
+}
+
+#else /* CONFIG_WPA_PMK_CACHE */
+
+esp_err_t esp_pmk_cache_clear(void)
+{
+    return ESP_OK;
+}
+
+#endif /* CONFIG_WPA_PMK_CACHE */
@@ -0,0 +1,43 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ESP_PMK_CACHE_I_H
+#define ESP_PMK_CACHE_I_H
+
+#include "crypto/sha1.h"
+#include "esp_pmk_cache.h"
+
+#define PMK_CACHE_PSK_ITERATIONS 4096
+
+#ifdef CONFIG_WPA_PMK_CACHE
+
+/**
+ * Derives the WPA-PSK PMK of a passphrase and SSID. A PMK derived before for
+ * the same SSID and passphrase is read from NVS instead of running PBKDF2
+ * again, a newly derived PMK replaces the least recently used cache entry.
+ * Falls back to PBKDF2 alone if NVS is not available.
+ *
+ * Returns 0 on success, -1 on failure.
+ */
+int esp_pmk_cache_derive(const char *passphrase, const u8 *ssid, size_t ssid_len, u8 *pmk, size_t pmk_len);
+
+#else /* CONFIG_WPA_PMK_CACHE */
+
+static inline int esp_pmk_cache_derive(const char *passphrase, const u8 *ssid, size_t ssid_len, u8 *pmk, size_t pmk_len)
+{
+    return pbkdf2_sha1(passphrase, (const char *)ssid, ssid_len, PMK_CACHE_PSK_ITERATIONS, pmk, pmk_len);
+}
+
+#endif /* CONFIG_WPA_PMK_CACHE */
+#endif /* ESP_PMK_CACHE_I_H */
@@ -0,0 +1,90 @@
+// Copyright 2019 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string.h>
+#include "unity.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "utils/includes.h"
+#include "utils/common.h"
+#include "esp_supplicant/esp_pmk_cache_i.h"
+
+#ifdef CONFIG_WPA_PMK_CACHE
+
+static const u8 ieee_psk[32] = {
+    0xf4, 0x2c, 0x6f, 0xc5, 0x2d, 0xf0, 0xeb, 0xef, 0x9e, 0xbb, 0x4b, 0x90, 0xb3, 0x8a, 0x5f, 0x90,
+    0x2e, 0x83, 0xfe, 0x1b, 0x13, 0x5a, 0x70, 0xe2, 0x3a, 0xed, 0x76, 0x2e, 0x97, 0x10, 0xa1, 0x2e
+};
+
+static int64_t derive_time_us(const char *passphrase, const char *ssid, u8 *pmk)
+{
+    int64_t start = esp_timer_get_time();
+    TEST_ASSERT_EQUAL(0, esp_pmk_cache_derive(passphrase, (const u8 *)ssid, strlen(ssid), pmk, 32));
+    return esp_timer_get_time() - start;
+}
+
+TEST_CASE("PMK cache returns derived PMKs without running PBKDF2", "[wpa_crypto]")
+{
+    u8 pmk[32], other[32];
+
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_flash_init());
+    esp_pmk_cache_clear();
+
+    int64_t derived = derive_time_us("password", "IEEE", pmk);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ieee_psk, pmk, sizeof(pmk));
+
+    memset(pmk, 0, sizeof(pmk));
+    int64_t cached = derive_time_us("password", "IEEE", pmk);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ieee_psk, pmk, sizeof(pmk));
+    printf("PMK derivation %lld us, from cache %lld us\n", derived, cached);
+    TEST_ASSERT_LESS_THAN(derived / 4, cached);
+
+    /* A different passphrase or SSID must not hit the cached PMK */
+    derive_time_us("passw0rd", "IEEE", other);
+    TEST_ASSERT_NOT_EQUAL(0, memcmp(ieee_psk, other, sizeof(other)));
+    derive_time_us("password", "IEEF", other);
+    TEST_ASSERT_NOT_EQUAL(0, memcmp(ieee_psk, other, sizeof(other)));
+
+    esp_pmk_cache_clear();
+}
+
+TEST_CASE("PMK cache replaces the least recently used PMK", "[wpa_crypto]")
+{
+    u8 pmk[32];
+    char ssid[8];
+
+    if (CONFIG_WPA_PMK_CACHE_SIZE < 2) {
+        TEST_IGNORE_MESSAGE("needs a cache of at least two PMKs");
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_flash_init());
+    esp_pmk_cache_clear();
+
+    /* Fill the cache, use the first PMK again, then add one more */
+    int64_t derived = derive_time_us("password", "IEEE", pmk);
+    for (int i = 1; i < CONFIG_WPA_PMK_CACHE_SIZE; i++) {
+        snprintf(ssid, sizeof(ssid), "ssid%d", i);
+        derive_time_us("password", ssid, pmk);
+    }
+    derive_time_us("password", "IEEE", pmk);
+    derive_time_us("password", "new", pmk);
+
+    /* The PMK used most recently is still cached, the oldest one was replaced */
+    TEST_ASSERT_LESS_THAN(derived / 4, derive_time_us("password", "IEEE", pmk));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(ieee_psk, pmk, sizeof(pmk));
+    TEST_ASSERT_GREATER_THAN(derived / 4, derive_time_us("password", "ssid1", pmk));
+
+    esp_pmk_cache_clear();
+}
+
+#endif /* CONFIG_WPA_PMK_CACHE */
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "catch.hpp"
+
+extern "C" {
+int pbkdf2_sha1(const char *passphrase, const char *ssid, size_t ssid_len,
+                int iterations, uint8_t *buf, size_t buflen);
+int hmac_sha1(const uint8_t *key, size_t key_len, const uint8_t *data, size_t data_len,
+              uint8_t *mac);
+int hmac_sha1_vector(const uint8_t *key, size_t key_len, size_t num_elem,
+                     const uint8_t *addr[], const size_t *len, uint8_t *mac);
+}
+
+static double time_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* PBKDF2 computing every HMAC from the passphrase, as sha1-pbkdf2.c did before the HMAC states were precomputed */
+static void reference_pbkdf2_sha1(const char *passphrase, const char *ssid, size_t ssid_len,
+                                  int iterations, uint8_t *buf, size_t buflen)
+{
+    size_t passphrase_len = strlen(passphrase);
+    for (uint32_t count = 1; buflen > 0; count++) {
+        uint8_t count_buf[4] = { (uint8_t) (count >> 24), (uint8_t) (count >> 16), (uint8_t) (count >> 8), (uint8_t) count };
+        const uint8_t *addr[2] = { (const uint8_t *) ssid, count_buf };
+        size_t len[2] = { ssid_len, sizeof(count_buf) };
+        uint8_t u[20], digest[20];
+        hmac_sha1_vector((const uint8_t *) passphrase, passphrase_len, 2, addr, len, u);
+        memcpy(digest, u, sizeof(digest));
+        for (int i = 1; i < iterations; i++) {
+            hmac_sha1((const uint8_t *) passphrase, passphrase_len, u, sizeof(u), u);
+            for (int j = 0; j < 20; j++) {
+                digest[j] ^= u[j];
+            }
+        }
+        size_t n = buflen < sizeof(digest) ? buflen : sizeof(digest);
+        memcpy(buf, digest, n);
+        buf += n;
+        buflen -= n;
+    }
+}
+
+static void check_pbkdf2(const char *passphrase, const char *salt, size_t salt_len, int iterations,
+                         const uint8_t *expected, size_t expected_len)
+{
+    uint8_t key[64];
+    REQUIRE(expected_len <= sizeof(key));
+    REQUIRE(pbkdf2_sha1(passphrase, salt, salt_len, iterations, key, expected_len) == 0);
+    CHECK(memcmp(key, expected, expected_len) == 0);
+}
+
+TEST_CASE("pbkdf2_sha1 matches the RFC 6070 test vectors", "[pbkdf2]")
+{
+    const uint8_t one[] = { 0x0c, 0x60, 0xc8, 0x0f, 0x96, 0x1f, 0x0e, 0x71, 0xf3, 0xa9,
+                            0xb5, 0x24, 0xaf, 0x60, 0x12, 0x06, 0x2f, 0xe0, 0x37, 0xa6 };
+    check_pbkdf2("password", "salt", 4, 1, one, sizeof(one));
+
+    const uint8_t two[] = { 0xea, 0x6c, 0x01, 0x4d, 0xc7, 0x2d, 0x6f, 0x8c, 0xcd, 0x1e,
+                            0xd9, 0x2a, 0xce, 0x1d, 0x41, 0xf0, 0xd8, 0xde, 0x89, 0x57 };
+    check_pbkdf2("password", "salt", 4, 2, two, sizeof(two));
+
+    const uint8_t many[] = { 0x4b, 0x00, 0x79, 0x01, 0xb7, 0x65, 0x48, 0x9a, 0xbe, 0xad,
+                             0x49, 0xd9, 0x26, 0xf7, 0x21, 0xd0, 0x65, 0xa4, 0x29, 0xc1 };
+    check_pbkdf2("password", "salt", 4, 4096, many, sizeof(many));
+
+    /* The salt spans two SHA1 blocks and the key two PBKDF2 blocks */
+    const uint8_t long_salt[] = { 0x3d, 0x2e, 0xec, 0x4f, 0xe4, 0x1c, 0x84, 0x9b, 0x80, 0xc8,
+                                  0xd8, 0x36, 0x62, 0xc0, 0xe4, 0x4a, 0x8b, 0x29, 0x1a, 0x96,
+                                  0x4c, 0xf2, 0xf0, 0x70, 0x38 };
+    const char *salt = "saltSALTsaltSALTsaltSALTsaltSALTsalt";
+    check_pbkdf2("passwordPASSWORDpassword", salt, strlen(salt), 4096, long_salt, sizeof(long_salt));
+}
+
+TEST_CASE("pbkdf2_sha1 derives the IEEE 802.11i WPA-PSK test vectors", "[pbkdf2]")
+{
+    const uint8_t ieee[] = { 0xf4, 0x2c, 0x6f, 0xc5, 0x2d, 0xf0, 0xeb, 0xef, 0x9e, 0xbb, 0x4b, 0x90, 0xb3, 0x8a, 0x5f, 0x90,
+                             0x2e, 0x83, 0xfe, 0x1b, 0x13, 0x5a, 0x70, 0xe2, 0x3a, 0xed, 0x76, 0x2e, 0x97, 0x10, 0xa1, 0x2e };
+    check_pbkdf2("password", "IEEE", 4, 4096, ieee, sizeof(ieee));
+
+    const uint8_t ssid[] = { 0x0d, 0xc0, 0xd6, 0xeb, 0x90, 0x55, 0x5e, 0xd6, 0x41, 0x97, 0x56, 0xb9, 0xa1, 0x5e, 0xc3, 0xe3,
+                             0x20, 0x9b, 0x63, 0xdf, 0x70, 0x7d, 0xd5, 0x08, 0xd1, 0x45, 0x81, 0xf8, 0x98, 0x27, 0x21, 0xaf };
+    check_pbkdf2("ThisIsAPassword", "ThisIsASSID", 11, 4096, ssid, sizeof(ssid));
+}
+
+TEST_CASE("pbkdf2_sha1 matches the HMAC based reference for any passphrase length", "[pbkdf2]")
+{
+    char passphrase[100];
+    const char ssid[] = "a network with a 32 byte SSID...";
+    for (size_t len = 8; len < sizeof(passphrase); len += 7) {
+        for (size_t i = 0; i < len; i++) {
+            passphrase[i] = 'A' + (i * 13 + len) % 26;
+        }
+        passphrase[len] = 0;
+        uint8_t key[32], expected[32];
+        REQUIRE(pbkdf2_sha1(passphrase, ssid, len % 33, 64, key, sizeof(key)) == 0);
+        reference_pbkdf2_sha1(passphrase, ssid, len % 33, 64, expected, sizeof(expected));
+        CHECK(memcmp(key, expected, sizeof(key)) == 0);
+    }
+}
+
+TEST_CASE("PMK derivation time", "[pbkdf2][timing]")
+{
+    const int rounds = 20;
+    uint8_t pmk[32];
+
+    double start = time_s();
+    for (int i = 0; i < rounds; i++) {
+        pbkdf2_sha1("ThisIsAPassword", "ThisIsASSID", 11, 4096, pmk, sizeof(pmk));
+    }
+    double precomputed = (time_s() - start) / rounds;
+
+    start = time_s();
+    for (int i = 0; i < rounds; i++) {
+        reference_pbkdf2_sha1("ThisIsAPassword", "ThisIsASSID", 11, 4096, pmk, sizeof(pmk));
+    }
+    double reference = (time_s() - start) / rounds;
+
+    printf("PMK derivation: %.2f ms with precomputed HMAC states, %.2f ms rehashing the key\n",
+           precomputed * 1000, reference * 1000);
+    CHECK(precomputed < reference);
+}